@@ -0,0 +1,559 @@
+//
+//  bench.cpp
+//  hydra
+//
+//  Microbenchmarks and end-to-end workloads.  The results are written
+//  as JSON, such that they can be compared between releases.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <canvas.hpp>
+#include <compiler.hpp>
+#include <interpreter.hpp>
+#include <io_helper.hpp>
+#include <kernels.hpp>
+#include <lexer.hpp>
+#include <pol.hpp>
+#include <random_engine.hpp>
+#include <system.hpp>
+#include <vm.hpp>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+DEFINE_string(filter, "",
+              "Only run the benchmarks whose name contains this string.");
+DEFINE_string(examples, "examples",
+              "The directory that contains random_lines.hydra.");
+DEFINE_string(directory, ".",
+              "The directory where files are written while benchmarking. "
+              "They are removed afterwards.");
+DEFINE_string(output, "",
+              "The file that the JSON results are written to. Standard "
+              "output is used if empty.");
+DEFINE_int32(max_primitives, 1000000,
+             "The largest number of lines in the end-to-end workloads.");
+DEFINE_double(min_time, 0.5,
+              "Each benchmark is repeated until it ran for at least this "
+              "many seconds (and at least three times).");
+DEFINE_double(max_time, 10.0,
+              "A benchmark is not repeated anymore once it ran for this "
+              "many seconds.");
+
+namespace {
+
+/**
+ * The measurements of one benchmark.  The items are what the
+ * benchmark processes in one repetition (e.g. lines or loop
+ * iterations), which makes benchmarks of different sizes comparable.
+ */
+struct Result {
+  std::string name;
+  double items;
+  std::vector<double> seconds;
+};
+
+std::vector<Result> results;
+
+/**
+ * Prevents the compiler from optimizing away computations whose
+ * results are otherwise unused.
+ */
+volatile double sink;
+
+/**
+ * Measures the time it takes to call the passed function.
+ */
+double seconds_for(const std::function<void()> &function) {
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/**
+ * Runs a benchmark repeatedly, unless it is filtered out.  Each call
+ * of repetition runs the benchmark once and returns the number of
+ * seconds that the measured part took, such that setting up the
+ * repetition is not measured.
+ */
+void benchmark(const std::string &name, double items,
+               const std::function<double()> &repetition) {
+  if (name.find(FLAGS_filter) == std::string::npos) {
+    return;
+  }
+
+  std::cerr << name << "..." << std::flush;
+
+  Result result;
+  result.name = name;
+  result.items = items;
+
+  double total_seconds = 0.0;
+  while (result.seconds.size() < 3 || total_seconds < FLAGS_min_time) {
+    const double seconds = repetition();
+    result.seconds.push_back(seconds);
+    total_seconds += seconds;
+
+    if (total_seconds >= FLAGS_max_time) {
+      break;
+    }
+  }
+
+  std::cerr << " " << total_seconds / result.seconds.size() << "s"
+            << std::endl;
+  results.push_back(result);
+}
+
+std::string json_string(const std::string &string) {
+  std::string json = "\"";
+  for (char character : string) {
+    if (character == '"' || character == '\\') {
+      json += '\\';
+    }
+    json += character;
+  }
+  return json + "\"";
+}
+
+void write_results(std::ostream &stream) {
+  stream << "{\n  \"instruction_set\": "
+         << json_string(hydra::Kernels::instruction_set())
+         << ",\n  \"benchmarks\": [";
+
+  for (size_t index = 0; index < results.size(); ++index) {
+    const Result &result = results[index];
+
+    std::vector<double> seconds = result.seconds;
+    std::sort(seconds.begin(), seconds.end());
+    const double median = seconds[seconds.size() / 2];
+
+    stream << (index > 0 ? "," : "") << "\n    {\"name\": "
+           << json_string(result.name)
+           << ", \"repetitions\": " << seconds.size()
+           << ", \"items\": " << result.items
+           << ", \"min_seconds\": " << seconds.front()
+           << ", \"median_seconds\": " << median
+           << ", \"items_per_second\": " << result.items / median << "}";
+  }
+
+  stream << "\n  ]\n}\n";
+}
+
+/**
+ * Splits code into lines, like it is read from a file.
+ */
+std::vector<std::string> lines_of_code(const std::string &code) {
+  std::vector<std::string> lines;
+  std::istringstream stream(code);
+  std::string line;
+  while (std::getline(stream, line)) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+/**
+ * Parses and runs the code using a new interpreter and returns the
+ * time it took to execute it.  The time for parsing is only included
+ * if requested.  Aborts if the code cannot be executed, since the
+ * measurement would be meaningless.
+ */
+double seconds_to_run(const std::vector<std::string> &code,
+                      const std::string &engine, bool include_parsing) {
+  hydra::System system;
+  hydra::Lexer lexer(system);
+  hydra::Interpreter interpreter(system);
+  hydra::VM vm(interpreter);
+  interpreter.random_engine.seed(42);
+
+  std::vector<hydra::ParseResult> parsed_code;
+  bool success = true;
+
+  const double parsing_seconds = seconds_for(
+      [&]() { success = lexer.parse_code(code, parsed_code); });
+
+  const double execution_seconds = seconds_for([&]() {
+    if (!success) {
+      return;
+    }
+
+    hydra::Value result;
+    if (engine == "vm") {
+      hydra::Compiler compiler(interpreter);
+      hydra::Chunk chunk;
+      success = compiler.compile_code(parsed_code, chunk) &&
+                vm.run(chunk, result);
+    } else {
+      success = interpreter.interpret_code(parsed_code, result);
+    }
+  });
+
+  CHECK(success) << "The benchmark code could not be interpreted.";
+  return execution_seconds + (include_parsing ? parsing_seconds : 0.0);
+}
+
+/**
+ * Code that draws the passed number of random lines and saves them to
+ * the passed file.
+ */
+std::string random_lines_code(int lines, const std::string &file_name) {
+  return "var R = 10.0\n"
+         "var point_1 = Pol(r: 0.0, phi: 0.0)\n"
+         "for i in [1, 1, " +
+         std::to_string(lines) +
+         "] {\n"
+         "    var point_2 = Pol(r: random(from: 0.0, to: R), phi: "
+         "random(from: 0.0, to: 2.0 * M_PI))\n"
+         "    line(from: point_1, to: point_2)\n"
+         "    point_1 = point_2\n"
+         "}\n"
+         "save(file: \"" +
+         file_name + "\")\n";
+}
+
+void benchmark_lexer() {
+  const int lines = 100000;
+  const std::vector<std::string> code =
+      lines_of_code(random_lines_code(lines, "unused.svg"));
+
+  /**
+   * The statements in the loop are tokenized repeatedly.
+   */
+  std::vector<std::string> statements;
+  for (int index = 0; index < lines; ++index) {
+    statements.push_back(code[3 + index % 3]);
+  }
+
+  benchmark("lexer/tokenize_string", lines, [&]() {
+    hydra::System system;
+    hydra::Lexer lexer(system);
+    return seconds_for([&]() {
+      for (const std::string &statement : statements) {
+        hydra::TokenRange tokens;
+        lexer.tokenize_string(statement, tokens);
+        sink = tokens.size();
+      }
+    });
+  });
+
+  /**
+   * A long program that consists of many short loops, each of which
+   * is a copy of the loop above.
+   */
+  std::string program = code[0] + "\n" + code[1] + "\n";
+  for (int index = 0; index < lines / 5; ++index) {
+    program += "for i in [1, 1, 1] {\n";
+    for (int line = 3; line < 6; ++line) {
+      program += code[line] + "\n";
+    }
+    program += "}\n";
+  }
+  const std::vector<std::string> program_lines = lines_of_code(program);
+
+  benchmark("lexer/parse_code", program_lines.size(), [&]() {
+    hydra::System system;
+    hydra::Lexer lexer(system);
+    std::vector<hydra::ParseResult> parsed_code;
+    return seconds_for([&]() {
+      CHECK(lexer.parse_code(program_lines, parsed_code));
+    });
+  });
+}
+
+void benchmark_interpreter() {
+  const int iterations = 1000000;
+  const std::vector<std::string> code = lines_of_code(
+      "var s = 0.0\n"
+      "for i in [1, 1, " +
+      std::to_string(iterations) +
+      "] {\n"
+      "    var x = i * 0.5 + i / 3.0 - 2.0 * i\n"
+      "    var y = x * x - s / i + 1.0\n"
+      "    s = s + y / x\n"
+      "}\n");
+
+  for (const std::string engine : {"tree", "vm"}) {
+    benchmark("interpreter/loop_arithmetic/" + engine, iterations,
+              [&]() { return seconds_to_run(code, engine, false); });
+  }
+
+  const std::vector<std::string> invariant_code = lines_of_code(
+      "var R = 10.0\n"
+      "var s = 0.0\n"
+      "for i in [1, 1, " +
+      std::to_string(iterations) +
+      "] {\n"
+      "    var x = cosh(x: R) * i - sinh(x: R / 2.0) * 2.0 * M_PI\n"
+      "    s = s + x\n"
+      "}\n");
+
+  for (const std::string engine : {"tree", "vm"}) {
+    benchmark("interpreter/loop_invariant_calls/" + engine, iterations,
+              [&]() { return seconds_to_run(invariant_code, engine, false); });
+  }
+}
+
+void benchmark_geometry() {
+  const int points = 1000000;
+
+  hydra::RandomEngine random_engine;
+  random_engine.seed(42);
+
+  std::vector<hydra::Pol> first_points;
+  std::vector<hydra::Pol> second_points;
+  for (int index = 0; index < points; ++index) {
+    first_points.push_back(hydra::Pol(10.0 * random_engine.uniform(),
+                                      2.0 * M_PI * random_engine.uniform()));
+    second_points.push_back(hydra::Pol(10.0 * random_engine.uniform(),
+                                       2.0 * M_PI * random_engine.uniform()));
+  }
+
+  benchmark("geometry/distance_to", points, [&]() {
+    return seconds_for([&]() {
+      double sum = 0.0;
+      for (int index = 0; index < points; ++index) {
+        sum += first_points[index].distance_to(second_points[index]);
+      }
+      sink = sum;
+    });
+  });
+
+  /**
+   * The distances from one point to all others, and between all pairs
+   * of a smaller set of points, using the cached coordinates.
+   */
+  std::vector<double> r;
+  std::vector<double> phi;
+  for (const hydra::Pol &point : second_points) {
+    r.push_back(point.r);
+    phi.push_back(point.phi);
+  }
+
+  benchmark("geometry/cached_distances", points, [&]() {
+    std::vector<double> distances(points);
+    return seconds_for([&]() {
+      const hydra::CachedPol from(first_points[0]);
+      hydra::CachedPol::distances(from, r.data(), phi.data(), points,
+                                  distances.data());
+      sink = distances.back();
+    });
+  });
+
+  const int points_for_pairs = 3000;
+  std::vector<hydra::CachedPol> cached_points;
+  for (int index = 0; index < points_for_pairs; ++index) {
+    cached_points.push_back(hydra::CachedPol(first_points[index]));
+  }
+
+  const int number_of_pairs = points_for_pairs * (points_for_pairs - 1) / 2;
+  benchmark("geometry/pairs_within", number_of_pairs, [&]() {
+    std::vector<std::pair<int, int>> pairs;
+    return seconds_for([&]() {
+      hydra::CachedPol::pairs_within(cached_points, 10.0, pairs);
+      sink = pairs.size();
+    });
+  });
+
+  benchmark("geometry/translate_horizontally_by", points, [&]() {
+    std::vector<hydra::Pol> translated_points = first_points;
+    return seconds_for([&]() {
+      for (int index = 0; index < points; ++index) {
+        translated_points[index].translate_horizontally_by(
+            second_points[index].r);
+      }
+      sink = translated_points.back().r;
+    });
+  });
+
+  const int primitives = 10000;
+  const double resolution = 100.0;
+
+  benchmark("geometry/path_for_line", primitives, [&]() {
+    return seconds_for([&]() {
+      hydra::Path path;
+      for (int index = 0; index < primitives; ++index) {
+        path.clear();
+        hydra::Canvas::path_for_line(first_points[index],
+                                     second_points[index], resolution, path);
+      }
+      sink = path.size();
+    });
+  });
+
+  benchmark("geometry/path_for_circle", primitives, [&]() {
+    return seconds_for([&]() {
+      hydra::Path path;
+      for (int index = 0; index < primitives; ++index) {
+        path.clear();
+        hydra::Canvas::path_for_circle(first_points[index],
+                                       second_points[index].r / 2.0,
+                                       resolution, path);
+      }
+      sink = path.size();
+    });
+  });
+
+  /**
+   * The adaptive paths with the tolerance of 0.25 at the default
+   * scale of 30.
+   */
+  const double tolerance = 0.25 / 30.0;
+
+  benchmark("geometry/adaptive_path_for_line", primitives, [&]() {
+    return seconds_for([&]() {
+      hydra::Path path;
+      for (int index = 0; index < primitives; ++index) {
+        path.clear();
+        hydra::Canvas::adaptive_path_for_line(
+            first_points[index], second_points[index], tolerance, path);
+      }
+      sink = path.size();
+    });
+  });
+
+  benchmark("geometry/adaptive_path_for_circle", primitives, [&]() {
+    return seconds_for([&]() {
+      hydra::Path path;
+      for (int index = 0; index < primitives; ++index) {
+        path.clear();
+        hydra::Canvas::adaptive_path_for_circle(first_points[index],
+                                                second_points[index].r / 2.0,
+                                                tolerance, path);
+      }
+      sink = path.size();
+    });
+  });
+}
+
+void benchmark_export() {
+  const int primitives = 10000;
+
+  hydra::RandomEngine random_engine;
+  random_engine.seed(42);
+
+  hydra::Canvas canvas;
+  for (int index = 0; index < primitives; ++index) {
+    const hydra::Pol from(10.0 * random_engine.uniform(),
+                          2.0 * M_PI * random_engine.uniform());
+    const hydra::Pol to(10.0 * random_engine.uniform(),
+                        2.0 * M_PI * random_engine.uniform());
+    if (index % 2 == 0) {
+      canvas.add_line(from, to);
+    } else {
+      canvas.add_circle(from, to.r / 2.0);
+    }
+  }
+
+  for (const std::string extension : {"ipe", "svg", "png", "hcanvas"}) {
+    const std::string file_name =
+        FLAGS_directory + "/hydra_bench." + extension;
+    benchmark("export/save_to_file/" + extension, primitives, [&]() {
+      const double seconds =
+          seconds_for([&]() { canvas.save_to_file(file_name); });
+      std::remove(file_name.c_str());
+      return seconds;
+    });
+  }
+
+  /**
+   * Only the objects close to a point are exported.
+   */
+  canvas.viewport_center = hydra::Pol(5.0, 1.0);
+  canvas.viewport_radius = 2.0;
+  const std::string file_name = FLAGS_directory + "/hydra_bench.svg";
+  benchmark("export/viewport/svg", primitives, [&]() {
+    const double seconds =
+        seconds_for([&]() { canvas.save_to_file(file_name); });
+    std::remove(file_name.c_str());
+    return seconds;
+  });
+
+  /**
+   * Every object is drawn twice and the paths are simplified.
+   */
+  canvas.viewport_radius = 0.0;
+  canvas.simplification = 0.25;
+  const std::vector<hydra::Primitive> paths = canvas.paths;
+  canvas.paths.insert(canvas.paths.end(), paths.begin(), paths.end());
+  benchmark("export/simplification/svg", 2 * primitives, [&]() {
+    const double seconds =
+        seconds_for([&]() { canvas.save_to_file(file_name); });
+    std::remove(file_name.c_str());
+    return seconds;
+  });
+}
+
+/**
+ * Runs examples/random_lines.hydra with more lines.  The measurement
+ * includes parsing, interpreting and saving the drawing.
+ */
+void benchmark_end_to_end() {
+  std::vector<std::string> example;
+  hydra::IOHelper::read_code_from_file(
+      FLAGS_examples + "/random_lines.hydra", example);
+  CHECK(!example.empty()) << "Could not read random_lines.hydra from '"
+                          << FLAGS_examples << "'.";
+
+  for (int lines = 10000; lines <= FLAGS_max_primitives; lines *= 10) {
+    const std::string file_name =
+        FLAGS_directory + "/hydra_bench_random_lines.ipe";
+
+    std::vector<std::string> code;
+    for (std::string line : example) {
+      const std::string::size_type range = line.find("[0, 1, 99]");
+      if (range != std::string::npos) {
+        line.replace(range, 10,
+                     "[0, 1, " + std::to_string(lines - 1) + "]");
+      }
+
+      const std::string::size_type file = line.find("\"random_lines.ipe\"");
+      if (file != std::string::npos) {
+        line.replace(file, 18, "\"" + file_name + "\"");
+      }
+
+      code.push_back(line);
+    }
+
+    benchmark("end_to_end/random_lines/" + std::to_string(lines), lines,
+              [&]() {
+                const double seconds = seconds_to_run(code, "tree", true);
+                std::remove(file_name.c_str());
+                return seconds;
+              });
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_logtostderr = 1;
+
+  benchmark_lexer();
+  benchmark_interpreter();
+  benchmark_geometry();
+  benchmark_export();
+  benchmark_end_to_end();
+
+  if (FLAGS_output.empty()) {
+    write_results(std::cout);
+  } else {
+    std::ofstream file(FLAGS_output);
+    write_results(file);
+  }
+
+  return 0;
+}
@@ -0,0 +1,128 @@
+//
+//  arena.hpp
+//  hydra
+//
+//  Monotonic memory for the nodes of parsed code.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef arena_hpp
+#define arena_hpp
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace hydra {
+
+/**
+ * A view of consecutive values, e.g., the children of a node that
+ * were stored in an arena.  The span does not own the values.
+ */
+template <typename T>
+class Span {
+ public:
+  Span() {}
+  Span(T *first, size_t size) : first(first), count(size) {}
+  Span(std::vector<std::remove_const_t<T>> &values)
+      : first(values.data()), count(values.size()) {}
+  Span(const std::vector<std::remove_const_t<T>> &values)
+      : first(values.data()), count(values.size()) {}
+
+  /**
+   * A span of values can be used as span of constant values.
+   */
+  template <typename U,
+            typename = std::enable_if_t<std::is_same<const U, T>::value>>
+  Span(const Span<U> &other) : first(other.begin()), count(other.size()) {}
+
+  T *begin() const { return this->first; }
+  T *end() const { return this->first + this->count; }
+  size_t size() const { return this->count; }
+  bool empty() const { return this->count == 0; }
+  T &operator[](size_t index) const { return this->first[index]; }
+  T &front() const { return this->first[0]; }
+  T &back() const { return this->first[this->count - 1]; }
+
+  /**
+   * The values from the position begin up to (excluding) the position
+   * end.
+   */
+  Span subrange(size_t begin, size_t end) const {
+    return Span(this->first + begin, end - begin);
+  }
+
+ private:
+  T *first = nullptr;
+  size_t count = 0;
+};
+
+/**
+ * Hands out memory from large blocks, which are only released
+ * together, when the arena is cleared or destroyed.  Only values that
+ * don't need to be destructed can be stored in an arena.
+ */
+class Arena {
+ public:
+  Arena(size_t block_size = 64 * 1024) : block_size(block_size) {}
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  /**
+   * Returns memory for size bytes with the passed alignment.
+   */
+  void *allocate(size_t size, size_t alignment);
+
+  /**
+   * Copies the passed values into the arena.
+   */
+  template <typename T>
+  Span<T> copy(const T *values, size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Values in an arena are never destructed.");
+    if (count == 0) {
+      return Span<T>();
+    }
+
+    T *copies = static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+    std::uninitialized_copy(values, values + count, copies);
+    return Span<T>(copies, count);
+  }
+
+  /**
+   * Copies the characters of the passed string into the arena.
+   */
+  std::string_view copy(std::string_view str);
+
+  /**
+   * Releases all memory that was handed out.  The first block is kept
+   * to be reused.
+   */
+  void clear();
+
+ private:
+  size_t block_size;
+
+  struct Block {
+    std::unique_ptr<char[]> memory;
+    size_t size;
+  };
+
+  std::vector<Block> blocks;
+
+  /**
+   * The start of the free part of the last block, and its size.
+   */
+  char *position = nullptr;
+  size_t remaining = 0;
+};
+
+}  // namespace hydra
+
+#endif /* arena_hpp */
@@ -0,0 +1,98 @@
+//
+//  bounded_queue.hpp
+//  hydra
+//
+//  Passes values from one thread to another.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef bounded_queue_hpp
+#define bounded_queue_hpp
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace hydra {
+
+/**
+ * A queue that holds at most a fixed number of values.  A producer
+ * that pushes values into a full queue waits until the consumer
+ * popped some of them, such that the producer cannot get arbitrarily
+ * far ahead.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  /**
+   * Adds a value to the queue, waiting while the queue is full.
+   * Returns false if the queue was closed, in which case the value is
+   * dropped.
+   */
+  bool push(const T &value) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->not_full.wait(lock, [this] {
+      return this->is_closed || this->values.size() < this->capacity;
+    });
+
+    if (this->is_closed) {
+      return false;
+    }
+
+    this->values.push_back(value);
+    this->not_empty.notify_one();
+    return true;
+  }
+
+  /**
+   * Removes the first value from the queue, waiting while the queue
+   * is empty.  Returns false if the queue is empty and was closed.
+   */
+  bool pop(T &value) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->not_empty.wait(
+        lock, [this] { return this->is_closed || !this->values.empty(); });
+
+    if (this->values.empty()) {
+      return false;
+    }
+
+    value = this->values.front();
+    this->values.pop_front();
+    this->not_full.notify_one();
+    return true;
+  }
+
+  /**
+   * Closes the queue.  Values that were pushed before can still be
+   * popped, but no values can be pushed anymore.
+   */
+  void close() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->is_closed = true;
+    this->not_empty.notify_all();
+    this->not_full.notify_all();
+  }
+
+ private:
+  const size_t capacity;
+
+  std::deque<T> values;
+  bool is_closed = false;
+
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+};
+
+}  // namespace hydra
+
+#endif /* bounded_queue_hpp */
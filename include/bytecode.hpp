@@ -0,0 +1,161 @@
+//
+//  bytecode.hpp
+//  hydra
+//
+//  The instructions that the virtual machine executes.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef bytecode_hpp
+#define bytecode_hpp
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <system.hpp>
+
+namespace hydra {
+
+struct Builtin;
+
+/**
+ * The operations known to the virtual machine.  Operands are encoded
+ * in the fields a, b and c of an instruction.  Unless stated
+ * otherwise, a denotes the register that receives the result of the
+ * operation.
+ */
+enum class OpCode {
+  LoadConstant,    // R[a] = constants[b]
+  LoadVariable,    // R[a] = value of variables[b]
+  LoadProperty,    // R[a] = property names[c] of variables[b]
+  DefineVariable,  // var variables[b] = R[a]
+  AssignVariable,  // variables[b] = R[a]
+  Add,             // R[a] = R[b] + R[c]
+  Subtract,        // R[a] = R[b] - R[c]
+  Multiply,        // R[a] = R[b] * R[c]
+  Divide,          // R[a] = R[b] / R[c]
+  BuildString,     // R[a] = R[b] + ... + R[b + c - 1] as string
+  Initialize,      // R[a] = object of call_sites[b], properties from R[c]...
+  CallBuiltin,     // R[a] = builtin function of call_sites[b],
+                   //        arguments from R[c]...
+  CallFunction,    // R[a] = user defined function of call_sites[b],
+                   //        arguments from R[c]...
+  DefineFunction,  // Makes functions[a] callable.
+  LoopPrepare,     // Starts a loop with lower bound, step size, upper
+                   // bound and loop variable in R[a]...R[a + 3]. The
+                   // loop variable is variables[b]. Jumps to c if the
+                   // loop is not entered.
+  LoopStep,        // Advances the loop in R[a]...R[a + 3]. Jumps back
+                   // to c, if the loop continues.
+  ParallelLoop,    // Lets the interpreter execute the parallel loop of
+                   // call_sites[b].
+  Return           // Returns R[a] or nothing if a < 0.
+};
+
+/**
+ * A single instruction.
+ */
+struct Instruction {
+  OpCode op_code;
+  int a = 0;
+  int b = 0;
+  int c = 0;
+};
+
+/**
+ * A variable as it was resolved by the resolver. The name is used
+ * for error messages and for variables that have to be looked up by
+ * name.
+ */
+struct VariableReference {
+  std::string name;
+  Frame frame = UnresolvedFrame;
+  int slot = -1;
+};
+
+/**
+ * Function calls and initializations need more information than
+ * fits into an instruction.  This is stored in a call site.
+ */
+struct CallSite {
+  /**
+   * A copy of the function call / initialization as it was
+   * parsed. Builtin functions interpret the argument that uses the
+   * hidden variable from here.
+   */
+  ParseResult call;
+
+  /**
+   * The names of the parameters whose arguments were evaluated into
+   * consecutive registers, in order.
+   */
+  std::vector<std::string> parameters;
+
+  /**
+   * For calls to builtin functions, the implementation of the
+   * function.
+   */
+  const Builtin *builtin = nullptr;
+
+  /**
+   * For initializations, the signature of the type.
+   */
+  const Func *function = nullptr;
+};
+
+/**
+ * A chunk is a compiled sequence of statements, e.g., the top level
+ * of a program or the body of a function.
+ */
+struct Chunk {
+  /**
+   * The name of the chunk. For function bodies this is the name of
+   * the function.
+   */
+  std::string name = "";
+
+  /**
+   * The instructions and, for each instruction, the number of the
+   * line that it was compiled from.
+   */
+  std::vector<Instruction> instructions;
+  std::vector<int> line_numbers;
+
+  /**
+   * The values, variables, names and call sites that the
+   * instructions refer to.
+   */
+  std::vector<Value> constants;
+  std::vector<VariableReference> variables;
+  std::vector<std::string> names;
+  std::vector<CallSite> call_sites;
+
+  /**
+   * The functions that are defined in this chunk. Together with
+   * their body, we keep the statements of the function such that the
+   * builtin functions (which are interpreted by walking the parse
+   * tree) can call them as well.
+   */
+  std::vector<std::shared_ptr<const Chunk>> functions;
+  std::vector<Span<const ParseResult>> function_statements;
+
+  /**
+   * The number of registers that executing the chunk requires.
+   */
+  int number_of_registers = 0;
+
+  /**
+   * For function bodies, the number of slots in the frame of the
+   * function.
+   */
+  int number_of_slots = 0;
+};
+
+}  // namespace hydra
+
+#endif /* bytecode_hpp */
@@ -14,11 +14,14 @@
 #ifndef canvas_hpp
 #define canvas_hpp
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include <output_sink.hpp>
 #include <pol.hpp>
 
 namespace hydra {
@@ -59,26 +62,64 @@ struct Euc {
 
   /**
    * A path object consists of multiple points and can either be
-   * closed or not.
+   * closed or not. The radial and angular coordinates of the points
+   * are stored in separate arrays, such that they can be processed
+   * in batches (see Kernels).
    */
   struct Path {
 
-    std::vector<Pol> points;
+    std::vector<double> r;
+    std::vector<double> phi;
     bool is_closed = false;
 
     /**
      * Convenience method to add points to a path.
      */
     void push_back(const Pol &point) {
-      this->points.push_back(point);
+      this->r.push_back(point.r);
+      this->phi.push_back(point.phi);
+    }
+
+    /**
+     * Adds the point with the passed coordinates. In contrast to
+     * creating a Pol, the angle is not normalized, so it has to be
+     * between 0 and 2pi already.
+     */
+    void push_back(double r, double phi) {
+      this->r.push_back(r);
+      this->phi.push_back(phi);
+    }
+
+    /**
+     * Reserves memory for the expected number of points, which
+     * usually depends on the resolution. Since the resolution can be
+     * arbitrarily large, at most maximum_reserved_points are reserved
+     * up front.
+     */
+    void reserve(double expected_number_of_points) {
+      static const double maximum_reserved_points = 1 << 20;
+
+      const size_t size =
+          std::max(0.0, std::min(expected_number_of_points,
+                                 maximum_reserved_points));
+      this->r.reserve(size);
+      this->phi.reserve(size);
+    }
+
+    /**
+     * Removes all points, but keeps the memory.
+     */
+    void clear() {
+      this->r.clear();
+      this->phi.clear();
     }
 
     int size() const {
-      return this->points.size();
+      return this->r.size();
     }
 
     bool empty() const {
-      return this->points.empty();
+      return this->r.empty();
     }
 
   };
@@ -96,15 +137,59 @@ struct Euc {
     bool is_filled = true;
   };
 
+  /**
+   * The kinds of objects that are drawn as paths.
+   */
+  enum class PrimitiveType { Line, Circle, Curve };
+
+  /**
+   * An object that is drawn as a path. Lines and circles only store
+   * the coordinates that define them. They are converted to points
+   * (tessellated) when the canvas is saved, using the resolution at
+   * that time. The points of a curve depend on the expression that
+   * defines it and are therefore determined right away and stored in
+   * the curves of the canvas.
+   */
+  struct Primitive {
+    PrimitiveType type;
+
+    /**
+     * The start of a line or the center of a circle.
+     */
+    Pol first;
+
+    /**
+     * The end of a line.
+     */
+    Pol second;
+
+    /**
+     * The radius of a circle.
+     */
+    double radius = 0.0;
+
+    /**
+     * The position of the points of a curve in the curves of the
+     * canvas.
+     */
+    int curve = -1;
+  };
+
   class Canvas {
    public:
 
     Canvas() {}
 
     /**
-     * All paths that are currently on the canvas
+     * All paths that are currently on the canvas, in the order in
+     * which they were drawn.
      */
-    std::vector<Path> paths;
+    std::vector<Primitive> paths;
+
+    /**
+     * The points of the curves among the paths.
+     */
+    std::vector<Path> curves;
 
     /**
      * All marks that are currently on the canvas.
@@ -117,6 +202,15 @@ struct Euc {
      */
     double resolution = 100.0;
 
+    /**
+     * If positive, lines and circles are tessellated adaptively
+     * instead of using the resolution: each gets only as many points
+     * as are needed such that the path deviates from the actual
+     * object by at most the tolerance.  The tolerance is measured in
+     * the units of the drawing, i.e., after applying the scale.
+     */
+    double tolerance = 0.0;
+
     /**
      * Since we don't want a hyperbolic length of 1.0 to be
      * represented by 1 pixel, we add a scale. Not sure whether the
@@ -125,9 +219,39 @@ struct Euc {
     double scale = 30.0;
 
     /**
-     * Convenience method to add a path to the canvas.
+     * If the radius is positive, only the objects within this distance
+     * of the center are exported.  Objects outside of the viewport are
+     * skipped before they are tessellated, paths are clipped at its
+     * boundary and the drawing is sized to fit the viewport.
+     */
+    Pol viewport_center;
+    double viewport_radius = 0.0;
+
+    /**
+     * If positive, the Ipe and SVG files are simplified before they are
+     * written: points of paths are dropped as long as the path deviates
+     * by at most this distance in the drawing (Douglas-Peucker), and
+     * objects that are drawn more than once are only written once.
+     * Objects count as the same if their coordinates in the drawing
+     * agree after rounding them to multiples of this distance.
+     */
+    double simplification = 0.0;
+
+    /**
+     * Convenience method to add a path to the canvas. The path is
+     * stored as a curve.
+     */
+    void add_path(Path path);
+
+    /**
+     * Adds the line between the passed points to the canvas.
+     */
+    void add_line(const Pol &from, const Pol &to);
+
+    /**
+     * Adds the circle with the passed center and radius to the canvas.
      */
-    void add_path(const Path &path);
+    void add_circle(const Pol &center, double radius);
 
     /**
      * Convenience method to add a mark to the canvas.
@@ -140,53 +264,241 @@ struct Euc {
     void clear();
 
     /**
-     * Writes the current canvas to file.
+     * Removes all marks and paths and restores the default resolution,
+     * tolerance, scale, viewport, simplification, precision and image
+     * size.  The memory of the objects is kept to be reused.
+     */
+    void reset();
+
+    /**
+     * Moves the marks and paths of the passed canvas to this canvas,
+     * as if they were drawn after the objects of this canvas.  The
+     * passed canvas is empty afterwards.
+     */
+    void append(Canvas &other);
+
+    /**
+     * What is needed to return the canvas to an earlier point: the
+     * number of objects that were drawn until then and the settings at
+     * that time.
+     */
+    struct Checkpoint {
+      size_t number_of_paths = 0;
+      size_t number_of_curves = 0;
+      size_t number_of_marks = 0;
+      int number_of_clears = 0;
+
+      double resolution;
+      double tolerance;
+      double scale;
+      Pol viewport_center;
+      double viewport_radius;
+      double simplification;
+      int precision;
+      int image_width;
+      int image_height;
+    };
+
+    /**
+     * Returns a checkpoint of the current canvas.
+     */
+    Checkpoint checkpoint() const;
+
+    /**
+     * Removes the objects that were drawn after the checkpoint and
+     * restores the settings of the checkpoint.  Returns false, without
+     * changing the canvas, if the canvas was cleared after the
+     * checkpoint, since the objects drawn before cannot be restored.
+     */
+    bool restore(const Checkpoint &checkpoint);
+
+    /**
+     * The number of decimal places that are used for the coordinates
+     * when writing the canvas to a file.
+     */
+    int precision = 6;
+
+    /**
+     * The number of threads that are used to tessellate and format the
+     * marks and paths when writing the canvas to a file.
+     */
+    int export_threads = 1;
+
+    /**
+     * The size of PNG images in pixels.  If either is 0, the size of
+     * the image is the size of the SVG drawing.  Otherwise, the
+     * drawing is scaled to fit into the image and centered.
+     */
+    int image_width = 0;
+    int image_height = 0;
+
+    /**
+     * The largest width and height of PNG images in pixels.
+     */
+    static const int maximum_image_size = 1 << 15;
+
+    /**
+     * Writes the current canvas to file.  The format is determined by
+     * the extension of the file name: '.ipe', '.svg', '.png' or
+     * '.hcanvas'.
      */
     void save_to_file(const std::string &file_name) const;
 
     /**
-     * Creates the content of an Ipe file that represents the current
-     * canvas.
+     * Adds the marks and paths stored in a binary canvas file
+     * (.hcanvas) to this canvas, as if they were drawn after the
+     * objects of this canvas.  If this canvas is empty, it takes the
+     * settings (scale, resolution and precision) of the stored canvas
+     * as well.  Returns false if the file could not be read.
      */
-    void ipe_canvas_representation(std::string &ipe_representation) const;
+    bool load_from_file(const std::string &file_name);
 
     /**
-     * Creates the content of an SVG file that represents the current
-     * canvas.
+     * Determines the largest radius among the marks and the points of
+     * the paths.
+     */
+    double maximum_radius() const;
+
+    /**
+     * Determines the largest radius among the points of the passed
+     * path, without tessellating lines and circles.
      */
-    void svg_canvas_representation(std::string &svg_representation) const;
+    double maximum_radius(const Primitive &primitive) const;
 
     /**
-     * Creates a string that represents the passed path, by applying
-     * the scale to each point and moving them by the passed offset.
+     * Determines the points of the passed path using the current
+     * resolution or tolerance. Returns the stored points for curves. Otherwise the
+     * points are written to the passed path, which is returned.
      */
-    static void ipe_path_representation(const Path &path,
-                                        std::string &ipe_path_representation,
+    const Path &path_for_primitive(const Primitive &primitive,
+                                   Path &path) const;
+
+    /**
+     * Determines the square that is drawn: its center and half of its
+     * side length, before applying the scale.  Without a viewport, the
+     * square is centered at the origin and contains all objects.
+     */
+    void drawing_area(Euc &center, double &radius) const;
+
+    /**
+     * Whether the center of the passed mark is within the viewport,
+     * extended by the radius of the mark.  Without a viewport, all
+     * marks are visible.
+     */
+    bool is_visible(const Circle &mark) const;
+
+    /**
+     * Passes the parts of the passed primitive that lie within the
+     * viewport to the function, one path at a time.  Lines are clipped
+     * before they are tessellated, circles and curves afterwards.
+     * Objects outside of the viewport are not tessellated at all.
+     * Without a viewport, the function is called once with the path for
+     * the primitive.  The passed paths are used as buffers.
+     */
+    void for_each_visible_path(
+        const Primitive &primitive, Path &path, Path &piece,
+        const std::function<void(const Path &)> &handle_path) const;
+
+    /**
+     * Marks the marks and paths that are drawn again after an earlier
+     * object with the same coordinates (see simplification).  The first
+     * of the equal objects is kept.
+     */
+    void find_duplicates(std::vector<bool> &is_duplicate_mark,
+                         std::vector<bool> &is_duplicate_path) const;
+
+    /**
+     * Removes the points of the passed path that are not needed to stay
+     * within the simplification distance, writing the remaining points
+     * to the simplified path, which is returned.  Returns the passed
+     * path itself if nothing is removed.
+     */
+    const Path &simplified_path(const Path &path, Path &simplified) const;
+
+    /**
+     * Writes the content of an Ipe file that represents the current
+     * canvas to the sink.
+     */
+    void ipe_canvas_representation(OutputSink &sink) const;
+
+    /**
+     * Writes the content of an SVG file that represents the current
+     * canvas to the sink.
+     */
+    void svg_canvas_representation(OutputSink &sink) const;
+
+    /**
+     * Draws the current canvas into a PNG image, which is written to
+     * the stream.  The objects look like in the SVG file, drawn black
+     * on white with anti-aliasing.  The image is drawn in tiles, using
+     * the export threads.
+     */
+    void png_canvas_representation(std::ostream &stream) const;
+
+    /**
+     * Writes the binary representation of the current canvas to the
+     * stream.  Lines and circles are stored as primitives, so they
+     * are tessellated when the canvas is finally saved as Ipe or SVG.
+     * The numbers are stored with the byte order of the machine that
+     * writes the file.
+     */
+    void binary_canvas_representation(std::ostream &stream) const;
+
+    /**
+     * Writes the representations of the marks and the paths to the
+     * sink, marks first, using the passed functions. With multiple
+     * export threads, chunks of objects are written to separate
+     * buffers in parallel, which are then written to the sink in the
+     * original order.
+     */
+    void write_marks_and_paths(
+        OutputSink &sink,
+        const std::function<void(const Circle &, OutputSink &)> &write_mark,
+        const std::function<void(const Path &, OutputSink &)> &write_path)
+        const;
+
+    /**
+     * Determines the Euclidean coordinates of the points of the passed
+     * path, after applying the scale and moving them by the passed
+     * offset.
+     */
+    static void euclidean_coordinates(const Path &path, double scale,
+                                      Euc offset, std::vector<double> &x,
+                                      std::vector<double> &y);
+
+    /**
+     * Writes the representation of the passed path to the sink, by
+     * applying the scale to each point and moving them by the passed
+     * offset.
+     */
+    static void ipe_path_representation(const Path &path, OutputSink &sink,
                                         double scale = 1.0,
                                         Euc offset = Euc(0.0, 0.0));
 
     /**
-     * Creates a string that represents the passed path, by applying
-     * the scale to each point and moving them by the passed offset.
+     * Writes the representation of the passed path to the sink, by
+     * applying the scale to each point and moving them by the passed
+     * offset.
      */
-    static void svg_path_representation(const Path &path,
-                                        std::string &svg_path_representation,
+    static void svg_path_representation(const Path &path, OutputSink &sink,
                                         double scale = 1.0,
                                         Euc offset = Euc(0.0, 0.0));
 
     /**
-     * Creates a string that represents the passed mark.
+     * Writes the representation of the passed mark to the sink.
      */
-    static void ipe_circle_representation(
-        const Circle &circle, std::string &ipe_circle_representation,
-        double scale = 1.0, Euc offset = Euc(0.0, 0.0));
+    static void ipe_circle_representation(const Circle &circle,
+                                          OutputSink &sink,
+                                          double scale = 1.0,
+                                          Euc offset = Euc(0.0, 0.0));
 
     /**
-     * Creates a string that represents the passed mark.
+     * Writes the representation of the passed mark to the sink.
      */
-    static void svg_circle_representation(
-        const Circle &circle, std::string &svg_circle_representation,
-        double scale = 1.0, Euc offset = Euc(0.0, 0.0));
+    static void svg_circle_representation(const Circle &circle,
+                                          OutputSink &sink,
+                                          double scale = 1.0,
+                                          Euc offset = Euc(0.0, 0.0));
 
     // "Rendering":
 
@@ -201,6 +513,36 @@ struct Euc {
 
     static void path_for_line(const Pol &from, const Pol &to, double resolution,
                               Path &path);
+
+    /**
+     * Determines the path that represents the circle with the passed
+     * center and radius, such that the distance between the path and
+     * the circle is at most the passed tolerance (before scaling).
+     * The points are denser where the circle is curved more strongly
+     * in the drawing.
+     */
+    static void adaptive_path_for_circle(const Pol &center, double radius,
+                                         double tolerance, Path &path);
+
+    /**
+     * Determines the path that represents the line between the passed
+     * points, such that the distance between the path and the line is
+     * at most the passed tolerance (before scaling).
+     */
+    static void adaptive_path_for_line(const Pol &from, const Pol &to,
+                                       double tolerance, Path &path);
+
+   private:
+    /**
+     * How often the canvas was cleared, which tells whether objects
+     * were removed since a checkpoint.
+     */
+    int number_of_clears = 0;
+
+    /**
+     * Takes the settings of the passed checkpoint.
+     */
+    void restore_settings(const Checkpoint &checkpoint);
   };
   }  // namespace hydra
 
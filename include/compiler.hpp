@@ -0,0 +1,135 @@
+//
+//  compiler.hpp
+//  hydra
+//
+//  Compiles parsed hydra code to bytecode.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef compiler_hpp
+#define compiler_hpp
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <bytecode.hpp>
+#include <interpreter.hpp>
+
+namespace hydra {
+
+class Compiler {
+ public:
+  /**
+   * Constructor
+   */
+  Compiler(Interpreter &interpreter);
+
+  /**
+   * The compiler needs to know about the builtin functions of the
+   * interpreter, as well as the functions that the user defined
+   * already.
+   */
+  Interpreter &interpreter;
+
+  /**
+   * Compiles a series of ParseResults into the passed chunk.  Returns
+   * false if an error occurred.
+   */
+  bool compile_code(const std::vector<ParseResult> &code, Chunk &chunk);
+
+  /**
+   * Prints the instructions of a chunk (and of the functions defined
+   * therein).
+   */
+  static void print_chunk(const Chunk &chunk,
+                          const std::string &indentation = "");
+
+ private:
+  /**
+   * The names of the functions that are defined in the code that is
+   * currently being compiled.
+   */
+  std::unordered_set<std::string> defined_functions;
+
+  /**
+   * During compilation, registers are allocated like a stack. This
+   * is the first register that is currently free.
+   */
+  int next_free_register = 0;
+
+  /**
+   * The line that the statement that is currently being compiled
+   * stems from.
+   */
+  int current_line_number = -1;
+
+  /**
+   * Allocates a new register in the passed chunk.
+   */
+  int allocate_register(Chunk &chunk);
+
+  /**
+   * Appends an instruction to the chunk.  Returns the index of the
+   * instruction.
+   */
+  int emit(Chunk &chunk, OpCode op_code, int a = 0, int b = 0, int c = 0);
+
+  /**
+   * Adds a constant / name to the chunk and returns its index.
+   */
+  int add_constant(Chunk &chunk, const Value &constant);
+  int add_name(Chunk &chunk, const std::string &name);
+  int add_variable(Chunk &chunk, const ParseResult &variable);
+
+  /**
+   * Compiles a sequence of statements.  The value of the last
+   * statement is returned from the chunk.
+   */
+  bool compile_statements(Span<const ParseResult> statements,
+                          int first_statement, Chunk &chunk);
+
+  /**
+   * Compiles a ParseResult such that its value ends up in the target
+   * register.  Sets has_value to false, if the ParseResult does not
+   * have a value (e.g., loops).
+   */
+  bool compile_parse_result(const ParseResult &input, Chunk &chunk, int target,
+                            bool &has_value);
+
+  /**
+   * Compiles a ParseResult that must have a value.
+   */
+  bool compile_value(const ParseResult &input, Chunk &chunk, int target);
+
+  bool compile_assignment(const ParseResult &input, Chunk &chunk, int target);
+  bool compile_expression(const ParseResult &input, Chunk &chunk, int target);
+  bool compile_function(const ParseResult &function_call, Chunk &chunk,
+                        int target);
+  bool compile_function_definition(const ParseResult &function_definition,
+                                   Chunk &chunk);
+  bool compile_initialization(const ParseResult &initialization, Chunk &chunk,
+                              int target);
+  bool compile_loop(const ParseResult &loop, Chunk &chunk);
+  bool compile_number(const ParseResult &input, Chunk &chunk, int target);
+  bool compile_string(const ParseResult &input, Chunk &chunk, int target);
+  bool compile_variable(const ParseResult &input, Chunk &chunk, int target);
+
+  /**
+   * Evaluates the arguments of a function call / initialization into
+   * consecutive registers. The first register is stored in
+   * first_register and the parameter names are added to the call
+   * site.  The argument at the position lazy_argument only gets a
+   * register, but is not evaluated.
+   */
+  bool compile_arguments(const ParseResult &function_call, Chunk &chunk,
+                         CallSite &call_site, int &first_register,
+                         int lazy_argument = -1);
+};
+
+}  // namespace hydra
+
+#endif /* compiler_hpp */
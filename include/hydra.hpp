@@ -0,0 +1,247 @@
+//
+//  hydra.hpp
+//  hydra
+//
+//  The interface for running hydra code from other programs, which
+//  is compiled into the hydra library (libhydra).
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef hydra_hpp
+#define hydra_hpp
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <canvas.hpp>
+#include <interpreter.hpp>
+#include <lexer.hpp>
+#include <program_cache.hpp>
+#include <system.hpp>
+#include <vm.hpp>
+
+namespace hydra {
+
+/**
+ * The settings of an instance.
+ */
+struct Options {
+  enum class Engine { Tree, VM };
+
+  /**
+   * The engine that executes the code.  Tree interprets the parse
+   * tree directly, VM compiles the code to bytecode first.
+   */
+  Engine engine = Engine::Tree;
+
+  /**
+   * The number of threads that are used to write the canvas to a file
+   * and to execute parallel loops.
+   */
+  int export_threads = 1;
+  int parallel_threads = 1;
+
+  /**
+   * The seed of the random numbers, which is set again whenever the
+   * instance is reset.  If negative, the numbers differ between runs.
+   */
+  int64_t seed = -1;
+
+  /**
+   * Where the messages of 'print' are written to.  Instances that run
+   * concurrently share the stream, so it has to be safe to use from
+   * multiple threads, like std::cout.
+   */
+  std::ostream *output = &std::cout;
+};
+
+/**
+ * Parsed code that can be executed by any number of instances, also
+ * concurrently, without parsing it again.  A program is not changed
+ * by running it.
+ */
+class Program {
+ public:
+  /**
+   * Parses the passed code.  Returns nullptr if the code could not be
+   * parsed, in which case the errors describe why.
+   */
+  static std::shared_ptr<const Program> parse(std::string_view code,
+                                              std::string &errors);
+
+  /**
+   * Parses the code in a hydra file.  If use_cache is set, the parsed
+   * code is taken from the precompiled program next to the file
+   * (.hydrac, see ProgramCache), unless it is stale, in which case the
+   * precompiled program is written again.
+   */
+  static std::shared_ptr<const Program> load(const std::string &file_name,
+                                             bool use_cache,
+                                             std::string &errors);
+
+  Program(const Program &) = delete;
+  Program &operator=(const Program &) = delete;
+
+ private:
+  friend class Instance;
+
+  Program();
+
+  /**
+   * The system of the lexer, which learns the user defined functions
+   * while parsing.
+   */
+  System system;
+  Lexer lexer;
+
+  /**
+   * Holds the parse results if they were loaded from a precompiled
+   * program.
+   */
+  ProgramCache cache;
+
+  /**
+   * The top level statements.  Each instance resolves copies of them
+   * against its own system.
+   */
+  std::vector<ParseResult> code;
+};
+
+/**
+ * Executes hydra code and keeps the drawn canvas, like a run of the
+ * hydra binary.  Code that is run after other code sees its variables
+ * and functions, unless the instance is reset in between.  Resetting
+ * an instance is much cheaper than creating a new one, since the
+ * builtin functions are kept and the memory is reused.
+ *
+ * An instance must only be used by one thread at a time, but
+ * different instances can be used concurrently.
+ */
+class Instance {
+ public:
+  Instance(const Options &options = Options());
+
+  const Options options;
+
+  /**
+   * Parses and executes the passed code.  Returns false if an error
+   * occurred, in which case the errors describe it.
+   */
+  bool run(std::string_view code);
+
+  /**
+   * Executes a parsed program.  The instance copies what it keeps of
+   * the program, so the program can be released once this returns.
+   * Returns false if an error occurred, in which case the errors
+   * describe it.
+   */
+  bool run(const Program &program);
+
+  /**
+   * Defines a global variable that the code which is run afterwards
+   * can use, e.g., a parameter of a program.  Code that defines the
+   * variable itself fails with an error that names the parameter.
+   */
+  void define_variable(const std::string &name, const Value &value);
+
+  /**
+   * Inserts the passed suffix before the extension of the files that
+   * the code saves, e.g. 'drawing_3.png' for 'drawing.png' and the
+   * suffix '_3', such that instances that run the same program at the
+   * same time don't write to the same files.  Resetting the instance
+   * removes the suffix.
+   */
+  void set_saved_file_suffix(const std::string &suffix);
+
+  /**
+   * The objects drawn by the code that was run.
+   */
+  const Canvas &canvas() const;
+
+  /**
+   * The error messages of all runs since the last reset.
+   */
+  std::string errors() const;
+
+  /**
+   * Forgets all code that was run, its variables, functions, drawn
+   * objects and canvas settings, as well as the errors.
+   */
+  void reset();
+
+  Instance(const Instance &) = delete;
+  Instance &operator=(const Instance &) = delete;
+
+ private:
+  std::ostringstream error_stream;
+
+  System system;
+  Lexer lexer;
+  Interpreter interpreter;
+  VM vm;
+
+  /**
+   * The copies of the parse results of programs, which are resolved
+   * against the system of this instance.
+   */
+  Arena arena;
+
+  bool execute(std::vector<ParseResult> &code);
+};
+
+/**
+ * Hands out instances to concurrent jobs.  Instances are created when
+ * needed and reset when they are returned, such that at most as many
+ * instances exist as jobs were executed at the same time.
+ */
+class InstancePool {
+ public:
+  InstancePool(const Options &options = Options());
+
+  /**
+   * An instance that returns to its pool when the lease ends.
+   */
+  class Lease {
+   public:
+    Lease(Lease &&other) = default;
+    ~Lease();
+
+    Instance &operator*() const { return *this->instance; }
+    Instance *operator->() const { return this->instance.get(); }
+
+   private:
+    friend class InstancePool;
+
+    Lease(InstancePool &pool, std::unique_ptr<Instance> instance)
+        : pool(&pool), instance(std::move(instance)) {}
+
+    InstancePool *pool;
+    std::unique_ptr<Instance> instance;
+  };
+
+  /**
+   * Returns an unused instance.  Can be called from any thread.
+   */
+  Lease acquire();
+
+ private:
+  const Options options;
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Instance>> unused_instances;
+
+  void release(std::unique_ptr<Instance> instance);
+};
+
+}  // namespace hydra
+
+#endif /* hydra_hpp */
@@ -14,8 +14,10 @@
 #ifndef interpreter_hpp
 #define interpreter_hpp
 
-#include <any>
+#include <cstdint>
 #include <functional>
+#include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -24,11 +26,118 @@
 
 #include <canvas.hpp>
 #include <lexer.hpp>
+#include <profiler.hpp>
+#include <random_engine.hpp>
+#include <thread_pool.hpp>
 
 namespace hydra {
+
+  class Interpreter;
+
+  /**
+   * The interpreted arguments of a call to a builtin function or of
+   * an initialization.  Arguments are bound to the parameters of the
+   * function by position: the parser ensures that the arguments of a
+   * call appear in the order of the parameters, so the value of the
+   * i-th parameter is stored at index i.  Since trailing arguments may
+   * be omitted, only the first size values belong to the call.
+   * Arguments that were not interpreted (yet) don't have a value.
+   */
+  struct Arguments {
+    /**
+     * The signature of the called function.
+     */
+    const Func *function = nullptr;
+
+    Value *values = nullptr;
+    int size = 0;
+  };
+
+  /**
+   * The numbers or points passed for a parameter of a builtin function
+   * that processes arrays element-wise.  A single number or point is
+   * used for every element.
+   */
+  struct Elements {
+    /**
+     * The passed array, or nullptr if a single value was passed.
+     */
+    const Array *array = nullptr;
+
+    /**
+     * The passed single value.  A number is stored as radius.
+     */
+    Pol single;
+
+    double number(size_t index) const {
+      return this->array != nullptr ? this->array->r[index] : this->single.r;
+    }
+
+    Pol pol(size_t index) const {
+      if (this->array == nullptr) {
+        return this->single;
+      }
+
+      Pol point;
+      point.r = this->array->r[index];
+      point.phi = this->array->phi[index];
+      return point;
+    }
+  };
+
+  /**
+   * A builtin function together with its signature.
+   */
+  struct Builtin {
+    std::function<bool(Interpreter *, const ParseResult &, Arguments &,
+                       Value &)>
+        implementation;
+
+    /**
+     * The signature is taken from the known functions of the system.
+     * It determines how many arguments are interpreted before the
+     * implementation is called and which argument is evaluated lazily
+     * using the hidden variable.
+     */
+    const Func *function = nullptr;
+  };
+
+  /**
+   * The values of the arguments of a call to a pure user defined
+   * function, under which its result is remembered.  Each number or
+   * point is stored as its type followed by the bits of its
+   * coordinates, such that the key only matches identical values.
+   */
+  using MemoizationKey = std::vector<uint64_t>;
+
+  struct MemoizationKeyHash {
+    size_t operator()(const MemoizationKey &key) const {
+      uint64_t hash = 0;
+      for (uint64_t part : key) {
+        hash = (hash ^ part) * 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+      }
+      return hash;
+    }
+  };
+
   class Interpreter {
   public:
 
+    /**
+     * The maximum number of parameters that a builtin function or an
+     * initialization can have.  The arguments of these calls are
+     * stored on the stack.
+     */
+    static const int maximum_number_of_arguments = 8;
+
+    /**
+     * The maximum number of results that are remembered per pure user
+     * defined function.  When a function has more, its results are
+     * forgotten.
+     */
+    static const int maximum_number_of_memoized_results = 1 << 16;
+
     /**
      * Constructor
      */
@@ -36,7 +145,7 @@ namespace hydra {
 
     /**
      * The system knows about types and keywords, and additionally
-     * knows holds the scopes, which the interpreter needs in order to
+     * knows holds the frames, which the interpreter needs in order to
      * evaluate variables, etc.
      */
     System &system;
@@ -46,28 +155,71 @@ namespace hydra {
      */
     Canvas canvas;
 
+    /**
+     * The source of all random numbers.
+     */
+    RandomEngine random_engine;
+
+    /**
+     * Where the messages of 'print' are written to.
+     */
+    std::ostream *output = &std::cout;
+
+    /**
+     * If not empty, 'save' inserts this suffix before the extension of
+     * the file name, e.g. 'drawing_3.png' for 'drawing.png' and the
+     * suffix '_3'.  This way, runs of the same code that happen at the
+     * same time don't write to the same files.
+     */
+    std::string saved_file_suffix;
+
+    /**
+     * The number of threads that execute the iterations of parallel
+     * loops.
+     */
+    int parallel_threads = 1;
+
+    /**
+     * The threads that execute parallel loops. Created by the first
+     * parallel loop.
+     */
+    std::unique_ptr<ThreadPool> thread_pool;
+
+    /**
+     * If set, the time spent on each statement, builtin function, user
+     * defined function and export is recorded.
+     */
+    Profiler *profiler = nullptr;
+
+    /**
+     * The results of the calls of pure user defined functions (see
+     * Func::is_pure) whose arguments are numbers or points, by
+     * function and arguments.
+     */
+    std::unordered_map<
+        const Func *,
+        std::unordered_map<MemoizationKey, Value, MemoizationKeyHash>>
+        memoized_results;
+
     /**
      * Maps a Type (e.g. Assignment) to the function that is
      * responsible for interpreting ParseResults of this type.
      */
     std::unordered_map<
         Type,
-        std::function<bool(Interpreter *, const ParseResult &, std::any &)>>
+        std::function<bool(Interpreter *, const ParseResult &, Value &)>>
         known_interpretations;
 
     /**
      * Maps the function names to the corresponding implementation.
      */
-    std::unordered_map<
-        std::string,
-        std::function<bool(Interpreter *, const ParseResult &, std::any &)>>
-        builtin_functions;
+    std::unordered_map<std::string, Builtin> builtin_functions;
 
     /**
-     * Tries to cast a value to double. Returns false if the cast
-     * failed.
+     * Tries to get the number stored in a value. Returns false if the
+     * value is not a number.
      */
-    bool number_from_value(const std::any &value, double &number);
+    bool number_from_value(const Value &value, double &number);
 
     /**
      * Returns if a parse result contains an error.
@@ -77,35 +229,41 @@ namespace hydra {
     /**
      * Interprets a series of ParseResults.
      */
-    bool interpret_code(const std::vector<ParseResult> &code, std::any &result);
+    bool interpret_code(Span<const ParseResult> code, Value &result);
 
     /**
      * Interprets a parse result.  Returns false if an error occurred
      * during interpretation.  The result contains the value of the
      * interpretation.
      */
-    bool interpret_parse_result(const ParseResult &input, std::any &result);
+    bool interpret_parse_result(const ParseResult &input, Value &result);
+
+    /**
+     * Interprets a statement of the code, a loop or a function, like
+     * interpret_parse_result, and reports its line to the profiler.
+     */
+    bool interpret_statement(const ParseResult &statement, Value &result);
 
     /**
      * Interprets an assignment.  Returns false if an error occurred
      * during interpretation.  The result contains the value of the
      * interpretation.
      */
-    bool interpret_assignment(const ParseResult &input, std::any &result);
+    bool interpret_assignment(const ParseResult &input, Value &result);
 
     /**
      * Interprets a mathematical expression.  Returns false if an
      * error occurred during interpretation.  The result contains the
      * value of the interpretation.
      */
-    bool interpret_expression(const ParseResult &input, std::any &result);
+    bool interpret_expression(const ParseResult &input, Value &result);
 
     /**
      * Interprets a function.  Returns false if an error occurred
      * during interpretation.  The result contains the value of the
      * interpretation.
      */
-    bool interpret_function(const ParseResult &function_call, std::any &result);
+    bool interpret_function(const ParseResult &function_call, Value &result);
 
     /**
      * Interprets a function definition.  Returns false if an error
@@ -113,7 +271,7 @@ namespace hydra {
      * of the interpretation.
      */
     bool interpret_function_definition(const ParseResult &function_definition,
-                                       std::any &result);
+                                       Value &result);
 
     /**
      * Interprets a user defined function.  Returns false if an error
@@ -121,7 +279,17 @@ namespace hydra {
      * of the interpretation.
      */
     bool interpret_user_defined_function(const ParseResult &function_call,
-                                         std::any &result);
+                                         Value &result);
+
+    /**
+     * Determines the key under which the result of a call to a pure
+     * user defined function with the passed argument values is
+     * remembered.  Returns false if one of the values is neither a
+     * number nor a point.
+     */
+    static bool memoization_key_for_arguments(const Value *values,
+                                              int number_of_values,
+                                              MemoizationKey &key);
 
     /**
      * Interprets an initialization.  Returns false if an error
@@ -129,155 +297,278 @@ namespace hydra {
      * of the interpretation.
      */
     bool interpret_initialization(const ParseResult &initialization,
-                                  std::any &result);
+                                  Value &result);
 
     /**
      * Interprets a loop.  Returns false if an error occurred during
      * interpretation.  The result contains the value of the
      * interpretation.
      */
-    bool interpret_loop(const ParseResult &loop, std::any &result);
+    bool interpret_loop(const ParseResult &loop, Value &result);
+
+    /**
+     * Interprets a parallel loop with the passed range.  The
+     * iterations are split into consecutive parts that are executed
+     * by separate interpreters, each with a copy of the state, its own
+     * canvas and its own random numbers.  Afterwards, the canvases and
+     * the printed messages of the parts are merged in the order of the
+     * iterations.  Returns false if an error occurred in one of the
+     * iterations.
+     */
+    bool interpret_parallel_loop(const ParseResult &loop, double lower_bound,
+                                 double step_size, double upper_bound);
 
     /**
      * Interprets a number.  Returns false if an error occurred during
      * interpretation.  The result contains the value of the
      * interpretation.
      */
-    bool interpret_number(const ParseResult &input, std::any &result);
+    bool interpret_number(const ParseResult &input, Value &result);
 
     /**
      * Interprets a string.  Returns false if an error occurred during
      * interpretation.  The result contains the value of the
      * interpretation.
      */
-    bool interpret_string(const ParseResult &input, std::any &result);
+    bool interpret_string(const ParseResult &input, Value &result);
 
     /**
      * Interprets a ParseResult of unknown type.  Returns false if an
      * error occurred during interpretation.  The result contains the
      * value of the interpretation.
      */
-    bool interpret_unknown(const ParseResult &input, std::any &result);
+    bool interpret_unknown(const ParseResult &input, Value &result);
 
     /**
      * Tries to interpret a variable.  Returns false if an error
      * occurred during interpretation.  The result contains the value
      * of the interpretation.
      */
-    bool interpret_variable(const ParseResult &input, std::any &result);
+    bool interpret_variable(const ParseResult &input, Value &result);
 
     // Functions:
 
     /**
      * Given a complete function call, tries to interpret the
-     * arguments.
-     *
-     * Since some functions cannot interpret all arguments at once,
-     * the parameters_to_interpret vector can by used to define which
-     * arguments should be interpreted. By default the
-     * parameters_to_interpret vector is empty, indicating that all
-     * arguments should be interpreted.
+     * arguments and stores them at the position of their parameter.
+     * The argument that uses the hidden variable (if the function has
+     * one) is not interpreted, since it has to be interpreted once for
+     * each value of the hidden variable.
      */
-    bool interpret_arguments_from_function_call(
-        const ParseResult &function_call,
-        std::unordered_map<std::string, std::any> &arguments,
-        const std::vector<std::string> &parameters_to_interpret = {});
+    bool interpret_arguments_from_function_call(const ParseResult &function_call,
+                                                Arguments &arguments);
 
     /**
-     * Given an interpreted argument list, tries to determine the value
-     * for the passed parameter name.  Returns false if the argument
-     * value could not be obtained.  If successful, returns true and
-     * passes the result to value.
+     * Interprets the argument of the function call for the parameter
+     * at the passed position.  Returns false if the argument could not
+     * be interpreted.
      */
-    bool argument_value_for_parameter(
-        const std::string &parameter,
-        const std::unordered_map<std::string, std::any> &interpreted_arguments,
-        std::any &result);
+    bool interpret_argument(const ParseResult &function_call, int parameter,
+                            Arguments &arguments);
 
     /**
-     * Given an interpreted argument list, tries to determine the
-     * numerical value for the passed parameter name.  Returns false,
-     * if the value could not be obtained.  If successful, returns true and
-     * passes the result to value.
+     * Calls a builtin function.  The arguments of the call are
+     * interpreted before the function is executed.
      */
-    bool number_value_for_parameter(
-        const std::string &parameter,
-        const std::unordered_map<std::string, std::any> &interpreted_arguments,
-        double &value);
+    bool call_builtin_function(const Builtin &builtin,
+                               const ParseResult &function_call,
+                               Value &result);
 
     /**
-     * Given an interpreted argument list, tries to determine the
-     * Pol value for the passed parameter name.  Returns false,
-     * if the value could not be obtained.  If successful, returns true and
-     * passes the result to value.
+     * Creates the value of an initialization (e.g. 'Pol(r: 1, phi:
+     * 2)') from its interpreted arguments.
      */
-    bool pol_value_for_parameter(
-        const std::string &parameter,
-        const std::unordered_map<std::string, std::any> &interpreted_arguments,
-        Pol &value);
+    bool value_for_initialization(const ParseResult &initialization,
+                                  const Arguments &arguments, Value &result);
 
     /**
-     * Given an interpreted argument list, tries to determine the
-     * numerical value for the passed parameter name.  Returns false,
-     * if the value could not be obtained.  If successful, returns true and
-     * passes the result to value.
+     * Given the interpreted arguments, tries to determine the
+     * numerical value for the parameter at the passed position.
+     * Returns false, if the value could not be obtained.  If
+     * successful, returns true and passes the result to value.
      */
-    bool string_value_for_parameter(
-        const std::string &parameter,
-        const std::unordered_map<std::string, std::any> &interpreted_arguments,
-        std::string &str);
+    bool number_value_for_parameter(const Arguments &arguments, int parameter,
+                                    double &value);
+
+    /**
+     * Given the interpreted arguments, tries to determine the Pol
+     * value for the parameter at the passed position.  Returns false,
+     * if the value could not be obtained.  If successful, returns true
+     * and passes the result to value.
+     */
+    bool pol_value_for_parameter(const Arguments &arguments, int parameter,
+                                 Pol &value);
+
+    /**
+     * Given the interpreted arguments, tries to determine the string
+     * value for the parameter at the passed position.  Returns false,
+     * if the value could not be obtained.  If successful, returns true
+     * and passes the result to value.
+     */
+    bool string_value_for_parameter(const Arguments &arguments, int parameter,
+                                    std::string &str);
+
+    /**
+     * Like number_value_for_parameter and pol_value_for_parameter,
+     * but the parameter may also be an array of numbers or points,
+     * respectively.
+     */
+    bool number_elements_for_parameter(const Arguments &arguments,
+                                       int parameter, Elements &elements);
+    bool pol_elements_for_parameter(const Arguments &arguments, int parameter,
+                                    Elements &elements);
+
+    /**
+     * Determines the array passed for the parameter at the passed
+     * position, whose elements have to be of the passed type (or of
+     * any type, if None is passed).  Returns false if the value is not
+     * such an array.
+     */
+    bool array_for_parameter(const Arguments &arguments, int parameter,
+                             ValueType element_type, const Array *&array);
+
+    /**
+     * Determines the number of elements that a function processes,
+     * i.e., the size of the passed arrays, which have to be equal.
+     * If no array was passed, the number is 1 and is_array is false.
+     */
+    bool number_of_elements(const ParseResult &function_call,
+                            std::initializer_list<const Elements *> elements,
+                            size_t &number, bool &is_array);
+
+    /**
+     * Reports that what a function was asked to create (e.g. '1000
+     * values') does not fit into memory.  Returns false, such that the
+     * function can return the result.
+     */
+    bool report_not_enough_memory(const ParseResult &function_call,
+                                  const std::string &objects);
+
+    /**
+     * Sets the value of the hidden variable _p for the argument of the
+     * passed function call that uses it. Returns false if the hidden
+     * variable could not be set.
+     */
+    bool set_hidden_variable(const ParseResult &function_call,
+                             const Value &value);
+
+    /**
+     * Determines the value of a property of the passed value, i.e.,
+     * the coordinates of a point or a property of an object. Returns
+     * false if the property could not be found.
+     */
+    bool value_for_property(const std::string &property_name,
+                            const Value &value, Value &result);
 
     /**
      * Determines the value of a property in the passed property
      * map. Returns false if the property could not be found.
      */
     bool value_for_property(const std::string &property_name,
-                            const PropertyMap &property_map, std::any &result);
+                            const PropertyMap &property_map, Value &result);
 
     /**
      * The implementation of these functions can be found in
      * interpreter_functions.cpp
      */
-    bool function_circle(const ParseResult &function_call, std::any &result);
-    bool function_clear(const ParseResult &function_call, std::any &result);
-    bool function_cos(const ParseResult &function_call, std::any &result);
-    bool function_cosh(const ParseResult &function_call, std::any &result);
-    bool function_curve_angle(const ParseResult &function_call, std::any &result);
-    bool function_curve_distance(const ParseResult &function_call, std::any &result);
-    bool function_distance(const ParseResult &function_call, std::any &result);
-    bool function_exp(const ParseResult &function_call, std::any &result);
-    bool function_log(const ParseResult &function_call, std::any &result);
-    bool function_line(const ParseResult &function_call, std::any &result);
-    bool function_mark(const ParseResult &function_call, std::any &result);
-    bool function_print(const ParseResult &function_call, std::any &result);
-    bool function_random(const ParseResult &function_call, std::any &result);
-    bool function_rotate(const ParseResult &function_call, std::any &result);
-    bool function_save(const ParseResult &function_call, std::any &result);
-    bool function_set_resolution(const ParseResult &function_call, std::any &result);
-    bool function_sin(const ParseResult &function_call, std::any &result);
-    bool function_sinh(const ParseResult &function_call, std::any &result);
-    bool function_sqrt(const ParseResult &function_call, std::any &result);
-    bool function_theta(const ParseResult &function_call, std::any &result);
-    bool function_translate(const ParseResult &function_call, std::any &result);
+    bool function_array_element(const ParseResult &function_call,
+                                Arguments &arguments, Value &result);
+    bool function_array_size(const ParseResult &function_call,
+                             Arguments &arguments, Value &result);
+    bool function_circle(const ParseResult &function_call,
+                         Arguments &arguments, Value &result);
+    bool function_clear(const ParseResult &function_call,
+                        Arguments &arguments, Value &result);
+    bool function_cos(const ParseResult &function_call,
+                      Arguments &arguments, Value &result);
+    bool function_cosh(const ParseResult &function_call,
+                       Arguments &arguments, Value &result);
+    bool function_curve_angle(const ParseResult &function_call,
+                              Arguments &arguments, Value &result);
+    bool function_curve_distance(const ParseResult &function_call,
+                                 Arguments &arguments, Value &result);
+    bool function_distance(const ParseResult &function_call,
+                           Arguments &arguments, Value &result);
+    bool function_exp(const ParseResult &function_call,
+                      Arguments &arguments, Value &result);
+    bool function_log(const ParseResult &function_call,
+                      Arguments &arguments, Value &result);
+    bool function_line(const ParseResult &function_call,
+                       Arguments &arguments, Value &result);
+    bool function_lines(const ParseResult &function_call,
+                        Arguments &arguments, Value &result);
+    bool function_lines_within(const ParseResult &function_call,
+                               Arguments &arguments, Value &result);
+    bool function_load(const ParseResult &function_call,
+                       Arguments &arguments, Value &result);
+    bool function_mark(const ParseResult &function_call,
+                       Arguments &arguments, Value &result);
+    bool function_marks(const ParseResult &function_call,
+                        Arguments &arguments, Value &result);
+    bool function_number_array(const ParseResult &function_call,
+                               Arguments &arguments, Value &result);
+    bool function_pol_array(const ParseResult &function_call,
+                            Arguments &arguments, Value &result);
+    bool function_polyline(const ParseResult &function_call,
+                           Arguments &arguments, Value &result);
+    bool function_print(const ParseResult &function_call,
+                        Arguments &arguments, Value &result);
+    bool function_random(const ParseResult &function_call,
+                         Arguments &arguments, Value &result);
+    bool function_random_angle(const ParseResult &function_call,
+                               Arguments &arguments, Value &result);
+    bool function_random_array(const ParseResult &function_call,
+                               Arguments &arguments, Value &result);
+    bool function_random_graph(const ParseResult &function_call,
+                               Arguments &arguments, Value &result);
+    bool function_random_radius(const ParseResult &function_call,
+                                Arguments &arguments, Value &result);
+    bool function_rotate(const ParseResult &function_call,
+                         Arguments &arguments, Value &result);
+    bool function_save(const ParseResult &function_call,
+                       Arguments &arguments, Value &result);
+    bool function_seed(const ParseResult &function_call,
+                       Arguments &arguments, Value &result);
+    bool function_set_image_size(const ParseResult &function_call,
+                                 Arguments &arguments, Value &result);
+    bool function_set_precision(const ParseResult &function_call,
+                                Arguments &arguments, Value &result);
+    bool function_set_resolution(const ParseResult &function_call,
+                                 Arguments &arguments, Value &result);
+    bool function_set_simplification(const ParseResult &function_call,
+                                     Arguments &arguments, Value &result);
+    bool function_set_tolerance(const ParseResult &function_call,
+                                Arguments &arguments, Value &result);
+    bool function_set_viewport(const ParseResult &function_call,
+                               Arguments &arguments, Value &result);
+    bool function_sin(const ParseResult &function_call,
+                      Arguments &arguments, Value &result);
+    bool function_sinh(const ParseResult &function_call,
+                       Arguments &arguments, Value &result);
+    bool function_sqrt(const ParseResult &function_call,
+                       Arguments &arguments, Value &result);
+    bool function_theta(const ParseResult &function_call,
+                        Arguments &arguments, Value &result);
+    bool function_translate(const ParseResult &function_call,
+                            Arguments &arguments, Value &result);
 
     /**
      * Determines the string representation of an interpretation
      * result. Returns false if no representation could be obtained.
      */
-    bool string_representation_of_interpretation_result(const std::any &result,
+    bool string_representation_of_interpretation_result(const Value &result,
                                                         std::string &str);
 
     /**
      * Tries to find out what type the result is and cast it in order
      * to print it.
      */
-    bool print_interpretation_result(const std::any &result);
+    bool print_interpretation_result(const Value &result);
 
     /**
-     * Print scopes.
+     * Print the global variables.
      */
-    void print_scopes();
-    void print_scope_at_index(int index);
+    void print_globals();
   };
 }
 
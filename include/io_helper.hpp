@@ -16,8 +16,42 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace hydra {
+
+/**
+ * A file that is mapped into memory (read only), such that its
+ * contents can be read without copying them first.  The file stays
+ * mapped as long as the object exists.
+ */
+class MappedFile {
+ public:
+  MappedFile(const std::string &file_name);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * Whether the file could be opened and mapped.
+   */
+  bool is_open() const { return this->is_mapped; }
+
+  /**
+   * The contents of the file.
+   */
+  std::string_view contents() const {
+    return std::string_view(this->data, this->size);
+  }
+
+ private:
+  const char *data = nullptr;
+  size_t size = 0;
+  bool is_mapped = false;
+};
+
 class IOHelper {
  public:
   /**
@@ -37,6 +71,14 @@ class IOHelper {
   static void read_code_from_file(const std::string &file_name,
                                   std::vector<std::string> &code);
 
+  /**
+   * Returns the line of the text that starts at position and
+   * advances position to the start of the next line.  Returns false
+   * if the text does not contain any more lines.
+   */
+  static bool next_line_in_text(std::string_view text, size_t &position,
+                                std::string_view &line);
+
   /**
    * Converts all occurrences of the sequence '\n' to an actual new
    * line character.
@@ -0,0 +1,58 @@
+//
+//  kernels.hpp
+//  hydra
+//
+//  Vectorized operations on arrays of coordinates.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef kernels_hpp
+#define kernels_hpp
+
+#include <cstddef>
+
+namespace hydra {
+
+/**
+ * Batch operations on coordinates, which are stored in separate
+ * arrays of radii and angles.  Depending on the processor, the
+ * operations use AVX2 (x86), NEON (ARM) or plain scalar code.  The
+ * implementation is chosen once, when the first operation is
+ * performed.
+ */
+class Kernels {
+ public:
+  /**
+   * Converts the polar coordinates (r[i], phi[i]) to Euclidean
+   * coordinates, scales them and moves them by the passed offset:
+   *
+   *   x[i] = scale * r[i] * cos(phi[i]) + offset_x
+   *   y[i] = scale * r[i] * sin(phi[i]) + offset_y
+   *
+   * This is equivalent to converting the points using Euc(point,
+   * scale) and adding the offset afterwards.
+   */
+  static void polar_to_euclidean(const double *r, const double *phi,
+                                 size_t size, double scale, double offset_x,
+                                 double offset_y, double *x, double *y);
+
+  /**
+   * Returns the maximum of the values and the passed initial value.
+   * NaNs are ignored.
+   */
+  static double maximum(const double *values, size_t size,
+                        double initial = 0.0);
+
+  /**
+   * The name of the instruction set that is used ("avx2", "neon" or
+   * "scalar").
+   */
+  static const char *instruction_set();
+};
+
+}  // namespace hydra
+
+#endif /* kernels_hpp */
@@ -16,6 +16,7 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -25,20 +26,35 @@
 
 namespace hydra {
 
+struct Token;
+
 /**
- * Tokens are used to determine the different parts of a string.
+ * A sequence of consecutive tokens, e.g., the tokens on the right
+ * hand side of an assignment.  Parsers work on ranges, such that
+ * parts of a tokenized string don't have to be copied.
+ */
+typedef Span<const Token> TokenRange;
+
+/**
+ * Tokens are used to determine the different parts of a string.  The
+ * value of a token refers to the string that was tokenized, which
+ * therefore has to outlive the token.
  */
 struct Token {
   Token() {}
-  Token(const std::string &value) { this->value = value; }
-  Token(const std::string &value, Type type) {
-    this->value = value;
-    this->type = type;
-  }
+  Token(std::string_view value, Type type = Unknown, int position = -1)
+      : value(value), type(type), position(position) {}
 
-  std::string value = "";
+  std::string_view value;
   Type type = Unknown;
-  std::vector<Token> children = {};
+
+  /**
+   * The index of the first character of the token in the tokenized
+   * string, which is used in error messages.
+   */
+  int position = -1;
+
+  TokenRange children;
 };
 
 class Lexer {
@@ -57,7 +73,7 @@ class Lexer {
    */
   std::unordered_map<
       Type,
-      std::function<bool(Lexer *, const std::vector<Token> &, ParseResult &)>>
+      std::function<bool(Lexer *, TokenRange, ParseResult &)>>
       known_parsers;
 
   /**
@@ -69,50 +85,43 @@ class Lexer {
                                    const std::string &delimiters);
 
   /**
-   * Cleans a string by removing leading and trailing white spaces as
-   * well as comments.
+   * Returns the part of the string that remains after removing
+   * leading and trailing white spaces as well as comments.
    */
-  static void clean_string(std::string &str);
+  static std::string_view cleaned_string(std::string_view str);
 
   /**
    * Determines whether a string consists of white spaces only.
    */
-  static bool is_string_empty(std::string &str);
+  static bool is_string_empty(std::string_view str);
 
   /**
-   * Finds the matching bracket to the one specified, starting from the position and
-   * returns its index.  If the matching bracket was not found,
-   * std::string::npos is returned.
-   *
-   * We explicitly specify the opening bracket as there are cases,
-   * where this is NOT the one that is at the passed position.
+   * Determines the matching closing bracket of each '(' and '[' in the
+   * string in a single pass.  Afterwards, matching_brackets[i] is the
+   * position of the bracket that closes the one at position i, or -1
+   * if the character at position i is not an opening bracket or the
+   * bracket is not closed.
    */
-  static int position_of_matching_bracket_for_position(
-      const std::string &str, const char opening_bracket, int position);
+  static void find_matching_brackets(std::string_view str,
+                                     std::vector<int> &matching_brackets);
 
   /**
-   * Finds the matching '"' to the one at the specified position and
-   * returns its index.  If the matching quote was not found,
-   * std::string::npos is returned.
+   * Determines the tokens in a string.  The values of the tokens
+   * refer to the passed string.  The tokens are valid until the next
+   * string is tokenized.
    */
-  static int position_of_matching_quote_for_position(const std::string &str,
-                                                     int position);
-
-  /**
-   * Determines the tokens in a string.
-   */
-  bool tokenize_string(const std::string &str, std::vector<Token> &tokens);
+  bool tokenize_string(std::string_view str, TokenRange &tokens);
 
   /**
    * Determines the type of a string.
    */
-  Type type_of_string(const std::string &str);
+  Type type_of_string(std::string_view str);
 
   /**
    * Parses a tokenized string and tries to understand what it does. E.g.:
    * does this code represent an Assignment or a Function call, etc.
    */
-  Type type_of_tokenized_string(const std::vector<Token> &tokenized_string);
+  Type type_of_tokenized_string(TokenRange tokenized_string);
 
   /**
    * Parses lines of code.
@@ -120,6 +129,22 @@ class Lexer {
   bool parse_code(const std::vector<std::string> &code,
                   std::vector<ParseResult> &parsed_code);
 
+  /**
+   * Parses the lines returned by next_line, until it returns
+   * nullptr.  Each top level statement is passed to
+   * statement_parsed as soon as it is complete, i.e., loops and
+   * function definitions once their closing brace was parsed.  If
+   * statement_parsed returns false, parsing stops.
+   *
+   * The statements are not resolved (see Resolver).  The line
+   * numbers start after first_line, e.g., when only the end of a file
+   * is parsed.
+   */
+  bool parse_lines(
+      const std::function<const std::string *()> &next_line,
+      const std::function<bool(const ParseResult &)> &statement_parsed,
+      int first_line = 0);
+
   /**
    * Parses a line of code.
    */
@@ -128,74 +153,74 @@ class Lexer {
   /**
    * Parses a tokenized string.
    */
-  bool parse_tokens(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_tokens(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses the parameter list of a function call or initialization.
    */
-  bool parse_argument_list(const std::vector<Token> &tokens,
+  bool parse_argument_list(TokenRange tokens,
                            const std::vector<std::string> &expected_arguments,
                            ParseResult &result);
 
   /**
    * Parses a string that represents an assignment.
    */
-  bool parse_assignment(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_assignment(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents an expression.  If the parsed
    * string is not an expression, the result will have type Error.
    */
-  bool parse_expression(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_expression(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents a function.  If the parsed string
    * is not a function call, the result will have type Error.
    */
-  bool parse_function(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_function(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents a function definition (for user
    * defined functions).  If the parsed string is not a function
    * definition, the result will have type Error.
    */
-  bool parse_function_definition(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_function_definition(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents an initialization.  If the parsed string
    * is not an initialization, the result will have type Error.
    */
-  bool parse_initialization(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_initialization(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents the definition of a for-loop.  If
    * the parsed string is not a for-loop, the result will have type
    * Error.
    */
-  bool parse_loop(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_loop(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents a number.  If the parsed string
    * is not a number, the result will have type Error.
    */
-  bool parse_number(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_number(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents a brace.  If the parsed
    * string is not a brace, the result will have type Error.
    */
-  bool parse_brace(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_brace(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents a range.  If the parsed string
    * is not a number, the result will have type Error.
    */
-  bool parse_range(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_range(TokenRange tokens, ParseResult &result);
 
   /**
    * Parses a string that represents a string.
    */
-  bool parse_string_token(const std::vector<Token> &tokens, ParseResult &result);
+  bool parse_string_token(TokenRange tokens, ParseResult &result);
 
   /**
    * Recursively prints the passed parse result.
@@ -206,8 +231,85 @@ class Lexer {
   /**
    * Recursively prints the passed tokenized string.
    */
-  static void print_tokenized_string(const std::vector<Token> &tokenized_string,
+  static void print_tokenized_string(TokenRange tokenized_string,
                                      const std::string &indentation = "");
+
+  /**
+   * Releases all parse results, which must not be used anymore
+   * afterwards.  The memory is kept to be reused.
+   */
+  void reset();
+
+ private:
+  /**
+   * The values and children of the parse results.  The arena lives as
+   * long as the lexer, since the statements of user defined functions
+   * are kept by the system.
+   */
+  Arena arena;
+
+  /**
+   * The children of the tokens of the current string.  Tokens are
+   * only needed while parsing a string, so this arena is cleared
+   * whenever a new string is tokenized.
+   */
+  Arena token_arena;
+
+  /**
+   * The tokens and parse results whose parents are not complete, yet.
+   * Once all children of a parent are known, they are moved to the
+   * corresponding arena in one piece.  This way, building the trees
+   * does not require a vector for each node.
+   */
+  std::vector<Token> pending_tokens;
+  std::vector<ParseResult> pending_results;
+
+  /**
+   * Collects the children of a parse result in pending_results.  If
+   * the children are not moved to the parse result, e.g., since an
+   * error occurred, they are discarded when the collection is
+   * destroyed.
+   */
+  class Children {
+   public:
+    Children(Lexer &lexer)
+        : lexer(lexer), first(lexer.pending_results.size()) {}
+    ~Children() {
+      if (this->lexer.pending_results.size() > this->first) {
+        this->lexer.pending_results.resize(this->first);
+      }
+    }
+
+    void push_back(const ParseResult &child) {
+      this->lexer.pending_results.push_back(child);
+    }
+
+    /**
+     * Moves the collected children to the arena and makes them the
+     * children of the passed parse result.  Collections that were
+     * created later must have been moved before.
+     */
+    void move_to(ParseResult &result);
+
+   private:
+    Lexer &lexer;
+    size_t first;
+  };
+
+  /**
+   * Determines the tokens in the part [begin, end) of the string,
+   * using the precomputed positions of the matching brackets.
+   */
+  bool tokenize_range(std::string_view str,
+                      const std::vector<int> &matching_brackets, int begin,
+                      int end, TokenRange &tokens);
+
+  /**
+   * Moves the pending tokens or results from the passed index on to
+   * the corresponding arena.
+   */
+  TokenRange move_pending_tokens(size_t first);
+  Span<ParseResult> move_pending_results(size_t first);
 };
 }  // namespace hydra
 
@@ -0,0 +1,124 @@
+//
+//  optimizer.hpp
+//  hydra
+//
+//  Simplifies resolved hydra code before it is executed.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef optimizer_hpp
+#define optimizer_hpp
+
+#include <unordered_set>
+#include <vector>
+
+#include <system.hpp>
+
+namespace hydra {
+
+/**
+ * The optimizer annotates resolved code, such that values that don't
+ * change are not computed again and again:
+ *
+ * Numbers and expressions that only consist of numbers (e.g. '2 *
+ * M_PI') are folded to their value (see ParseResult::is_constant).
+ *
+ * Calls of pure functions (see Func::is_pure) in a loop, whose
+ * arguments don't change while the loop is running, are hoisted out
+ * of the loop.  The call is evaluated when it is reached for the
+ * first time in a run of the loop and its value is kept in a slot of
+ * the frame the loop is in (see ParseResult::number_of_hoisted_calls).
+ * Calls are hoisted out of the outermost loop possible.
+ *
+ * The annotations are computed from scratch, so code can be optimized
+ * again after it was resolved again, e.g. with another system.
+ */
+class Optimizer {
+ public:
+  /**
+   * Constructor
+   */
+  Optimizer(System &system);
+
+  /**
+   * The system knows which functions are pure and how many slots the
+   * frames of the user defined functions need.
+   */
+  System &system;
+
+  /**
+   * Optimizes the passed code, whose top level frame needs the passed
+   * number of slots.  Afterwards, the top level frame is large enough
+   * to also hold the values of the hoisted calls.
+   */
+  void optimize_code(std::vector<ParseResult> &code,
+                     int number_of_top_level_slots);
+
+ private:
+  /**
+   * What the statements in a loop change.
+   */
+  struct LoopEffects {
+    /**
+     * The slots of the variables that are defined in or assigned to in
+     * the loop, including the loop variables.
+     */
+    std::unordered_set<int> local_slots;
+    std::unordered_set<int> global_slots;
+
+    /**
+     * Whether the loop calls functions that may assign to global
+     * variables or assigns to variables that were not resolved.
+     */
+    bool changes_globals = false;
+  };
+
+  /**
+   * The number of slots of the frame that is currently being
+   * optimized, which grows with each hoisted call.
+   */
+  int number_of_slots = 0;
+
+  /**
+   * Determines whether the passed parse result and each of its
+   * descendants is constant and folds them.
+   */
+  void fold_constants(ParseResult &input);
+
+  /**
+   * Hoists the calls in all loops within the passed parse result.
+   */
+  void hoist_calls(ParseResult &input);
+  void hoist_calls_in_function_definition(ParseResult &function_definition);
+  void hoist_calls_in_loop(ParseResult &loop);
+
+  /**
+   * Hoists the calls within the passed parse result that don't depend
+   * on what the loop changes, assigning them the next free slots.
+   */
+  void hoist_invariant_calls(ParseResult &input, const LoopEffects &effects);
+
+  /**
+   * Collects what the passed parse result changes when it is executed.
+   */
+  void collect_effects(const ParseResult &input, LoopEffects &effects) const;
+
+  /**
+   * Whether the value of the passed parse result does not change
+   * while the loop with the passed effects is running.
+   */
+  bool is_loop_invariant(const ParseResult &input,
+                         const LoopEffects &effects) const;
+
+  /**
+   * Whether the function with the passed name is known to be pure.
+   */
+  bool is_pure_function(const ParseResult &function_call) const;
+};
+
+}  // namespace hydra
+
+#endif /* optimizer_hpp */
@@ -0,0 +1,84 @@
+//
+//  output_sink.hpp
+//  hydra
+//
+//  A buffered sink that is used to write canvas files.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef output_sink_hpp
+#define output_sink_hpp
+
+#include <ostream>
+#include <string>
+
+namespace hydra {
+
+/**
+ * Collects text in a buffer and writes it to a stream whenever the
+ * buffer is full.  If there is no stream, the sink simply collects
+ * everything in its buffer.
+ *
+ * Numbers are written with a fixed number of decimal places, which
+ * by default matches the output of std::to_string.
+ */
+class OutputSink {
+ public:
+  /**
+   * The number of bytes that are collected before they are written
+   * to the stream.
+   */
+  static const size_t buffer_capacity = 1 << 16;
+
+  /**
+   * The maximum number of decimal places.  Beyond that, the
+   * additional digits carry no information.
+   */
+  static const int maximum_precision = 17;
+
+  /**
+   * Constructor
+   */
+  OutputSink(std::ostream *stream = nullptr, int precision = 6);
+
+  /**
+   * Writes the remaining contents of the buffer to the stream.
+   */
+  ~OutputSink();
+
+  /**
+   * The text that was not yet written to the stream.
+   */
+  std::string buffer;
+
+  /**
+   * The number of decimal places of written numbers.
+   */
+  int precision;
+
+  OutputSink &operator<<(const char *str);
+  OutputSink &operator<<(const std::string &str);
+  OutputSink &operator<<(char character);
+  OutputSink &operator<<(double number);
+
+  /**
+   * Writes the contents of the buffer to the stream.  Does nothing if
+   * there is no stream.
+   */
+  void flush();
+
+ private:
+  std::ostream *stream;
+
+  /**
+   * Writes the buffer to the stream, if it is full.
+   */
+  void flush_if_full();
+};
+
+}  // namespace hydra
+
+#endif /* output_sink_hpp */
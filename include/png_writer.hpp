@@ -0,0 +1,40 @@
+//
+//  png_writer.hpp
+//  hydra
+//
+//  Encodes raster images as PNG files.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef png_writer_hpp
+#define png_writer_hpp
+
+#include <cstdint>
+#include <iostream>
+
+namespace hydra {
+
+/**
+ * Writes 8 bit grayscale images in the PNG format, without depending
+ * on zlib.  The image data is compressed using fixed Huffman codes
+ * and run-lengths only (i.e., references to the preceding byte),
+ * which is fast and works well for drawings, since most of their
+ * pixels are part of long runs of white.
+ */
+class PNGWriter {
+ public:
+  /**
+   * Writes the image with the passed size to the stream.  The pixels
+   * are stored row by row, from top to bottom, and each pixel is a
+   * brightness between 0 (black) and 255 (white).
+   */
+  static void write_grayscale(std::ostream &stream, int width, int height,
+                              const uint8_t *pixels);
+};
+
+}  // namespace hydra
+
+#endif /* png_writer_hpp */
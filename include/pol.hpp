@@ -14,8 +14,12 @@
 #ifndef pol_hpp
 #define pol_hpp
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 namespace hydra {
 
@@ -30,8 +34,16 @@ public:
   double r = 0.0;
   double phi = 0.0;
 
+  /**
+   * The angle is normalized to be between 0 and 2pi.
+   */
   Pol(double r, double phi);
-  Pol(const Pol &p);
+
+  /**
+   * Copies are not normalized again, since the original already is.
+   */
+  Pol(const Pol &p) = default;
+  Pol &operator=(const Pol &p) = default;
 
   friend std::ostream &operator<<(std::ostream &os, const Pol &p) {
     return os << p.to_string();
@@ -57,6 +69,83 @@ private:
    */
   void normalize_phi();
 };
+
+/**
+ * A point together with cosh and sinh of its radius and cos and sin
+ * of its angle.  They are computed once, such that the distance to
+ * other cached points only takes a few multiplications, which pays
+ * off when a point is compared to many others.  Since cosh is
+ * increasing, comparing distances does not even need acosh, when the
+ * cosh of the distance to compare with is computed once as well.
+ */
+class CachedPol {
+ public:
+  CachedPol() {}
+
+  explicit CachedPol(const Pol &point)
+      : point(point),
+        cosh_r(cosh(point.r)),
+        sinh_r(sinh(point.r)),
+        cos_phi(cos(point.phi)),
+        sin_phi(sin(point.phi)) {}
+
+  Pol point;
+  double cosh_r = 1.0;
+  double sinh_r = 0.0;
+  double cos_phi = 1.0;
+  double sin_phi = 0.0;
+
+  /**
+   * The cosh of the distance to the other point, i.e.,
+   *
+   *   cosh(r) cosh(r') - sinh(r) sinh(r') cos(phi - phi'),
+   *
+   * where cos(phi - phi') = cos(phi) cos(phi') + sin(phi) sin(phi').
+   */
+  double cosh_distance_to(const CachedPol &other) const {
+    return this->cosh_r * other.cosh_r -
+           this->sinh_r * other.sinh_r *
+               (this->cos_phi * other.cos_phi + this->sin_phi * other.sin_phi);
+  }
+
+  double distance_to(const CachedPol &other) const {
+    return acosh(std::max(1.0, cosh_distance_to(other)));
+  }
+
+  /**
+   * The distance to a point that is not cached, which only needs the
+   * hyperbolic functions of the other point.
+   */
+  double distance_to(const Pol &other) const {
+    const double cosh_distance =
+        this->cosh_r * cosh(other.r) -
+        this->sinh_r * sinh(other.r) * cos(this->point.phi - other.phi);
+    return acosh(std::max(1.0, cosh_distance));
+  }
+
+  /**
+   * Whether the distance to the other point is at most the distance
+   * whose cosh is passed.
+   */
+  bool is_within(const CachedPol &other, double cosh_distance) const {
+    return cosh_distance_to(other) <= cosh_distance;
+  }
+
+  /**
+   * Computes the distances between the point and each of the passed
+   * points, given by their coordinates.
+   */
+  static void distances(const CachedPol &from, const double *r,
+                        const double *phi, size_t size, double *distances);
+
+  /**
+   * Appends all pairs (i, j) with i < j of the passed points, whose
+   * distance is at most the passed distance.
+   */
+  static void pairs_within(const std::vector<CachedPol> &points,
+                           double distance,
+                           std::vector<std::pair<int, int>> &pairs);
+};
 }  // namespace hydra
 
 #endif /* pol_hpp */
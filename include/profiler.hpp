@@ -0,0 +1,160 @@
+//
+//  profiler.hpp
+//  hydra
+//
+//  Measures where the time of a run is spent.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef profiler_hpp
+#define profiler_hpp
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hydra {
+
+/**
+ * Records how often and for how long lines of code, builtin
+ * functions, user defined functions and exports are executed.  The
+ * interpreter reports when it enters and leaves them, which forms a
+ * stack.  For each entry, the profiler sums the inclusive time (from
+ * entering to leaving) and the exclusive time (the inclusive time
+ * minus the time spent in entries that were entered in between).
+ * Additionally, the exclusive time is recorded per stack, which can
+ * be written as folded stacks that flame graph tools understand.
+ *
+ * The profiler is not thread safe.  The iterations of parallel loops
+ * are not profiled individually, only the loop as a whole.
+ */
+class Profiler {
+ public:
+  enum class Kind { Line, Builtin, Function, Export };
+
+  Profiler();
+
+  /**
+   * Enters the statement in the passed line.
+   */
+  void enter_line(int line_number);
+
+  /**
+   * Enters the builtin, user defined function or export with the
+   * passed name.
+   */
+  void enter(Kind kind, std::string_view name);
+
+  /**
+   * Leaves the entry that was entered last.
+   */
+  void leave();
+
+  /**
+   * Prints the entries with the largest exclusive time, at most the
+   * passed number.
+   */
+  void print_hotspots(std::ostream &stream, int number_of_rows) const;
+
+  /**
+   * Writes the exclusive time of each stack in microseconds, in the
+   * folded format of flame graph tools, e.g. 'line:3;builtin:line 1200'.
+   * Returns false if the file could not be written.
+   */
+  bool write_folded_stacks(const std::string &file_name) const;
+
+  /**
+   * Enters an entry when created and leaves it when destroyed, unless
+   * the profiler is null.
+   */
+  class Scope {
+   public:
+    Scope(Profiler *profiler, int line_number) : profiler(profiler) {
+      if (profiler != nullptr) {
+        profiler->enter_line(line_number);
+      }
+    }
+
+    Scope(Profiler *profiler, Kind kind, std::string_view name)
+        : profiler(profiler) {
+      if (profiler != nullptr) {
+        profiler->enter(kind, name);
+      }
+    }
+
+    ~Scope() {
+      if (this->profiler != nullptr) {
+        this->profiler->leave();
+      }
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    Profiler *const profiler;
+  };
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    Kind kind;
+    std::string name;
+    long long calls = 0;
+    double inclusive_seconds = 0.0;
+    double exclusive_seconds = 0.0;
+
+    /**
+     * How often the entry is on the stack.  For recursive calls, only
+     * the outermost one adds to the inclusive time.
+     */
+    int active = 0;
+  };
+
+  /**
+   * A node in the tree of all stacks that occurred.
+   */
+  struct Stack {
+    int parent;
+    int entry;
+    double exclusive_seconds = 0.0;
+  };
+
+  struct Frame {
+    int entry;
+    int stack;
+    Clock::time_point start;
+    double child_seconds = 0.0;
+  };
+
+  Clock::time_point start;
+
+  std::vector<Entry> entries;
+  std::vector<int> entries_for_lines;
+
+  /**
+   * The entries of each kind (except lines) by name.
+   */
+  std::map<std::string, int, std::less<>> entries_for_names[4];
+
+  std::vector<Stack> stacks;
+  std::map<std::pair<int, int>, int> stacks_for_children;
+
+  std::vector<Frame> frames;
+
+  void enter_entry(int entry);
+
+  static std::string name_of_kind(Kind kind);
+};
+
+}  // namespace hydra
+
+#endif /* profiler_hpp */
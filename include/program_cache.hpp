@@ -0,0 +1,88 @@
+//
+//  program_cache.hpp
+//  hydra
+//
+//  Stores parsed code in a binary file, such that it does not have
+//  to be parsed again.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef program_cache_hpp
+#define program_cache_hpp
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <io_helper.hpp>
+#include <system.hpp>
+
+namespace hydra {
+
+/**
+ * A precompiled program (.hydrac) holds the parse results of a hydra
+ * file, together with the hash of the code they were parsed from and
+ * the build of hydra that parsed them.  If either differs, the cache
+ * is stale and the code has to be parsed again.
+ *
+ * The parse results are stored unresolved, so they have to be passed
+ * to the Resolver after loading, just like with freshly parsed code.
+ * The numbers are stored with the byte order of the machine that
+ * wrote the file.
+ */
+class ProgramCache {
+ public:
+  /**
+   * Increased whenever the layout of the file or the parse results
+   * change.
+   */
+  static const uint32_t format_version = 1;
+
+  /**
+   * The name of the cache file for the hydra file with the passed
+   * name, e.g. 'code.hydrac' for 'code.hydra'.
+   */
+  static std::string file_name_for_code(const std::string &file_name);
+
+  /**
+   * The hash that identifies the code in the cache.
+   */
+  static uint64_t hash_of_code(std::string_view code);
+
+  /**
+   * Writes the passed parse results to a cache file.  Returns false
+   * if the file could not be written.
+   */
+  static bool save(const std::string &file_name, uint64_t code_hash,
+                   const std::vector<ParseResult> &code);
+
+  /**
+   * Loads the parse results from a cache file.  Returns false if
+   * the file does not exist, is stale or is corrupt.  The parse results refer to
+   * the memory of the cache, so they are only valid as long as the
+   * cache exists and until the next file is loaded.
+   */
+  bool load(const std::string &file_name, uint64_t code_hash,
+            std::vector<ParseResult> &code);
+
+ private:
+  /**
+   * The values of the parse results refer to the mapped file.
+   */
+  std::unique_ptr<MappedFile> file;
+
+  /**
+   * All loaded parse results.  The children of each result are
+   * stored consecutively.
+   */
+  std::vector<ParseResult> results;
+};
+
+}  // namespace hydra
+
+#endif /* program_cache_hpp */
@@ -0,0 +1,108 @@
+//
+//  random_engine.hpp
+//  hydra
+//
+//  The source of random numbers of the interpreter.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef random_engine_hpp
+#define random_engine_hpp
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+namespace hydra {
+
+/**
+ * A seedable pseudo random number generator.  All random numbers of
+ * one interpreter are drawn from the same engine, such that the
+ * numbers of a run are determined by the seed.  The conversion from
+ * the raw numbers to doubles does not depend on the standard library,
+ * so a seed yields the same numbers on all platforms.
+ */
+class RandomEngine {
+ public:
+  /**
+   * Creates an engine with a random seed.
+   */
+  RandomEngine();
+
+  /**
+   * Restarts the sequence of random numbers from the passed seed.
+   */
+  void seed(uint64_t seed);
+
+  /**
+   * Starts one of several independent sequences that belong to the
+   * same seed.  Used to give each part of a parallel loop its own
+   * random numbers.
+   */
+  void seed(uint64_t seed, uint64_t stream);
+
+  /**
+   * A raw random number, which can be used as seed for other engines.
+   */
+  uint64_t bits() { return this->engine(); }
+
+  /**
+   * A number drawn uniformly at random from [0, 1).
+   */
+  double uniform() {
+    return (this->engine() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  /**
+   * A number drawn uniformly at random from [from, to).
+   */
+  double uniform(double from, double to) {
+    return from + (to - from) * uniform();
+  }
+
+  /**
+   * An angle drawn uniformly at random from [0, 2pi).
+   */
+  double angle() { return uniform(0.0, 2.0 * M_PI); }
+
+  /**
+   * A radius between 0 and R drawn from the density
+   *
+   *   alpha * sinh(alpha * r) / (cosh(alpha * R) - 1).
+   *
+   * For alpha = 1 the resulting points are distributed uniformly in
+   * the hyperbolic disk of radius R.  Smaller values of alpha move
+   * the points closer to the origin.
+   */
+  double radius(double R, double alpha) {
+    return radius_from_uniform(uniform(), R, alpha);
+  }
+
+  /**
+   * Fill the passed arrays with count many samples of the
+   * corresponding distribution.
+   */
+  void fill_uniform(double from, double to, double *values, size_t count);
+  void fill_angles(double *values, size_t count);
+  void fill_radii(double R, double alpha, double *values, size_t count);
+
+ private:
+  std::mt19937_64 engine;
+
+  /**
+   * Transforms a uniform sample from [0, 1) to a sample from the
+   * radial distribution (by inverting its cumulative distribution
+   * function).
+   */
+  static double radius_from_uniform(double uniform, double R, double alpha) {
+    return acosh(1.0 + (cosh(alpha * R) - 1.0) * uniform) / alpha;
+  }
+};
+
+}  // namespace hydra
+
+#endif /* random_engine_hpp */
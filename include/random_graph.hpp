@@ -0,0 +1,143 @@
+//
+//  random_graph.hpp
+//  hydra
+//
+//  Generates hyperbolic random graphs.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef random_graph_hpp
+#define random_graph_hpp
+
+#include <pol.hpp>
+#include <random_engine.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace hydra {
+
+/**
+ * A hyperbolic random graph.  The n vertices are points in the
+ * hyperbolic disk of radius R, whose angles are drawn uniformly and
+ * whose radii are drawn from the radial distribution with parameter
+ * alpha (see RandomEngine::radius).
+ *
+ * For temperature T = 0 two vertices are adjacent if their distance is
+ * at most R.  For T > 0 two vertices at distance d are adjacent with
+ * probability
+ *
+ *   1 / (1 + exp((d - R) / (2T))).
+ *
+ * Instead of considering all pairs of vertices, the disk is divided
+ * into concentric bands in which the vertices are sorted by angle.
+ * The neighbors of a vertex in a band can then only be among the
+ * vertices whose angular distance is at most theta(r, r_band, R),
+ * where r_band is the inner radius of the band.  For T > 0, the
+ * remaining angles are split into segments of growing width.  Within
+ * a segment the candidates are visited using geometric jumps, based on
+ * an upper bound on the connection probability in that segment.
+ */
+class RandomGraph {
+ public:
+  RandomGraph(int n, double R, double alpha, double T)
+      : n(n), R(R), alpha(alpha), T(T) {}
+
+  int n;
+  double R;
+  double alpha;
+  double T;
+
+  /**
+   * The vertices, indexed in the order in which they were sampled.
+   */
+  std::vector<Pol> points;
+
+  /**
+   * The edges, as pairs of vertex indices.
+   */
+  std::vector<std::pair<int, int>> edges;
+
+  /**
+   * Samples the vertices and the edges using the passed engine.
+   */
+  void generate(RandomEngine &engine);
+
+ private:
+  /**
+   * A ring of the disk. The vertices in the band are sorted by angle.
+   */
+  struct Band {
+    double inner_radius = 0.0;
+    double outer_radius = 0.0;
+    std::vector<int> vertices;
+    std::vector<double> angles;
+  };
+
+  std::vector<Band> bands;
+
+  /**
+   * The band of each vertex and its position within that band.  A pair
+   * of vertices is only considered by the vertex that comes first in
+   * this order, such that each pair is decided exactly once.
+   */
+  std::vector<int> band_of_vertex;
+  std::vector<int> position_in_band;
+
+  /**
+   * The points with the hyperbolic and trigonometric functions of
+   * their coordinates, which are needed for every distance
+   * computation.
+   */
+  std::vector<CachedPol> cached_points;
+
+  /**
+   * A range [begin, end) of positions in a band.
+   */
+  typedef std::pair<int, int> Range;
+
+  void sample_points(RandomEngine &engine);
+  void build_bands();
+
+  /**
+   * Adds the edges between the vertex u and the vertices in the band
+   * that come after u.
+   */
+  void add_threshold_edges(int u, const Band &band);
+  void add_probabilistic_edges(int u, const Band &band,
+                               RandomEngine &engine);
+
+  /**
+   * Adds the position ranges of the vertices in the band, whose angles
+   * lie in [from, to), to the passed ranges. The width of the interval
+   * must not exceed 2pi.
+   */
+  static void append_ranges(const Band &band, double from, double to,
+                            std::vector<Range> &ranges);
+
+  /**
+   * Whether the pair (u, v) is decided when considering the neighbors
+   * of u.
+   */
+  bool comes_before(int u, int v) const;
+
+  /**
+   * cosh of the distance between the vertices u and v.
+   */
+  double cosh_distance(int u, int v) const;
+
+  /**
+   * The smallest distance between the vertex u and a point in the
+   * band, whose angular distance to u is at least the passed angle.
+   */
+  double minimum_distance(int u, const Band &band, double angle) const;
+
+  double connection_probability(double distance) const;
+};
+
+}  // namespace hydra
+
+#endif /* random_graph_hpp */
@@ -0,0 +1,96 @@
+//
+//  rasterizer.hpp
+//  hydra
+//
+//  Draws strokes into a grayscale image.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef rasterizer_hpp
+#define rasterizer_hpp
+
+#include <cstdint>
+#include <vector>
+
+#include <thread_pool.hpp>
+
+namespace hydra {
+
+/**
+ * A black shape in pixel coordinates: all points whose distance to
+ * the segment from (x0, y0) to (x1, y1) lies between the inner and
+ * the outer radius.  A segment of a path with width w has the radii
+ * -w/2 and w/2, a filled mark is a segment of length 0 and an empty
+ * mark is a segment of length 0 whose inner radius is positive.
+ */
+struct Stroke {
+  double x0;
+  double y0;
+  double x1;
+  double y1;
+  double inner_radius;
+  double outer_radius;
+};
+
+/**
+ * Draws strokes into a white image with anti-aliasing.  The image is
+ * split into square tiles.  The strokes are drawn in batches: first,
+ * each batch of strokes is sorted into the tiles (binned) that the
+ * strokes touch, then the tiles are drawn, both in parallel.  Since
+ * the tiles don't overlap, the threads never write to the same
+ * pixels.
+ *
+ * A pixel that is covered by multiple strokes takes the darkest of
+ * their shades, so the result does not depend on the order in which
+ * the strokes are drawn or on the number of threads.
+ */
+class Rasterizer {
+ public:
+  /**
+   * The width and height of a tile in pixels.
+   */
+  static const int tile_size = 64;
+
+  Rasterizer(int width, int height, ThreadPool &thread_pool);
+
+  const int width;
+  const int height;
+
+  /**
+   * The brightness of the pixels, row by row, from 0 (black) to 255
+   * (white).
+   */
+  std::vector<uint8_t> pixels;
+
+  /**
+   * Draws the strokes of all passed batches.  Each batch is binned by
+   * its own thread, so there should be about as many batches as the
+   * thread pool has threads.
+   */
+  void draw(const std::vector<std::vector<Stroke>> &batches);
+
+ private:
+  ThreadPool &thread_pool;
+
+  int columns_of_tiles;
+  int rows_of_tiles;
+
+  /**
+   * The indices of the strokes of each batch that touch each tile.
+   * The lists are kept between calls to draw, such that their memory
+   * can be reused.
+   */
+  std::vector<std::vector<std::vector<uint32_t>>> bins;
+
+  void bin(const std::vector<Stroke> &strokes,
+           std::vector<std::vector<uint32_t>> &bins) const;
+
+  void draw_tile(int tile, const std::vector<std::vector<Stroke>> &batches);
+};
+
+}  // namespace hydra
+
+#endif /* rasterizer_hpp */
@@ -0,0 +1,145 @@
+//
+//  resolver.hpp
+//  hydra
+//
+//  Resolves the variables in parsed hydra code to slots in frames.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef resolver_hpp
+#define resolver_hpp
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <system.hpp>
+
+namespace hydra {
+
+/**
+ * The resolver assigns each variable a fixed slot, either in the
+ * global frame or in the local frame of the function it is defined
+ * in.  Loops do not get frames of their own. Instead, the variables
+ * defined in a loop get slots in the frame that the loop is in.
+ *
+ * Functions only see their own variables and the global variables.
+ *
+ * The iterations of parallel loops must not depend on each other.
+ * Therefore, the resolver rejects parallel loops that assign to
+ * variables defined outside the loop, define functions or call
+ * functions that change shared state.
+ *
+ * Once the code is resolved, it is passed to the Optimizer.
+ */
+class Resolver {
+ public:
+  /**
+   * Constructor
+   */
+  Resolver(System &system);
+
+  /**
+   * The system holds the state with the global frame, as well as
+   * the known functions.
+   */
+  System &system;
+
+  /**
+   * Resolves the variables of all passed ParseResults.  Returns false
+   * if an error occurred, e.g., when a variable was defined twice in
+   * the same scope.
+   */
+  bool resolve_code(std::vector<ParseResult> &code);
+
+ private:
+  /**
+   * The scopes of the frame that is currently being resolved. Each
+   * maps the names of the variables defined in that scope to their
+   * slots.  At the top level, the first scope represents the global
+   * variables, whose slots are stored in the state instead.
+   */
+  std::vector<std::unordered_map<std::string, int>> scopes;
+
+  /**
+   * Whether we're resolving the body of a function.
+   */
+  bool is_in_function = false;
+
+  /**
+   * The next free slot in the current frame and the number of slots
+   * that the frame needs.
+   */
+  int next_free_slot = 0;
+  int number_of_slots = 0;
+
+  /**
+   * The names of the global variables and functions defined in the
+   * code that is currently being resolved.
+   */
+  std::unordered_set<std::string> defined_globals;
+  std::unordered_set<std::string> defined_functions;
+
+  /**
+   * The scope of the innermost parallel loop that is currently being
+   * resolved, or -1 if there is none.  Within the loop, only the
+   * variables of this and later scopes can be assigned to.
+   */
+  int parallel_loop_scope = -1;
+
+  /**
+   * Whether the body of the function that is currently being resolved
+   * changes shared state (see Func::changes_shared_state).
+   */
+  bool changes_shared_state = false;
+
+  /**
+   * Whether the body of the function that is currently being resolved
+   * only depends on the arguments of the function (see Func::is_pure),
+   * i.e., it neither reads nor assigns to global variables and only
+   * calls pure functions.
+   */
+  bool is_pure = true;
+
+  /**
+   * The name of the function whose body is currently being resolved,
+   * which is assumed to be pure when it calls itself.
+   */
+  std::string function_name;
+
+  bool resolve_parse_result(ParseResult &input);
+  bool resolve_assignment(ParseResult &assignment);
+  bool resolve_function(ParseResult &function_call);
+  bool resolve_function_definition(ParseResult &function_definition);
+  bool resolve_loop(ParseResult &loop);
+
+  /**
+   * Resolves a variable that is being read or assigned to.
+   */
+  void resolve_variable(ParseResult &variable);
+
+  /**
+   * Whether the variable with the passed name was defined in the
+   * innermost parallel loop.
+   */
+  bool is_defined_in_parallel_loop(const std::string &name) const;
+
+  /**
+   * Defines a new variable in the current scope.
+   */
+  bool define_variable(ParseResult &variable);
+
+  /**
+   * Opens / closes a scope in the current frame.
+   */
+  void open_scope();
+  void close_scope();
+};
+
+}  // namespace hydra
+
+#endif /* resolver_hpp */
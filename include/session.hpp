@@ -0,0 +1,153 @@
+//
+//  session.hpp
+//  hydra
+//
+//  Executes code that changes over time, by executing only what
+//  changed.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef session_hpp
+#define session_hpp
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <canvas.hpp>
+#include <interpreter.hpp>
+#include <lexer.hpp>
+#include <random_engine.hpp>
+#include <state.hpp>
+#include <system.hpp>
+#include <vm.hpp>
+
+namespace hydra {
+
+/**
+ * Runs code that is changed between the runs, e.g., a file that is
+ * being edited or the lines entered into the REPL.  The top level
+ * statements are executed one after another and before each of them,
+ * a snapshot is taken of what the statements executed so far
+ * determined: the variables, the canvas (see Canvas::Checkpoint) and
+ * the random numbers.
+ *
+ * When the code is run again, the statements that precede the first
+ * changed line are neither parsed nor executed again.  Instead, the
+ * snapshot of the first changed statement is restored, which removes
+ * the objects that were drawn by the following statements, and only
+ * the code from there on is parsed and executed.  Since the random
+ * numbers are restored as well, the result is the same as if all of
+ * the code was executed again.  Objects that were drawn before a
+ * statement that clears the canvas cannot be restored, in which case
+ * all of the code is executed again.
+ *
+ * Output of the code, like printed messages and saved files, is only
+ * produced by the statements that are executed again.
+ */
+class Session {
+ public:
+  /**
+   * The lexer and the interpreter have to share their system and must
+   * not have been used before.  If a VM is passed, the statements are
+   * compiled and executed by the VM, otherwise they are interpreted.
+   */
+  Session(Lexer &lexer, Interpreter &interpreter, VM *vm = nullptr);
+
+  Lexer &lexer;
+  Interpreter &interpreter;
+  VM *vm;
+
+  /**
+   * Runs the passed lines of code, continuing from the first line
+   * that differs from the code of the previous run.  The result
+   * contains the value of the last statement that was executed.
+   * Returns false if the code could not be parsed or an error
+   * occurred.  In that case, the failing statement and all that
+   * follow it are undone, such that the next run continues with the
+   * statements that were executed successfully.
+   */
+  bool run(const std::vector<std::string> &code, Value &result);
+
+  /**
+   * The number of top level statements that were executed
+   * successfully, and how many of them were executed by the last
+   * run.
+   */
+  int number_of_statements() const;
+  int number_of_executed_statements() const;
+
+  /**
+   * The number of lines that belong to the statements that were
+   * executed successfully.
+   */
+  int number_of_lines() const;
+
+ private:
+  /**
+   * What the statements that were executed before a statement
+   * determined.  The user defined functions that were known at that
+   * point follow from the statements.
+   */
+  struct Snapshot {
+    State state;
+    Canvas::Checkpoint canvas;
+    RandomEngine random_engine;
+  };
+
+  struct Statement {
+    ParseResult parse_result;
+
+    /**
+     * The index of the line after the last line of the statement.
+     */
+    int end_of_lines = 0;
+
+    /**
+     * The snapshot taken right before the statement was executed.
+     */
+    Snapshot snapshot;
+  };
+
+  /**
+   * The statements that were executed successfully and their lines.
+   */
+  std::vector<Statement> statements;
+  std::vector<std::string> lines;
+
+  int number_of_executed_statements_in_last_run = 0;
+
+  /**
+   * Holds the statement that is currently being executed.
+   */
+  std::vector<ParseResult> code_to_execute;
+
+  /**
+   * Undoes the passed statement and all that follow it.  Returns
+   * false if the canvas cannot be restored, in which case nothing is
+   * undone.
+   */
+  bool undo_statements(int first_statement);
+
+  /**
+   * Forgets the user defined functions that are not defined by the
+   * statements that were executed successfully.
+   */
+  void forget_undone_functions();
+
+  /**
+   * Collects the names of the functions that are defined within the
+   * passed parse result.
+   */
+  static void collect_defined_functions(
+      const ParseResult &input, std::unordered_set<std::string> &functions);
+
+  bool execute(const std::vector<ParseResult> &code, Value &result);
+};
+
+}  // namespace hydra
+
+#endif /* session_hpp */
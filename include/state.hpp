@@ -1,5 +1,5 @@
 //
-//  system.hpp
+//  state.hpp
 //  hydra
 //
 //  Represents the state of a hydra program.
@@ -14,20 +14,35 @@
 #ifndef state_hpp
 #define state_hpp
 
-#include <any>
+#include <value.hpp>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <canvas.hpp>
 
 namespace hydra {
+
+/**
+ * Variables are stored in frames. Global variables live in the global
+ * frame, all other variables in the frame of the function that is
+ * currently being executed (or the top level frame, when no function
+ * is being executed).  Variables that could not be resolved when the
+ * code was parsed are looked up by name, first in the frames of the
+ * calling functions (from the innermost caller outwards) and then in
+ * the global frame.  This way, a function can still use the local
+ * variables of its callers, e.g., the variable of a loop it is called
+ * from.
+ */
+enum Frame { UnresolvedFrame = 0, GlobalFrame = 1, LocalFrame = 2 };
+
 /**
  * Used to store a state of a hydra program. E.g., the current line
- * number, the current line, the scopes containing the variables.
+ * number, the current line, the frames containing the variables.
  */
 class State {
-
  public:
 
   State();
@@ -37,56 +52,114 @@ class State {
   std::string current_line = "";
 
   /**
-   * Holds the variables by name and value for all currently open
-   * scopes.
+   * The values of the global variables, by slot.
+   */
+  std::vector<Value> globals;
+
+  /**
+   * Global variables can also be accessed by name. This maps the
+   * names of the global variables to their slots.
    */
-  std::vector<std::unordered_map<std::string, std::any>> scopes;
+  std::unordered_map<std::string, int> slots_for_globals;
 
   /**
-   * Opens a new scope.
+   * The global variables whose values were passed to the code (see
+   * define_variable_with_value), which the code must not define
+   * again.
    */
-  void open_new_scope();
+  std::unordered_set<std::string> names_of_parameters;
 
   /**
-   * Closes / removes the current scope. Note that the very first
-   * scope cannot be closed.
-   *
-   * Returns false, if the last remaining scope would have been
-   * deleted that way.
+   * The local frames of all functions that are currently being
+   * executed are stored consecutively.  The current frame starts at
+   * frame_base.
    */
-  bool close_scope();
+  std::vector<Value> stack;
+  int frame_base = 0;
 
   /**
-   * Define the variable with the passed value. Variables are always
-   * defined in the current scope. Returns the index of the scope that
-   * the variable was defined in or -1 if the assignment failed..
+   * The names of the variables that were defined in the slots of the
+   * stack, which are needed to look up unresolved variables in the
+   * frames of the callers.  Slots without a name are empty.
    */
-  int define_variable_with_value(const std::string &variable,
-                                 const std::any &value);
+  std::vector<std::string> names_of_slots;
 
   /**
-   * Sets the value of the current variable in the passed
-   * scope. Returns false if the variable did not exist in this scope.
+   * The bases of the frames of the callers of the current function,
+   * the innermost caller last.
    */
-  bool set_value_for_variable(const std::string &variable,
-                              const std::any &value, int scope);
+  std::vector<int> caller_frame_bases;
 
   /**
-   * Determines the value for a variable and stores the result in
-   * value.  Returns the index of the scope, that the variable is
-   * defined in. If no value could be determined, value_for_variable
-   * returns -1 and value.has_value() returns false.
+   * Returns the slot of the global variable with the passed
+   * name. If the variable does not have a slot yet, a new one is
+   * created.
    */
-  int value_for_variable(const std::string &variable, std::any &value);
+  int slot_for_global(const std::string &variable);
 
   /**
-   * Determines the value for a variable in the current scope and
-   * stores the result in value.  If no value could be determined,
-   * value.has_value() returns false.
+   * Defines a global variable with the passed value, or replaces the
+   * value if the variable exists already.  The variable is a
+   * parameter of the code that is executed afterwards.
    */
-  bool value_for_variable_in_current_scope(const std::string &variable,
-                                           std::any &value);
+  void define_variable_with_value(const std::string &variable,
+                                  const Value &value);
 
+  /**
+   * Ensures that the top level frame has at least the passed number
+   * of slots.
+   */
+  void reserve_top_level_slots(int number_of_slots);
+
+  /**
+   * Opens a new local frame with the passed number of slots. Returns
+   * the base of the previous frame, which has to be passed when
+   * closing the frame.
+   */
+  int open_frame(int number_of_slots);
+
+  /**
+   * Reserves the slots of a new local frame at the end of the stack,
+   * without entering it.  This allows the arguments of a call to be
+   * stored in the frame while variables are still looked up in the
+   * current frame. Returns the base of the reserved frame.
+   */
+  int reserve_frame(int number_of_slots);
+
+  /**
+   * Enters a frame that was reserved before. Returns the base of the
+   * previous frame, which has to be passed when closing the frame.
+   */
+  int enter_frame(int frame);
+
+  /**
+   * Closes the current frame and restores the passed frame.
+   */
+  void close_frame(int previous_frame_base);
+
+  /**
+   * Returns where the value of a variable is stored. The name is
+   * only used when the variable is unresolved. Returns nullptr if
+   * the variable could not be found.  Note that the returned pointer
+   * is only valid until the next frame is opened.
+   */
+  Value *storage_for_variable(Frame frame, int slot,
+                              std::string_view variable);
+
+  /**
+   * Like storage_for_variable, but for a variable that is being
+   * defined (including parameters and loop variables).  The name of
+   * a variable in a local frame is recorded, such that the functions
+   * that are called from the frame can find it.
+   */
+  Value *storage_for_definition(Frame frame, int slot,
+                                std::string_view variable);
+
+  /**
+   * Removes all variables and frames.  The memory is kept to be
+   * reused.
+   */
+  void reset();
 };
 }  // namespace hydra
 
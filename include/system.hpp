@@ -14,11 +14,14 @@
 #ifndef system_hpp
 #define system_hpp
 
-#include <any>
+#include <iostream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <arena.hpp>
 #include <state.hpp>
 
 namespace hydra {
@@ -49,33 +52,54 @@ enum Type {
 
 /**
  * A parse result has a type, e.g. Assignment, a value (which is the
- * original string that yielded the result) and a vector
- * representing the child results of the parsing.
+ * original string that yielded the result) and the child results of
+ * the parsing.
+ *
+ * The value and the children are stored in the arena of the lexer
+ * that parsed the code, such that a parse result is only valid as long
+ * as that lexer exists.  Copying a parse result does not copy its
+ * children.
  */
 struct ParseResult {
-  ParseResult() : type(Unknown), value(""), children({}) {}
+  ParseResult() {}
 
-  ParseResult(Type type, const std::string &value) {
-    this->type = type;
-    this->value = value;
-  }
+  ParseResult(Type type, std::string_view value) : type(type), value(value) {}
 
   Type type = Unknown;
-  std::string value = "";
-  std::vector<ParseResult> children = {};
+  std::string_view value;
+  Span<ParseResult> children;
 
   /**
    * A parse result is associated with the number of the line from
    * which it was parsed.
    */
   int line_number = -1;
-};
 
-/**
- * We use unordered_maps from string to any to store properties of
- * non-primitive types.
- */
-typedef std::unordered_map<std::string, std::any> PropertyMap;
+  /**
+   * Parse results that refer to variables are resolved to a slot in
+   * a frame by the Resolver.
+   */
+  Frame frame = UnresolvedFrame;
+  int slot = -1;
+
+  /**
+   * Numbers and expressions that only consist of numbers are folded
+   * to their value by the Optimizer, such that they don't have to be
+   * evaluated again and again.
+   */
+  bool is_constant = false;
+  double number = 0.0;
+
+  /**
+   * The Optimizer hoists calls of pure functions whose arguments
+   * don't change while a loop is running out of the loop.  Such a
+   * call is resolved to the slot that keeps its value (like a
+   * variable), and the loop to the first of the consecutive slots of
+   * the calls hoisted out of it, which are cleared whenever the loop
+   * starts.
+   */
+  int number_of_hoisted_calls = 0;
+};
 
 /**
  * How functions are represented in hydra.
@@ -97,6 +121,34 @@ struct Func {
    * function. This map tells us how.
    */
   std::unordered_map<std::string, std::string> parameter_map = {};
+
+  /**
+   * Some functions evaluate one of their arguments repeatedly, each
+   * time with a different value for the hidden variable _p. This is
+   * the position of that argument, or -1 if there is none.
+   */
+  int argument_with_hidden_variable = -1;
+
+  /**
+   * The number of slots that the frame of a user defined function
+   * needs.
+   */
+  int number_of_slots = 0;
+
+  /**
+   * Whether calling the function changes state that is shared by the
+   * iterations of a loop, e.g., the canvas settings or global
+   * variables.  Such functions cannot be called in parallel loops.
+   */
+  bool changes_shared_state = false;
+
+  /**
+   * Whether the result of the function only depends on the values of
+   * its arguments, and calling it has no other effect.  Calls of pure
+   * functions can be hoisted out of loops and the results of pure user
+   * defined functions are remembered.
+   */
+  bool is_pure = false;
 };
 
 class System {
@@ -104,7 +156,7 @@ class System {
  public:
 
   static const std::string error_string;
-  static const std::string type_string;
+  static const std::string hidden_variable_string;
 
   /**
    * Constructor
@@ -117,6 +169,11 @@ class System {
    */
   State state;
 
+  /**
+   * Where error messages are written to.
+   */
+  std::ostream *error_output = &std::cerr;
+
  /**
   * Assigns each type the corresponding name.
   */
@@ -142,7 +199,7 @@ class System {
   * In order to execute user defined functions, we need to store the
   * statement for the corresponding function.
   */
- std::unordered_map<std::string, std::vector<ParseResult>>
+ std::unordered_map<std::string, Span<const ParseResult>>
      statements_for_functions;
 
  /**
@@ -153,7 +210,35 @@ class System {
  /**
   * Prints a vector of strings a argument list.
   */
- static void print_argument_list(const std::vector<std::string> &arguments);
+ static void print_argument_list(const std::vector<std::string> &arguments,
+                                 std::ostream &stream);
+
+ /**
+  * Forgets the variables and user defined functions of the code that
+  * was executed, such that other code can be executed as if the
+  * system was new.  The memory of the state is kept.
+  */
+ void reset();
+
+ /**
+  * Forgets the user defined functions, except for the ones with the
+  * passed names, e.g., to return to an earlier point of the code.
+  */
+ void forget_user_defined_functions(
+     const std::unordered_set<std::string> &kept_functions);
+
+ /**
+  * Whether the function with the passed name is a builtin function,
+  * rather than a user defined function.
+  */
+ bool is_builtin_function(const std::string &name) const;
+
+ private:
+
+ /**
+  * The functions that are known before any code is parsed.
+  */
+ std::unordered_set<std::string> builtin_function_names;
 };
 
 } // namespace hydra
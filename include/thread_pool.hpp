@@ -0,0 +1,90 @@
+//
+//  thread_pool.hpp
+//  hydra
+//
+//  A fixed set of worker threads that process independent tasks.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef thread_pool_hpp
+#define thread_pool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hydra {
+
+class ThreadPool {
+ public:
+  /**
+   * Creates a pool that processes tasks using the passed number of
+   * threads, including the thread that calls parallel_for.
+   */
+  ThreadPool(int number_of_threads);
+
+  /**
+   * Waits for the workers to finish.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * The number of threads that process tasks.
+   */
+  int size() const { return this->workers.size() + 1; }
+
+  /**
+   * Calls task(index) for each index in [0, count) and returns once
+   * all calls are done.  The calls are distributed among the threads,
+   * so the task must not depend on the order in which the indices are
+   * processed.
+   */
+  void parallel_for(int count, const std::function<void(int)> &task);
+
+ private:
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+
+  /**
+   * Notifies the workers about a new job or the destruction of the
+   * pool.
+   */
+  std::condition_variable job_available;
+
+  /**
+   * Notifies parallel_for that all workers left the current job.
+   */
+  std::condition_variable job_done;
+
+  /**
+   * The current job.  Each job gets a new generation, such that the
+   * workers can tell whether they already processed it.
+   */
+  const std::function<void(int)> *task = nullptr;
+  int count = 0;
+  std::atomic<int> next_index{0};
+  int generation = 0;
+  int busy_workers = 0;
+  bool is_stopping = false;
+
+  /**
+   * Processes the indices of the current job until none are left.
+   */
+  void process_job(const std::function<void(int)> &task, int count);
+
+  void work();
+};
+
+}  // namespace hydra
+
+#endif /* thread_pool_hpp */
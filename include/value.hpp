@@ -0,0 +1,163 @@
+//
+//  value.hpp
+//  hydra
+//
+//  Represents the values of hydra expressions.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef value_hpp
+#define value_hpp
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include <pol.hpp>
+
+namespace hydra {
+
+struct Func;
+struct Object;
+struct Array;
+
+/**
+ * The kinds of values that an expression can evaluate to.  The order
+ * matches the alternatives stored in a Value.
+ */
+enum class ValueType { None, Number, String, Pol, Function, Object, Array };
+
+/**
+ * The value of an expression.  Numbers, strings and points are stored
+ * inline, such that no allocations are necessary when passing them
+ * around (except for long strings).  All other non-primitive types
+ * are stored as objects.
+ */
+class Value {
+ public:
+  Value() {}
+  Value(double number) : storage(number) {}
+  Value(const std::string &str) : storage(str) {}
+  Value(std::string &&str) : storage(std::move(str)) {}
+  Value(const char *str) : storage(std::string(str)) {}
+  Value(const Pol &point) : storage(point) {}
+
+  /**
+   * A reference to a function.  The function is owned by the system.
+   */
+  Value(const Func *function) : storage(function) {}
+
+  /**
+   * Objects are immutable, which is why copies of a value can share
+   * the same object.
+   */
+  Value(std::shared_ptr<const Object> object) : storage(std::move(object)) {}
+
+  /**
+   * Arrays are immutable as well.
+   */
+  Value(std::shared_ptr<const Array> array) : storage(std::move(array)) {}
+
+  ValueType type() const { return (ValueType)this->storage.index(); }
+
+  /**
+   * Returns false if the value is None, e.g., because the expression
+   * that produced it did not have a value.
+   */
+  bool has_value() const { return this->storage.index() != 0; }
+
+  void reset() { this->storage = std::monostate(); }
+
+  /**
+   * Each of the following returns nullptr if the value is not of the
+   * corresponding type.
+   */
+  const double *number() const { return std::get_if<double>(&this->storage); }
+
+  double *number() { return std::get_if<double>(&this->storage); }
+
+  const std::string *string() const {
+    return std::get_if<std::string>(&this->storage);
+  }
+
+  const Pol *pol() const { return std::get_if<Pol>(&this->storage); }
+
+  const Func *function() const {
+    const Func *const *function = std::get_if<const Func *>(&this->storage);
+    return function != nullptr ? *function : nullptr;
+  }
+
+  const Object *object() const {
+    const std::shared_ptr<const Object> *object =
+        std::get_if<std::shared_ptr<const Object>>(&this->storage);
+    return object != nullptr ? object->get() : nullptr;
+  }
+
+  const Array *array() const {
+    const std::shared_ptr<const Array> *array =
+        std::get_if<std::shared_ptr<const Array>>(&this->storage);
+    return array != nullptr ? array->get() : nullptr;
+  }
+
+ private:
+  std::variant<std::monostate, double, std::string, Pol, const Func *,
+               std::shared_ptr<const Object>, std::shared_ptr<const Array>>
+      storage;
+};
+
+/**
+ * We use unordered_maps from string to value to store properties of
+ * non-primitive types.
+ */
+typedef std::unordered_map<std::string, Value> PropertyMap;
+
+/**
+ * A value of a non-primitive type other than Pol (e.g. Euc).
+ */
+struct Object {
+  std::string type = "";
+  PropertyMap properties;
+};
+
+/**
+ * An array of numbers or points, which builtin functions process as a
+ * whole.  Like the points of paths, the points are stored as separate
+ * arrays of radii and angles.  Numbers are stored in the radii.
+ */
+struct Array {
+  /**
+   * Either ValueType::Number or ValueType::Pol.
+   */
+  ValueType element_type = ValueType::Number;
+
+  std::vector<double> r;
+  std::vector<double> phi;
+
+  size_t size() const { return this->r.size(); }
+
+  /**
+   * The element at the passed position, which must exist.
+   */
+  Value element(size_t index) const {
+    if (this->element_type == ValueType::Number) {
+      return this->r[index];
+    }
+
+    /**
+     * The angles are normalized already.
+     */
+    Pol point;
+    point.r = this->r[index];
+    point.phi = this->phi[index];
+    return point;
+  }
+};
+
+}  // namespace hydra
+
+#endif /* value_hpp */
@@ -0,0 +1,96 @@
+//
+//  vm.hpp
+//  hydra
+//
+//  Executes compiled hydra code.
+//
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#ifndef vm_hpp
+#define vm_hpp
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <bytecode.hpp>
+#include <interpreter.hpp>
+
+namespace hydra {
+
+/**
+ * A register based virtual machine. Variables are stored in the
+ * frames of the system state, just like with the interpreter, such
+ * that both can be used interchangeably.
+ */
+class VM {
+ public:
+  /**
+   * Constructor
+   */
+  VM(Interpreter &interpreter);
+
+  /**
+   * The interpreter provides the system state, the canvas and the
+   * builtin functions.
+   */
+  Interpreter &interpreter;
+
+  /**
+   * Executes a compiled chunk.  Returns false if an error occurred
+   * during execution.  The result contains the value of the last
+   * statement.
+   */
+  bool run(const Chunk &chunk, Value &result);
+
+  /**
+   * Forgets the compiled user defined functions.  The registers are
+   * kept to be reused.
+   */
+  void reset();
+
+  /**
+   * Forgets the compiled user defined functions that the system does
+   * not know anymore (see System::forget_user_defined_functions).
+   */
+  void forget_unknown_functions();
+
+ private:
+  /**
+   * The registers of all chunks that are currently being
+   * executed. Each chunk uses a window of registers starting at its
+   * base.
+   */
+  std::vector<Value> registers;
+
+  /**
+   * The user defined functions, by name.
+   */
+  std::unordered_map<std::string, std::shared_ptr<const Chunk>> functions;
+
+  /**
+   * Executes the chunk using the registers starting at base.
+   */
+  bool execute(const Chunk &chunk, int base, Value &result);
+
+  /**
+   * Calls the user defined function of the call site with the
+   * arguments stored in the registers starting at first_argument.
+   */
+  bool call_function(const CallSite &call_site, int first_argument, int base,
+                     Value &result);
+
+  /**
+   * Prints an error message for the instruction at the passed
+   * index.
+   */
+  bool fail(const Chunk &chunk, int instruction, const std::string &message);
+};
+
+}  // namespace hydra
+
+#endif /* vm_hpp */
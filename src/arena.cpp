@@ -0,0 +1,55 @@
+//
+//  arena.cpp
+//  hydra
+//
+
+#include <arena.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace hydra {
+
+void *Arena::allocate(size_t size, size_t alignment) {
+  void *memory = this->position;
+  if (std::align(alignment, size, memory, this->remaining) == nullptr) {
+    /**
+     * The current block is full.  Values that are larger than a block
+     * get a block of their own.
+     */
+    Block block;
+    block.size = std::max(this->block_size, size + alignment);
+    block.memory.reset(new char[block.size]);
+
+    memory = block.memory.get();
+    this->remaining = block.size;
+    std::align(alignment, size, memory, this->remaining);
+    this->blocks.push_back(std::move(block));
+  }
+
+  this->position = static_cast<char *>(memory) + size;
+  this->remaining -= size;
+  return memory;
+}
+
+std::string_view Arena::copy(std::string_view str) {
+  if (str.empty()) {
+    return std::string_view();
+  }
+
+  char *characters = static_cast<char *>(allocate(str.size(), 1));
+  std::memcpy(characters, str.data(), str.size());
+  return std::string_view(characters, str.size());
+}
+
+void Arena::clear() {
+  if (this->blocks.empty()) {
+    return;
+  }
+
+  this->blocks.resize(1);
+  this->position = this->blocks[0].memory.get();
+  this->remaining = this->blocks[0].size;
+}
+
+}  // namespace hydra
@@ -6,9 +6,19 @@
 //
 
 #include <canvas.hpp>
-
+#include <io_helper.hpp>
+#include <kernels.hpp>
+#include <png_writer.hpp>
+#include <rasterizer.hpp>
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <glog/logging.h>
+#include <unordered_set>
+#include <utility>
 
 /**
  * Including the lexer here is probably not the nice way, but we need
@@ -18,306 +28,1464 @@
 
 namespace hydra {
 
-void Canvas::add_path(const Path &path) {
+/**
+ * Buffers for the Euclidean coordinates of the path that is currently
+ * being written. Each export thread uses its own buffers, which are
+ * reused for all paths.
+ */
+static thread_local std::vector<double> euclidean_x;
+static thread_local std::vector<double> euclidean_y;
+
+/**
+ * Buffers for simplifying paths: the coordinates in the drawing, which
+ * points are kept and the ranges of points that are still to be
+ * simplified.
+ */
+static thread_local std::vector<double> simplification_x;
+static thread_local std::vector<double> simplification_y;
+static thread_local std::vector<bool> simplification_keeps_point;
+static thread_local std::vector<std::pair<int, int>> simplification_ranges;
+
+void Canvas::add_path(Path path) {
   DLOG(INFO) << "Adding path." << std::endl;
-  this->paths.push_back(path);
+
+  Primitive curve;
+  curve.type = PrimitiveType::Curve;
+  curve.curve = this->curves.size();
+
+  this->curves.push_back(std::move(path));
+  this->paths.push_back(curve);
+}
+
+void Canvas::add_line(const Pol &from, const Pol &to) {
+  Primitive line;
+  line.type = PrimitiveType::Line;
+  line.first = from;
+  line.second = to;
+  this->paths.push_back(line);
+}
+
+void Canvas::add_circle(const Pol &center, double radius) {
+  Primitive circle;
+  circle.type = PrimitiveType::Circle;
+  circle.first = center;
+  circle.radius = radius;
+  this->paths.push_back(circle);
 }
 
 void Canvas::add_mark(const Circle &mark) { this->marks.push_back(mark); }
 
 void Canvas::clear() {
   this->paths.clear();
+  this->curves.clear();
   this->marks.clear();
+  ++this->number_of_clears;
 }
 
-void Canvas::save_to_file(const std::string &file_name) const {
-  DLOG(INFO) << "Writing canvas to file: '" << file_name << "'." << std::endl;
+void Canvas::reset() {
+  clear();
+  restore_settings(Canvas().checkpoint());
+}
+
+Canvas::Checkpoint Canvas::checkpoint() const {
+  Checkpoint checkpoint;
+  checkpoint.number_of_paths = this->paths.size();
+  checkpoint.number_of_curves = this->curves.size();
+  checkpoint.number_of_marks = this->marks.size();
+  checkpoint.number_of_clears = this->number_of_clears;
+
+  checkpoint.resolution = this->resolution;
+  checkpoint.tolerance = this->tolerance;
+  checkpoint.scale = this->scale;
+  checkpoint.viewport_center = this->viewport_center;
+  checkpoint.viewport_radius = this->viewport_radius;
+  checkpoint.simplification = this->simplification;
+  checkpoint.precision = this->precision;
+  checkpoint.image_width = this->image_width;
+  checkpoint.image_height = this->image_height;
+  return checkpoint;
+}
 
+bool Canvas::restore(const Checkpoint &checkpoint) {
   /**
-   * The stream that is used to write to the file.
+   * Objects are only ever appended, unless the canvas is cleared.  A
+   * checkpoint of an empty canvas can always be restored.
    */
-  std::fstream output_file_stream(file_name, std::fstream::out);
+  const bool was_empty = checkpoint.number_of_paths == 0 &&
+                         checkpoint.number_of_curves == 0 &&
+                         checkpoint.number_of_marks == 0;
+  if (!was_empty &&
+      (checkpoint.number_of_clears != this->number_of_clears ||
+       this->paths.size() < checkpoint.number_of_paths ||
+       this->curves.size() < checkpoint.number_of_curves ||
+       this->marks.size() < checkpoint.number_of_marks)) {
+    return false;
+  }
+
+  this->paths.erase(this->paths.begin() + checkpoint.number_of_paths,
+                    this->paths.end());
+  this->curves.erase(this->curves.begin() + checkpoint.number_of_curves,
+                     this->curves.end());
+  this->marks.erase(this->marks.begin() + checkpoint.number_of_marks,
+                    this->marks.end());
+  restore_settings(checkpoint);
+  return true;
+}
+
+void Canvas::restore_settings(const Checkpoint &checkpoint) {
+  this->resolution = checkpoint.resolution;
+  this->tolerance = checkpoint.tolerance;
+  this->scale = checkpoint.scale;
+  this->viewport_center = checkpoint.viewport_center;
+  this->viewport_radius = checkpoint.viewport_radius;
+  this->simplification = checkpoint.simplification;
+  this->precision = checkpoint.precision;
+  this->image_width = checkpoint.image_width;
+  this->image_height = checkpoint.image_height;
+}
+
+void Canvas::append(Canvas &other) {
+  this->marks.insert(this->marks.end(), other.marks.begin(),
+                     other.marks.end());
+
+  /**
+   * The curves of the other canvas are stored after the curves of
+   * this canvas.
+   */
+  const int curve_offset = this->curves.size();
+  for (Primitive &primitive : other.paths) {
+    if (primitive.type == PrimitiveType::Curve) {
+      primitive.curve += curve_offset;
+    }
+    this->paths.push_back(primitive);
+  }
+
+  for (Path &curve : other.curves) {
+    this->curves.push_back(std::move(curve));
+  }
+
+  other.clear();
+}
+
+/**
+ * The layout of binary canvas files.  The header is followed by the
+ * records of the marks and the paths, the number of points of each
+ * curve and finally the radii and the angles of all points of the
+ * curves.
+ */
+namespace {
+
+const char binary_canvas_magic[8] = {'h', 'c', 'a', 'n', 'v', 'a', 's', '\n'};
+const uint32_t binary_canvas_version = 1;
+
+struct BinaryCanvasHeader {
+  uint32_t version;
+  int32_t precision;
+  double scale;
+  double resolution;
+  uint64_t number_of_marks;
+  uint64_t number_of_paths;
+  uint64_t number_of_curves;
+  uint64_t number_of_points;
+};
+
+struct MarkRecord {
+  double r;
+  double phi;
+  double radius;
+  uint64_t is_filled;
+};
+
+struct PrimitiveRecord {
+  uint32_t type;
+  int32_t curve;
+  double first_r;
+  double first_phi;
+  double second_r;
+  double second_phi;
+  double radius;
+};
+
+struct CurveRecord {
+  uint64_t number_of_points;
+  uint64_t is_closed;
+};
+
+/**
+ * Writes the records for the passed objects to the stream, a few at
+ * a time.
+ */
+template <typename Record, typename Object>
+void write_records(std::ostream &stream, const std::vector<Object> &objects,
+                   const std::function<Record(const Object &)> &record_for) {
+  static const size_t records_per_write = 4096;
+
+  std::vector<Record> records;
+  records.reserve(std::min(objects.size(), records_per_write));
+
+  for (size_t start = 0; start < objects.size(); start += records_per_write) {
+    const size_t end = std::min(start + records_per_write, objects.size());
+
+    records.clear();
+    for (size_t index = start; index < end; ++index) {
+      records.push_back(record_for(objects[index]));
+    }
+
+    stream.write(reinterpret_cast<const char *>(records.data()),
+                 records.size() * sizeof(Record));
+  }
+}
+
+}  // namespace
+
+void Canvas::save_to_file(const std::string &file_name) const {
+  DLOG(INFO) << "Writing canvas to file: '" << file_name << "'." << std::endl;
 
   std::vector<std::string> file_name_components;
   Lexer::components_in_string(file_name, file_name_components, ".");
   std::string file_extension = file_name_components.back();
 
-  std::string canvas_representation;
+  if (file_extension == "hcanvas") {
+    std::fstream output_file_stream(file_name,
+                                    std::fstream::out | std::fstream::binary);
+    binary_canvas_representation(output_file_stream);
+    return;
+  }
+
+  if (file_extension == "png") {
+    std::fstream output_file_stream(file_name,
+                                    std::fstream::out | std::fstream::binary);
+    png_canvas_representation(output_file_stream);
+    return;
+  }
+
+  /**
+   * The stream that is used to write to the file.
+   */
+  std::fstream output_file_stream(file_name, std::fstream::out);
+
+  /**
+   * The representation is written to the file piece by piece, such
+   * that the whole file never has to be kept in memory.
+   */
+  OutputSink sink(&output_file_stream, this->precision);
 
   if (file_extension == "ipe") {
-    ipe_canvas_representation(canvas_representation);
+    ipe_canvas_representation(sink);
   } else if (file_extension == "svg") {
-    svg_canvas_representation(canvas_representation);
+    svg_canvas_representation(sink);
   } else {
     LOG(ERROR) << "Unrecognized file extension while saving canvas. Allowed "
-                  "extensions are: \".ipe\" and \".svg\"."
+                  "extensions are: \".ipe\", \".svg\", \".png\" and "
+                  "\".hcanvas\"."
                << std::endl;
   }
 
-  output_file_stream << canvas_representation;
+  sink.flush();
 }
 
-void Canvas::ipe_canvas_representation(std::string &ipe_representation) const {
+void Canvas::binary_canvas_representation(std::ostream &stream) const {
+  BinaryCanvasHeader header;
+  header.version = binary_canvas_version;
+  header.precision = this->precision;
+  header.scale = this->scale;
+  header.resolution = this->resolution;
+  header.number_of_marks = this->marks.size();
+  header.number_of_paths = this->paths.size();
+  header.number_of_curves = this->curves.size();
+  header.number_of_points = 0;
+  for (const Path &curve : this->curves) {
+    header.number_of_points += curve.size();
+  }
+
+  stream.write(binary_canvas_magic, sizeof(binary_canvas_magic));
+  stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  write_records<MarkRecord, Circle>(
+      stream, this->marks, [](const Circle &mark) {
+        return MarkRecord{mark.center.r, mark.center.phi, mark.radius,
+                          mark.is_filled};
+      });
+
+  write_records<PrimitiveRecord, Primitive>(
+      stream, this->paths, [](const Primitive &primitive) {
+        return PrimitiveRecord{(uint32_t)primitive.type, primitive.curve,
+                               primitive.first.r,        primitive.first.phi,
+                               primitive.second.r,       primitive.second.phi,
+                               primitive.radius};
+      });
+
+  write_records<CurveRecord, Path>(stream, this->curves, [](const Path &curve) {
+    return CurveRecord{(uint64_t)curve.size(), curve.is_closed};
+  });
+
   /**
-   * Print the ipe header.
+   * The coordinates are already stored in arrays.
    */
-  ipe_representation =
-      "<?xml version=\"1.0\"?>\n"
-      "<!DOCTYPE ipe SYSTEM \"ipe.dtd\">\n"
-      "<ipe version=\"70206\" creator=\"Ipe 7.2.7\">\n"
-      "<info created=\"D:20170719160807\" modified=\"D:20170719160807\"/>\n"
-      "<ipestyle name=\"basic\">\n"
-      "</ipestyle>\n"
-      "<page>\n"
-      "<layer name=\"alpha\"/>\n"
-      "<view layers=\"alpha\" active=\"alpha\"/>\n";
+  for (const Path &curve : this->curves) {
+    stream.write(reinterpret_cast<const char *>(curve.r.data()),
+                 curve.size() * sizeof(double));
+  }
+
+  for (const Path &curve : this->curves) {
+    stream.write(reinterpret_cast<const char *>(curve.phi.data()),
+                 curve.size() * sizeof(double));
+  }
+}
+
+bool Canvas::load_from_file(const std::string &file_name) {
+  DLOG(INFO) << "Loading canvas from file: '" << file_name << "'."
+             << std::endl;
+
+  MappedFile file(file_name);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  const std::string_view data = file.contents();
+
+  BinaryCanvasHeader header;
+  if (data.size() < sizeof(binary_canvas_magic) + sizeof(header) ||
+      std::memcmp(data.data(), binary_canvas_magic,
+                  sizeof(binary_canvas_magic)) != 0) {
+    return false;
+  }
+
+  std::memcpy(&header, data.data() + sizeof(binary_canvas_magic),
+              sizeof(header));
 
   /**
-   * In order to obtain a nice drawing, we now determine the
-   * coordinate with the largest radius. When we know that, we
-   * translate everything such that all points are in the drawing
-   * canvas. (E.g. in Ipe the point 0,0 is in the bottom left and
-   * everything with negative x/y coordinates is out of the canvas.)
+   * The size of the file has to match the header exactly. The counts
+   * are checked one by one first, such that the sum cannot overflow.
    */
-  double maximum_radius = 0.0;
+  const uint64_t remaining_size =
+      data.size() - sizeof(binary_canvas_magic) - sizeof(header);
+  if (header.version != binary_canvas_version ||
+      !(header.precision >= 0 &&
+        header.precision <= OutputSink::maximum_precision) ||
+      !(header.resolution > 0.0) ||
+      header.number_of_marks > remaining_size / sizeof(MarkRecord) ||
+      header.number_of_paths > remaining_size / sizeof(PrimitiveRecord) ||
+      header.number_of_curves > remaining_size / sizeof(CurveRecord) ||
+      header.number_of_points > remaining_size / (2 * sizeof(double)) ||
+      header.number_of_marks * sizeof(MarkRecord) +
+              header.number_of_paths * sizeof(PrimitiveRecord) +
+              header.number_of_curves * sizeof(CurveRecord) +
+              header.number_of_points * 2 * sizeof(double) !=
+          remaining_size) {
+    return false;
+  }
+
+  const char *position =
+      data.data() + sizeof(binary_canvas_magic) + sizeof(header);
+  const char *mark_records = position;
+  const char *path_records =
+      mark_records + header.number_of_marks * sizeof(MarkRecord);
+  const char *curve_records =
+      path_records + header.number_of_paths * sizeof(PrimitiveRecord);
+  const char *radii =
+      curve_records + header.number_of_curves * sizeof(CurveRecord);
+  const char *angles = radii + header.number_of_points * sizeof(double);
 
   /**
-   * Find the maximum radius among the marks.
+   * The objects are read into a canvas of their own first, such that
+   * this canvas does not change if the file is invalid.
    */
+  Canvas loaded;
+
+  uint64_t number_of_points = 0;
+  loaded.curves.resize(header.number_of_curves);
+  for (Path &curve : loaded.curves) {
+    CurveRecord record;
+    std::memcpy(&record, curve_records, sizeof(record));
+    curve_records += sizeof(record);
+
+    if (record.number_of_points > header.number_of_points - number_of_points) {
+      return false;
+    }
+
+    curve.is_closed = record.is_closed != 0;
+    curve.r.resize(record.number_of_points);
+    curve.phi.resize(record.number_of_points);
+    std::memcpy(curve.r.data(), radii + number_of_points * sizeof(double),
+                record.number_of_points * sizeof(double));
+    std::memcpy(curve.phi.data(), angles + number_of_points * sizeof(double),
+                record.number_of_points * sizeof(double));
+    number_of_points += record.number_of_points;
+  }
+
+  loaded.paths.resize(header.number_of_paths);
+  for (Primitive &primitive : loaded.paths) {
+    PrimitiveRecord record;
+    std::memcpy(&record, path_records, sizeof(record));
+    path_records += sizeof(record);
+
+    if (record.type > (uint32_t)PrimitiveType::Curve ||
+        ((PrimitiveType)record.type == PrimitiveType::Curve &&
+         (record.curve < 0 ||
+          (uint64_t)record.curve >= header.number_of_curves))) {
+      return false;
+    }
+
+    /**
+     * The coordinates were normalized when they were drawn.
+     */
+    primitive.type = (PrimitiveType)record.type;
+    primitive.curve = record.curve;
+    primitive.first.r = record.first_r;
+    primitive.first.phi = record.first_phi;
+    primitive.second.r = record.second_r;
+    primitive.second.phi = record.second_phi;
+    primitive.radius = record.radius;
+  }
+
+  loaded.marks.reserve(header.number_of_marks);
+  for (uint64_t index = 0; index < header.number_of_marks; ++index) {
+    MarkRecord record;
+    std::memcpy(&record, mark_records, sizeof(record));
+    mark_records += sizeof(record);
+
+    Circle mark(Pol(), record.radius);
+    mark.center.r = record.r;
+    mark.center.phi = record.phi;
+    mark.is_filled = record.is_filled != 0;
+    loaded.marks.push_back(mark);
+  }
+
+  if (this->marks.empty() && this->paths.empty()) {
+    this->precision = header.precision;
+    this->scale = header.scale;
+    this->resolution = header.resolution;
+  }
+
+  append(loaded);
+  return true;
+}
+
+double Canvas::maximum_radius() const {
+  double maximum_radius = 0.0;
+
   for (const Circle &mark : this->marks) {
-    if (mark.center.r > maximum_radius) {
-      maximum_radius = mark.center.r;
+    maximum_radius = std::max(maximum_radius, mark.center.r);
+  }
+
+  for (const Primitive &primitive : this->paths) {
+    maximum_radius = std::max(maximum_radius, this->maximum_radius(primitive));
+  }
+
+  return maximum_radius;
+}
+
+double Canvas::maximum_radius(const Primitive &primitive) const {
+  switch (primitive.type) {
+    case PrimitiveType::Line:
+      /**
+       * The distance to the origin is largest at one of the end points
+       * of the line.
+       */
+      return std::max(primitive.first.r, primitive.second.r);
+
+    case PrimitiveType::Circle: {
+      /**
+       * The points that path_for_circle determines lie between the
+       * minimum and the maximum radius of the circle (or on the
+       * circle, if it's centered at the origin).
+       */
+      const Pol &center = primitive.first;
+      if (center.r == 0.0) {
+        return primitive.radius;
+      }
+      return std::max(center.r + primitive.radius,
+                      std::abs(primitive.radius - center.r));
+    }
+
+    case PrimitiveType::Curve: {
+      const Path &curve = this->curves[primitive.curve];
+      return Kernels::maximum(curve.r.data(), curve.size());
     }
   }
 
+  return 0.0;
+}
+
+const Path &Canvas::path_for_primitive(const Primitive &primitive,
+                                       Path &path) const {
+  if (primitive.type == PrimitiveType::Curve) {
+    return this->curves[primitive.curve];
+  }
+
   /**
-   * Find the maximum radius among the paths.
+   * The path is reused for all primitives, to avoid allocations.
    */
-  for (const Path &path : this->paths) {
-    for (const Pol point : path.points) {
-      if (point.r > maximum_radius) {
-        maximum_radius = point.r;
-      }
+  path.clear();
+
+  /**
+   * The tolerance refers to the drawing, so it is converted to the
+   * coordinates before scaling.
+   */
+  if (this->tolerance > 0.0) {
+    const double tolerance = this->tolerance / this->scale;
+    if (primitive.type == PrimitiveType::Line) {
+      Canvas::adaptive_path_for_line(primitive.first, primitive.second,
+                                     tolerance, path);
+    } else {
+      Canvas::adaptive_path_for_circle(primitive.first, primitive.radius,
+                                       tolerance, path);
     }
+  } else if (primitive.type == PrimitiveType::Line) {
+    Canvas::path_for_line(primitive.first, primitive.second, this->resolution,
+                          path);
+  } else {
+    Canvas::path_for_circle(primitive.first, primitive.radius,
+                            this->resolution, path);
   }
 
+  return path;
+}
+
+namespace {
+
+/**
+ * Moves points such that the viewport center is at the origin and
+ * represents them in the Beltrami-Klein model.  There, lines are
+ * straight and the viewport is the disk of radius tanh(radius) around
+ * the origin, so lines are clipped like in the Euclidean plane.  The
+ * formulas avoid subtracting large numbers, such that points far from
+ * the origin do not lose their precision.
+ */
+class ViewportFrame {
+ public:
+  ViewportFrame(const Pol &center, double radius)
+      : center(center),
+        cosh_center(cosh(center.r)),
+        sinh_center(sinh(center.r)),
+        cosh_radius(cosh(radius)),
+        klein_radius(tanh(radius)) {}
+
+  const Pol center;
+  const double cosh_center;
+  const double sinh_center;
+  const double cosh_radius;
+  const double klein_radius;
+
   /**
-   * The offset that shifts everything.
+   * Determines the coordinates of the point in the Klein model and
+   * the cosh of its distance to the center.
    */
-  Euc offset(this->scale * maximum_radius,
-             this->scale * maximum_radius);
+  Euc klein_coordinates(const Pol &point, double &cosh_distance) const {
+    const double delta_phi = point.phi - this->center.phi;
+    const double sin_half_delta_phi = sin(0.5 * delta_phi);
+    const double versine = 2.0 * sin_half_delta_phi * sin_half_delta_phi;
+    const double sinh_r = sinh(point.r);
+
+    /**
+     * The coordinates in the hyperboloid model after rotating the
+     * center onto the x-axis and moving it to the origin.
+     */
+    cosh_distance =
+        cosh(point.r - this->center.r) + sinh_r * this->sinh_center * versine;
+    const double x =
+        sinh(point.r - this->center.r) - sinh_r * this->cosh_center * versine;
+    const double y = sinh_r * sin(delta_phi);
+
+    return Euc(x / cosh_distance, y / cosh_distance);
+  }
 
   /**
-   * Print Marks.
+   * The inverse of klein_coordinates.
    */
-  for (const Circle &mark : this->marks) {
-    std::string circle_representation;
-    Canvas::ipe_circle_representation(mark, circle_representation, this->scale,
-                                      offset);
-    ipe_representation += circle_representation;
+  Pol point_for_klein_coordinates(const Euc &klein) const {
+    const double t = 1.0 / sqrt(1.0 - klein.x * klein.x - klein.y * klein.y);
+    const double x = this->sinh_center * t + this->cosh_center * t * klein.x;
+    const double y = t * klein.y;
+    return Pol(asinh(sqrt(x * x + y * y)), atan2(y, x) + this->center.phi);
   }
 
   /**
-   * Print Paths.
+   * Determines the part of the segment between the passed points in
+   * the Klein model that lies in the viewport, given as the interval
+   * [first, last] of the positions between from (0) and to (1).
+   * Returns false if the segment misses the viewport.
    */
-  for (const Path &path : this->paths) {
-    std::string path_representation;
-    Canvas::ipe_path_representation(path, path_representation, this->scale, offset);
-    ipe_representation += path_representation;
+  bool clip_segment(const Euc &from, const Euc &to, double &first,
+                    double &last) const {
+    const double delta_x = to.x - from.x;
+    const double delta_y = to.y - from.y;
+
+    const double a = delta_x * delta_x + delta_y * delta_y;
+    const double b = from.x * delta_x + from.y * delta_y;
+    const double c = from.x * from.x + from.y * from.y -
+                     this->klein_radius * this->klein_radius;
+
+    first = 0.0;
+    last = 1.0;
+    if (!(a > 0.0)) {
+      return c <= 0.0;
+    }
+
+    const double discriminant = b * b - a * c;
+    if (discriminant < 0.0) {
+      return false;
+    }
+
+    const double root = sqrt(discriminant);
+    first = std::max(0.0, (-b - root) / a);
+    last = std::min(1.0, (-b + root) / a);
+    return first <= last;
   }
 
   /**
-   * Print Ipe footer.
+   * Clips the line between the passed points to the viewport, where
+   * the flags tell whether the points lie within the viewport.  Points
+   * within the viewport are kept as they are.  Returns false if the
+   * line misses the viewport.
    */
-  ipe_representation +=
-      "</page>\n"
-      "</ipe>";
-}
+  bool clip_line(const Pol &from, const Euc &klein_from, bool is_from_visible,
+                 const Pol &to, const Euc &klein_to, bool is_to_visible,
+                 Pol &start, Pol &end) const {
+    start = from;
+    end = to;
+    if (is_from_visible && is_to_visible) {
+      return true;
+    }
 
-void Canvas::svg_canvas_representation(std::string &svg_representation) const {
+    double first;
+    double last;
+    if (!clip_segment(klein_from, klein_to, first, last)) {
+      return false;
+    }
+
+    /**
+     * If the viewport is so large that its boundary cannot be
+     * represented in the Klein model, the points are kept.
+     */
+    const auto point_at = [this, &klein_from, &klein_to](double position,
+                                                         Pol &point) {
+      const Pol clipped_point = point_for_klein_coordinates(
+          Euc(klein_from.x + position * (klein_to.x - klein_from.x),
+              klein_from.y + position * (klein_to.y - klein_from.y)));
+      if (std::isfinite(clipped_point.r)) {
+        point = clipped_point;
+      }
+    };
+
+    if (!is_from_visible) {
+      point_at(first, start);
+    }
+    if (!is_to_visible) {
+      point_at(last, end);
+    }
+
+    return true;
+  }
 
   /**
-   * In order to obtain a nice drawing, we now determine the
-   * coordinate with the largest radius. When we know that, we
-   * translate everything such that all points are in the drawing
-   * canvas. (E.g. in Ipe the point 0,0 is in the bottom left and
-   * everything with negative x/y coordinates is out of the canvas.)
+   * Passes the parts of the path that lie within the viewport to the
+   * function.  The path itself is passed on if it lies within the
+   * viewport completely.
    */
-  double maximum_radius = 0.0;
+  void clip_path(const Path &path, Path &piece,
+                 const std::function<void(const Path &)> &handle_path) const {
+    if (path.empty()) {
+      return;
+    }
+
+    Pol previous_point;
+    previous_point.r = path.r[0];
+    previous_point.phi = path.phi[0];
+
+    double cosh_distance;
+    Euc previous_klein = klein_coordinates(previous_point, cosh_distance);
+    bool is_previous_visible = cosh_distance <= this->cosh_radius;
+
+    if (path.size() == 1) {
+      if (is_previous_visible) {
+        handle_path(path);
+      }
+      return;
+    }
+
+    /**
+     * A closed path has a segment from its last to its first point.
+     */
+    const int number_of_segments =
+        path.is_closed ? path.size() : path.size() - 1;
+    bool is_clipped = false;
+    piece.clear();
+    piece.is_closed = false;
+
+    for (int segment = 0; segment < number_of_segments; ++segment) {
+      const int index = (segment + 1) % path.size();
+      Pol point;
+      point.r = path.r[index];
+      point.phi = path.phi[index];
+
+      const Euc klein = klein_coordinates(point, cosh_distance);
+      const bool is_visible = cosh_distance <= this->cosh_radius;
+
+      Pol start;
+      Pol end;
+      if (!is_previous_visible || !is_visible) {
+        is_clipped = true;
+      }
+
+      if (clip_line(previous_point, previous_klein, is_previous_visible,
+                    point, klein, is_visible, start, end)) {
+        /**
+         * A piece starts where a segment enters the viewport.
+         */
+        if (!is_previous_visible || piece.empty()) {
+          if (!piece.empty()) {
+            handle_path(piece);
+            piece.clear();
+          }
+          piece.push_back(start.r, start.phi);
+        }
+
+        piece.push_back(end.r, end.phi);
+
+        if (!is_visible) {
+          handle_path(piece);
+          piece.clear();
+        }
+      }
+
+      previous_point = point;
+      previous_klein = klein;
+      is_previous_visible = is_visible;
+    }
+
+    if (!is_clipped) {
+      handle_path(path);
+    } else if (!piece.empty()) {
+      handle_path(piece);
+    }
+  }
+};
+
+/**
+ * The length of the line between the passed points, determined like
+ * in LineGeometry.
+ */
+double length_of_line(const Pol &from, const Pol &to) {
+  const double sinh_half_delta_r = sinh(0.5 * (from.r - to.r));
+  const double sin_half_delta_phi = sin(0.5 * (from.phi - to.phi));
+  return 2.0 * asinh(sqrt(sinh_half_delta_r * sinh_half_delta_r +
+                          sinh(from.r) * sinh(to.r) * sin_half_delta_phi *
+                              sin_half_delta_phi));
+}
+
+}  // namespace
+
+void Canvas::drawing_area(Euc &center, double &radius) const {
+  if (this->viewport_radius > 0.0) {
+    /**
+     * Distances in the drawing are at most as large as in the
+     * hyperbolic plane, so the square around the viewport center
+     * contains the whole viewport.
+     */
+    center = Euc(this->viewport_center);
+    radius = this->viewport_radius;
+    return;
+  }
+
+  center = Euc(0.0, 0.0);
+  radius = maximum_radius();
+}
+
+bool Canvas::is_visible(const Circle &mark) const {
+  if (!(this->viewport_radius > 0.0)) {
+    return true;
+  }
+
+  const ViewportFrame frame(this->viewport_center, this->viewport_radius);
+  double cosh_distance;
+  frame.klein_coordinates(mark.center, cosh_distance);
+  return cosh_distance <= cosh(this->viewport_radius + mark.radius);
+}
+
+void Canvas::for_each_visible_path(
+    const Primitive &primitive, Path &path, Path &piece,
+    const std::function<void(const Path &)> &handle_path) const {
+  if (!(this->viewport_radius > 0.0)) {
+    handle_path(path_for_primitive(primitive, path));
+    return;
+  }
+
+  const ViewportFrame frame(this->viewport_center, this->viewport_radius);
+  double cosh_distance;
+
+  if (primitive.type == PrimitiveType::Line) {
+    /**
+     * Only the visible part of a line is tessellated.
+     */
+    const Euc klein_from = frame.klein_coordinates(primitive.first,
+                                                   cosh_distance);
+    const bool is_from_visible = cosh_distance <= frame.cosh_radius;
+    const Euc klein_to = frame.klein_coordinates(primitive.second,
+                                                 cosh_distance);
+    const bool is_to_visible = cosh_distance <= frame.cosh_radius;
+
+    Primitive line = primitive;
+    if (!frame.clip_line(primitive.first, klein_from, is_from_visible,
+                         primitive.second, klein_to, is_to_visible,
+                         line.first, line.second)) {
+      return;
+    }
+
+    if (this->tolerance > 0.0 || (is_from_visible && is_to_visible)) {
+      handle_path(path_for_primitive(line, path));
+      return;
+    }
+
+    /**
+     * The resolution determines the number of points of the whole
+     * line, so the visible part gets its share, such that the points
+     * are as dense as without the viewport.
+     */
+    const double length = length_of_line(primitive.first, primitive.second);
+    const double visible_length = length_of_line(line.first, line.second);
+    double resolution = this->resolution;
+    if (length > 0.0 && visible_length > 0.0) {
+      resolution *= visible_length / length;
+    }
+
+    path.clear();
+    Canvas::path_for_line(line.first, line.second, resolution, path);
+    handle_path(path);
+    return;
+  }
+
+  if (primitive.type == PrimitiveType::Circle) {
+    frame.klein_coordinates(primitive.first, cosh_distance);
+    const double distance = acosh(std::max(1.0, cosh_distance));
+
+    /**
+     * Circles that lie within the viewport completely are not clipped,
+     * those that miss its boundary are skipped.
+     */
+    if (distance + primitive.radius <= this->viewport_radius) {
+      handle_path(path_for_primitive(primitive, path));
+      return;
+    }
+    if (distance > primitive.radius + this->viewport_radius ||
+        distance < primitive.radius - this->viewport_radius) {
+      return;
+    }
+  }
+
+  frame.clip_path(path_for_primitive(primitive, path), piece, handle_path);
+}
+
+namespace {
+
+/**
+ * The coordinates of an object in the drawing, rounded to multiples of
+ * the simplification distance, which identify the object when looking
+ * for duplicates.
+ */
+typedef std::vector<int64_t> DuplicateKey;
+
+struct DuplicateKeyHash {
+  size_t operator()(const DuplicateKey &key) const {
+    uint64_t hash = 0;
+    for (int64_t part : key) {
+      hash = (hash ^ (uint64_t)part) * 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 33;
+    }
+    return hash;
+  }
+};
+
+int64_t rounded_coordinate(double value, double simplification) {
+  return std::llround(value / simplification);
+}
+
+void append_point_to_key(const Pol &point, double scale,
+                         double simplification, DuplicateKey &key) {
+  const Euc euclidean(point, scale);
+  key.push_back(rounded_coordinate(euclidean.x, simplification));
+  key.push_back(rounded_coordinate(euclidean.y, simplification));
+}
+
+}  // namespace
+
+void Canvas::find_duplicates(std::vector<bool> &is_duplicate_mark,
+                             std::vector<bool> &is_duplicate_path) const {
+  const double scale = this->scale;
+  const double simplification = this->simplification;
+
+  std::unordered_set<DuplicateKey, DuplicateKeyHash> keys;
+  DuplicateKey key;
+
+  is_duplicate_mark.assign(this->marks.size(), false);
+  for (size_t index = 0; index < this->marks.size(); ++index) {
+    const Circle &mark = this->marks[index];
+
+    key.clear();
+    append_point_to_key(mark.center, scale, simplification, key);
+    key.push_back(rounded_coordinate(mark.radius * scale, simplification));
+    key.push_back(mark.is_filled);
+
+    is_duplicate_mark[index] = !keys.insert(key).second;
+  }
 
   /**
-   * Find the maximum radius among the marks.
+   * Marks and paths are never the same, since the keys of the paths
+   * start with their type.
    */
-  for (const Circle &mark : this->marks) {
-    if (mark.center.r > maximum_radius) {
-      maximum_radius = mark.center.r;
+  is_duplicate_path.assign(this->paths.size(), false);
+  for (size_t index = 0; index < this->paths.size(); ++index) {
+    const Primitive &primitive = this->paths[index];
+
+    key.clear();
+    key.push_back(-1 - (int64_t)primitive.type);
+
+    switch (primitive.type) {
+      case PrimitiveType::Line: {
+        /**
+         * A line is the same in both directions.
+         */
+        DuplicateKey first;
+        DuplicateKey second;
+        append_point_to_key(primitive.first, scale, simplification, first);
+        append_point_to_key(primitive.second, scale, simplification, second);
+        if (second < first) {
+          std::swap(first, second);
+        }
+        key.insert(key.end(), first.begin(), first.end());
+        key.insert(key.end(), second.begin(), second.end());
+        break;
+      }
+      case PrimitiveType::Circle:
+        append_point_to_key(primitive.first, scale, simplification, key);
+        key.push_back(
+            rounded_coordinate(primitive.radius * scale, simplification));
+        break;
+      case PrimitiveType::Curve: {
+        const Path &curve = this->curves[primitive.curve];
+        key.push_back(curve.is_closed);
+        for (int point = 0; point < curve.size(); ++point) {
+          append_point_to_key(Pol(curve.r[point], curve.phi[point]), scale,
+                              simplification, key);
+        }
+        break;
+      }
     }
+
+    is_duplicate_path[index] = !keys.insert(key).second;
   }
+}
+
+const Path &Canvas::simplified_path(const Path &path, Path &simplified) const {
+  const int number_of_points = path.size();
+  if (!(this->simplification > 0.0) || number_of_points <= 2) {
+    return path;
+  }
+
+  /**
+   * The distances are measured in the drawing, where the offset does
+   * not matter.
+   */
+  std::vector<double> &x = simplification_x;
+  std::vector<double> &y = simplification_y;
+  x.resize(number_of_points);
+  y.resize(number_of_points);
+  Kernels::polar_to_euclidean(path.r.data(), path.phi.data(),
+                              number_of_points, this->scale, 0.0, 0.0,
+                              x.data(), y.data());
 
   /**
-   * Find the maximum radius among the paths.
+   * Douglas-Peucker: the point of a range that is farthest from the
+   * segment between the first and the last point of the range is kept
+   * if it is farther away than the simplification distance, and the
+   * two ranges it splits the range into are simplified as well.
+   * Otherwise, the points in between are dropped.
    */
-  for (const Path &path : this->paths) {
-    for (const Pol point : path.points) {
-      if (point.r > maximum_radius) {
-        maximum_radius = point.r;
+  const double maximum_squared_distance =
+      this->simplification * this->simplification;
+
+  std::vector<bool> &keeps_point = simplification_keeps_point;
+  keeps_point.assign(number_of_points, false);
+  keeps_point.front() = true;
+  keeps_point.back() = true;
+
+  std::vector<std::pair<int, int>> &ranges = simplification_ranges;
+  ranges.clear();
+  ranges.push_back(std::make_pair(0, number_of_points - 1));
+
+  while (!ranges.empty()) {
+    const int first = ranges.back().first;
+    const int last = ranges.back().second;
+    ranges.pop_back();
+
+    const double segment_x = x[last] - x[first];
+    const double segment_y = y[last] - y[first];
+    const double squared_length = segment_x * segment_x + segment_y * segment_y;
+
+    double farthest_squared_distance = 0.0;
+    int farthest_point = -1;
+    for (int point = first + 1; point < last; ++point) {
+      /**
+       * The distance to the closest point of the segment.
+       */
+      double position = 0.0;
+      if (squared_length > 0.0) {
+        position = ((x[point] - x[first]) * segment_x +
+                    (y[point] - y[first]) * segment_y) /
+                   squared_length;
+        position = std::max(0.0, std::min(1.0, position));
       }
+
+      const double delta_x = x[point] - (x[first] + position * segment_x);
+      const double delta_y = y[point] - (y[first] + position * segment_y);
+      const double squared_distance = delta_x * delta_x + delta_y * delta_y;
+      if (squared_distance > farthest_squared_distance) {
+        farthest_squared_distance = squared_distance;
+        farthest_point = point;
+      }
+    }
+
+    if (farthest_point >= 0 &&
+        farthest_squared_distance > maximum_squared_distance) {
+      keeps_point[farthest_point] = true;
+      ranges.push_back(std::make_pair(first, farthest_point));
+      ranges.push_back(std::make_pair(farthest_point, last));
     }
   }
 
+  const int number_of_kept_points =
+      std::count(keeps_point.begin(), keeps_point.end(), true);
+  if (number_of_kept_points == number_of_points) {
+    return path;
+  }
+
+  simplified.clear();
+  simplified.reserve(number_of_kept_points);
+  simplified.is_closed = path.is_closed;
+  for (int point = 0; point < number_of_points; ++point) {
+    if (keeps_point[point]) {
+      simplified.push_back(path.r[point], path.phi[point]);
+    }
+  }
+
+  return simplified;
+}
+
+void Canvas::ipe_canvas_representation(OutputSink &sink) const {
+  /**
+   * Print the ipe header.
+   */
+  sink << "<?xml version=\"1.0\"?>\n"
+          "<!DOCTYPE ipe SYSTEM \"ipe.dtd\">\n"
+          "<ipe version=\"70206\" creator=\"Ipe 7.2.7\">\n"
+          "<info created=\"D:20170719160807\" modified=\"D:20170719160807\"/>\n"
+          "<ipestyle name=\"basic\">\n"
+          "</ipestyle>\n"
+          "<page>\n"
+          "<layer name=\"alpha\"/>\n"
+          "<view layers=\"alpha\" active=\"alpha\"/>\n";
+
+  /**
+   * In order to obtain a nice drawing, we now determine the
+   * coordinate with the largest radius (or the viewport). When we know
+   * that, we translate everything such that all points are in the
+   * drawing canvas. (E.g. in Ipe the point 0,0 is in the bottom left
+   * and everything with negative x/y coordinates is out of the
+   * canvas.)
+   */
+  Euc center(0.0, 0.0);
+  double radius;
+  drawing_area(center, radius);
+
+  /**
+   * The offset that shifts everything.
+   */
+  Euc offset(this->scale * (radius - center.x),
+             this->scale * (radius - center.y));
+
+  /**
+   * Print Marks and Paths.
+   */
+  const double scale = this->scale;
+  write_marks_and_paths(
+      sink,
+      [scale, offset](const Circle &mark, OutputSink &sink) {
+        Canvas::ipe_circle_representation(mark, sink, scale, offset);
+      },
+      [scale, offset](const Path &path, OutputSink &sink) {
+        Canvas::ipe_path_representation(path, sink, scale, offset);
+      });
+
+  /**
+   * Print Ipe footer.
+   */
+  sink << "</page>\n"
+          "</ipe>";
+}
+
+void Canvas::svg_canvas_representation(OutputSink &sink) const {
+
+  /**
+   * In order to obtain a nice drawing, we now determine the
+   * coordinate with the largest radius (or the viewport). When we know
+   * that, we translate everything such that all points are in the
+   * drawing canvas. (E.g. in Ipe the point 0,0 is in the bottom left
+   * and everything with negative x/y coordinates is out of the
+   * canvas.)
+   */
+  Euc center(0.0, 0.0);
+  double radius;
+  drawing_area(center, radius);
+
   /**
    * The offset that shifts everything.
    */
-  Euc offset(this->scale * maximum_radius,
-             this->scale * maximum_radius);
+  Euc offset(this->scale * (radius - center.x),
+             this->scale * (radius - center.y));
 
   /**
    * SVG Header
    */
-  svg_representation =
-      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE svg PUBLIC "
-      "\"-//W3C//DTD SVG 1.1//EN\" "
-      "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n\n<svg "
-      "xmlns=\"http://www.w3.org/2000/svg\"\nxmlns:xlink=\"http://www.w3.org/"
-      "1999/xlink\" "
-      "xmlns:ev=\"http://www.w3.org/2001/xml-events\"\nversion=\"1.1\" ";
+  sink << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE svg PUBLIC "
+          "\"-//W3C//DTD SVG 1.1//EN\" "
+          "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n\n<svg "
+          "xmlns=\"http://www.w3.org/2000/svg\"\nxmlns:xlink=\"http://www.w3.org/"
+          "1999/xlink\" "
+          "xmlns:ev=\"http://www.w3.org/2001/xml-events\"\nversion=\"1.1\" ";
 
-  svg_representation += std::string("baseProfile=\"full\"\nwidth=\"") +
-                        std::to_string(offset.x * 2.0) + "\" height=\"" +
-                        std::to_string(offset.y * 2.0) + "\">\n\n";
+  sink << "baseProfile=\"full\"\nwidth=\"" << this->scale * radius * 2.0
+       << "\" height=\"" << this->scale * radius * 2.0 << "\">\n\n";
 
   /**
-   * Print Marks.
+   * Print Marks and Paths.
    */
-  for (const Circle &mark : this->marks) {
-    std::string circle_representation;
-    Canvas::svg_circle_representation(mark, circle_representation, this->scale,
-                                      offset);
-    svg_representation += circle_representation;
+  const double scale = this->scale;
+  write_marks_and_paths(
+      sink,
+      [scale, offset](const Circle &mark, OutputSink &sink) {
+        Canvas::svg_circle_representation(mark, sink, scale, offset);
+      },
+      [scale, offset](const Path &path, OutputSink &sink) {
+        Canvas::svg_path_representation(path, sink, scale, offset);
+      });
+
+  /**
+   * Print SVG footer.
+   */
+  sink << "\n</svg>\n";
+}
+
+void Canvas::png_canvas_representation(std::ostream &stream) const {
+  Euc center(0.0, 0.0);
+  double radius;
+  drawing_area(center, radius);
+
+  /**
+   * The size of the drawing, like in the SVG file.
+   */
+  const double drawing_size = 2.0 * this->scale * radius;
+
+  int width = this->image_width;
+  int height = this->image_height;
+  if (width <= 0 || height <= 0) {
+    width = height = std::max(
+        1.0, std::min((double)maximum_image_size, std::ceil(drawing_size)));
   }
 
   /**
-   * Print Paths.
+   * The drawing is scaled to fit into the image and centered.
+   */
+  const double pixels_per_unit =
+      drawing_size > 0.0 ? std::min(width, height) / drawing_size : 1.0;
+  const double scale = this->scale * pixels_per_unit;
+  const Euc offset(
+      (width - drawing_size * pixels_per_unit) / 2.0 +
+          scale * (radius - center.x),
+      (height - drawing_size * pixels_per_unit) / 2.0 +
+          scale * (radius - center.y));
+
+  /**
+   * Paths and the outlines of marks have the same width as in the SVG
+   * file.
+   */
+  const double stroke_radius = 0.1 * scale;
+
+  ThreadPool thread_pool(this->export_threads);
+  Rasterizer rasterizer(width, height, thread_pool);
+
+  /**
+   * Like when writing the other formats, the objects are converted to
+   * strokes in rounds of chunks, one chunk per thread, such that only
+   * the strokes of the current round have to be kept in memory.
    */
-  for (const Path &path : this->paths) {
-    std::string path_representation;
-    Canvas::svg_path_representation(path, path_representation, this->scale, offset);
-    svg_representation += path_representation;
+  static const int objects_per_chunk = 1024;
+  const int chunks_per_round = thread_pool.size();
+  std::vector<std::vector<Stroke>> batches(chunks_per_round);
+
+  const int number_of_marks = this->marks.size();
+  const int number_of_objects = number_of_marks + this->paths.size();
+
+  for (int round_start = 0; round_start < number_of_objects;
+       round_start += chunks_per_round * objects_per_chunk) {
+    thread_pool.parallel_for(chunks_per_round, [&](int chunk) {
+      std::vector<Stroke> &strokes = batches[chunk];
+      strokes.clear();
+
+      const int start = round_start + chunk * objects_per_chunk;
+      const int end = std::min(start + objects_per_chunk, number_of_objects);
+
+      Path path;
+      Path piece;
+      for (int index = start; index < end; ++index) {
+        if (index < number_of_marks) {
+          const Circle &mark = this->marks[index];
+          if (!is_visible(mark)) {
+            continue;
+          }
+
+          Euc center(mark.center, scale);
+          center.x += offset.x;
+          center.y += offset.y;
+
+          const double radius = mark.radius * scale;
+          strokes.push_back(
+              {center.x, center.y, center.x, center.y,
+               mark.is_filled ? -(radius + stroke_radius)
+                              : std::max(radius - stroke_radius,
+                                         -(radius + stroke_radius)),
+               radius + stroke_radius});
+          continue;
+        }
+
+        for_each_visible_path(
+            this->paths[index - number_of_marks], path, piece,
+            [&](const Path &points) {
+              if (points.size() < 2) {
+                return;
+              }
+
+              std::vector<double> &x = euclidean_x;
+              std::vector<double> &y = euclidean_y;
+              Canvas::euclidean_coordinates(points, scale, offset, x, y);
+
+              for (int point = 1; point < points.size(); ++point) {
+                strokes.push_back({x[point - 1], y[point - 1], x[point],
+                                   y[point], -stroke_radius, stroke_radius});
+              }
+
+              if (points.is_closed) {
+                strokes.push_back({x.back(), y.back(), x[0], y[0],
+                                   -stroke_radius, stroke_radius});
+              }
+            });
+      }
+    });
+
+    rasterizer.draw(batches);
   }
 
+  PNGWriter::write_grayscale(stream, width, height, rasterizer.pixels.data());
+}
+
+void Canvas::write_marks_and_paths(
+    OutputSink &sink,
+    const std::function<void(const Circle &, OutputSink &)> &write_mark,
+    const std::function<void(const Path &, OutputSink &)> &write_path) const {
   /**
-   * Print SVG footer.
+   * Objects that are drawn more than once are skipped.
    */
-  svg_representation += "\n</svg>\n";
+  std::vector<bool> is_duplicate_mark;
+  std::vector<bool> is_duplicate_path;
+  if (this->simplification > 0.0) {
+    find_duplicates(is_duplicate_mark, is_duplicate_path);
+  }
+
+  const auto is_written_mark = [this, &is_duplicate_mark](int index) {
+    return (is_duplicate_mark.empty() || !is_duplicate_mark[index]) &&
+           is_visible(this->marks[index]);
+  };
+
+  const auto is_written_path = [&is_duplicate_path](int index) {
+    return is_duplicate_path.empty() || !is_duplicate_path[index];
+  };
+
+  if (this->export_threads <= 1) {
+    for (int index = 0; index < (int)this->marks.size(); ++index) {
+      if (is_written_mark(index)) {
+        write_mark(this->marks[index], sink);
+      }
+    }
+
+    Path path;
+    Path piece;
+    Path simplified;
+    for (int index = 0; index < (int)this->paths.size(); ++index) {
+      if (!is_written_path(index)) {
+        continue;
+      }
+
+      for_each_visible_path(this->paths[index], path, piece,
+                            [&](const Path &visible_path) {
+                              write_path(
+                                  simplified_path(visible_path, simplified),
+                                  sink);
+                            });
+    }
+    return;
+  }
+
+  /**
+   * The objects are split into chunks of the following size. Each
+   * round, every thread gets one chunk, such that only the buffers of
+   * the current round have to be kept in memory.
+   */
+  static const int objects_per_chunk = 1024;
+
+  ThreadPool thread_pool(this->export_threads);
+  const int chunks_per_round = thread_pool.size();
+
+  std::vector<std::string> buffers(chunks_per_round);
+
+  /**
+   * The marks are numbered before the paths.
+   */
+  const int number_of_marks = this->marks.size();
+  const int number_of_objects = number_of_marks + this->paths.size();
+
+  for (int round_start = 0; round_start < number_of_objects;
+       round_start += chunks_per_round * objects_per_chunk) {
+    thread_pool.parallel_for(chunks_per_round, [&](int chunk) {
+      OutputSink chunk_sink(nullptr, sink.precision);
+      chunk_sink.buffer = std::move(buffers[chunk]);
+      chunk_sink.buffer.clear();
+
+      const int start = round_start + chunk * objects_per_chunk;
+      const int end = std::min(start + objects_per_chunk, number_of_objects);
+
+      Path path;
+      Path piece;
+      Path simplified;
+      for (int index = start; index < end; ++index) {
+        if (index < number_of_marks) {
+          if (is_written_mark(index)) {
+            write_mark(this->marks[index], chunk_sink);
+          }
+        } else if (is_written_path(index - number_of_marks)) {
+          for_each_visible_path(
+              this->paths[index - number_of_marks], path, piece,
+              [&](const Path &visible_path) {
+                write_path(simplified_path(visible_path, simplified),
+                           chunk_sink);
+              });
+        }
+      }
+
+      buffers[chunk] = std::move(chunk_sink.buffer);
+    });
+
+    for (const std::string &buffer : buffers) {
+      sink << buffer;
+    }
+  }
 }
 
-/**
- * Creates a string that represents the passed path.
- */
-void Canvas::ipe_path_representation(const Path &path,
-                                     std::string &ipe_path_representation,
+void Canvas::euclidean_coordinates(const Path &path, double scale,
+                                   Euc offset, std::vector<double> &x,
+                                   std::vector<double> &y) {
+  x.resize(path.size());
+  y.resize(path.size());
+  Kernels::polar_to_euclidean(path.r.data(), path.phi.data(), path.size(),
+                              scale, offset.x, offset.y, x.data(), y.data());
+}
+
+void Canvas::ipe_path_representation(const Path &path, OutputSink &sink,
                                      double scale, Euc offset) {
   /**
-   * Only determine the representation if the path is not empty.
+   * Only write the representation if the path is not empty.
    */
   if (!path.empty()) {
-    ipe_path_representation =
-        std::string("<path stroke=\"") + "black" + "\">\n";
+    sink << "<path stroke=\"" << "black" << "\">\n";
+
+    std::vector<double> &x = euclidean_x;
+    std::vector<double> &y = euclidean_y;
+    Canvas::euclidean_coordinates(path, scale, offset, x, y);
 
     /**
      * Print the first point of the path.
      */
-    Euc point(path.points[0], scale);
-    point.x += offset.x;
-    point.y += offset.y;
-    ipe_path_representation +=
-        std::to_string(point.x) + " " + std::to_string(point.y) + " m\n";
+    sink << x[0] << ' ' << y[0] << " m\n";
 
     /**
      * Print the remaining points.
      */
     for (int index = 1; index < path.size(); ++index) {
-      point = Euc(path.points[index], scale);
-      point.x += offset.x;
-      point.y += offset.y;
-
-      ipe_path_representation +=
-          std::to_string(point.x) + " " + std::to_string(point.y) + " l\n";
+      sink << x[index] << ' ' << y[index] << " l\n";
     }
 
     if (path.is_closed) {
-      ipe_path_representation += "h\n";
+      sink << "h\n";
     }
 
-    ipe_path_representation += "</path>\n";
+    sink << "</path>\n";
   }
 }
 
-void Canvas::svg_path_representation(const Path &path,
-                                     std::string &svg_path_representation,
+void Canvas::svg_path_representation(const Path &path, OutputSink &sink,
                                      double scale, Euc offset) {
 
-  svg_path_representation = std::string("<path d =\"");
+  sink << "<path d =\"";
 
   /**
-   * Only determine the representation if the path is not empty.
+   * Only write the points if the path is not empty.
    */
   if (!path.empty()) {
 
+    std::vector<double> &x = euclidean_x;
+    std::vector<double> &y = euclidean_y;
+    Canvas::euclidean_coordinates(path, scale, offset, x, y);
+
     /**
      * Print the first point of the path.
      */
-    Euc point(path.points[0], scale);
-    point.x += offset.x;
-    point.y += offset.y;
-    svg_path_representation += std::string("M ") + std::to_string(point.x) +
-                               "," + std::to_string(point.y) + " ";
+    sink << "M " << x[0] << ',' << y[0] << ' ';
 
     /**
      * Print the remaining points.
      */
     for (int index = 1; index < path.size(); ++index) {
-      point = Euc(path.points[index], scale);
-      point.x += offset.x;
-      point.y += offset.y;
-
-      svg_path_representation += std::string("L ") + std::to_string(point.x) + ", " + std::to_string(point.y) + " ";
+      sink << "L " << x[index] << ", " << y[index] << ' ';
     }
 
     if (path.is_closed) {
-      svg_path_representation += "Z";
+      sink << 'Z';
     }
 
     double path_width = 0.2 * scale;
 
-    svg_path_representation +=
-        std::string("\" stroke = \"") + "black" + "\" stroke-width = \"" +
-        std::to_string(path_width) + "\" fill=\"none\"/>";
+    sink << "\" stroke = \"" << "black" << "\" stroke-width = \"" << path_width
+         << "\" fill=\"none\"/>";
   }
 }
 
-void Canvas::ipe_circle_representation(const Circle &circle,
-                                       std::string &ipe_circle_representation,
+void Canvas::ipe_circle_representation(const Circle &circle, OutputSink &sink,
                                        double scale, Euc offset) {
   Euc center(circle.center, scale);
   center.x += offset.x;
   center.y += offset.y;
 
-  ipe_circle_representation =
-    std::string("<path stroke=\"") + "black" + "\"";
+  sink << "<path stroke=\"" << "black" << "\"";
 
   if (circle.is_filled) {
-    ipe_circle_representation += std::string(" fill=\"") + "black" + "\"";
+    sink << " fill=\"" << "black" << "\"";
   }
 
-  ipe_circle_representation +=
-      std::string(">\n") + std::to_string(circle.radius * scale) + " 0 0 " +
-      std::to_string(circle.radius * scale) + " " + std::to_string(center.x) + " " +
-      std::to_string(center.y) + " e\n</path>\n";
+  sink << ">\n"
+       << circle.radius * scale << " 0 0 " << circle.radius * scale << ' '
+       << center.x << ' ' << center.y << " e\n</path>\n";
 }
 
-void Canvas::svg_circle_representation(const Circle &circle,
-                                       std::string &svg_circle_representation,
+void Canvas::svg_circle_representation(const Circle &circle, OutputSink &sink,
                                        double scale, Euc offset) {
   Euc center(circle.center, scale);
   center.x += offset.x;
@@ -325,23 +1493,141 @@ void Canvas::svg_circle_representation(const Circle &circle,
 
   double stroke_width = 0.2 * scale;
 
-  if (circle.is_filled) {
-    svg_circle_representation =
-        std::string("<circle cx=\"") + std::to_string(center.x) + "\" cy=\"" +
-        std::to_string(center.y) + "\" r=\"" +
-        std::to_string(circle.radius * scale) + "\" fill=\"" + "black" +
-        "\" stroke=\"" + "black" + "\" stroke-width=\"" +
-        std::to_string(stroke_width) + "\"/>\n";
+  sink << "<circle cx=\"" << center.x << "\" cy=\"" << center.y << "\" r=\""
+       << circle.radius * scale << "\" fill=\""
+       << (circle.is_filled ? "black" : "none") << "\" stroke=\"" << "black"
+       << "\" stroke-width=\"" << stroke_width << "\"/>\n";
+}
+
+namespace {
+
+/**
+ * The closed form of a line in the hyperboloid model that is
+ * explained in path_for_line: with M denoting the midpoint between the end
+ * points and T the direction of the line at M, the point at distance
+ * t from the first point is
+ *
+ *   cosh(t - d/2) M + sinh(t - d/2) T,
+ *
+ * where d is the length of the line.  Only the last two coordinates
+ * of M and T are stored.
+ */
+struct LineGeometry {
+  LineGeometry(const Pol &from, const Pol &to) {
+    /**
+     * Determine sinh(d/2) from the polar coordinates directly, which
+     * is numerically stable even if the points are very close.
+     */
+    const double sinh_from = sinh(from.r);
+    const double sinh_to = sinh(to.r);
+    const double sinh_half_delta_r = sinh(0.5 * (from.r - to.r));
+    const double sin_half_delta_phi = sin(0.5 * (from.phi - to.phi));
+
+    this->sinh_half_length =
+        sqrt(sinh_half_delta_r * sinh_half_delta_r +
+             sinh_from * sinh_to * sin_half_delta_phi * sin_half_delta_phi);
+
+    if (this->sinh_half_length > 0.0) {
+      const double cosh_half_length =
+          sqrt(1.0 + this->sinh_half_length * this->sinh_half_length);
+      this->half_length = asinh(this->sinh_half_length);
+
+      const double from_x = sinh_from * cos(from.phi);
+      const double from_y = sinh_from * sin(from.phi);
+      const double to_x = sinh_to * cos(to.phi);
+      const double to_y = sinh_to * sin(to.phi);
+
+      this->midpoint_x = (from_x + to_x) / (2.0 * cosh_half_length);
+      this->midpoint_y = (from_y + to_y) / (2.0 * cosh_half_length);
+      this->direction_x = (to_x - from_x) / (2.0 * this->sinh_half_length);
+      this->direction_y = (to_y - from_y) / (2.0 * this->sinh_half_length);
+    }
+  }
+
+  /**
+   * The point at distance t from the first point.
+   */
+  Pol point_at(double t) const {
+    const double cosh_offset = cosh(t - this->half_length);
+    const double sinh_offset = sinh(t - this->half_length);
+
+    const double x =
+        cosh_offset * this->midpoint_x + sinh_offset * this->direction_x;
+    const double y =
+        cosh_offset * this->midpoint_y + sinh_offset * this->direction_y;
+
+    return Pol(asinh(sqrt(x * x + y * y)), atan2(y, x));
+  }
+
+  double sinh_half_length = 0.0;
+  double half_length = 0.0;
+  double midpoint_x = 0.0;
+  double midpoint_y = 0.0;
+  double direction_x = 0.0;
+  double direction_y = 0.0;
+};
+
+/**
+ * Adaptive tessellation halves an interval at most this often, which
+ * bounds the number of points if the tolerance is tiny.
+ */
+const int maximum_subdivision_depth = 16;
+
+/**
+ * The distance between the point b and the segment from a to c, in
+ * the native representation (i.e., in the drawing before applying
+ * the scale).
+ */
+double deviation(const Pol &a, const Pol &b, const Pol &c) {
+  const double a_x = a.r * cos(a.phi);
+  const double a_y = a.r * sin(a.phi);
+  const double b_x = b.r * cos(b.phi) - a_x;
+  const double b_y = b.r * sin(b.phi) - a_y;
+  const double c_x = c.r * cos(c.phi) - a_x;
+  const double c_y = c.r * sin(c.phi) - a_y;
+
+  const double squared_length = c_x * c_x + c_y * c_y;
+  double t = 0.0;
+  if (squared_length > 0.0) {
+    t = std::max(0.0, std::min(1.0, (b_x * c_x + b_y * c_y) / squared_length));
+  }
+
+  return std::hypot(b_x - t * c_x, b_y - t * c_y);
+}
+
+/**
+ * Adds the point at start and the points that are needed between
+ * start and end to the path, such that the segments deviate from the
+ * curve given by point_at by at most the tolerance.  An interval is
+ * halved as long as one of the points at a quarter, half or three
+ * quarters of it deviates too much from the segment between its end
+ * points.  Checking more than the middle catches parts where the
+ * parametrization is uneven, and the points at the quarters are the
+ * middles of the halves, so they are reused when halving.
+ */
+template <typename PointAt>
+void subdivide(const PointAt &point_at, double start, const Pol &start_point,
+               const Pol &middle_point, double end, const Pol &end_point,
+               double tolerance, int depth, Path &path) {
+  const double middle = 0.5 * (start + end);
+  const Pol first_quarter_point = point_at(0.5 * (start + middle));
+  const Pol third_quarter_point = point_at(0.5 * (middle + end));
+
+  if (depth < maximum_subdivision_depth &&
+      (deviation(start_point, middle_point, end_point) > tolerance ||
+       deviation(start_point, first_quarter_point, end_point) > tolerance ||
+       deviation(start_point, third_quarter_point, end_point) > tolerance)) {
+    subdivide(point_at, start, start_point, first_quarter_point, middle,
+              middle_point, tolerance, depth + 1, path);
+    subdivide(point_at, middle, middle_point, third_quarter_point, end,
+              end_point, tolerance, depth + 1, path);
   } else {
-    svg_circle_representation =
-      std::string("<circle cx=\"") + std::to_string(center.x) + "\" cy=\"" +
-      std::to_string(center.y) + "\" r=\"" +
-      std::to_string(circle.radius * scale) + "\" fill=\"" + "none" +
-      "\" stroke=\"" + "black" + "\" stroke-width=\"" +
-      std::to_string(stroke_width) + "\"/>\n";
+    path.push_back(start_point);
   }
 }
 
+}  // namespace
+
 void Canvas::path_for_circle(const Pol &center, double radius, double resolution,
                              Path &path) {
 
@@ -363,9 +1649,10 @@ void Canvas::path_for_circle(const Pol &center, double radius, double resolution
     double angle = 0.0;
     double angle_step_size = (2.0 * M_PI) / resolution;
 
+    path.reserve(resolution + 1.0);
+
     while (angle < 2.0 * M_PI) {
-      Pol point(radius, angle);
-      path.push_back(point);
+      path.push_back(radius, angle);
       angle += angle_step_size;
     }
 
@@ -391,8 +1678,6 @@ void Canvas::path_for_circle(const Pol &center, double radius, double resolution
   double r = r_max;
   double angle = 0.0;
 
-  Pol point(0.0, 0.0);
-
   /**
    * When we get closer to the origin, we need finer steps in order to
    * get a smooth circle.
@@ -401,6 +1686,13 @@ void Canvas::path_for_circle(const Pol &center, double radius, double resolution
   double additional_detail_points = resolution / 5.0;
   double additional_step_size = step_size / additional_detail_points;
 
+  /**
+   * On each side of the x-axis, there are about resolution many
+   * points with the regular step size and resolution many additional
+   * points close to the minimum radius.
+   */
+  path.reserve(4.0 * resolution + 4.0);
+
   /**
    * First we determine the circle points on one side of the x-axis.
    */
@@ -415,8 +1707,10 @@ void Canvas::path_for_circle(const Pol &center, double radius, double resolution
       angle = new_angle;
     }
 
-    point = Pol(r, angle);
-    path.push_back(point);
+    /**
+     * The angles determined by theta are between 0 and pi.
+     */
+    path.push_back(r, angle);
 
     /**
      * If we're close to the minimum radius, we need finer steps.
@@ -432,8 +1726,7 @@ void Canvas::path_for_circle(const Pol &center, double radius, double resolution
         }
 
         if (additional_r >= r_min) {
-          point = Pol(additional_r, angle);
-          path.push_back(point);
+          path.push_back(additional_r, angle);
         }
 
         additional_r -= additional_step_size;
@@ -452,7 +1745,7 @@ void Canvas::path_for_circle(const Pol &center, double radius, double resolution
   if (center.r > radius) {
     inner_point_angle = 0.0;
   }
-  path.push_back(Pol(r_min, inner_point_angle));
+  path.push_back(r_min, inner_point_angle);
 
   /**
    * Now we copy all points by mirroring them on the x-axis. We exclude the
@@ -461,18 +1754,21 @@ void Canvas::path_for_circle(const Pol &center, double radius, double resolution
    */
   int i = path.size() - 2;
   while (i > 0) {
-    point = path.points[i];
-    path.push_back(Pol(point.r, (2.0 * M_PI) - point.phi));
+    path.push_back(path.r[i], (2.0 * M_PI) - path.phi[i]);
 
     --i;
   }
 
   /**
    * Finally we rotate all points around the origin to match the angular
-   * coordinate of the circle center.
+   * coordinate of the circle center (just like Pol::rotate_by).
    */
-  for (Pol &p : path.points) {
-    p.rotate_by(center.phi);
+  for (double &phi : path.phi) {
+    phi = std::fmod(phi + center.phi, 2.0 * M_PI);
+
+    while (phi < 0.0) {
+      phi += 2.0 * M_PI;
+    }
   }
 }
 
@@ -484,64 +1780,86 @@ void Canvas::path_for_line(const Pol &from, const Pol &to, double resolution,
   path.is_closed = false;
 
   /**
-   * We first translate / rotate both points, such that one of the
-   * lies in the origin. Then we samples resolution many points on the
-   * radius from the origin to the second point. Afterwards we perform
-   * the inverse translation / rotation (inverse to the first
-   * operation) to all points.
-   *
-   * All we need for these translations / rotations are the coordinate
-   * of the first point. (We copy both points, since we must not
-   * manipulate the input coordinates.)
+   * The points are sampled with equal distances, such that resolution
+   * many steps lead from the first to the second point. To determine
+   * the length of the line, we translate / rotate the second point,
+   * as if the first one was moved to the origin. (We copy the second
+   * point, since we must not manipulate the input coordinates.)
    */
-  Pol p1(from);
   Pol p2(to);
-  double from_radius = from.r;
-  double from_phi = from.phi;
+  p2.rotate_by(-from.phi);
+  p2.translate_horizontally_by(-from.r);
 
   /**
-   * Rotate 'both' points by -from_phi (such that p1 lies on the
-   * x-axis). We don't need to actually perform the transformation on p1
-   * itself. In the end we only care for the position of p2.
+   * The path consists of the two end points and the points in
+   * between.
    */
-  p2.rotate_by(-from_phi);
+  path.reserve(resolution + 2.0);
 
-  /**
-   * Translate 'both' points (such that p1 lies on the origin). Since
-   * p1 will then be on the origin we don't need to actually perform
-   * the transformation on p1.
-   */
-  p2.translate_horizontally_by(-from_radius);
+  path.push_back(from); // The first point on the path.
 
   /**
-   * Now p1 is on the origin and all points on the line from p1 to p2
-   * have the same angular coordinate as p2 currently has.
+   * Instead of transforming each sampled point back individually, we
+   * determine the points in the hyperboloid model, where the line is
+   * given in closed form. A point with polar coordinates (r, phi) is
+   * represented by (cosh(r), sinh(r) cos(phi), sinh(r) sin(phi)).
+   * With M denoting the midpoint between the two points and T the
+   * direction of the line at M, the point at distance t from the
+   * first point is
+   *
+   *   cosh(t - d/2) M + sinh(t - d/2) T,
+   *
+   * where d is the length of the line. We only need the last two
+   * coordinates (x, y), from which we obtain the radius as
+   * asinh(sqrt(x^2 + y^2)) and the angle as atan2(y, x). Since the
+   * points are equidistant, exp(t - d/2) is updated by a
+   * multiplication, such that each point only requires basic
+   * arithmetic, a square root, asinh and atan2.
+   *
+   * In contrast to transforming the points with
+   * translate_horizontally_by, this is numerically stable even for
+   * lines far away from the origin.
    */
-  path.push_back(from); // The first point on the path.
+  const double step_size = p2.r / resolution;
+
+  const LineGeometry line(from, to);
 
   /**
-   * Add the points
+   * If the points coincide, there are no points in between.
    */
-  double step_size = p2.r / resolution;
-  double r = step_size;
+  if (line.sinh_half_length > 0.0) {
+    const double half_length = line.half_length;
+    const double midpoint_x = line.midpoint_x;
+    const double midpoint_y = line.midpoint_y;
+    const double direction_x = line.direction_x;
+    const double direction_y = line.direction_y;
 
-  while (r < p2.r) {
     /**
-     * Create the point.
+     * exp(t - d/2) and exp(d/2 - t) for the current point.
      */
-    Pol point(r, p2.phi);
+    const double exp_step_size = exp(step_size);
+    const double exp_negative_step_size = exp(-step_size);
+    double exp_offset = exp(step_size - half_length);
+    double exp_negative_offset = exp(half_length - step_size);
 
-    /**
-     * Apply the inverse transformation.
-     */
-    point.translate_horizontally_by(from_radius);
-    point.rotate_by(from_phi);
+    double r = step_size;
 
-    /**
-     * Add the point and continue with the next one.
-     */
-    path.push_back(point);
-    r += step_size;
+    while (r < p2.r) {
+      const double cosh_offset = 0.5 * (exp_offset + exp_negative_offset);
+      const double sinh_offset = 0.5 * (exp_offset - exp_negative_offset);
+
+      const double x = cosh_offset * midpoint_x + sinh_offset * direction_x;
+      const double y = cosh_offset * midpoint_y + sinh_offset * direction_y;
+
+      /**
+       * Add the point and continue with the next one.
+       */
+      path.push_back(Pol(asinh(sqrt(x * x + y * y)), atan2(y, x)));
+
+      r += step_size;
+      exp_offset *= exp_step_size;
+      exp_negative_offset *= exp_negative_step_size;
+    }
   }
 
   /**
@@ -550,4 +1868,61 @@ void Canvas::path_for_line(const Pol &from, const Pol &to, double resolution,
   path.push_back(to);
 }
 
+void Canvas::adaptive_path_for_circle(const Pol &center, double radius,
+                                      double tolerance, Path &path) {
+  path.is_closed = true;
+
+  /**
+   * The points are parametrized by their angle around the center. We
+   * first determine them as if the center had angular coordinate 0,
+   * by translating the point with polar coordinates (radius, angle)
+   * along the x-axis in the hyperboloid model, and rotate them
+   * afterwards.
+   */
+  const double cosh_center = cosh(center.r);
+  const double sinh_center = sinh(center.r);
+  const double cosh_radius = cosh(radius);
+  const double sinh_radius = sinh(radius);
+
+  const auto point_at = [&](double angle) {
+    const double x =
+        sinh_center * cosh_radius + cosh_center * sinh_radius * cos(angle);
+    const double y = sinh_radius * sin(angle);
+    return Pol(asinh(sqrt(x * x + y * y)), atan2(y, x) + center.phi);
+  };
+
+  /**
+   * A circle is not straight anywhere, so a few initial pieces make
+   * sure that the subdivision does not stop too early.
+   */
+  static const int initial_pieces = 4;
+  const double piece_size = 2.0 * M_PI / initial_pieces;
+
+  Pol start_point = point_at(0.0);
+  for (int piece = 0; piece < initial_pieces; ++piece) {
+    const double start = piece * piece_size;
+    const double end = start + piece_size;
+    const Pol end_point = point_at(end);
+    subdivide(point_at, start, start_point, point_at(0.5 * (start + end)),
+              end, end_point, tolerance, 0, path);
+    start_point = end_point;
+  }
+}
+
+void Canvas::adaptive_path_for_line(const Pol &from, const Pol &to,
+                                    double tolerance, Path &path) {
+  path.is_closed = false;
+
+  const LineGeometry line(from, to);
+  if (line.sinh_half_length > 0.0) {
+    subdivide([&line](double t) { return line.point_at(t); }, 0.0, from,
+              line.point_at(line.half_length), 2.0 * line.half_length, to,
+              tolerance, 0, path);
+  } else {
+    path.push_back(from);
+  }
+
+  path.push_back(to);
+}
+
 }  // namespace hydra
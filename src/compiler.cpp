@@ -0,0 +1,757 @@
+//
+//  compiler.cpp
+//  hydra
+//
+
+#include <compiler.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+namespace hydra {
+
+Compiler::Compiler(Interpreter &interpreter) : interpreter(interpreter) {}
+
+bool Compiler::compile_code(const std::vector<ParseResult> &code,
+                            Chunk &chunk) {
+  this->next_free_register = 0;
+  this->current_line_number = -1;
+  this->defined_functions.clear();
+
+  return compile_statements(code, 0, chunk);
+}
+
+int Compiler::allocate_register(Chunk &chunk) {
+  int allocated_register = this->next_free_register++;
+
+  if (this->next_free_register > chunk.number_of_registers) {
+    chunk.number_of_registers = this->next_free_register;
+  }
+
+  return allocated_register;
+}
+
+int Compiler::emit(Chunk &chunk, OpCode op_code, int a, int b, int c) {
+  Instruction instruction;
+  instruction.op_code = op_code;
+  instruction.a = a;
+  instruction.b = b;
+  instruction.c = c;
+
+  chunk.instructions.push_back(instruction);
+  chunk.line_numbers.push_back(this->current_line_number);
+
+  return chunk.instructions.size() - 1;
+}
+
+int Compiler::add_constant(Chunk &chunk, const Value &constant) {
+  chunk.constants.push_back(constant);
+  return chunk.constants.size() - 1;
+}
+
+int Compiler::add_name(Chunk &chunk, const std::string &name) {
+  /**
+   * Names are used repeatedly, so we store each only once.
+   */
+  for (int index = 0; index < (int)chunk.names.size(); ++index) {
+    if (chunk.names[index] == name) {
+      return index;
+    }
+  }
+
+  chunk.names.push_back(name);
+  return chunk.names.size() - 1;
+}
+
+int Compiler::add_variable(Chunk &chunk, const ParseResult &variable) {
+  for (int index = 0; index < (int)chunk.variables.size(); ++index) {
+    const VariableReference &reference = chunk.variables[index];
+    if (reference.name == variable.value && reference.frame == variable.frame &&
+        reference.slot == variable.slot) {
+      return index;
+    }
+  }
+
+  VariableReference reference;
+  reference.name = variable.value;
+  reference.frame = variable.frame;
+  reference.slot = variable.slot;
+
+  chunk.variables.push_back(reference);
+  return chunk.variables.size() - 1;
+}
+
+bool Compiler::compile_statements(Span<const ParseResult> statements,
+                                  int first_statement, Chunk &chunk) {
+  /**
+   * The value of the last statement is the value of the whole
+   * chunk.
+   */
+  int result_register = -1;
+
+  for (int index = first_statement; index < (int)statements.size(); ++index) {
+    /**
+     * Each statement gets a fresh register for its value. Since only
+     * the value of the last statement matters, all statements can
+     * share the same register.
+     */
+    this->next_free_register = 0;
+    int target = allocate_register(chunk);
+
+    bool has_value = false;
+    if (!compile_parse_result(statements[index], chunk, target, has_value)) {
+      return false;
+    }
+
+    result_register = has_value ? target : -1;
+  }
+
+  emit(chunk, OpCode::Return, result_register);
+  return true;
+}
+
+bool Compiler::compile_parse_result(const ParseResult &input, Chunk &chunk,
+                                    int target, bool &has_value) {
+  has_value = true;
+
+  /**
+   * Nested ParseResults often don't know which line they stem
+   * from. In that case they belong to the line of the enclosing
+   * statement.
+   */
+  int enclosing_line_number = this->current_line_number;
+  if (input.line_number >= 0) {
+    this->current_line_number = input.line_number;
+  }
+
+  this->interpreter.system.state.line_number = this->current_line_number;
+
+  bool success = false;
+
+  switch (input.type) {
+    case Assignment:
+      success = compile_assignment(input, chunk, target);
+      break;
+    case Expression:
+      success = compile_expression(input, chunk, target);
+      break;
+    case Function:
+      success = compile_function(input, chunk, target);
+      break;
+    case FunctionDefinition:
+      has_value = false;
+      success = compile_function_definition(input, chunk);
+      break;
+    case Initialization:
+      success = compile_initialization(input, chunk, target);
+      break;
+    case Loop:
+      has_value = false;
+      success = compile_loop(input, chunk);
+      break;
+    case Number:
+      success = compile_number(input, chunk, target);
+      break;
+    case String:
+      success = compile_string(input, chunk, target);
+      break;
+    case Unknown:
+      /**
+       * Unknown ParseResults are assumed to be variables. This only
+       * works if they don't have children.
+       */
+      if (!input.children.empty()) {
+        this->interpreter.system.print_error_message(
+            std::string("Could not interpret '") + std::string(input.value) +
+            "'.");
+        break;
+      }
+      success = compile_variable(input, chunk, target);
+      break;
+    case Variable:
+      success = compile_variable(input, chunk, target);
+      break;
+    case Empty:
+      has_value = false;
+      success = true;
+      break;
+    default:
+      this->interpreter.system.print_error_message(
+          std::string("Cannot interpret statement of type '") +
+          System::name_for_type.at(input.type) + "'.");
+      break;
+  }
+
+  this->current_line_number = enclosing_line_number;
+  return success;
+}
+
+bool Compiler::compile_value(const ParseResult &input, Chunk &chunk,
+                             int target) {
+  bool has_value = false;
+  if (!compile_parse_result(input, chunk, target, has_value)) {
+    return false;
+  }
+
+  if (!has_value) {
+    this->interpreter.system.print_error_message(
+        std::string("Expected a value but found '") +
+        System::name_for_type.at(input.type) + "' instead.");
+    return false;
+  }
+
+  return true;
+}
+
+bool Compiler::compile_assignment(const ParseResult &input, Chunk &chunk,
+                                  int target) {
+  if (!this->interpreter.parse_result_is_valid(input)) {
+    this->interpreter.system.print_error_message(
+        std::string("Interpretation failed: An error occurred while parsing."));
+    Lexer::print_parse_result(input);
+    return false;
+  }
+
+  /**
+   * Version 1 (with 'var'):
+   */
+  if (!input.children.empty() && input.children[0].type == Assignment) {
+    /**
+     * var variable (=) value
+     */
+    if (input.children.size() != 3 || input.children[1].type != Variable) {
+      this->interpreter.system.print_error_message(
+          std::string("Invalid assignment. Use 'var a = 5.0' instead."));
+      return false;
+    }
+
+    const std::string_view variable_name = input.children[1].value;
+
+    if (variable_name.empty()) {
+      this->interpreter.system.print_error_message(
+          std::string("Invalid assignment: The variable name must not be "
+                      "empty. Use 'var a = 5.0' instead."));
+      return false;
+    }
+
+    /**
+     * Underscores are reserved for internal variables.
+     */
+    if (variable_name[0] == '_') {
+      this->interpreter.system.print_error_message(
+          std::string("Invalid assignment. Variables starting with '_' "
+                      "cannot be assigned to."));
+      return false;
+    }
+
+    if (!compile_value(input.children[2], chunk, target)) {
+      return false;
+    }
+
+    emit(chunk, OpCode::DefineVariable, target,
+         add_variable(chunk, input.children[1]));
+    return true;
+  }
+
+  /**
+   * Version 2 (without 'var'):
+   */
+  if (input.children.size() != 2) {
+    this->interpreter.system.print_error_message(
+        std::string("Invalid assignment. Use 'a = 5.0' instead."));
+    return false;
+  }
+
+  if (!compile_value(input.children[1], chunk, target)) {
+    return false;
+  }
+
+  emit(chunk, OpCode::AssignVariable, target,
+       add_variable(chunk, input.children[0]));
+  return true;
+}
+
+bool Compiler::compile_expression(const ParseResult &input, Chunk &chunk,
+                                  int target) {
+  /**
+   * Expressions that only consist of numbers were folded by the
+   * optimizer.
+   */
+  if (input.is_constant) {
+    emit(chunk, OpCode::LoadConstant, target,
+         add_constant(chunk, input.number));
+    return true;
+  }
+
+  /**
+   * An expression consists of operands and operators in an
+   * alternating manner.
+   */
+  if (input.children.size() % 2 != 1) {
+    this->interpreter.system.print_error_message(
+        std::string("Could not evaluate expression with ") +
+        std::to_string(input.children.size()) + " parts.");
+    return false;
+  }
+
+  int first_free_register = this->next_free_register;
+
+  /**
+   * The sum of all completed terms is accumulated in the target
+   * register.  The term that is currently being multiplied /
+   * divided lives in term_register. As long as there was no '+' or
+   * '-', this is the target itself.
+   */
+  int term_register = target;
+  OpCode pending_operation = OpCode::Add;
+
+  if (!compile_value(input.children[0], chunk, target)) {
+    return false;
+  }
+
+  for (int index = 1; index < (int)input.children.size(); index += 2) {
+    const ParseResult &operator_result = input.children[index];
+    const ParseResult &operand = input.children[index + 1];
+
+    if (operator_result.type != Operator) {
+      this->interpreter.system.print_error_message(
+          std::string("Expected operator but found '") +
+          std::string(operator_result.value) +
+          "' instead.");
+      return false;
+    }
+
+    const std::string_view operator_string = operator_result.value;
+
+    if ("*" == operator_string || "/" == operator_string) {
+      /**
+       * Multiplications and divisions are applied to the current term
+       * immediately.
+       */
+      int operand_register = allocate_register(chunk);
+      if (!compile_value(operand, chunk, operand_register)) {
+        return false;
+      }
+
+      emit(chunk,
+           "*" == operator_string ? OpCode::Multiply : OpCode::Divide,
+           term_register, term_register, operand_register);
+
+      this->next_free_register = operand_register;
+    } else if ("+" == operator_string || "-" == operator_string) {
+      /**
+       * The current term is complete. Add it to the sum and start a
+       * new term.
+       */
+      if (term_register != target) {
+        emit(chunk, pending_operation, target, target, term_register);
+        this->next_free_register = term_register;
+      }
+
+      pending_operation =
+          "+" == operator_string ? OpCode::Add : OpCode::Subtract;
+
+      term_register = allocate_register(chunk);
+      if (!compile_value(operand, chunk, term_register)) {
+        return false;
+      }
+    } else {
+      this->interpreter.system.print_error_message(
+          std::string("Unknown operator '") + std::string(operator_string) +
+          "'.");
+      return false;
+    }
+  }
+
+  if (term_register != target) {
+    emit(chunk, pending_operation, target, target, term_register);
+  }
+
+  this->next_free_register = first_free_register;
+  return true;
+}
+
+bool Compiler::compile_function(const ParseResult &function_call, Chunk &chunk,
+                                int target) {
+  /**
+   * User defined functions take precedence over builtin
+   * functions. Calls to functions that we don't know at all are
+   * compiled as calls to user defined functions, that may still be
+   * defined when the call is executed.
+   */
+  std::unordered_map<std::string, Builtin>::const_iterator
+      position_of_function =
+          this->interpreter.builtin_functions.find(std::string(
+              function_call.value));
+
+  bool is_builtin =
+      position_of_function != this->interpreter.builtin_functions.end() &&
+      this->defined_functions.find(std::string(function_call.value)) ==
+          this->defined_functions.end() &&
+      this->interpreter.system.statements_for_functions.find(std::string(
+          function_call.value)) ==
+          this->interpreter.system.statements_for_functions.end();
+
+  CallSite call_site;
+  call_site.call = function_call;
+
+  /**
+   * The call site needs to know the line of the call, in order to
+   * report errors properly.
+   */
+  if (call_site.call.line_number < 0) {
+    call_site.call.line_number = this->current_line_number;
+  }
+
+  /**
+   * The argument of a builtin function that uses the hidden variable
+   * is interpreted by the function itself.
+   */
+  int lazy_argument = -1;
+  if (is_builtin) {
+    call_site.builtin = &position_of_function->second;
+    lazy_argument =
+        call_site.builtin->function->argument_with_hidden_variable;
+  }
+
+  int first_free_register = this->next_free_register;
+  int first_argument_register;
+  if (!compile_arguments(function_call, chunk, call_site,
+                         first_argument_register, lazy_argument)) {
+    return false;
+  }
+
+  chunk.call_sites.push_back(call_site);
+  emit(chunk, is_builtin ? OpCode::CallBuiltin : OpCode::CallFunction, target,
+       chunk.call_sites.size() - 1, first_argument_register);
+
+  this->next_free_register = first_free_register;
+  return true;
+}
+
+bool Compiler::compile_function_definition(
+    const ParseResult &function_definition, Chunk &chunk) {
+  if (function_definition.children.empty() ||
+      function_definition.children[0].type != ParameterList) {
+    this->interpreter.system.print_error_message(
+        std::string("Could not interpret function definition '") +
+        std::string(function_definition.value) +
+        "': The function definition did not contain the parameter list.");
+    return false;
+  }
+
+  /**
+   * We know about the function before compiling its body, such that
+   * the function can call itself.
+   */
+  this->defined_functions.insert(std::string(function_definition.value));
+
+  std::shared_ptr<Chunk> function = std::make_shared<Chunk>();
+  function->name = function_definition.value;
+
+  /**
+   * The resolver determined the size of the frame of the function.
+   */
+  std::unordered_map<std::string, Func>::const_iterator position_of_function =
+      this->interpreter.system.known_functions.find(std::string(
+          function_definition.value));
+  if (position_of_function != this->interpreter.system.known_functions.end()) {
+    function->number_of_slots = position_of_function->second.number_of_slots;
+  }
+
+  /**
+   * The body of the function uses its own registers.
+   */
+  int first_free_register = this->next_free_register;
+
+  if (!compile_statements(function_definition.children, 1, *function)) {
+    return false;
+  }
+
+  this->next_free_register = first_free_register;
+
+  /**
+   * Index 0 is the parameter list.
+   */
+  chunk.functions.push_back(function);
+  chunk.function_statements.push_back(function_definition.children.subrange(
+      1, function_definition.children.size()));
+
+  emit(chunk, OpCode::DefineFunction, chunk.functions.size() - 1);
+  return true;
+}
+
+bool Compiler::compile_initialization(const ParseResult &initialization,
+                                      Chunk &chunk, int target) {
+  CallSite call_site;
+  call_site.call = initialization;
+
+  std::unordered_map<std::string, Func>::const_iterator position_of_type =
+      this->interpreter.system.known_functions.find(std::string(
+          initialization.value));
+
+  if (position_of_type == this->interpreter.system.known_functions.end()) {
+    this->interpreter.system.print_error_message(
+        std::string("Could not interpret '") +
+        std::string(initialization.value) +
+        "'. No initialization definition found.");
+    return false;
+  }
+
+  call_site.function = &position_of_type->second;
+
+  int first_free_register = this->next_free_register;
+  int first_argument_register;
+  if (!compile_arguments(initialization, chunk, call_site,
+                         first_argument_register)) {
+    return false;
+  }
+
+  chunk.call_sites.push_back(call_site);
+  emit(chunk, OpCode::Initialize, target, chunk.call_sites.size() - 1,
+       first_argument_register);
+
+  this->next_free_register = first_free_register;
+  return true;
+}
+
+bool Compiler::compile_loop(const ParseResult &loop, Chunk &chunk) {
+  /**
+   * The children of a loop parse result are the loop variable, the
+   * range and the statements in the loop.
+   */
+  if (loop.children.size() < 3) {
+    this->interpreter.system.print_error_message(
+        std::string("Invalid number of arguments for loop."));
+    return false;
+  }
+
+  if (loop.children[0].type != Unknown && loop.children[0].type != Variable) {
+    this->interpreter.system.print_error_message(
+        std::string("Invalid syntax in loop definition. Expected variable "
+                    "name but found '") +
+        System::name_for_type.at(loop.children[0].type) + "' instead.");
+    return false;
+  }
+
+  /**
+   * Parallel loops are executed by the interpreter, which distributes
+   * the iterations among multiple threads.
+   */
+  if (loop.value == "parallel") {
+    CallSite call_site;
+    call_site.call = loop;
+    if (call_site.call.line_number < 0) {
+      call_site.call.line_number = this->current_line_number;
+    }
+
+    chunk.call_sites.push_back(call_site);
+    emit(chunk, OpCode::ParallelLoop, 0, chunk.call_sites.size() - 1);
+    return true;
+  }
+
+  const ParseResult &range = loop.children[1];
+
+  if (range.type != Range) {
+    this->interpreter.system.print_error_message(
+        std::string(
+            "Invalid syntax in loop definition. Expected Range but found '") +
+        System::name_for_type.at(range.type) + "' instead.");
+    return false;
+  }
+
+  if (range.children.size() != 3) {
+    this->interpreter.system.print_error_message(
+        std::string("Invalid number of arguments in range definition. Expected "
+                    "3 arguments but found ") +
+        std::to_string(range.children.size()) + " instead.");
+    return false;
+  }
+
+  int first_free_register = this->next_free_register;
+
+  /**
+   * The loop uses four consecutive registers: lower bound, step
+   * size, upper bound and the current value of the loop variable.
+   */
+  int loop_register = allocate_register(chunk);
+  for (int index = 1; index < 4; ++index) {
+    allocate_register(chunk);
+  }
+
+  for (int index = 0; index < 3; ++index) {
+    if (!compile_value(range.children[index], chunk, loop_register + index)) {
+      return false;
+    }
+  }
+
+  int loop_variable = add_variable(chunk, loop.children[0]);
+  int loop_prepare =
+      emit(chunk, OpCode::LoopPrepare, loop_register, loop_variable);
+  int loop_body = chunk.instructions.size();
+
+  for (int index = 2; index < (int)loop.children.size(); ++index) {
+    int statement_register = allocate_register(chunk);
+
+    bool has_value;
+    if (!compile_parse_result(loop.children[index], chunk, statement_register,
+                              has_value)) {
+      return false;
+    }
+
+    this->next_free_register = statement_register;
+  }
+
+  emit(chunk, OpCode::LoopStep, loop_register, loop_variable, loop_body);
+
+  /**
+   * If the loop is not entered, the execution continues after the
+   * loop.
+   */
+  chunk.instructions[loop_prepare].c = chunk.instructions.size();
+
+  this->next_free_register = first_free_register;
+  return true;
+}
+
+bool Compiler::compile_number(const ParseResult &input, Chunk &chunk,
+                              int target) {
+  double value;
+
+  if (input.is_constant) {
+    value = input.number;
+  } else if (input.value == "M_PI") {
+    value = M_PI;
+  } else {
+    try {
+      value = stod(std::string(input.value));
+    } catch (const std::logic_error &le) {
+      this->interpreter.system.print_error_message(
+          std::string("Interpretation failed: Invalid argument: ") + le.what());
+      return false;
+    }
+  }
+
+  emit(chunk, OpCode::LoadConstant, target, add_constant(chunk, value));
+  return true;
+}
+
+bool Compiler::compile_string(const ParseResult &input, Chunk &chunk,
+                              int target) {
+  /**
+   * A string without escape sequences is a constant.
+   */
+  if (input.children.empty()) {
+    emit(chunk, OpCode::LoadConstant, target,
+         add_constant(chunk, std::string(input.value)));
+    return true;
+  }
+
+  /**
+   * Otherwise, the children form the actual string. We evaluate
+   * them into consecutive registers and join them afterwards.
+   */
+  int first_free_register = this->next_free_register;
+  int first_part_register = this->next_free_register;
+
+  for (const ParseResult &string_part : input.children) {
+    if (!compile_value(string_part, chunk, allocate_register(chunk))) {
+      return false;
+    }
+  }
+
+  emit(chunk, OpCode::BuildString, target, first_part_register,
+       input.children.size());
+
+  this->next_free_register = first_free_register;
+  return true;
+}
+
+bool Compiler::compile_variable(const ParseResult &input, Chunk &chunk,
+                                int target) {
+  int variable = add_variable(chunk, input);
+
+  /**
+   * Check whether we are actually accessing a property of the
+   * variable.
+   */
+  if (input.children.size() == 1 && input.children[0].type == Property) {
+    emit(chunk, OpCode::LoadProperty, target, variable,
+         add_name(chunk, std::string(input.children[0].value)));
+  } else {
+    emit(chunk, OpCode::LoadVariable, target, variable);
+  }
+
+  return true;
+}
+
+bool Compiler::compile_arguments(const ParseResult &function_call,
+                                 Chunk &chunk, CallSite &call_site,
+                                 int &first_register, int lazy_argument) {
+  first_register = this->next_free_register;
+
+  if (function_call.children.size() != 1 ||
+      function_call.children[0].type != ArgumentList) {
+    this->interpreter.system.print_error_message(
+        std::string("Could not interpret function '") +
+        std::string(function_call.value) +
+        "': Expected argument list.");
+    return false;
+  }
+
+  const Span<ParseResult> arguments = function_call.children[0].children;
+
+  for (int index = 0; index < (int)arguments.size(); ++index) {
+    const ParseResult &argument = arguments[index];
+
+    if (argument.type != Argument || argument.children.size() != 1) {
+      this->interpreter.system.print_error_message(
+          std::string("In function call '") + std::string(function_call.value) +
+          "': Expected argument but found '" +
+          System::name_for_type.at(argument.type) + "' instead.");
+      return false;
+    }
+
+    /**
+     * The registers of the arguments have to be consecutive, so we
+     * allocate the register before compiling the argument.
+     */
+    int argument_register = allocate_register(chunk);
+
+    if (index != lazy_argument &&
+        !compile_value(argument.children[0], chunk, argument_register)) {
+      return false;
+    }
+
+    call_site.parameters.emplace_back(argument.value);
+  }
+
+  return true;
+}
+
+void Compiler::print_chunk(const Chunk &chunk, const std::string &indentation) {
+  static const std::vector<std::string> names_for_op_codes = {
+      "LoadConstant", "LoadVariable", "LoadProperty",   "DefineVariable",
+      "AssignVariable", "Add",        "Subtract",       "Multiply",
+      "Divide",       "BuildString",  "Initialize",     "CallBuiltin",
+      "CallFunction", "DefineFunction", "LoopPrepare",  "LoopStep",
+      "ParallelLoop", "Return"};
+
+  std::cout << indentation << "Chunk '" << chunk.name << "' ("
+            << chunk.number_of_registers << " registers)" << std::endl;
+
+  for (int index = 0; index < (int)chunk.instructions.size(); ++index) {
+    const Instruction &instruction = chunk.instructions[index];
+    std::cout << indentation << index << "| "
+              << names_for_op_codes[(int)instruction.op_code] << " "
+              << instruction.a << " " << instruction.b << " " << instruction.c
+              << " (" << chunk.line_numbers[index] << ")" << std::endl;
+  }
+
+  for (const std::shared_ptr<const Chunk> &function : chunk.functions) {
+    print_chunk(*function, indentation + "\t");
+  }
+}
+
+}  // namespace hydra
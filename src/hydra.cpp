@@ -0,0 +1,222 @@
+//
+//  hydra.cpp
+//  hydra
+//
+
+#include <hydra.hpp>
+
+#include <compiler.hpp>
+#include <io_helper.hpp>
+#include <resolver.hpp>
+
+namespace hydra {
+
+namespace {
+
+/**
+ * Splits code into lines, which are converted just like by
+ * IOHelper::read_code_from_file.
+ */
+void lines_of_code(std::string_view text, std::vector<std::string> &lines) {
+  size_t position = 0;
+  std::string_view line;
+  while (IOHelper::next_line_in_text(text, position, line)) {
+    lines.emplace_back(line);
+    IOHelper::convert_new_lines(lines.back());
+  }
+}
+
+/**
+ * Copies the passed parse results, their values and all their
+ * descendants into the arena, such that the copies don't refer to
+ * the memory of the program anymore.
+ */
+Span<ParseResult> copy_parse_results(Span<const ParseResult> results,
+                                     Arena &arena) {
+  Span<ParseResult> copies = arena.copy(results.begin(), results.size());
+  for (ParseResult &copy : copies) {
+    copy.value = arena.copy(copy.value);
+    copy.children = copy_parse_results(copy.children, arena);
+  }
+
+  return copies;
+}
+
+}  // namespace
+
+Program::Program() : lexer(system) {}
+
+std::shared_ptr<const Program> Program::parse(std::string_view code,
+                                              std::string &errors) {
+  std::shared_ptr<Program> program(new Program());
+
+  std::ostringstream error_stream;
+  program->system.error_output = &error_stream;
+
+  std::vector<std::string> lines;
+  lines_of_code(code, lines);
+  const bool success = program->lexer.parse_code(lines, program->code);
+
+  program->system.error_output = &std::cerr;
+  errors = error_stream.str();
+
+  if (!success) {
+    return nullptr;
+  }
+
+  return program;
+}
+
+std::shared_ptr<const Program> Program::load(const std::string &file_name,
+                                             bool use_cache,
+                                             std::string &errors) {
+  MappedFile file(file_name);
+  if (!file.is_open()) {
+    errors = "Could not open file '" + file_name + "'.\n";
+    return nullptr;
+  }
+
+  const std::string_view text = file.contents();
+  if (!use_cache) {
+    return parse(text, errors);
+  }
+
+  const uint64_t code_hash = ProgramCache::hash_of_code(text);
+  const std::string cache_file_name =
+      ProgramCache::file_name_for_code(file_name);
+
+  std::shared_ptr<Program> program(new Program());
+  if (program->cache.load(cache_file_name, code_hash, program->code)) {
+    errors.clear();
+    return program;
+  }
+
+  std::shared_ptr<const Program> parsed_program = parse(text, errors);
+  if (parsed_program != nullptr &&
+      !ProgramCache::save(cache_file_name, code_hash, parsed_program->code)) {
+    DLOG(INFO) << "Could not write the cache '" << cache_file_name << "'."
+               << std::endl;
+  }
+
+  return parsed_program;
+}
+
+Instance::Instance(const Options &options)
+    : options(options), lexer(system), interpreter(system), vm(interpreter) {
+  this->system.error_output = &this->error_stream;
+  this->interpreter.output = options.output;
+  this->interpreter.canvas.export_threads = options.export_threads;
+  this->interpreter.parallel_threads = options.parallel_threads;
+  if (options.seed >= 0) {
+    this->interpreter.random_engine.seed(options.seed);
+  }
+}
+
+bool Instance::run(std::string_view code) {
+  std::vector<std::string> lines;
+  lines_of_code(code, lines);
+
+  std::vector<ParseResult> parsed_code;
+  if (!this->lexer.parse_code(lines, parsed_code)) {
+    return false;
+  }
+
+  return execute(parsed_code);
+}
+
+bool Instance::run(const Program &program) {
+  /**
+   * The resolver assigns the slots of this instance to the variables,
+   * so the program is not changed.  Functions defined by the program
+   * keep their statements until the instance is reset, which is why
+   * the copies must not refer to the program.
+   */
+  Span<ParseResult> copies =
+      copy_parse_results(Span<const ParseResult>(program.code), this->arena);
+  std::vector<ParseResult> code(copies.begin(), copies.end());
+
+  Resolver resolver(this->system);
+  if (!resolver.resolve_code(code)) {
+    return false;
+  }
+
+  return execute(code);
+}
+
+void Instance::define_variable(const std::string &name, const Value &value) {
+  this->system.state.define_variable_with_value(name, value);
+}
+
+bool Instance::execute(std::vector<ParseResult> &code) {
+  Value result;
+  if (this->options.engine == Options::Engine::Tree) {
+    return this->interpreter.interpret_code(code, result);
+  }
+
+  Compiler compiler(this->interpreter);
+  Chunk chunk;
+  if (!compiler.compile_code(code, chunk)) {
+    return false;
+  }
+
+  return this->vm.run(chunk, result);
+}
+
+void Instance::set_saved_file_suffix(const std::string &suffix) {
+  this->interpreter.saved_file_suffix = suffix;
+}
+
+const Canvas &Instance::canvas() const { return this->interpreter.canvas; }
+
+std::string Instance::errors() const { return this->error_stream.str(); }
+
+void Instance::reset() {
+  this->system.reset();
+  this->lexer.reset();
+  this->vm.reset();
+  this->arena.clear();
+
+  this->interpreter.canvas.reset();
+  this->interpreter.memoized_results.clear();
+  this->interpreter.saved_file_suffix.clear();
+  if (this->options.seed >= 0) {
+    this->interpreter.random_engine.seed(this->options.seed);
+  }
+
+  this->error_stream.str(std::string());
+  this->error_stream.clear();
+}
+
+InstancePool::InstancePool(const Options &options) : options(options) {}
+
+InstancePool::Lease InstancePool::acquire() {
+  std::unique_ptr<Instance> instance;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->unused_instances.empty()) {
+      instance = std::move(this->unused_instances.back());
+      this->unused_instances.pop_back();
+    }
+  }
+
+  if (instance == nullptr) {
+    instance = std::make_unique<Instance>(this->options);
+  }
+
+  return Lease(*this, std::move(instance));
+}
+
+void InstancePool::release(std::unique_ptr<Instance> instance) {
+  instance->reset();
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->unused_instances.push_back(std::move(instance));
+}
+
+InstancePool::Lease::~Lease() {
+  if (this->instance != nullptr) {
+    this->pool->release(std::move(this->instance));
+  }
+}
+
+}  // namespace hydra
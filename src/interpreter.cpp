@@ -8,38 +8,67 @@
 #include <interpreter.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <iostream>
-#include <random>
+#include <sstream>
 
 namespace hydra {
 
 Interpreter::Interpreter(System &system) : system(system) {
 
   this->builtin_functions = {
-      {"clear", &Interpreter::function_clear},
-      {"circle", &Interpreter::function_circle},
-      {"cos", &Interpreter::function_cos},
-      {"cosh", &Interpreter::function_cosh},
-      {"curve_angle", &Interpreter::function_curve_angle},
-      {"curve_distance", &Interpreter::function_curve_distance},
-      {"distance", &Interpreter::function_distance},
-      {"exp", &Interpreter::function_exp},
-      {"log", &Interpreter::function_log},
-      {"line", &Interpreter::function_line},
-      {"mark", &Interpreter::function_mark},
-      {"print", &Interpreter::function_print},
-      {"random", &Interpreter::function_random},
-      {"rotate", &Interpreter::function_rotate},
-      {"save", &Interpreter::function_save},
-      {"set_resolution", &Interpreter::function_set_resolution},
-      {"sin", &Interpreter::function_sin},
-      {"sinh", &Interpreter::function_sinh},
-      {"sqrt", &Interpreter::function_sqrt},
-      {"theta", &Interpreter::function_theta},
-      {"translate", &Interpreter::function_translate}
+      {"array_element", {&Interpreter::function_array_element}},
+      {"array_size", {&Interpreter::function_array_size}},
+      {"clear", {&Interpreter::function_clear}},
+      {"circle", {&Interpreter::function_circle}},
+      {"cos", {&Interpreter::function_cos}},
+      {"cosh", {&Interpreter::function_cosh}},
+      {"curve_angle", {&Interpreter::function_curve_angle}},
+      {"curve_distance", {&Interpreter::function_curve_distance}},
+      {"distance", {&Interpreter::function_distance}},
+      {"exp", {&Interpreter::function_exp}},
+      {"log", {&Interpreter::function_log}},
+      {"line", {&Interpreter::function_line}},
+      {"lines", {&Interpreter::function_lines}},
+      {"lines_within", {&Interpreter::function_lines_within}},
+      {"load", {&Interpreter::function_load}},
+      {"mark", {&Interpreter::function_mark}},
+      {"marks", {&Interpreter::function_marks}},
+      {"number_array", {&Interpreter::function_number_array}},
+      {"pol_array", {&Interpreter::function_pol_array}},
+      {"polyline", {&Interpreter::function_polyline}},
+      {"print", {&Interpreter::function_print}},
+      {"random", {&Interpreter::function_random}},
+      {"random_angle", {&Interpreter::function_random_angle}},
+      {"random_array", {&Interpreter::function_random_array}},
+      {"random_graph", {&Interpreter::function_random_graph}},
+      {"random_radius", {&Interpreter::function_random_radius}},
+      {"rotate", {&Interpreter::function_rotate}},
+      {"save", {&Interpreter::function_save}},
+      {"seed", {&Interpreter::function_seed}},
+      {"set_image_size", {&Interpreter::function_set_image_size}},
+      {"set_precision", {&Interpreter::function_set_precision}},
+      {"set_resolution", {&Interpreter::function_set_resolution}},
+      {"set_simplification", {&Interpreter::function_set_simplification}},
+      {"set_tolerance", {&Interpreter::function_set_tolerance}},
+      {"set_viewport", {&Interpreter::function_set_viewport}},
+      {"sin", {&Interpreter::function_sin}},
+      {"sinh", {&Interpreter::function_sinh}},
+      {"sqrt", {&Interpreter::function_sqrt}},
+      {"theta", {&Interpreter::function_theta}},
+      {"translate", {&Interpreter::function_translate}}
   };
 
+  /**
+   * The builtin functions know their signature.
+   */
+  for (std::pair<const std::string, Builtin> &builtin :
+       this->builtin_functions) {
+    builtin.second.function = &this->system.known_functions.at(builtin.first);
+  }
+
   this->known_interpretations = {
       {Assignment, &Interpreter::interpret_assignment},
       {Initialization, &Interpreter::interpret_initialization},
@@ -55,14 +84,15 @@ Interpreter::Interpreter(System &system) : system(system) {
 
 }
 
-bool Interpreter::number_from_value(const std::any &value, double &number) {
+bool Interpreter::number_from_value(const Value &value, double &number) {
 
-  try {
-    number = std::any_cast<double>(value);
-    return true;
-  } catch (std::bad_any_cast &bac) {
+  const double *number_value = value.number();
+  if (number_value == nullptr) {
     return false;
   }
+
+  number = *number_value;
+  return true;
 }
 
 bool Interpreter::parse_result_is_valid(const ParseResult &result) {
@@ -80,8 +110,8 @@ bool Interpreter::parse_result_is_valid(const ParseResult &result) {
   return true;
 }
 
-bool Interpreter::interpret_code(const std::vector<ParseResult> &code,
-                                 std::any &result) {
+bool Interpreter::interpret_code(Span<const ParseResult> code,
+                                 Value &result) {
   /**
    * Interpret the ParseResults one after another.
    */
@@ -90,7 +120,7 @@ bool Interpreter::interpret_code(const std::vector<ParseResult> &code,
     /**
      * Try to interpret the parsed_code. If it fails, return false.
      */
-    if (!interpret_parse_result(parsed_code, result)) {
+    if (!interpret_statement(parsed_code, result)) {
       return false;
     }
   }
@@ -101,8 +131,18 @@ bool Interpreter::interpret_code(const std::vector<ParseResult> &code,
   return true;
 }
 
+bool Interpreter::interpret_statement(const ParseResult &statement,
+                                      Value &result) {
+  if (this->profiler == nullptr) {
+    return interpret_parse_result(statement, result);
+  }
+
+  Profiler::Scope scope(this->profiler, statement.line_number);
+  return interpret_parse_result(statement, result);
+}
+
 bool Interpreter::interpret_parse_result(const ParseResult &input,
-                                         std::any &result) {
+                                         Value &result) {
   DLOG(INFO) << "Interpreting parse result of type: '" << System::name_for_type.at(input.type)
              << "'." << std::endl;
 
@@ -117,6 +157,14 @@ bool Interpreter::interpret_parse_result(const ParseResult &input,
    */
   this->system.state.line_number = input.line_number;
 
+  /**
+   * Numbers and constant expressions were folded by the optimizer.
+   */
+  if (input.is_constant) {
+    result = input.number;
+    return true;
+  }
+
   if (input.type == Error) {
     this->system.print_error_message(
         std::string("Cannot interpret statemet of type '") +
@@ -134,7 +182,7 @@ bool Interpreter::interpret_parse_result(const ParseResult &input,
    */
   std::unordered_map<Type,
                      std::function<bool(Interpreter *, const ParseResult &,
-                                        std::any &)>>::const_iterator
+                                        Value &)>>::const_iterator
       position_of_interpretation = this->known_interpretations.find(input.type);
 
   if (position_of_interpretation != this->known_interpretations.end()) {
@@ -149,7 +197,7 @@ bool Interpreter::interpret_parse_result(const ParseResult &input,
 }
 
 bool Interpreter::interpret_assignment(const ParseResult &input,
-                                       std::any &result) {
+                                       Value &result) {
   DLOG(INFO) << "Interpreting assignment with value: '" << input.value << "'."
              << std::endl;
 
@@ -231,7 +279,7 @@ bool Interpreter::interpret_assignment(const ParseResult &input,
      * The value is not defined yet. Now we have to interpret
      * what is being assigned.
      */
-    std::any value_interpretation_result;
+    Value value_interpretation_result;
 
     /**
      * Check whether the value was interpreted successfully.
@@ -241,33 +289,34 @@ bool Interpreter::interpret_assignment(const ParseResult &input,
       DLOG(INFO) << "Assignment value interpreted successfully." << std::endl;
 
       /**
-       * Actually defining the variable. The result of the definition
-       * is the index of the scope that the variable was defined
-       * in. If the definition failed, this will be -1.
+       * Check whether the value did actually have a value.
        */
-      if (this->system.state.define_variable_with_value(
-              input.children[1].value, value_interpretation_result) < 0) {
-        /**
-         * Defining the variable can fail for two reasons. Either the
-         * value didn't actually have a value, or the variable was
-         * defined already..
-         */
-        if (!value_interpretation_result.has_value()) {
-          this->system.print_error_message(
-              std::string("Could not define '") + input.children[1].value +
-              "'. Right hand side of assignment did not have a value.");
-        } else {
-          /**
-           * If we did have a value but definition failed, then it was
-           * because the variable already existed.
-           */
-          this->system.print_error_message(std::string("Redefinition of : '") +
-                                           input.children[1].value + "'.");
-        }
+      if (!value_interpretation_result.has_value()) {
+        this->system.print_error_message(
+            std::string("Could not define '") +
+            std::string(input.children[1].value) +
+            "'. Right hand side of assignment did not have a value.");
+        return false;
+      }
 
+      /**
+       * Actually defining the variable. Whether the variable was
+       * already defined in the current scope, was already checked by
+       * the resolver.
+       */
+      Value *variable_value = this->system.state.storage_for_definition(
+          input.children[1].frame, input.children[1].slot,
+          input.children[1].value);
+
+      if (variable_value == nullptr) {
+        this->system.print_error_message(std::string("Could not define '") +
+                                         std::string(
+                                             input.children[1].value) + "'.");
         return false;
       }
 
+      *variable_value = value_interpretation_result;
+
       /**
        * Everything worked as expected.
        */
@@ -293,7 +342,7 @@ bool Interpreter::interpret_assignment(const ParseResult &input,
      * The variable was declared before. Now we have to interpret
      * what is being assigned.
      */
-    std::any value_interpretation_result;
+    Value value_interpretation_result;
 
     /**
      * Check whether the value was interpreted successfully.
@@ -303,44 +352,35 @@ bool Interpreter::interpret_assignment(const ParseResult &input,
       DLOG(INFO) << "Assignment value interpreted successfully." << std::endl;
 
       /**
-       * Check whether the variable is already defined and in what
-       * scope.
-       *
-       * The new value will then be written in that scope.
+       * Check whether the variable is already defined. The new value
+       * will then be written where the old value was stored.
        */
-      std::any old_value;
-      int scope = this->system.state.value_for_variable(input.children[0].value,
-                                                        old_value);
+      Value *variable_value = this->system.state.storage_for_variable(
+          input.children[0].frame, input.children[0].slot,
+          input.children[0].value);
 
-      /**
-       * A scope < 0 indicates that the variable is not defined.
-       */
-      if (scope < 0) {
+      if (variable_value == nullptr || !variable_value->has_value()) {
         this->system.print_error_message(
             std::string(
                 "Trying to assign to undefined variable. Define the variable "
                 "first using 'var ") +
-            input.children[0].value + " = ...' instead.");
+            std::string(input.children[0].value) + " = ...' instead.");
         return false;
       }
 
       /**
-       * Now we try to actually assign the value in its scope.
+       * If the new value doesn't actually have a value, we cannot
+       * assign it.
        */
-      if (!this->system.state.set_value_for_variable(
-              input.children[0].value, value_interpretation_result, scope)) {
-        /**
-         * If the assignment fails, there are two reasons. Either the
-         * value was empty, or the variable was undefined. The last
-         * case was checked for before trying the assignment.
-         */
+      if (!value_interpretation_result.has_value()) {
         this->system.print_error_message(
-            std::string("Could not define '") + input.children[0].value +
+            std::string("Could not define '") +
+            std::string(input.children[0].value) +
             "'. Right hand side of assignment did not have a value.");
-
         return false;
       }
 
+      *variable_value = value_interpretation_result;
       result = value_interpretation_result;
       return true;
     }
@@ -350,7 +390,7 @@ bool Interpreter::interpret_assignment(const ParseResult &input,
 }
 
 bool Interpreter::interpret_initialization(const ParseResult &initialization,
-                                           std::any &result) {
+                                           Value &result) {
   DLOG(INFO) << "Interpreting initialization with value: '" << initialization.value
              << "'." << std::endl;
 
@@ -402,76 +442,94 @@ bool Interpreter::interpret_initialization(const ParseResult &initialization,
     return false;
   }
 
+  /**
+   * The signature of the type tells us which properties to expect.
+   */
+  std::unordered_map<std::string, Func>::const_iterator position_of_type =
+      this->system.known_functions.find(std::string(initialization.value));
+
+  if (position_of_type == this->system.known_functions.end() ||
+      (int)position_of_type->second.arguments.size() >
+          maximum_number_of_arguments) {
+    this->system.print_error_message(std::string("Could not interpret '") +
+                                     std::string(initialization.value) +
+                                     "'. No initialization definition found.");
+    return false;
+  }
+
   /**
    * Now we actually interpret the argument list.
    */
-  std::unordered_map<std::string, std::any> arguments;
+  Value values[maximum_number_of_arguments];
+  Arguments arguments;
+  arguments.function = &position_of_type->second;
+  arguments.values = values;
+
   if (!interpret_arguments_from_function_call(initialization, arguments)) {
     return false;
   }
 
+  return value_for_initialization(initialization, arguments, result);
+}
+
+bool Interpreter::value_for_initialization(const ParseResult &initialization,
+                                           const Arguments &arguments,
+                                           Value &result) {
   /**
    * Now depending on which type to evaluate we initialize it.
    */
 
-  // /**
-  //  * Evaluating Pol (Polar coordinates).
-  //  */
-  // if (initialization.value == "Pol") {
-
-  //   /**
-  //    * Get the actual argument values.
-  //    */
-  //   double r;
-  //   double phi;
+  /**
+   * Evaluating Pol (Polar coordinates). Points are stored directly
+   * in the value.
+   */
+  if (initialization.value == "Pol") {
 
-  //   /**
-  //    * Get the numbers for the parameters.
-  //    */
-  //   if (!number_value_for_parameter("r", arguments, r) ||
-  //       !number_value_for_parameter("phi", arguments, phi)) {
-  //     return false;
-  //   }
+    /**
+     * Get the actual argument values.
+     */
+    double r;
+    double phi;
 
-  //   /**
-  //    * If we're at this point, we all we need for the initialization.
-  //    */
-  //   result = Pol(r, phi);
-  //   return true;
-  // } else {
-  //   this->system.print_error_message(std::string("Could not interpret '") +
-  //                                    initialization.value +
-  //                                    "'. No initialization definition found.");
-  //   return false;
-  // }
+    /**
+     * Get the numbers for the parameters (r: phi:).
+     */
+    if (!number_value_for_parameter(arguments, 0, r) ||
+        !number_value_for_parameter(arguments, 1, phi)) {
+      return false;
+    }
 
-  /**
-   * Non-primitive types are defined using maps. The maps contains a
-   * key for the type and one for each property.
-   */
-  PropertyMap property_map;
+    /**
+     * If we're at this point, we all we need for the initialization.
+     */
+    result = Pol(r, phi);
+    return true;
+  }
 
   /**
-   * Assign the type.
+   * Other non-primitive types are defined using objects. An object
+   * contains the type and one value for each property.
    */
-  property_map[System::type_string] = initialization.value;
+  std::shared_ptr<Object> object = std::make_shared<Object>();
+  object->type = initialization.value;
 
   /**
    * Assign the properties from the initialization.
    */
-  for (const std::pair<std::string, std::any> &property_value : arguments) {
-    property_map[property_value.first] = property_value.second;
+  for (int index = 0; index < arguments.size; ++index) {
+    object->properties[arguments.function->arguments[index]] =
+        arguments.values[index];
   }
 
   /**
-   * The result is the property map.
+   * The result is the object.
    */
-  result = property_map;
+  result = std::shared_ptr<const Object>(object);
 
   return true;
 }
 
-bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
+bool Interpreter::interpret_loop(const ParseResult &loop, Value &result) {
 
   /**
    * Reset the result so the check for has_value fails.
@@ -510,12 +568,6 @@ bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
     return false;
   }
 
-  /**
-   * We open a new scope, since all variables defined in the loop (as
-   * well as the loop variable) will be forgotten after the loop.
-   */
-  this->system.state.open_new_scope();
-
   /**
    * The first child of the loop-parse-result is the variable
    * name.
@@ -531,7 +583,7 @@ bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
   /**
    * Get the loop variable name.
    */
-  std::string loop_variable_name = loop.children[0].value;
+  std::string loop_variable_name(loop.children[0].value);
 
   /**
    * The next child should be the range.
@@ -560,7 +612,7 @@ bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
   /**
    * Interpret the lower bound of the range.
    */
-  std::any lower_bound_result;
+  Value lower_bound_result;
   double lower_bound;
   if (!(interpret_parse_result(loop.children[1].children[0],
                                lower_bound_result) &&
@@ -573,7 +625,7 @@ bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
   /**
    * Interpret the step size of the range.
    */
-  std::any step_size_result;
+  Value step_size_result;
   double step_size;
   if (!(interpret_parse_result(loop.children[1].children[1],
                                step_size_result) &&
@@ -586,7 +638,7 @@ bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
   /**
    * Interpret the upper bound of the range.
    */
-  std::any upper_bound_result;
+  Value upper_bound_result;
   double upper_bound;
   if (!(interpret_parse_result(loop.children[1].children[2],
                                upper_bound_result) &&
@@ -596,22 +648,37 @@ bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
     return false;
   }
 
+  /**
+   * The calls that were hoisted out of the loop are evaluated again
+   * in each run of the loop, when they are reached for the first time.
+   */
+  for (int slot = loop.slot; slot < loop.slot + loop.number_of_hoisted_calls;
+       ++slot) {
+    Value *hoisted_value =
+        this->system.state.storage_for_variable(LocalFrame, slot, "");
+    if (hoisted_value != nullptr) {
+      hoisted_value->reset();
+    }
+  }
+
+  if (loop.value == "parallel") {
+    return interpret_parallel_loop(loop, lower_bound, step_size,
+                                   upper_bound);
+  }
+
   /**
    * At this point we interpreted the whole range. Now we actually
    * loop.
    *
-   * We start by assigning the lower_bound to the loop variable in the
-   * current scope.
+   * We start with the lower_bound as value for the loop variable.
    */
   double loop_variable = lower_bound;
-  std::any loop_variable_value = loop_variable;
 
   /**
-   * Since we update the value for the loop variable within the loop
-   * scope, we keep track of the index of the loop scope.
+   * The loop variable (and all variables defined in the loop) have
+   * been assigned slots in the current frame by the resolver.
    */
-  int loop_scope_index = this->system.state.define_variable_with_value(
-      loop_variable_name, loop_variable_value);
+  const ParseResult &loop_variable_parse_result = loop.children[0];
 
   /**
    * Now loop! We loop as long as the loop variable is smaller than
@@ -622,6 +689,25 @@ bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
              << upper_bound << std::endl;
 
   while (loop_variable <= upper_bound) {
+    /**
+     * Set the value of the loop variable for this iteration.  Since
+     * the loop body may call functions that open new frames, we
+     * determine where the variable is stored in each iteration.
+     */
+    Value *loop_variable_storage = this->system.state.storage_for_definition(
+        loop_variable_parse_result.frame, loop_variable_parse_result.slot,
+        loop_variable_name);
+
+    if (loop_variable_storage == nullptr) {
+      this->system.print_error_message(
+          std::string(
+              "Could not interpret loop. Unable to update loop variable '") +
+          loop_variable_name + "'.");
+      return false;
+    }
+
+    *loop_variable_storage = loop_variable;
+
     /**
      * Interpret the code within the loop. Since the first to children
      * of the loop are variable name and range, this leaves all later
@@ -633,85 +719,173 @@ bool Interpreter::interpret_loop(const ParseResult &loop, std::any &result) {
       /**
        * If interpreting this ParseResult fails, the whole loop fails.
        */
-      std::any interpretation_result;
-      if (!interpret_parse_result(loop.children[index], interpretation_result)) {
+      Value interpretation_result;
+      if (!interpret_statement(loop.children[index], interpretation_result)) {
         return false;
       }
     }
 
     /**
      * The code in the loop was interpreted successfully. Now we
-     * determine the value of the loop variable, which might have
-     * changed during the loop and then update it by increasing it by
-     * the step size.
+     * update the loop variable by increasing it by the step size.
+     * Note that assignments to the loop variable within the loop
+     * don't affect the iteration.
+     *
+     * Variables defined within the loop don't have to be removed,
+     * since the resolver ensures that their slots are not read before
+     * they are defined again in the next iteration.
      */
+    loop_variable += step_size;
 
-    /**
-     * First check whether we can get the value for the loop
-     * variable. We only allow to take the variable from the current
-     * scope.
-     */
-    if (!this->system.state.value_for_variable_in_current_scope(
-            loop_variable_name, loop_variable_value) &&
-        number_from_value(loop_variable_value, loop_variable)) {
-      this->system.print_error_message(
-          std::string("Could not interpret loop. Loop variable '") +
-          loop_variable_name + "' could not be interpreted as number.");
-      return false;
+#ifdef DEBUG
+    print_globals();
+    #endif
+  }
+
+  /**
+   * If we get here, everything went as expected.
+   */
+  return true;
+}
+
+bool Interpreter::interpret_parallel_loop(const ParseResult &loop,
+                                          double lower_bound,
+                                          double step_size,
+                                          double upper_bound) {
+  if (!(step_size > 0.0)) {
+    this->system.print_error_message(
+        std::string("Invalid range for parallel loop. The step size has to "
+                    "be positive."));
+    return false;
+  }
+
+  /**
+   * The values of the loop variable are obtained the same way as in
+   * serial loops, by repeatedly adding the step size.
+   */
+  long long number_of_iterations = 0;
+  for (double value = lower_bound; value <= upper_bound; value += step_size) {
+    ++number_of_iterations;
+  }
+
+  if (number_of_iterations == 0) {
+    return true;
+  }
+
+  /**
+   * The iterations are split into consecutive parts, each with its own
+   * canvas, messages and random numbers.  The parts only depend on the
+   * number of iterations, such that the result does not depend on the
+   * number of threads.
+   */
+  const int maximum_number_of_parts = 256;
+  const long long iterations_per_part =
+      (number_of_iterations + maximum_number_of_parts - 1) /
+      maximum_number_of_parts;
+  const int number_of_parts =
+      (number_of_iterations + iterations_per_part - 1) / iterations_per_part;
+
+  std::vector<double> first_value_of_part(number_of_parts);
+  long long iteration = 0;
+  for (double value = lower_bound; value <= upper_bound; value += step_size) {
+    if (iteration % iterations_per_part == 0) {
+      first_value_of_part[iteration / iterations_per_part] = value;
     }
+    ++iteration;
+  }
 
-    /**
-     * The loop_variable now has the current value. Update it by
-     * increasing it by the step_size.
-     */
-    loop_variable += step_size;
+  std::vector<Canvas> canvases(number_of_parts);
+  std::vector<std::string> outputs(number_of_parts);
 
-    /**
-     * Now we clear the current scope and only add the loop variable
-     * back in.
-     *
-     * This allows the definition of variables within the
-     * loop. (Otherwise, a variable would be re-defined in the second
-     * loop iteration.)
-     */
-    this->system.state.scopes.back().clear();
+  const uint64_t seed = this->random_engine.bits();
+  std::atomic<int> next_part(0);
+  std::atomic<bool> failed(false);
+
+  const ParseResult &loop_variable = loop.children[0];
 
+  const std::function<void(int)> work = [&](int) {
     /**
-     * Now we set the new value in the current scope.
+     * Each thread works on a copy of the system, such that line
+     * numbers and variables are not shared with other threads. The
+     * resolver ensures that the loop does not assign to variables
+     * that were defined outside the loop, so nothing is lost by
+     * discarding the copy afterwards.
      */
-    loop_variable_value = loop_variable;
-    if (!this->system.state.define_variable_with_value(loop_variable_name,
-                                                       loop_variable_value)) {
-      this->system.print_error_message(
-          std::string(
-              "Could not interpret loop. Unable to update loop variable '") +
-          loop_variable_name + "'.");
-      return false;
+    System system(this->system);
+    Interpreter interpreter(system);
+    interpreter.canvas.resolution = this->canvas.resolution;
+    interpreter.canvas.scale = this->canvas.scale;
+    interpreter.canvas.precision = this->canvas.precision;
+
+    for (int part = next_part++; part < number_of_parts && !failed;
+         part = next_part++) {
+      interpreter.random_engine.seed(seed, part);
+
+      std::ostringstream output;
+      interpreter.output = &output;
+
+      const long long first_iteration = part * iterations_per_part;
+      const long long end_of_part = std::min(
+          number_of_iterations, first_iteration + iterations_per_part);
+      double value = first_value_of_part[part];
+
+      for (long long iteration = first_iteration; iteration < end_of_part;
+           ++iteration) {
+        Value *loop_variable_storage = system.state.storage_for_definition(
+            loop_variable.frame, loop_variable.slot, loop_variable.value);
+
+        if (loop_variable_storage == nullptr) {
+          system.print_error_message(
+              std::string("Could not interpret loop. Unable to update loop "
+                          "variable '") +
+              std::string(loop_variable.value) + "'.");
+          failed = true;
+          return;
+        }
+
+        *loop_variable_storage = value;
+
+        for (int index = 2; index < (int)loop.children.size(); ++index) {
+          Value interpretation_result;
+          if (!interpreter.interpret_parse_result(loop.children[index],
+                                                  interpretation_result)) {
+            failed = true;
+            return;
+          }
+        }
+
+        value += step_size;
+      }
+
+      canvases[part].append(interpreter.canvas);
+      outputs[part] = output.str();
     }
+  };
 
-#ifdef DEBUG
-    print_scopes();
-    #endif
+  if (this->thread_pool == nullptr ||
+      this->thread_pool->size() != this->parallel_threads) {
+    this->thread_pool.reset(new ThreadPool(this->parallel_threads));
   }
 
-  /**
-   * We're done interpreting the loop. We now remove the scope of the
-   * loop including all the variables defined in there.
-   */
-  if (!this->system.state.close_scope()) {
-    this->system.print_error_message(
-        std::string("Could not close loop-scope as that would mean closing the "
-                    "last scope."));
+  this->thread_pool->parallel_for(
+      std::min(this->parallel_threads, number_of_parts), work);
+
+  if (failed) {
     return false;
   }
 
   /**
-   * If we get here, everything went as expected.
+   * Merge the results in the order of the iterations.
    */
+  for (int part = 0; part < number_of_parts; ++part) {
+    this->canvas.append(canvases[part]);
+    *this->output << outputs[part];
+  }
+
   return true;
 }
 
-bool Interpreter::interpret_number(const ParseResult &input, std::any &result) {
+bool Interpreter::interpret_number(const ParseResult &input, Value &result) {
 
   DLOG(INFO) << "Interpreting number with value: '" << input.value
              << "'." << std::endl;
@@ -728,7 +902,7 @@ bool Interpreter::interpret_number(const ParseResult &input, std::any &result) {
   this->system.state.line_number = input.line_number;
 
   try {
-    double value = stod(input.value);
+    double value = stod(std::string(input.value));
     result = value;
     return true;
   } catch (const std::invalid_argument &ia) {
@@ -754,7 +928,7 @@ bool Interpreter::interpret_number(const ParseResult &input, std::any &result) {
   return false;
 }
 
-bool Interpreter::interpret_string(const ParseResult &input, std::any &result) {
+bool Interpreter::interpret_string(const ParseResult &input, Value &result) {
   DLOG(INFO) << "Interpreting string with value: '" << input.value << "'."
              << std::endl;
 
@@ -786,7 +960,7 @@ bool Interpreter::interpret_string(const ParseResult &input, std::any &result) {
    */
 
   if (input.children.empty()) {
-    result = input.value;
+    result = std::string(input.value);
     return true;
   }
 
@@ -805,7 +979,7 @@ bool Interpreter::interpret_string(const ParseResult &input, std::any &result) {
     /**
      * Try to interpret this string part.
      */
-    std::any string_part_value;
+    Value string_part_value;
     if (!interpret_parse_result(string_part, string_part_value)) {
       return false;
     }
@@ -818,7 +992,7 @@ bool Interpreter::interpret_string(const ParseResult &input, std::any &result) {
     if (!Interpreter::string_representation_of_interpretation_result(
             string_part_value, string_representation)) {
       this->system.print_error_message(std::string("Interpretation failed. '") +
-                                       string_part.value +
+                                       std::string(string_part.value) +
                                        "' could not be interpreted as string.");
       return false;
     }
@@ -837,7 +1011,7 @@ bool Interpreter::interpret_string(const ParseResult &input, std::any &result) {
 }
 
 bool Interpreter::interpret_unknown(const ParseResult &input,
-                                    std::any &result) {
+                                    Value &result) {
 
   /**
    * Reset the result so the check for has_value fails.
@@ -877,7 +1051,7 @@ bool Interpreter::interpret_unknown(const ParseResult &input,
 }
 
 bool Interpreter::interpret_expression(const ParseResult &input,
-                                       std::any &result) {
+                                       Value &result) {
 
   DLOG(INFO) << "Interpreting mathematical expression." << std::endl;
 
@@ -897,445 +1071,264 @@ bool Interpreter::interpret_expression(const ParseResult &input,
    * number, and operators in an alternating manner.  These are stored
    * as the children of the expression ParseResult.
    */
+  if (input.children.empty()) {
+    /**
+     * If the expression is empty, something went wrong.
+     */
+    this->system.print_error_message(
+        std::string("Could not evaluate empty expression."));
+    return false;
+  }
+
+  /**
+   * If the expression consists of only one element, then this is the
+   * result of the whole expression. It does not have to be a number.
+   */
+  if (input.children.size() == 1) {
+    DLOG(INFO) << "Size of expression is 1. Evaluating single result."
+               << std::endl;
+
+    if (!interpret_parse_result(input.children[0], result)) {
+      this->system.print_error_message(
+          std::string("Expression evaluated to a single term that could not be "
+                      "interpreted."));
+      return false;
+    }
+
+    return true;
+  }
 
   /**
    * Since multiplication and division come before addition and
-   * subtraction we first evaluate these operators and then the rest.
-   *
-   * We thus iterate the parts of the expression and collect all parts
-   * that are not part of a multiplication or division.  Additionally,
-   * we immediately evaluate multiplications and divisions and add the
-   * resulting value to the collection of expression parts that still
-   * need to be evaluated.
+   * subtraction, we evaluate the expression as a sum of terms, where
+   * each term is a product of operands.  The operands are evaluated
+   * from left to right.  The value of a term is added to (or
+   * subtracted from) the final result, once we reach the next '+' or
+   * '-', or the end of the expression.
    */
-  std::vector<ParseResult> remaining_expression;
+  double final_result = 0.0;
+  double term = 0.0;
 
   /**
-   * When we find a '*' or '/' we manipulate the index, since in that
-   * case we can skip the next (it will be evaluated in the current
-   * iteration.)  Since index manipulation within for-loops is bad
-   * style, we use a while-loop instead.
+   * The operator that is applied to the current term once it is
+   * complete.  Initially, the first term will be added to 0 (which
+   * is the current final_result).
    */
-  int index = 0;
-  while (index < (int)input.children.size()) {
+  std::string term_operation = "+";
 
-    /**
-     * If we find an operator at the current index and it's '*' or '/'
-     * we immediately evaluate the corresponding operation by
-     * evaluating the preceding and following statements.
-     */
+  /**
+   * The operator that precedes the current operand.
+   */
+  std::string current_operation = "";
+
+  for (int index = 0; index < (int)input.children.size(); ++index) {
+
+    const ParseResult &part = input.children[index];
 
     /**
-     * Check whether we find an operator.
+     * Odd positions are operators.
      */
-    if (input.children[index].type == Operator) {
-
-      /**
-       * Check if the operator is at an odd index. Otherwise something
-       * is wrong.
-       */
-      if (index % 2 != 1) {
+    if (index % 2 == 1) {
+      if (part.type != Operator) {
         this->system.print_error_message(
-            std::string("Unexpected operator found at an even index in the "
-                        "expression."));
+            std::string("Expected operator but found '") +
+            std::string(part.value) +
+            "' instead.");
         return false;
       }
 
-      /**
-       * The string representing the current operator.
-       */
-      std::string operator_string = input.children[index].value;
+      current_operation = part.value;
 
       /**
-       * Check whether the operator is '*' or '/'
+       * Addition and subtraction complete the current term.
        */
-      if ("*" == operator_string || "/" == operator_string) {
-        /**
-         * We now evaluate the operation.  For this, we evaluate the
-         * preceding and following part of the expression.
-         *
-         * Start with the left hand side.
-         */
-        std::any lhs_result;
-
-        /**
-         * We now use the last element of the REMAINING_EXPRESSION
-         * as left hand side. This is due to the following
-         * reason. In the previous iteration we added the previous
-         * element of the expression to the end of the
-         * remaining_expression vector. We now use it and then pop
-         * it from the remaining_expression since we won't evaluate
-         * it again.
-         *
-         * If the previous element was already a right hand side of
-         * a multiplication or division, this right hand side was
-         * already evaluated and the result of the multiplication or
-         * division was added to the back of the
-         * remaining_expression vector. Which means now taking this
-         * element from the end is exactly what we want.
-         */
-        bool lhs_interpretation_success =
-            interpret_parse_result(remaining_expression.back(), lhs_result);
-
-        /**
-         * We don't want to interpret this element again.
-         */
-        remaining_expression.pop_back();
-
-        /**
-         * Check whether the left hand side was evaluated
-         * successfully.
-         */
-        if (!lhs_interpretation_success) {
-          this->system.print_error_message(
-              std::string(
-                  "Could not interpret left hand side of operation near '") +
-              operator_string + "'.");
-          return false;
-        }
-
-        /**
-         * We now try to get the numerical value of the left hand
-         * side.  Operators can only be applied to numbers. So we
-         * try to cast the result to a number.
-         */
-        double lhs_value;
-
-        try {
-          lhs_value = std::any_cast<double>(lhs_result);
-        } catch (const std::bad_any_cast &bac) {
-          this->system.print_error_message(
-              std::string("Interpretation failed: Left hand side of "
-                          "operation near '") +
-              operator_string +
-              "', could not be interpreted as number :" + bac.what());
-          return false;
+      if ("+" == current_operation || "-" == current_operation) {
+        if ("+" == term_operation) {
+          final_result += term;
+        } else {
+          final_result -= term;
         }
 
-        /**
-         * Now proceed with the right hand side.
-         */
-
-        std::any rhs_result;
-        bool rhs_interpretation_success =
-            interpret_parse_result(input.children[index + 1], rhs_result);
-
-        /**
-         * Check whether the left hand side was evaluated
-         * successfully.
-         */
-        if (!rhs_interpretation_success) {
-          this->system.print_error_message(
-              std::string(
-                  "Could not interpret right hand side of operation near '") +
-              operator_string + "'.");
-          return false;
-        }
+        term_operation = current_operation;
+      }
 
-        /**
-         * We now try to get the numerical value of the left hand
-         * side.  Operators can only be applied to numbers. So we
-         * try to cast the result to a number.
-         */
-        double rhs_value;
-
-        try {
-          rhs_value = std::any_cast<double>(rhs_result);
-        } catch (const std::bad_any_cast &bac) {
-          this->system.print_error_message(
-              std::string("Interpretation failed: Right hand side of "
-                          "operation near '") +
-              operator_string +
-              "', could not be interpreted as number :" + bac.what());
-          return false;
-        }
+      DLOG(INFO) << "Operation updated for index " << index << ": '"
+                 << current_operation << "'." << std::endl;
+      continue;
+    }
 
-        /**
-         * Now we have the left hand side and the right hand
-         * side. So we can actually evaluate the expression.
-         */
-        double result_value;
-
-        /**
-         * Perform multiplications
-         */
-        if ("*" == operator_string) {
-          result_value = lhs_value * rhs_value;
-          DLOG(INFO) << "Intermediate result of expression: " << lhs_value
-                     << " * " << rhs_value << " = " << result_value;
-        } else {
-          result_value = lhs_value / rhs_value;
+    /**
+     * Even positions are operands.
+     */
+    if (part.type == Operator) {
+      this->system.print_error_message(
+          std::string("Unexpected operator found at an even index in the "
+                      "expression."));
+      return false;
+    }
 
-          DLOG(INFO) << "Intermediate result of expression: " << lhs_value
-                     << " / " << rhs_value << " = " << result_value;
-        }
+    const bool is_right_hand_side =
+        "*" == current_operation || "/" == current_operation;
+    const bool is_left_hand_side =
+        index + 1 < (int)input.children.size() &&
+        ("*" == input.children[index + 1].value ||
+         "/" == input.children[index + 1].value);
 
-        /**
-         * Since we later need to evaluate the whole expression, we
-         * now add this intermediate result as ParseResult so later
-         * evaluation becomes easier.
-         */
-        ParseResult intermediate_result(Number, std::to_string(result_value));
-
-        /**
-         * We now simply add the result at the end of the
-         * remaining_expression in order to be evaluated later.
-         */
-        remaining_expression.push_back(intermediate_result);
-
-        /**
-         * Now we're done with the evaluation. Since we don't need
-         * to consider the right side of this operation again, we
-         * skip this element by increasing the current index by two
-         * instead of one.
-         */
-        index += 2;
-
-        /**
-         * Skip the remainder of the loop.
-         */
-        continue;
+    Value operand_result;
+    if (!interpret_parse_result(part, operand_result)) {
+      if (is_right_hand_side) {
+        this->system.print_error_message(
+            std::string(
+                "Could not interpret right hand side of operation near '") +
+            current_operation + "'.");
+      } else if (is_left_hand_side) {
+        this->system.print_error_message(
+            std::string(
+                "Could not interpret left hand side of operation near '") +
+            std::string(input.children[index + 1].value) + "'.");
+      } else {
+        this->system.print_error_message(
+            std::string("Could not interpret operand '") +
+            std::string(part.value) + "'.");
+      }
+      return false;
+    }
 
+    /**
+     * Operators can only be applied to numbers.
+     */
+    double operand_value;
+    if (!number_from_value(operand_result, operand_value)) {
+      if (is_right_hand_side) {
+        this->system.print_error_message(
+            std::string("Interpretation failed: Right hand side of "
+                        "operation near '") +
+            current_operation + "' could not be interpreted as number.");
+      } else if (is_left_hand_side) {
+        this->system.print_error_message(
+            std::string("Interpretation failed: Left hand side of "
+                        "operation near '") +
+            std::string(input.children[index + 1].value) +
+            "' could not be interpreted as number.");
       } else {
-        /**
-         * If the operator is not '*' or '/', we add it to the
-         * remaining_expression.
-         */
-        remaining_expression.push_back(input.children[index]);
+        this->system.print_error_message(
+            std::string("Interpretation failed: Operand '") +
+            std::string(part.value) +
+            "' could not be interpreted as number.");
       }
-    } else {
-      /**
-       * If we don't have an operator, we simply add the part of the
-       * expression to the remaining_expression for later evaluation.
-       */
-      remaining_expression.push_back(input.children[index]);
+      return false;
     }
 
     /**
-     * Continue with the next part of the expression.
+     * Now depending on the preceding operator we either start a new
+     * term, or multiply / divide the current one.
      */
-    ++index;
+    if ("*" == current_operation) {
+      DLOG(INFO) << "Intermediate result of expression: " << term << " * "
+                 << operand_value << " = " << term * operand_value;
+      term *= operand_value;
+    } else if ("/" == current_operation) {
+      DLOG(INFO) << "Intermediate result of expression: " << term << " / "
+                 << operand_value << " = " << term / operand_value;
+      term /= operand_value;
+    } else {
+      term = operand_value;
+    }
   }
 
   /**
-   * If we reach this point, all multiplications and divisions were
-   * interpreted successfully.
-   *
-   * It remains to interpret the addition and subtraction operators if
-   * there are any.
+   * An expression cannot end with an operator.
    */
+  if (input.children.size() % 2 == 0) {
+    this->system.print_error_message(
+        std::string("Could not interpret right hand side of operation near '") +
+        current_operation + "'.");
+    return false;
+  }
 
   /**
-   * If the remaining_expression consists of only one element, then
-   * this is the result of the whole expression. We evaluate it and
-   * return the result.
+   * Add the last term.
    */
-  if (remaining_expression.size() == 1) {
-    DLOG(INFO) << "Size of remaining expression is 1. Evaluating single result."
-               << std::endl;
-    /**
-     * Interpret the single element of the expression.
-     */
-    bool interpretation_success =
-        interpret_parse_result(remaining_expression[0], result);
+  if ("+" == term_operation) {
+    final_result += term;
+  } else {
+    final_result -= term;
+  }
 
-    if (!interpretation_success) {
-      this->system.print_error_message(
-          std::string("Expression evaluated to a single term that could not be "
-                      "interpreted."));
-      return false;
-    }
+  /**
+   * Everything went as expected.
+   */
+  result = final_result;
+  return true;
+}
 
-    return true;
+bool Interpreter::interpret_variable(const ParseResult &input,
+                                     Value &result) {
+  DLOG(INFO) << "Interpreting variable with value: '" << input.value
+             << "'." << std::endl;
 
-  } else if (remaining_expression.size() > 1) {
-    DLOG(INFO) << "Remaining expression has size "
-               << remaining_expression.size() << std::endl;
-    /**
-     * If the remaining_expression contains more than one element, we
-     * evaluate the whole expression which should consist of additions
-     * and subtractions only.
-     */
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
 
-    /**
-     * The variable that we use to create the final result.  Since
-     * from now on we only have additions and subtractions, we can
-     * safely initialize this with 0.
-     */
-    double final_result = 0;
+  /**
+   * Let the system state now, which line we're currently
+   * interpreting.
+   */
+  this->system.state.line_number = input.line_number;
 
-    /**
-     * This variable that holds the operator in each iteration.
-     *
-     * Initially the current operation will be '+' since the first
-     * operand will be added to 0 (which is the current final_result).
-     */
-    std::string current_operation = "+";
+  /**
+   * We now check whether the variable is defined, using the slot
+   * that the resolver assigned to it.
+   */
+  Value *variable_value = this->system.state.storage_for_variable(
+      input.frame, input.slot, input.value);
 
-    for (int index = 0; index < (int)remaining_expression.size(); ++index) {
+  if (variable_value == nullptr || !variable_value->has_value()) {
+    this->system.print_error_message(
+        std::string("Use of undeclared variable '") + std::string(input.value) +
+        "'. Declare the variable first using 'var " +
+        std::string(input.value) + " = ...'");
+    return false;
+  }
 
-      /**
-       * Even positions are operands. We evaluate the operand and
-       * perform the current_operation.
-       */
-      if (index % 2 == 0) {
+  /**
+   * Check whether we are actually trying to access a property of the
+   * current variable.
+   */
+  if (input.children.size() == 1 && input.children[0].type == Property) {
 
-        std::any operand_result;
-
-        /**
-         * Interpret the operand.
-         */
-        bool interpretation_success =
-          interpret_parse_result(remaining_expression[index], operand_result);
-
-        if (!interpretation_success) {
-          this->system.print_error_message(
-              std::string("Could not interpret operand '") +
-              remaining_expression[index].value + "'.");
-          return false;
-        }
-
-        /**
-         * If the operand was interpreted successfully, we now try to
-         * evaluate at it as a number.
-         */
-        double operand_value;
-
-        try {
-          operand_value = std::any_cast<double>(operand_result);
-          DLOG(INFO) << "Operand " << index
-                     << " in remaining expression was evaluated to '"
-                     << operand_value << "'." << std::endl;
-        } catch (const std::bad_any_cast &bac) {
-          this->system.print_error_message(
-              std::string("Interpretation failed: Operand '") +
-              remaining_expression[index].value +
-              "' could not be interpreted as number :" + bac.what());
-          return false;
-        }
-
-        /**
-         * Now depending on the current operator we either add or
-         * subtract the current operand.
-         */
-        if ("+" == current_operation) {
-          /**
-           * Add the operand_value to the final_result.
-           */
-          final_result += operand_value;
-          DLOG(INFO) << "Adding '" << operand_value
-                     << "' to current result, yielding: '" << final_result
-                     << "'." << std::endl;
-        } else {
-          /**
-           * The only alternative is subtraction.
-           */
-          final_result -= operand_value;
-          DLOG(INFO) << "Subtracting '" << operand_value
-                     << "' from current result, yielding: '" << final_result
-                     << "'." << std::endl;
-        }
-      } else {
-        /**
-         * If the index is odd, we expect an operator.
-         */
-        if (remaining_expression[index].type != Operator) {
-          this->system.print_error_message(
-              std::string("Expected operator but found '") +
-              remaining_expression[index].value + "' instead.");
-          return false;
-        }
-
-        /**
-         * Update the current operation.
-         */
-        current_operation = remaining_expression[index].value;
-        DLOG(INFO) << "Operation updated for index " << index << ": '"
-                   << current_operation << "'." << std::endl;
-      }
-    }
-
-    /**
-     * Everything went as expected.
-     */
-    result = final_result;
-    return true;
-  } else {
-    /**
-     * If the remaining_expression is empty, something went wrong.
-     */
-    this->system.print_error_message(
-        std::string("Could not evaluate empty expression."));
-    return false;
-  }
-
-  return false;
-}
-
-bool Interpreter::interpret_variable(const ParseResult &input,
-                                     std::any &result) {
-  DLOG(INFO) << "Interpreting variable with value: '" << input.value
-             << "'." << std::endl;
-
-  /**
-   * Reset the result so the check for has_value fails.
-   */
-  result.reset();
-
-  /**
-   * Let the system state now, which line we're currently
-   * interpreting.
-   */
-  this->system.state.line_number = input.line_number;
-
-  /**
-   * We now check whether the variable is defined. The result of the
-   * check is the scope that the variable was defined in, or -1 if the
-   * variable was not defined.
-   */
-  if (this->system.state.value_for_variable(input.value, result) < 0) {
-    this->system.print_error_message(
-        std::string("Use of undeclared variable '") + input.value +
-        "'. Declare the variable first using 'var " + input.value + " = ...'");
-    return false;
-  }
-
-  /**
-   * Check whether we are actually trying to access a property of the
-   * current variable.
-   */
-  if (input.children.size() == 1 && input.children[0].type == Property) {
-
-    std::string property_name = input.children[0].value;
+    std::string property_name(input.children[0].value);
 
     DLOG(INFO) << "Trying to access property '" << property_name
                << "' of variable '" << input.value << "'." << std::endl;
 
     /**
-     * Try to get the property value from the variable which is
-     * currently stored in the result.
+     * Only points, objects and arrays of points have properties.
      */
-    try {
-      PropertyMap property_map = std::any_cast<PropertyMap>(result);
-
-      /**
-       * Try to get the value of the property.
-       */
-      return value_for_property(property_name, property_map, result);
-
-    } catch (std::bad_any_cast &bac) {
+    if (variable_value->pol() == nullptr &&
+        variable_value->object() == nullptr &&
+        variable_value->array() == nullptr) {
       this->system.print_error_message(
           std::string("Could not access property '") + property_name +
-          "' of variable '" + input.value + "'. Did not find property map.");
+          "' of variable '" + std::string(input.value) +
+          "'. Did not find property map.");
       return false;
     }
+
+    /**
+     * Try to get the value of the property.
+     */
+    return value_for_property(property_name, *variable_value, result);
   }
 
+  result = *variable_value;
   return true;
 }
 
 bool Interpreter::interpret_function(const ParseResult &function_call,
-                                     std::any &result) {
+                                     Value &result) {
 
   DLOG(INFO) << "Trying to interpret function: '" << function_call.value
              << "'." << std::endl;
@@ -1357,64 +1350,90 @@ bool Interpreter::interpret_function(const ParseResult &function_call,
    */
   if (function_call.type != Function) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_call.value +
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
         "'. Expected function but found '" +
         System::name_for_type.at(function_call.type) + "' instead.");
     return false;
   }
 
+  /**
+   * If the optimizer hoisted the call out of a loop, its value is
+   * kept in a slot, once the call was evaluated in the current run of
+   * the loop.
+   */
+  if (function_call.frame != UnresolvedFrame) {
+    Value *hoisted_value = this->system.state.storage_for_variable(
+        function_call.frame, function_call.slot, "");
+    if (hoisted_value != nullptr && hoisted_value->has_value()) {
+      result = *hoisted_value;
+      return true;
+    }
+  }
+
   /**
    * First we check whether we have a user defined function with the
    * current name.
    */
-  std::unordered_map<std::string, std::vector<ParseResult>>::const_iterator
+  std::unordered_map<std::string, Span<const ParseResult>>::const_iterator
       position_of_statements =
-          this->system.statements_for_functions.find(function_call.value);
+          this->system.statements_for_functions.find(std::string(
+              function_call.value));
+
+  bool success;
 
   /**
    * If we found statements for that function, we want to interpret
    * the function as a user defined function.
    */
   if (position_of_statements != this->system.statements_for_functions.end()) {
-    return interpret_user_defined_function(function_call, result);
-  }
-
-  /**
-   * If we didn't identify this function call as a call to a user
-   * defined function, we now check if we know about a builtin
-   * function with the corresponding name.
-   */
-  std::unordered_map<std::string,
-                     std::function<bool(Interpreter *, const ParseResult &,
-                                        std::any &)>>::const_iterator
-      position_of_function = this->builtin_functions.find(function_call.value);
+    success = interpret_user_defined_function(function_call, result);
+  } else {
+    /**
+     * If we didn't identify this function call as a call to a user
+     * defined function, we now check if we know about a builtin
+     * function with the corresponding name.
+     */
+    std::unordered_map<std::string, Builtin>::const_iterator
+        position_of_function = this->builtin_functions.find(std::string(
+            function_call.value));
 
-  /**
-   * If we did find the function, execute it.
-   */
-  if (position_of_function != this->builtin_functions.end()) {
-    std::function<bool(Interpreter *, const ParseResult &, std::any &)>
-        function = position_of_function->second;
+    /**
+     * At this point we have neither found the function as a builtin
+     * function nor as a user defined function.  Therefore, we print an
+     * error message.
+     */
+    if (position_of_function == this->builtin_functions.end()) {
+      this->system.print_error_message(std::string("Could not interpret '") +
+                                       std::string(function_call.value) +
+                                       "'. No function definition found.");
+      return false;
+    }
 
     /**
-     * Actually calling the function.
+     * If we did find the function, execute it.
      */
-    return function(this, function_call, result);
+    success = call_builtin_function(position_of_function->second,
+                                    function_call, result);
   }
 
   /**
-   * At this point we have neither found the function as a builtin
-   * function nor as a user defined function.  Therefore, we print an
-   * error message.
+   * The stack may have been reallocated by the call, so the slot of a
+   * hoisted call is determined again.
    */
-  this->system.print_error_message(std::string("Could not interpret '") +
-                                   function_call.value +
-                                   "'. No function definition found.");
-  return false;
+  if (success && function_call.frame != UnresolvedFrame) {
+    Value *hoisted_value = this->system.state.storage_for_variable(
+        function_call.frame, function_call.slot, "");
+    if (hoisted_value != nullptr) {
+      *hoisted_value = result;
+    }
+  }
+
+  return success;
 }
 
 bool Interpreter::interpret_function_definition(
-    const ParseResult &function_definition, std::any &result) {
+    const ParseResult &function_definition, Value &result) {
 
   DLOG(INFO) << "Trying to interpret function definition: '"
              << function_definition.value << "'." << std::endl;
@@ -1436,7 +1455,8 @@ bool Interpreter::interpret_function_definition(
    */
   if (function_definition.type != FunctionDefinition) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_definition.value +
+        std::string("Could not interpret '") +
+        std::string(function_definition.value) +
         "'. Expected function definition but found '" +
         System::name_for_type.at(function_definition.type) + "' instead.");
     return false;
@@ -1454,7 +1474,7 @@ bool Interpreter::interpret_function_definition(
   if (function_definition.children.empty()) {
     this->system.print_error_message(
         std::string("Could not interpret function definition '") +
-        function_definition.value +
+        std::string(function_definition.value) +
         ": The function definition did not contain the parameter list.");
     return false;
   }
@@ -1464,7 +1484,8 @@ bool Interpreter::interpret_function_definition(
    */
   if (function_definition.children[0].type != ParameterList) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_definition.value +
+        std::string("Could not interpret '") +
+        std::string(function_definition.value) +
         "'. Expected parameter list but found '" +
         System::name_for_type.at(function_definition.children[0].type) +
         "' instead.");
@@ -1473,30 +1494,20 @@ bool Interpreter::interpret_function_definition(
 
   /**
    * It remains to save the statements of that function so that we can
-   * execute them later.
-   */
-  std::vector<ParseResult> function_statements;
-
-  /**
-   * Collect the statements, starting at index 1, since index 0 is the
-   * parameter list.
-   */
-  for (int i = 1; i < (int)function_definition.children.size(); ++i) {
-    function_statements.push_back(function_definition.children[i]);
-  }
-
-  /**
-   * Save the statements of that function for later lookup.
+   * execute them later.  The statements start at index 1, since index
+   * 0 is the parameter list.
    */
   this->system.statements_for_functions.insert(
-      std::pair<std::string, std::vector<ParseResult>>(function_definition.value,
-                                                       function_statements));
+      std::pair<std::string, Span<const ParseResult>>(
+          function_definition.value,
+          function_definition.children.subrange(
+              1, function_definition.children.size())));
 
   return true;
 }
 
 bool Interpreter::interpret_user_defined_function(
-    const ParseResult &function_call, std::any &result) {
+    const ParseResult &function_call, Value &result) {
 
   DLOG(INFO) << "Trying to interpret user defined function: '"
              << function_call.value << "'." << std::endl;
@@ -1518,7 +1529,8 @@ bool Interpreter::interpret_user_defined_function(
    */
   if (function_call.type != Function) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_call.value +
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
         "'. Expected function but found '" +
         System::name_for_type.at(function_call.type) + "' instead.");
     return false;
@@ -1528,9 +1540,10 @@ bool Interpreter::interpret_user_defined_function(
    * First we check whether we actually have a user defined function
    * with the current name.
    */
-  std::unordered_map<std::string, std::vector<ParseResult>>::const_iterator
+  std::unordered_map<std::string, Span<const ParseResult>>::const_iterator
     position_of_statements =
-    this->system.statements_for_functions.find(function_call.value);
+    this->system.statements_for_functions.find(std::string(
+        function_call.value));
 
   /**
    * If we found statements for that function, we want to interpret
@@ -1538,34 +1551,121 @@ bool Interpreter::interpret_user_defined_function(
    */
   if (position_of_statements == this->system.statements_for_functions.end()) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_call.value +
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
         "'. Could not find function definition for a function with that name.");
     return false;
   }
 
   /**
-   * We open a new scope, since all variables defined in the function
-   * will be forgotten after the function.
+   * The resolver determined how many slots the frame of the function
+   * needs.
+   */
+  std::unordered_map<std::string, Func>::const_iterator position_of_function =
+      this->system.known_functions.find(std::string(function_call.value));
+
+  if (position_of_function == this->system.known_functions.end()) {
+    this->system.print_error_message(
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
+        "'. Could not find the parameters of the function.");
+    return false;
+  }
+
+  const Func &function = position_of_function->second;
+
+  /**
+   * All variables defined in the function will be forgotten after the
+   * function, which is why the function gets a new frame.  The
+   * parameters occupy the first slots of the frame, in the order in
+   * which they were declared.  Since the arguments of the call appear
+   * in the same order, the argument at index i is stored in slot i.
    */
-  this->system.state.open_new_scope();
+  State &state = this->system.state;
+
+  int number_of_slots = function.number_of_slots;
+  if (number_of_slots < (int)function.arguments.size()) {
+    number_of_slots = function.arguments.size();
+  }
+
+  int frame = state.reserve_frame(number_of_slots);
 
   /**
-   * At first we interpret the argument list.  And then define the
-   * parameter values in the newly opened scope.
+   * At first we interpret the argument list. This still happens in
+   * the frame of the caller.  Functions called while interpreting the
+   * arguments put their frames after the reserved frame.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  if (function_call.children.size() != 1 ||
+      function_call.children[0].type != ArgumentList) {
+    this->system.print_error_message(
+        std::string("Could not interpret function '") +
+        std::string(function_call.value) +
+        ": The function call contained more than the argument list.");
+    state.stack.resize(frame);
     return false;
   }
 
+  const Span<ParseResult> arguments = function_call.children[0].children;
+
+  for (int index = 0;
+       index < (int)arguments.size() && index < number_of_slots; ++index) {
+    if (arguments[index].type != Argument ||
+        arguments[index].children.size() != 1) {
+      this->system.print_error_message(
+          std::string("In function call '") + std::string(function_call.value) +
+          "': Expected argument but found '" +
+          System::name_for_type.at(arguments[index].type) + "' instead.");
+      state.stack.resize(frame);
+      return false;
+    }
+
+    Value argument_value;
+    if (!interpret_parse_result(arguments[index].children[0], argument_value)) {
+      state.stack.resize(frame);
+      return false;
+    }
+
+    /**
+     * The stack may have been reallocated while interpreting the
+     * argument, so we store the value by index.
+     */
+    state.stack[frame + index] = argument_value;
+  }
+
   /**
-   * Now we iterate all arguments and define the corresponding values
-   * in the current scope.
+   * The result of a pure function only depends on its arguments, so
+   * it is remembered if the arguments are numbers or points.
    */
-  for (const std::pair<std::string, std::any> &interpreted_argument : interpreted_arguments) {
-    this->system.state.define_variable_with_value(interpreted_argument.first,
-                                                  interpreted_argument.second);
+  std::unordered_map<MemoizationKey, Value, MemoizationKeyHash>
+      *memoized_results = nullptr;
+  MemoizationKey memoization_key;
+
+  if (function.is_pure &&
+      memoization_key_for_arguments(
+          state.stack.data() + frame,
+          std::min((int)arguments.size(), number_of_slots), memoization_key)) {
+    memoized_results = &this->memoized_results[&function];
+
+    std::unordered_map<MemoizationKey, Value,
+                       MemoizationKeyHash>::const_iterator
+        position_of_result = memoized_results->find(memoization_key);
+    if (position_of_result != memoized_results->end()) {
+      result = position_of_result->second;
+      state.stack.resize(frame);
+      return true;
+    }
+  }
+
+  int previous_frame_base = state.enter_frame(frame);
+
+  /**
+   * The parameters are named, such that the functions called from
+   * this function can use them.
+   */
+  for (int index = 0; index < (int)function.arguments.size() &&
+                      index < (int)arguments.size() && index < number_of_slots;
+       ++index) {
+    state.storage_for_definition(LocalFrame, index, function.arguments[index]);
   }
 
   DLOG(INFO) << "Defined argument values for used defined function." << std::endl;
@@ -1574,29 +1674,68 @@ bool Interpreter::interpret_user_defined_function(
    * Now we simply interpret all statements that belong to the
    * function.
    */
+  bool success = true;
+  Profiler::Scope scope(this->profiler, Profiler::Kind::Function,
+                        function_call.value);
   for (const ParseResult &parsed_statement : (*position_of_statements).second) {
-    if (!interpret_parse_result(parsed_statement, result)) {
-      return false;
+    if (!interpret_statement(parsed_statement, result)) {
+      success = false;
+      break;
     }
   }
 
   /**
-   * When we're done executing, we remove the function scope.
+   * When we're done executing, we remove the function frame.
    */
-  this->system.state.close_scope();
+  state.close_frame(previous_frame_base);
+
+  if (success && memoized_results != nullptr) {
+    if ((int)memoized_results->size() >= maximum_number_of_memoized_results) {
+      memoized_results->clear();
+    }
+    memoized_results->emplace(std::move(memoization_key), result);
+  }
+
+  return success;
+}
+
+bool Interpreter::memoization_key_for_arguments(const Value *values,
+                                                int number_of_values,
+                                                MemoizationKey &key) {
+  key.clear();
 
   /**
-   * If we did not return, yet, everything seems to be fine.
+   * Appends the bits of a coordinate to the key.
    */
+  const auto append_coordinate = [&key](double coordinate) {
+    uint64_t bits;
+    std::memcpy(&bits, &coordinate, sizeof(bits));
+    key.push_back(bits);
+  };
+
+  for (int index = 0; index < number_of_values; ++index) {
+    const double *number = values[index].number();
+    const Pol *point = values[index].pol();
+
+    if (number != nullptr) {
+      key.push_back((uint64_t)ValueType::Number);
+      append_coordinate(*number);
+    } else if (point != nullptr) {
+      key.push_back((uint64_t)ValueType::Pol);
+      append_coordinate(point->r);
+      append_coordinate(point->phi);
+    } else {
+      return false;
+    }
+  }
+
   return true;
 }
 
 // Functions:
 
 bool Interpreter::interpret_arguments_from_function_call(
-    const ParseResult &function_call,
-    std::unordered_map<std::string, std::any> &arguments,
-    const std::vector<std::string> &parameters_to_interpret) {
+    const ParseResult &function_call, Arguments &arguments) {
 
   DLOG(INFO) << "Interpreting arguments from function call '"
              << function_call.value << "'." << std::endl;
@@ -1615,7 +1754,8 @@ bool Interpreter::interpret_arguments_from_function_call(
     this->system.print_error_message(
         std::string("Unexpectedly found '") +
         System::name_for_type.at(function_call.type) +
-        "' while interpreting function '" + function_call.value + "'.");
+        "' while interpreting function '" + std::string(function_call.value) +
+        "'.");
     return false;
   }
 
@@ -1625,83 +1765,51 @@ bool Interpreter::interpret_arguments_from_function_call(
    */
   if (function_call.children.size() != 1) {
     this->system.print_error_message(
-        std::string("Could not interpret function '") + function_call.value +
+        std::string("Could not interpret function '") +
+        std::string(function_call.value) +
         ": The function call contained more than the argument list.");
     return false;
   }
 
   if (function_call.children[0].type != ArgumentList) {
     this->system.print_error_message(
-        std::string("In function call '") + function_call.value +
+        std::string("In function call '") + std::string(function_call.value) +
         "': Expected argument list but found '" +
         System::name_for_type.at(function_call.children[0].type) +
         "' instead.");
     return false;
   }
 
+  /**
+   * The parser made sure that the call does not have more arguments
+   * than the function has parameters.
+   */
+  arguments.size = function_call.children[0].children.size();
+  if (arguments.size > (int)arguments.function->arguments.size()) {
+    this->system.print_error_message(
+        std::string("Extraneous argument in call to function '") +
+        std::string(function_call.value) + "'.");
+    return false;
+  }
+
   /**
    * Now we gather the values.
    */
-  for (const ParseResult &argument : function_call.children[0].children) {
+  for (int parameter = 0; parameter < arguments.size; ++parameter) {
     /**
-     * Check whether we're dealing with an argument.
+     * The argument that uses the hidden variable is interpreted by
+     * the function itself.
      */
-    if (argument.type != Argument) {
-      this->system.print_error_message(
-          std::string("In function call '") + function_call.value +
-          "': Expected argument but found '" +
-          System::name_for_type.at(argument.type) + "' instead.");
-      return false;
+    if (parameter == arguments.function->argument_with_hidden_variable) {
+      DLOG(INFO) << "Skipping interpretation of argument for parameter '"
+                 << arguments.function->arguments[parameter] << "'."
+                 << std::endl;
+      arguments.values[parameter].reset();
+      continue;
     }
 
-    std::string parameter_name = argument.value;
-
-    /**
-     * Check whether we should evaluate this argument now. If
-     * the parameters_to_interpret vector is empty, we
-     * interpret all arguments. Otherwise we check if the
-     * current argument is contained.
-     */
-    if (parameters_to_interpret.empty() ||
-        std::find(parameters_to_interpret.begin(),
-                  parameters_to_interpret.end(),
-                  parameter_name) != parameters_to_interpret.end()) {
-      DLOG(INFO) << "Interpreting argument for parameter: '" << parameter_name
-                 << "'." << std::endl;
-
-      /**
-       * The parameter has to have exactly one argument value
-       * as its child.
-       */
-      if (argument.children.size() != 1) {
-        this->system.print_error_message(
-            std::string("In function call '") + function_call.value +
-            "': Expected argument but found '" +
-            System::name_for_type.at(argument.type) + "' instead.");
-        return false;
-      }
-
-      std::any argument_value;
-      bool success =
-          interpret_parse_result(argument.children[0], argument_value);
-
-      /**
-       * If we couldn't interpret the argument, we return false. The
-       * resulting error will have been printed already.
-       */
-      if (!success) {
-        return false;
-      }
-
-      /**
-       * If the argument value could be interpreted successfully, we
-       * store the resulting value using the argument_name.
-       */
-      arguments[parameter_name] = argument_value;
-
-    } else {
-      DLOG(INFO) << "Skipping interpretation of argument for parameter '"
-                 << parameter_name << "'." << std::endl;
+    if (!interpret_argument(function_call, parameter, arguments)) {
+      return false;
     }
   }
 
@@ -1713,168 +1821,369 @@ bool Interpreter::interpret_arguments_from_function_call(
   return true;
 }
 
-bool Interpreter::argument_value_for_parameter(
-    const std::string &parameter,
-    const std::unordered_map<std::string, std::any> &interpreted_arguments,
-    std::any &result) {
+bool Interpreter::interpret_argument(const ParseResult &function_call,
+                                     int parameter, Arguments &arguments) {
+  /**
+   * Trailing arguments may be omitted in the call. These don't have a
+   * value, which is reported when the value is used.
+   */
+  if (parameter >= arguments.size) {
+    return true;
+  }
+
+  const ParseResult &argument = function_call.children[0].children[parameter];
 
+  /**
+   * Check whether we're dealing with an argument.  The parameter has
+   * to have exactly one argument value as its child.
+   */
+  if (argument.type != Argument || argument.children.size() != 1) {
+    this->system.print_error_message(
+        std::string("In function call '") + std::string(function_call.value) +
+        "': Expected argument but found '" +
+        System::name_for_type.at(argument.type) + "' instead.");
+    return false;
+  }
+
+  DLOG(INFO) << "Interpreting argument for parameter: '" << argument.value
+             << "'." << std::endl;
+
+  /**
+   * If we couldn't interpret the argument, we return false. The
+   * resulting error will have been printed already.
+   */
+  return interpret_parse_result(argument.children[0],
+                                arguments.values[parameter]);
+}
+
+bool Interpreter::call_builtin_function(const Builtin &builtin,
+                                        const ParseResult &function_call,
+                                        Value &result) {
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  std::unordered_map<std::string, std::any>::const_iterator position =
-      interpreted_arguments.find(parameter);
+  if ((int)builtin.function->arguments.size() > maximum_number_of_arguments) {
+    this->system.print_error_message(
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
+        "'. The function has too many parameters.");
+    return false;
+  }
 
-  if (position != interpreted_arguments.end()) {
-    result = position->second;
-    return true;
+  /**
+   * The arguments are stored on the stack, such that calling a
+   * builtin function does not require any allocations.
+   */
+  Value values[maximum_number_of_arguments];
+  Arguments arguments;
+  arguments.function = builtin.function;
+  arguments.values = values;
+
+  if (!interpret_arguments_from_function_call(function_call, arguments)) {
+    return false;
   }
 
   /**
-   * If we didn't find the value something went wrong.
+   * Actually calling the function.
    */
-  return false;
+  Profiler::Scope scope(this->profiler, Profiler::Kind::Builtin,
+                        function_call.value);
+  return builtin.implementation(this, function_call, arguments, result);
 }
 
-bool Interpreter::number_value_for_parameter(
-    const std::string &parameter,
-    const std::unordered_map<std::string, std::any> &interpreted_arguments,
-    double &value) {
+bool Interpreter::number_value_for_parameter(const Arguments &arguments,
+                                             int parameter, double &value) {
 
-  std::any argument_value;
-  if (!(argument_value_for_parameter(parameter, interpreted_arguments,
-                                     argument_value) &&
-        number_from_value(argument_value, value))) {
+  if (!(parameter < arguments.size &&
+        number_from_value(arguments.values[parameter], value))) {
     this->system.print_error_message(
         std::string(
             "Could not interpret function / initialization. Argument for "
             "parameter '") +
-        parameter + "' could not be interpreted as number.");
+        arguments.function->arguments[parameter] +
+        "' could not be interpreted as number.");
     return false;
   }
 
   return true;
 }
 
-bool Interpreter::pol_value_for_parameter(
-    const std::string &parameter,
-    const std::unordered_map<std::string, std::any> &interpreted_arguments,
-    Pol &value) {
+bool Interpreter::pol_value_for_parameter(const Arguments &arguments,
+                                          int parameter, Pol &value) {
+
+  const std::string &parameter_name = arguments.function->arguments[parameter];
 
   /**
    * Check whether the argument was is in the list.
    */
-  std::any argument_value;
-  if (!argument_value_for_parameter(parameter, interpreted_arguments,
-                                    argument_value)) {
+  if (parameter >= arguments.size ||
+      !arguments.values[parameter].has_value()) {
     this->system.print_error_message(
         std::string(
             "Could not interpret function / initialization. Argument for "
             "parameter '") +
-        parameter + "' could not be found.");
+        parameter_name + "' could not be found.");
     return false;
   }
 
+  const Value &argument_value = arguments.values[parameter];
+
   /**
-   * Check whether the value can be cast to a PropertyMap.
+   * Check whether the value is a point.
    */
-  try {
-    PropertyMap property_map = std::any_cast<PropertyMap>(argument_value);
+  const Pol *point = argument_value.pol();
+  if (point != nullptr) {
+    value = *point;
+    return true;
+  }
 
-    /**
-     * Check whether the type of the object is Pol.
-     */
-    PropertyMap::const_iterator position_of_type = property_map.find(System::type_string);
+  /**
+   * If the value is an object of a different type, we report which
+   * type we found instead.
+   */
+  const Object *object = argument_value.object();
+  if (object != nullptr) {
+    this->system.print_error_message(
+        std::string("Unexpectedly found '") + object->type +
+        "' while trying to interpret 'Pol' for parameter: '" + parameter_name +
+        "'.");
+    return false;
+  }
 
-    if (position_of_type == property_map.end()) {
-      this->system.print_error_message(
-          std::string("Property map found while interpreting parameter '") +
-          parameter + "' did not contain the type of the object.");
-      return false;
-    }
+  this->system.print_error_message(
+      std::string(
+          "Could not interpret function / initialization. Argument for "
+          "parameter '") +
+      parameter_name + "' could not be interpreted as Pol.");
+  return false;
+}
 
-    /**
-     * Try to cast the type as string.
-     */
-    std::string type_string;
-    try {
-      type_string = std::any_cast<std::string>(position_of_type->second);
-    } catch (std::bad_any_cast &bac) {
-      this->system.print_error_message(
-          std::string(
-              "Type of property map found while interpreting parameter '") +
-          parameter + "' could not be determined.");
-      return false;
-    }
+bool Interpreter::string_value_for_parameter(const Arguments &arguments,
+                                             int parameter, std::string &str) {
 
-    /**
-     * Check whether we actually found a Pol object.
-     */
-    if (type_string != "Pol") {
-      this->system.print_error_message(
-          std::string("Unexpectedly found '") + type_string +
-          "' while trying to interpret 'Pol' for parameter: '" + parameter +
-          "'.");
-      return false;
+  /**
+   * First we try to get the argument value from the argument list.
+   */
+  if (parameter >= arguments.size ||
+      !arguments.values[parameter].has_value()) {
+    this->system.print_error_message(
+        std::string("Could not interpret function . Argument for "
+                    "parameter '") +
+        arguments.function->arguments[parameter] +
+        "' could not be interpreted as number.");
+    return false;
+  }
+
+  /**
+   * Now that we found the argument we check whether it is a string.
+   */
+  const std::string *string_value = arguments.values[parameter].string();
+  if (string_value == nullptr) {
+    return false;
+  }
+
+  str = *string_value;
+  return true;
+}
+
+bool Interpreter::number_elements_for_parameter(const Arguments &arguments,
+                                                int parameter,
+                                                Elements &elements) {
+  elements.array = nullptr;
+  if (parameter < arguments.size) {
+    const Array *array = arguments.values[parameter].array();
+    if (array != nullptr && array->element_type == ValueType::Number) {
+      elements.array = array;
+      return true;
     }
+  }
 
-    /**
-     * Now we try to get the properties.
-     */
-    double r;
-    double phi;
-    if (!number_value_for_parameter("r", property_map, r) ||
-        !number_value_for_parameter("phi", property_map, phi)) {
-      return false;
+  return number_value_for_parameter(arguments, parameter, elements.single.r);
+}
+
+bool Interpreter::pol_elements_for_parameter(const Arguments &arguments,
+                                             int parameter,
+                                             Elements &elements) {
+  elements.array = nullptr;
+  if (parameter < arguments.size) {
+    const Array *array = arguments.values[parameter].array();
+    if (array != nullptr && array->element_type == ValueType::Pol) {
+      elements.array = array;
+      return true;
     }
+  }
 
-    value = Pol(r, phi);
-    return true;
-  } catch (std::bad_any_cast &bac) {
+  return pol_value_for_parameter(arguments, parameter, elements.single);
+}
+
+bool Interpreter::array_for_parameter(const Arguments &arguments,
+                                      int parameter, ValueType element_type,
+                                      const Array *&array) {
+  array = parameter < arguments.size ? arguments.values[parameter].array()
+                                     : nullptr;
+
+  if (array == nullptr || (element_type != ValueType::None &&
+                           array->element_type != element_type)) {
     this->system.print_error_message(
         std::string(
             "Could not interpret function / initialization. Argument for "
             "parameter '") +
-        parameter + "' could not be interpreted as Pol.");
+        arguments.function->arguments[parameter] +
+        "' could not be interpreted as " +
+        (element_type == ValueType::Number
+             ? "array of numbers"
+             : element_type == ValueType::Pol ? "array of Pols" : "array") +
+        ".");
     return false;
   }
 
+  return true;
+}
+
+bool Interpreter::number_of_elements(
+    const ParseResult &function_call,
+    std::initializer_list<const Elements *> elements, size_t &number,
+    bool &is_array) {
+  number = 1;
+  is_array = false;
+
+  for (const Elements *argument : elements) {
+    if (argument->array == nullptr) {
+      continue;
+    }
+
+    if (is_array && argument->array->size() != number) {
+      this->system.print_error_message(
+          std::string("Invalid argument in function '") +
+          std::string(function_call.value) +
+          "'. The arrays have different sizes (" + std::to_string(number) +
+          " and " + std::to_string(argument->array->size()) + ").");
+      return false;
+    }
+
+    number = argument->array->size();
+    is_array = true;
+  }
+
+  return true;
+}
+
+bool Interpreter::report_not_enough_memory(const ParseResult &function_call,
+                                           const std::string &objects) {
+  this->system.print_error_message(
+      std::string("Invalid argument in function '") +
+      std::string(function_call.value) + "'. There is not enough memory for " +
+      objects + ".");
   return false;
 }
 
-bool Interpreter::string_value_for_parameter(
-    const std::string &parameter,
-    const std::unordered_map<std::string, std::any> &interpreted_arguments,
-    std::string &str) {
+bool Interpreter::set_hidden_variable(const ParseResult &function_call,
+                                      const Value &value) {
+  /**
+   * Find out which argument uses the hidden variable.
+   */
+  std::unordered_map<std::string, Func>::const_iterator position_of_function =
+      this->system.known_functions.find(std::string(function_call.value));
+
+  if (position_of_function == this->system.known_functions.end() ||
+      function_call.children.empty()) {
+    return true;
+  }
+
+  int parameter = position_of_function->second.argument_with_hidden_variable;
 
   /**
-   * First we try to get the argument value from the argument list.
+   * If the function call does not contain the argument, there is
+   * nothing to set. The missing argument is reported when it is
+   * interpreted.
+   */
+  if (parameter < 0 ||
+      parameter >= (int)function_call.children[0].children.size()) {
+    return true;
+  }
+
+  /**
+   * The resolver stored the slot of the hidden variable in the
+   * argument.
    */
-  std::any argument_value;
-  if (!(argument_value_for_parameter(parameter, interpreted_arguments,
-                                     argument_value))) {
+  const ParseResult &argument = function_call.children[0].children[parameter];
+  Value *hidden_variable_value = this->system.state.storage_for_variable(
+      argument.frame, argument.slot, System::hidden_variable_string);
+
+  if (hidden_variable_value == nullptr) {
     this->system.print_error_message(
-        std::string("Could not interpret function . Argument for "
-                    "parameter '") +
-        parameter + "' could not be interpreted as number.");
+        std::string("Could not set hidden variable '") +
+        System::hidden_variable_string + "' in function '" +
+        std::string(function_call.value) + "'.");
     return false;
   }
 
+  *hidden_variable_value = value;
+  return true;
+}
+
+bool Interpreter::value_for_property(const std::string &property_name,
+                                     const Value &value, Value &result) {
+
   /**
-   * Now that we found the argument we try to cast it as string.
+   * Reset the result so the check for has_value fails.
    */
-  try {
-    str = std::any_cast<std::string>(argument_value);
-    return true;
-  } catch (std::bad_any_cast &bac) {
+  result.reset();
+
+  /**
+   * The properties of points are their coordinates.
+   */
+  const Pol *point = value.pol();
+  if (point != nullptr) {
+    if (property_name == "r") {
+      result = point->r;
+      return true;
+    }
+
+    if (property_name == "phi") {
+      result = point->phi;
+      return true;
+    }
+
+    this->system.print_error_message(std::string("Could not find property '") +
+                                     property_name + "'.");
     return false;
   }
+
+  const Object *object = value.object();
+  if (object != nullptr) {
+    return value_for_property(property_name, object->properties, result);
+  }
+
+  /**
+   * The coordinates of an array of points are arrays of numbers.
+   */
+  const Array *array = value.array();
+  if (array != nullptr) {
+    if (array->element_type == ValueType::Pol &&
+        (property_name == "r" || property_name == "phi")) {
+      std::shared_ptr<Array> coordinates = std::make_shared<Array>();
+      coordinates->r = property_name == "r" ? array->r : array->phi;
+      result = std::shared_ptr<const Array>(coordinates);
+      return true;
+    }
+
+    this->system.print_error_message(std::string("Could not find property '") +
+                                     property_name + "'.");
+    return false;
+  }
+
+  this->system.print_error_message(
+      std::string("Could not access property '") + property_name +
+      "'. Did not find property map.");
+  return false;
 }
 
 bool Interpreter::value_for_property(const std::string &property_name,
                                      const PropertyMap &property_map,
-                                     std::any &result) {
+                                     Value &result) {
 
   /**
    * Reset the result so the check for has_value fails.
@@ -1895,121 +2204,120 @@ bool Interpreter::value_for_property(const std::string &property_name,
 }
 
 bool Interpreter::string_representation_of_interpretation_result(
-    const std::any &result, std::string &str) {
+    const Value &result, std::string &str) {
 
-  /**
-   * Check whether it is a double.
-   */
-  try {
-    str = std::to_string(std::any_cast<double>(result));
-    return true;
-  } catch (const std::bad_any_cast &e) {
-  }
+  switch (result.type()) {
+    case ValueType::Number:
+      str = std::to_string(*result.number());
+      return true;
 
-  /**
-   * Check whether it is a string.
-   */
-  try {
-    str = std::any_cast<std::string>(result);
-    return true;
-  } catch (const std::bad_any_cast &e) {
-  }
+    case ValueType::String:
+      str = *result.string();
+      return true;
 
-  /**
-   * Check whether is a property map.
-   */
-  try {
+    case ValueType::Pol:
+      str = std::string("Pol(r: ") + std::to_string(result.pol()->r) +
+            ", phi: " + std::to_string(result.pol()->phi) + ")";
+      return true;
 
-    /**
-     * Cast to property map.
-     */
-    PropertyMap property_map = std::any_cast<PropertyMap>(result);
-    try {
-      /**
-       * Try to get the type of the object.
-       */
-      std::string type_string =
-          std::any_cast<std::string>(property_map[System::type_string]);
+    case ValueType::Function:
+      str = result.function()->name;
+      return true;
 
-      /**
-       * Now that we have the type, we try to get the properties of
-       * this type.
-       */
-      std::unordered_map<std::string, Func>::const_iterator
-        position_of_function_arguments =
-        this->system.known_functions.find(type_string);
+    case ValueType::Object:
+      break;
 
-      if (position_of_function_arguments == this->system.known_functions.end()) {
-        this->system.print_error_message(
-            std::string("Could not find expected properties for type '") +
-            type_string + "'.");
-        return false;
+    case ValueType::Array: {
+      const Array &array = *result.array();
+      str = "[";
+      for (size_t index = 0; index < array.size(); ++index) {
+        std::string element;
+        if (!string_representation_of_interpretation_result(
+                array.element(index), element)) {
+          return false;
+        }
+
+        str += (index > 0 ? ", " : "") + element;
       }
+      str += "]";
+      return true;
+    }
 
+    default:
       /**
-       * Print the type of the object.
+       * If we didn't find a string representation, we return false.
        */
-      str = type_string + "(";
+      return false;
+  }
 
-      /**
-       * Iterate and print the properties.
-       */
-      for (int index = 0;
-           index < (int)position_of_function_arguments->second.arguments.size();
-           ++index) {
-        std::string property_name =
-            position_of_function_arguments->second.arguments[index];
-
-        str += property_name  + ": ";
-
-        /**
-         * Try to get the value for this property.
-         */
-        std::unordered_map<std::string, std::any>::const_iterator
-            position_of_property = property_map.find(property_name);
-
-        if (position_of_property == property_map.end()) {
-          this->system.print_error_message(
-              std::string("Could not find property '") + property_name +
-              "' for type '" + type_string + "'.");
-          return false;
-        }
+  const Object &object = *result.object();
 
-        /**
-         * Get the string representation of the property value.
-         */
-        std::string property_value;
-        if (!string_representation_of_interpretation_result(
-                position_of_property->second, property_value)) {
-          return false;
-        }
+  /**
+   * Now that we have the type, we try to get the properties of
+   * this type.
+   */
+  std::unordered_map<std::string, Func>::const_iterator
+      position_of_function_arguments =
+          this->system.known_functions.find(object.type);
 
-        str += property_value;
+  if (position_of_function_arguments == this->system.known_functions.end()) {
+    this->system.print_error_message(
+        std::string("Could not find expected properties for type '") +
+        object.type + "'.");
+    return false;
+  }
 
-        if (index < (int)position_of_function_arguments->second.arguments.size() - 1) {
-          str += ", ";
-        } else {
-          str += ")";
-        }
-      }
+  /**
+   * Print the type of the object.
+   */
+  str = object.type + "(";
 
-      return true;
+  /**
+   * Iterate and print the properties.
+   */
+  for (int index = 0;
+       index < (int)position_of_function_arguments->second.arguments.size();
+       ++index) {
+    std::string property_name =
+        position_of_function_arguments->second.arguments[index];
+
+    str += property_name + ": ";
+
+    /**
+     * Try to get the value for this property.
+     */
+    PropertyMap::const_iterator position_of_property =
+        object.properties.find(property_name);
 
-    } catch (std::bad_any_cast &bac){
+    if (position_of_property == object.properties.end()) {
+      this->system.print_error_message(
+          std::string("Could not find property '") + property_name +
+          "' for type '" + object.type + "'.");
       return false;
     }
 
-    return true;
-  } catch (const std::bad_any_cast &bac) {
+    /**
+     * Get the string representation of the property value.
+     */
+    std::string property_value;
+    if (!string_representation_of_interpretation_result(
+            position_of_property->second, property_value)) {
+      return false;
+    }
+
+    str += property_value;
+
+    if (index < (int)position_of_function_arguments->second.arguments.size() - 1) {
+      str += ", ";
+    } else {
+      str += ")";
+    }
   }
 
-  /**
-   * If we didn't find a string representation, we return false.
-   */
-  return false;
+  return true;
 }
 
-bool Interpreter::print_interpretation_result(const std::any &result) {
+bool Interpreter::print_interpretation_result(const Value &result) {
 
   std::string string_representation;
   if (string_representation_of_interpretation_result(result,
@@ -2025,35 +2333,28 @@ bool Interpreter::print_interpretation_result(const std::any &result) {
   return false;
 }
 
-void Interpreter::print_scopes() {
-  for (int i = this->system.state.scopes.size() - 1; i >= 0; --i) {
-    this->print_scope_at_index(i);
-  }
-}
-
-void Interpreter::print_scope_at_index(int index) {
-  std::cout << "Scope " << index << ": (" << this->system.state.scopes[index].size()
+void Interpreter::print_globals() {
+  std::cout << "Globals: (" << this->system.state.slots_for_globals.size()
             << " variables)" << std::endl;
 
   /**
-   * Get all keys in order to sort them afterwards.
+   * Get all names in order to sort them afterwards.
    */
-  std::vector<std::string> keys;
-
-  for (const std::pair<std::string, std::any> &key_value :
-       this->system.state.scopes[index]) {
-    keys.push_back(key_value.first);
+  std::vector<std::string> names;
+  for (const std::pair<const std::string, int> &name_slot :
+       this->system.state.slots_for_globals) {
+    names.push_back(name_slot.first);
   }
 
   /**
-   * Sort keys.
+   * Sort names.
    */
-  std::sort(keys.begin(), keys.end());
+  std::sort(names.begin(), names.end());
 
-  for (int i = 0; i < (int)keys.size(); ++i) {
-    std::cout << "  [" << i << "] " << keys[i] << " = '";
+  for (int i = 0; i < (int)names.size(); ++i) {
+    std::cout << "  [" << i << "] " << names[i] << " = '";
     Interpreter::print_interpretation_result(
-        this->system.state.scopes[index].at(keys[i]));
+        this->system.state.globals[this->system.state.slots_for_globals.at(names[i])]);
     std::cout << "'" << std::endl;
   }
 }
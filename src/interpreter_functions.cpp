@@ -9,15 +9,54 @@
 
 #include <interpreter.hpp>
 #include <pol.hpp>
+#include <random_graph.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
-#include <random>
+#include <new>
+#include <stdexcept>
 
 namespace hydra {
 
-bool Interpreter::function_clear(const ParseResult &function_call,
-                                 std::any &result) {
+bool Interpreter::function_array_element(const ParseResult &function_call,
+                                         Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument values.
+   */
+  const Array *array;
+  if (!array_for_parameter(arguments, 0, ValueType::None, array)) {
+    return false;
+  }
+
+  double index;
+  if (!number_value_for_parameter(arguments, 1, index)) {
+    return false;
+  }
+
+  if (!(index >= 0.0 && index < array->size() && index == std::floor(index))) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) + "'. " +
+        (array->size() == 0
+             ? std::string("The array is empty.")
+             : "The index has to be a whole number between 0 and " +
+                   std::to_string(array->size() - 1) + "."));
+    return false;
+  }
+
+  result = array->element((size_t)index);
+  return true;
+}
+
+bool Interpreter::function_array_size(const ParseResult &function_call,
+                                      Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -25,22 +64,34 @@ bool Interpreter::function_clear(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument value.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  const Array *array;
+  if (!array_for_parameter(arguments, 0, ValueType::None, array)) {
     return false;
   }
 
+  result = (double)array->size();
+  return true;
+}
+
+bool Interpreter::function_clear(const ParseResult &function_call,
+                                 Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
   /**
    * If there are arguments, something went wrong. Clear is not
    * supposed to have arguments.
    */
-  if (!interpreted_arguments.empty()) {
+  if (arguments.size > 0) {
     this->system.print_error_message(
         std::string("Extraneous argument in call to function '") +
-        function_call.value + "'. This function does not take any arguments.");
+        std::string(function_call.value) +
+        "'. This function does not take any arguments.");
     return false;
   }
 
@@ -53,69 +104,49 @@ bool Interpreter::function_clear(const ParseResult &function_call,
 }
 
 bool Interpreter::function_circle(const ParseResult &function_call,
-                                  std::any &result) {
+                                  Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
   /**
    * Now we try to obtain the actual argument value.
    */
   Pol center;
-  if (!pol_value_for_parameter("center", interpreted_arguments, center)) {
+  if (!pol_value_for_parameter(arguments, 0, center)) {
     return false;
   }
 
   double radius;
 
-  if (!number_value_for_parameter("radius", interpreted_arguments, radius)) {
+  if (!number_value_for_parameter(arguments, 1, radius)) {
     return false;
   }
 
   /**
    * Add the circle to the canvas.
    */
-  Path circle_path;
-  Canvas::path_for_circle(center, radius, this->canvas.resolution, circle_path);
-  this->canvas.add_path(circle_path);
+  this->canvas.add_circle(center, radius);
 
   return true;
 }
 
 bool Interpreter::function_cos(const ParseResult &function_call,
-                                std::any &result) {
+                               Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
   /**
    * Now we try to obtain the actual argument value.
    */
   double x;
 
-  if (!number_value_for_parameter("x", interpreted_arguments, x)) {
+  if (!number_value_for_parameter(arguments, 0, x)) {
     return false;
   }
 
@@ -127,28 +158,19 @@ bool Interpreter::function_cos(const ParseResult &function_call,
 }
 
 bool Interpreter::function_cosh(const ParseResult &function_call,
-                                std::any &result) {
+                                Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
   /**
    * Now we try to obtain the actual argument value.
    */
   double x;
 
-  if (!number_value_for_parameter("x", interpreted_arguments, x)) {
+  if (!number_value_for_parameter(arguments, 0, x)) {
     return false;
   }
 
@@ -160,7 +182,7 @@ bool Interpreter::function_cosh(const ParseResult &function_call,
 }
 
 bool Interpreter::function_curve_angle(const ParseResult &function_call,
-                                       std::any &result) {
+                                       Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -168,27 +190,21 @@ bool Interpreter::function_curve_angle(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments. Note, that we don't interpret all
-   * arguments initially. That is because the last argument might
-   * contain the hidden variable _p which will only be evaluated when
-   * _p is known.
+   * Note, that the last argument was not interpreted with the other
+   * arguments. That is because it might contain the hidden variable
+   * _p which will only be evaluated when _p is known.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call, interpreted_arguments,
-                                              {"from", "to"})) {
-    return false;
-  }
 
   /**
    * Now we try to obtain the actual argument value.
    */
   Pol from;
-  if (!pol_value_for_parameter("from", interpreted_arguments, from)) {
+  if (!pol_value_for_parameter(arguments, 0, from)) {
     return false;
   }
 
   Pol to;
-  if (!pol_value_for_parameter("to", interpreted_arguments, to)) {
+  if (!pol_value_for_parameter(arguments, 1, to)) {
     return false;
   }
 
@@ -198,7 +214,8 @@ bool Interpreter::function_curve_angle(const ParseResult &function_call,
    */
   if (from.phi != to.phi) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_call.value +
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
         "'. The angular coordinates of the two endpoints did not match: '" +
         std::to_string(from.phi) + "' vs. '" + std::to_string(to.phi) + "'.");
     return false;
@@ -242,33 +259,28 @@ bool Interpreter::function_curve_angle(const ParseResult &function_call,
   if (!(step_size > 0)) {
     this->system.print_error_message(
         std::string("Invalid step size <= 0 in function '") +
-        function_call.value +
+        std::string(function_call.value) +
         "'. Make sure that 'to' and 'from' are not the same point.");
     return false;
   }
 
-  double radius = from.r;
-
   /**
-   * We add current point (on the line) as the hidden variable _p to
-   * a new scope that will only live for this function execution.
+   * Besides one point per step, there are additional points close to
+   * the origin.
    */
-  this->system.state.open_new_scope();
-
-  PropertyMap current_point;
-  current_point[System::type_string] = std::string("Pol");
-  current_point["r"] = radius;
-  current_point["phi"] = from.phi;
+  path.reserve(2.0 * this->canvas.resolution + 2.0);
 
-  const std::string hidden_variable_name = "_p";
+  double radius = from.r;
 
-  int current_scope =
-      this->system.state.define_variable_with_value(hidden_variable_name, current_point);
+  /**
+   * We pass the current point (on the line) as the hidden variable
+   * _p to the angle argument.
+   */
+  Pol current_point(radius, from.phi);
 
   /**
    * In the loop we iteratively evaluate the angle argument.
    */
-  std::unordered_map<std::string, std::any> interpreted_angle_argument;
   double angle = 0.0;
 
   /**
@@ -307,24 +319,23 @@ bool Interpreter::function_curve_angle(const ParseResult &function_call,
     /**
      * Update the radius of the hidden variable _p.
      */
-    current_point["r"] = r;
-    this->system.state.set_value_for_variable(hidden_variable_name,
-                                              current_point, current_scope);
+    current_point.r = r;
+    if (!set_hidden_variable(function_call, current_point)) {
+      return false;
+    }
 
     /**
      * Now that the hidden variable is defined, we interpret the angle
      * argument.
      */
-    if (!interpret_arguments_from_function_call(function_call, interpreted_angle_argument,
-                                                {"angle"})) {
+    if (!interpret_argument(function_call, 2, arguments)) {
       return false;
     }
 
     /**
      * We try to get the angle value.
      */
-    if (!number_value_for_parameter("angle", interpreted_angle_argument,
-                                    angle)) {
+    if (!number_value_for_parameter(arguments, 2, angle)) {
       return false;
     }
 
@@ -339,26 +350,16 @@ bool Interpreter::function_curve_angle(const ParseResult &function_call,
     path.push_back(point);
   }
 
-  /**
-   * We now close the scope that holds the hidden variable.
-   */
-  if (!this->system.state.close_scope()) {
-    this->system.print_error_message(std::string(
-        "Could not close hidden variable scope as that would mean closing the "
-        "last scope."));
-    return false;
-  }
-
   /**
    * Actually adding the path to the canvas.
    */
-  this->canvas.add_path(path);
+  this->canvas.add_path(std::move(path));
 
   return true;
 }
 
 bool Interpreter::function_curve_distance(const ParseResult &function_call,
-                                          std::any &result) {
+                                          Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -366,27 +367,21 @@ bool Interpreter::function_curve_distance(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments. Note, that we don't interpret all
-   * arguments initially. That is because the last argument might
-   * contain the hidden variable _p which will only be evaluated when
-   * _p is known.
+   * Note, that the last argument was not interpreted with the other
+   * arguments. That is because it might contain the hidden variable
+   * _p which will only be evaluated when _p is known.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call, interpreted_arguments,
-                                              {"from", "to"})) {
-    return false;
-  }
 
   /**
    * Now we try to obtain the actual argument value.
    */
   Pol from;
-  if (!pol_value_for_parameter("from", interpreted_arguments, from)) {
+  if (!pol_value_for_parameter(arguments, 0, from)) {
     return false;
   }
 
   Pol to;
-  if (!pol_value_for_parameter("to", interpreted_arguments, to)) {
+  if (!pol_value_for_parameter(arguments, 1, to)) {
     return false;
   }
 
@@ -410,33 +405,24 @@ bool Interpreter::function_curve_distance(const ParseResult &function_call,
   if (!(step_size > 0)) {
     this->system.print_error_message(
         std::string("Invalid step size <= 0 in function '") +
-        function_call.value +
+        std::string(function_call.value) +
         "'. Make sure that 'to' and 'from' are not the same point.");
     return false;
   }
 
+  path.reserve(this->canvas.resolution + 2.0);
+
   double radius = from.r;
 
   /**
-   * We add current point (on the line) as the hidden variable _p to
-   * a new scope that will only live for this function execution.
+   * We pass the current point (on the line) as the hidden variable
+   * _p to the distance argument.
    */
-  this->system.state.open_new_scope();
-
-  PropertyMap current_point;
-  current_point[System::type_string] = std::string("Pol");
-  current_point["r"] = radius;
-  current_point["phi"] = from.phi;
-
-  const std::string hidden_variable_name = "_p";
-
-  int current_scope =
-      this->system.state.define_variable_with_value(hidden_variable_name, current_point);
+  Pol current_point(radius, from.phi);
 
   /**
    * In the loop we iteratively evaluate the distance argument.
    */
-  std::unordered_map<std::string, std::any> interpreted_distance_argument;
   double distance = 0.0;
 
   /**
@@ -505,25 +491,23 @@ bool Interpreter::function_curve_distance(const ParseResult &function_call,
     /**
      * Update the radius of the hidden variable _p.
      */
-    current_point["r"] = current_helper_point_on_line.r;
-    current_point["phi"] = current_helper_point_on_line.phi;
-    this->system.state.set_value_for_variable(hidden_variable_name,
-                                              current_point, current_scope);
+    current_point = current_helper_point_on_line;
+    if (!set_hidden_variable(function_call, current_point)) {
+      return false;
+    }
 
     /**
      * Now that the hidden variable is defined, we interpret the angle
      * argument.
      */
-    if (!interpret_arguments_from_function_call(function_call, interpreted_distance_argument,
-                                                {"distance"})) {
+    if (!interpret_argument(function_call, 2, arguments)) {
       return false;
     }
 
     /**
-     * We try to get the angle value.
+     * We try to get the distance value.
      */
-    if (!number_value_for_parameter("distance", interpreted_distance_argument,
-                                    distance)) {
+    if (!number_value_for_parameter(arguments, 2, distance)) {
       return false;
     }
 
@@ -574,26 +558,16 @@ bool Interpreter::function_curve_distance(const ParseResult &function_call,
     path.push_back(final_resulting_point);
   }
 
-  /**
-   * We now close the scope that holds the hidden variable.
-   */
-  if (!this->system.state.close_scope()) {
-    this->system.print_error_message(std::string(
-        "Could not close hidden variable scope as that would mean closing the "
-        "last scope."));
-    return false;
-  }
-
   /**
    * Actually adding the path to the canvas.
    */
-  this->canvas.add_path(path);
+  this->canvas.add_path(std::move(path));
 
   return true;
 }
 
 bool Interpreter::function_distance(const ParseResult &function_call,
-                                    std::any &result) {
+                                    Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -601,57 +575,70 @@ bool Interpreter::function_distance(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument value.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  Elements from;
+  if (!pol_elements_for_parameter(arguments, 0, from)) {
     return false;
   }
 
-  /**
-   * Now we try to obtain the actual argument value.
-   */
-  Pol from;
-  if (!pol_value_for_parameter("from", interpreted_arguments, from)) {
+  Elements to;
+  if (!pol_elements_for_parameter(arguments, 1, to)) {
     return false;
   }
 
-  Pol to;
-  if (!pol_value_for_parameter("to", interpreted_arguments, to)) {
+  size_t number_of_distances;
+  bool is_array;
+  if (!number_of_elements(function_call, {&from, &to}, number_of_distances,
+                          is_array)) {
     return false;
   }
 
   /**
    * Compute the result.
    */
-  result = from.distance_to(to);
+  if (!is_array) {
+    result = from.single.distance_to(to.single);
+    return true;
+  }
+
+  std::shared_ptr<Array> distances = std::make_shared<Array>();
+  distances->r.resize(number_of_distances);
+
+  /**
+   * When the distances to a single point are computed, its hyperbolic
+   * functions are only evaluated once.  The distance is symmetric, so
+   * it does not matter which of the two is the single point.
+   */
+  if (from.array == nullptr || to.array == nullptr) {
+    const CachedPol single(from.array == nullptr ? from.single : to.single);
+    const Array &points = from.array == nullptr ? *to.array : *from.array;
+    CachedPol::distances(single, points.r.data(), points.phi.data(),
+                         number_of_distances, distances->r.data());
+  } else {
+    for (size_t index = 0; index < number_of_distances; ++index) {
+      distances->r[index] = from.pol(index).distance_to(to.pol(index));
+    }
+  }
+
+  result = std::shared_ptr<const Array>(distances);
   return true;
 }
 
 bool Interpreter::function_exp(const ParseResult &function_call,
-                               std::any &result) {
+                               Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
   /**
    * Now we try to obtain the actual argument value.
    */
   double x;
 
-  if (!number_value_for_parameter("x", interpreted_arguments, x)) {
+  if (!number_value_for_parameter(arguments, 0, x)) {
     return false;
   }
 
@@ -663,35 +650,26 @@ bool Interpreter::function_exp(const ParseResult &function_call,
 }
 
 bool Interpreter::function_print(const ParseResult &function_call,
-                                 std::any &result) {
+                                 Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
   /**
    * Now we try to obtain the actual argument value.
    */
   std::string message;
 
-  if (!string_value_for_parameter("message", interpreted_arguments, message)) {
+  if (!string_value_for_parameter(arguments, 0, message)) {
     return false;
   }
 
   /**
    * Simply print the message;
    */
-  std::cout << message;
+  *this->output << message;
 
   /**
    * Compute the result.
@@ -700,28 +678,19 @@ bool Interpreter::function_print(const ParseResult &function_call,
 }
 
 bool Interpreter::function_log(const ParseResult &function_call,
-                               std::any &result) {
+                               Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
   /**
    * Now we try to obtain the actual argument value.
    */
   double x;
 
-  if (!number_value_for_parameter("x", interpreted_arguments, x)) {
+  if (!number_value_for_parameter(arguments, 0, x)) {
     return false;
   }
 
@@ -733,47 +702,36 @@ bool Interpreter::function_log(const ParseResult &function_call,
 }
 
 bool Interpreter::function_line(const ParseResult &function_call,
-                                std::any &result) {
+                                Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
   /**
    * Now we try to obtain the actual argument value.
    */
   Pol from;
-  if (!pol_value_for_parameter("from", interpreted_arguments, from)) {
+  if (!pol_value_for_parameter(arguments, 0, from)) {
     return false;
   }
 
   Pol to;
-  if (!pol_value_for_parameter("to", interpreted_arguments, to)) {
+  if (!pol_value_for_parameter(arguments, 1, to)) {
     return false;
   }
 
   /**
    * Add the line to the canvas.
    */
-  Path line_path;
-  Canvas::path_for_line(from, to, this->canvas.resolution, line_path);
-  this->canvas.add_path(line_path);
+  this->canvas.add_line(from, to);
 
   return true;
 }
 
-bool Interpreter::function_mark(const ParseResult &function_call,
-                                std::any &result) {
+bool Interpreter::function_lines(const ParseResult &function_call,
+                                 Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -781,39 +739,35 @@ bool Interpreter::function_mark(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
-  /**
-   * Now we try to obtain the actual argument value.
+   * Now we try to obtain the actual argument values.
    */
-  Pol center;
-  if (!pol_value_for_parameter("center", interpreted_arguments, center)) {
+  Elements from;
+  Elements to;
+  if (!pol_elements_for_parameter(arguments, 0, from) ||
+      !pol_elements_for_parameter(arguments, 1, to)) {
     return false;
   }
 
-  double radius;
-  if (!number_value_for_parameter("radius", interpreted_arguments, radius)) {
+  size_t number_of_lines;
+  bool is_array;
+  if (!number_of_elements(function_call, {&from, &to}, number_of_lines,
+                          is_array)) {
     return false;
   }
 
   /**
-   * Add circle to the canvas.
+   * Add the i-th line between the i-th points to the canvas.
    */
-  Circle mark(center, radius);
-  this->canvas.add_mark(mark);
+  this->canvas.paths.reserve(this->canvas.paths.size() + number_of_lines);
+  for (size_t index = 0; index < number_of_lines; ++index) {
+    this->canvas.add_line(from.pol(index), to.pol(index));
+  }
 
   return true;
 }
 
-bool Interpreter::function_random(const ParseResult &function_call,
-                                  std::any &result) {
-
+bool Interpreter::function_lines_within(const ParseResult &function_call,
+                                        Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -821,117 +775,112 @@ bool Interpreter::function_random(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument values.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  Elements points;
+  if (!array_for_parameter(arguments, 0, ValueType::Pol, points.array)) {
     return false;
   }
 
-  /**
-   * Now we try to obtain the actual argument values.
-   */
-  double from;
-  double to;
-
-  /**
-   * Try interpreting the parameters.
-   */
-  if (!number_value_for_parameter("from", interpreted_arguments, from) ||
-      !number_value_for_parameter("to", interpreted_arguments, to)) {
+  double distance;
+  if (!number_value_for_parameter(arguments, 1, distance)) {
     return false;
   }
 
   /**
-   * Check whether the lower bound is actually smaller than the upper
-   * bound.
+   * Each point is compared to every other point, so the hyperbolic
+   * functions of the coordinates are only computed once per point.
    */
-  if (to < from) {
-    this->system.print_error_message(
-        std::string("Could not interpret '") + function_call.value +
-        "'. Argument 'from' must not be larger than 'to'.");
-    return false;
+  std::vector<CachedPol> cached_points;
+  cached_points.reserve(points.array->size());
+  for (size_t index = 0; index < points.array->size(); ++index) {
+    cached_points.emplace_back(points.pol(index));
   }
 
+  std::vector<std::pair<int, int>> pairs;
+  CachedPol::pairs_within(cached_points, distance, pairs);
+
   /**
-   * Now that we have the lower bound (from) and the upper bound (to)
-   * we draw a random double from this interval, which will then be
-   * the result.
+   * Add the lines between the close points to the canvas.
    */
-  std::random_device random_device;
-  std::mt19937 mersenne_twister(random_device());
-  std::uniform_real_distribution<double> distribution(from, to);
+  this->canvas.paths.reserve(this->canvas.paths.size() + pairs.size());
+  for (const std::pair<int, int> &pair : pairs) {
+    this->canvas.add_line(cached_points[pair.first].point,
+                          cached_points[pair.second].point);
+  }
 
-  result = distribution(mersenne_twister);
+  result = (double)pairs.size();
   return true;
 }
 
-bool Interpreter::function_rotate(const ParseResult &function_call,
-                                  std::any &result) {
+bool Interpreter::function_mark(const ParseResult &function_call,
+                                Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
-
   /**
    * Now we try to obtain the actual argument value.
    */
-  Pol point;
-  if (!pol_value_for_parameter("point", interpreted_arguments, point)) {
+  Pol center;
+  if (!pol_value_for_parameter(arguments, 0, center)) {
     return false;
   }
 
-  /**
-   * Try interpreting the angle argument.
-   */
-  double angle;
-  if (!number_value_for_parameter("by", interpreted_arguments, angle)) {
+  double radius;
+  if (!number_value_for_parameter(arguments, 1, radius)) {
     return false;
   }
 
   /**
-   * Actually rotating.
+   * Add circle to the canvas.
    */
-  point.rotate_by(angle);
+  Circle mark(center, radius);
+  this->canvas.add_mark(mark);
 
-  /**
-   * Non-primitive types are defined using maps. The maps contains a
-   * key for the type and one for each property.
-   */
-  PropertyMap property_map;
+  return true;
+}
 
+bool Interpreter::function_marks(const ParseResult &function_call,
+                                 Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
-   * Assign the type.
+   * Reset the result so the check for has_value fails.
    */
-  property_map[System::type_string] = std::string("Pol");
+  result.reset();
 
   /**
-   * Assign the properties from the initialization.
+   * Now we try to obtain the actual argument values.
    */
-  property_map["r"] = point.r;
-  property_map["phi"] = point.phi;
+  Elements centers;
+  Elements radii;
+  if (!pol_elements_for_parameter(arguments, 0, centers) ||
+      !number_elements_for_parameter(arguments, 1, radii)) {
+    return false;
+  }
+
+  size_t number_of_marks;
+  bool is_array;
+  if (!number_of_elements(function_call, {&centers, &radii}, number_of_marks,
+                          is_array)) {
+    return false;
+  }
 
   /**
-   * The result is the property map.
+   * Add the marks to the canvas.
    */
-  result = property_map;
+  this->canvas.marks.reserve(this->canvas.marks.size() + number_of_marks);
+  for (size_t index = 0; index < number_of_marks; ++index) {
+    this->canvas.add_mark(Circle(centers.pol(index), radii.number(index)));
+  }
 
   return true;
 }
 
-bool Interpreter::function_translate(const ParseResult &function_call,
-                                     std::any &result) {
+bool Interpreter::function_number_array(const ParseResult &function_call,
+                                        Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -939,62 +888,107 @@ bool Interpreter::function_translate(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument values.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  double from;
+  double step;
+  double to;
+  if (!number_value_for_parameter(arguments, 0, from) ||
+      !number_value_for_parameter(arguments, 1, step) ||
+      !number_value_for_parameter(arguments, 2, to)) {
     return false;
   }
 
   /**
-   * Now we try to obtain the actual argument value.
+   * The step must not vanish when it is added to the bounds, since
+   * the array would never end otherwise.
    */
-  Pol point;
-  if (!pol_value_for_parameter("point", interpreted_arguments, point)) {
+  const double largest_bound = std::max(std::fabs(from), std::fabs(to));
+  if (!(step > 0.0 && std::isfinite(from) && std::isfinite(to) &&
+        largest_bound + step != largest_bound)) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. The bounds have to be finite and the step has to be positive and "
+        "not too small for the bounds.");
     return false;
   }
 
   /**
-   * Try interpreting the angle argument.
+   * The numbers are the values that a loop over the range [from,
+   * step, to] takes.  Arrays that don't fit into memory are reported
+   * like invalid arguments, instead of ending the program.
    */
-  double distance;
-  if (!number_value_for_parameter("by", interpreted_arguments, distance)) {
-    return false;
+  std::shared_ptr<Array> array = std::make_shared<Array>();
+  const double number_of_values =
+      from <= to ? std::floor((to - from) / step) + 1.0 : 0.0;
+  try {
+    if (number_of_values > (double)array->r.max_size()) {
+      throw std::length_error("Too many values.");
+    }
+
+    array->r.reserve((size_t)number_of_values);
+    for (double value = from; value <= to; value += step) {
+      array->r.push_back(value);
+    }
+  } catch (const std::bad_alloc &) {
+    return report_not_enough_memory(
+        function_call,
+        std::to_string((long long)number_of_values) + " values");
+  } catch (const std::length_error &) {
+    return report_not_enough_memory(
+        function_call,
+        std::to_string((long long)number_of_values) + " values");
   }
 
-  point.translate_horizontally_by(distance);
+  result = std::shared_ptr<const Array>(array);
+  return true;
+}
 
+bool Interpreter::function_pol_array(const ParseResult &function_call,
+                                     Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
-   * Preparing the variable that holds the result of the translation.
-   *
-   * Non-primitive types are defined using maps. The maps contains a
-   * key for the type and one for each property.
+   * Reset the result so the check for has_value fails.
    */
-  PropertyMap property_map;
+  result.reset();
 
   /**
-   * Assign the type.
+   * Now we try to obtain the actual argument values.
    */
-  property_map[System::type_string] = std::string("Pol");
+  Elements radii;
+  Elements angles;
+  if (!number_elements_for_parameter(arguments, 0, radii) ||
+      !number_elements_for_parameter(arguments, 1, angles)) {
+    return false;
+  }
 
-  /**
-   * Assign the properties from the initialization.
-   */
-  property_map["r"] = point.r;
-  property_map["phi"] = point.phi;
+  size_t number_of_points;
+  bool is_array;
+  if (!number_of_elements(function_call, {&radii, &angles}, number_of_points,
+                          is_array)) {
+    return false;
+  }
 
   /**
-   * The result is the property map.
+   * The angles are normalized like those of single points.
    */
-  result = property_map;
+  std::shared_ptr<Array> array = std::make_shared<Array>();
+  array->element_type = ValueType::Pol;
+  array->r.reserve(number_of_points);
+  array->phi.reserve(number_of_points);
+  for (size_t index = 0; index < number_of_points; ++index) {
+    const Pol point(radii.number(index), angles.number(index));
+    array->r.push_back(point.r);
+    array->phi.push_back(point.phi);
+  }
 
+  result = std::shared_ptr<const Array>(array);
   return true;
 }
 
-bool Interpreter::function_save(const ParseResult &function_call,
-                                std::any &result) {
-
+bool Interpreter::function_polyline(const ParseResult &function_call,
+                                    Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -1002,31 +996,31 @@ bool Interpreter::function_save(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument value.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  Elements points;
+  if (!array_for_parameter(arguments, 0, ValueType::Pol, points.array)) {
     return false;
   }
 
   /**
-   * Now we try to obtain the actual argument value.
+   * Add the lines between consecutive points to the canvas.
    */
-  std::string file_name;
-  if (!string_value_for_parameter("file", interpreted_arguments, file_name)) {
-    return false;
+  const size_t number_of_points = points.array->size();
+  if (number_of_points > 1) {
+    this->canvas.paths.reserve(this->canvas.paths.size() + number_of_points -
+                               1);
+  }
+  for (size_t index = 1; index < number_of_points; ++index) {
+    this->canvas.add_line(points.pol(index - 1), points.pol(index));
   }
 
-  /**
-   * Tell the canvas to save its contents to the passed file.
-   */
-  this->canvas.save_to_file(file_name);
   return true;
 }
 
-bool Interpreter::function_set_resolution(const ParseResult &function_call,
-                                          std::any &result) {
+bool Interpreter::function_random(const ParseResult &function_call,
+                                  Arguments &arguments, Value &result) {
+
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -1034,76 +1028,452 @@ bool Interpreter::function_set_resolution(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument values.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
-    return false;
-  }
+  double from;
+  double to;
 
   /**
-   * Now we try to obtain the actual argument value.
+   * Try interpreting the parameters.
    */
-  double x;
-
-  if (!number_value_for_parameter("x", interpreted_arguments, x)) {
+  if (!number_value_for_parameter(arguments, 0, from) ||
+      !number_value_for_parameter(arguments, 1, to)) {
     return false;
   }
 
   /**
-   * The step size has to be positive.
+   * Check whether the lower bound is actually smaller than the upper
+   * bound.
    */
-  if (!(x > 0.0)) {
+  if (to < from) {
     this->system.print_error_message(
-        std::string("Invalid argument in function '") + function_call.value +
-        "'. Cannot set non-positive resolution.");
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
+        "'. Argument 'from' must not be larger than 'to'.");
     return false;
   }
 
   /**
-   * Set the resolution of the canvas.
+   * Now that we have the lower bound (from) and the upper bound (to)
+   * we draw a random double from this interval, which will then be
+   * the result.
    */
-  this->canvas.resolution = x;
-  result = x;
+  result = this->random_engine.uniform(from, to);
   return true;
 }
 
-bool Interpreter::function_sin(const ParseResult &function_call,
-                               std::any &result) {
+bool Interpreter::function_random_angle(const ParseResult &function_call,
+                                        Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
    */
   result.reset();
 
-  /**
-   * Interpret the arguments.
-   */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  if (arguments.size > 0) {
+    this->system.print_error_message(
+        std::string("Extraneous argument in call to function '") +
+        std::string(function_call.value) +
+        "'. This function does not take any arguments.");
     return false;
   }
 
+  result = this->random_engine.angle();
+  return true;
+}
+
+bool Interpreter::function_random_array(const ParseResult &function_call,
+                                        Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
-   * Now we try to obtain the actual argument value.
+   * Reset the result so the check for has_value fails.
    */
-  double x;
+  result.reset();
 
-  if (!number_value_for_parameter("x", interpreted_arguments, x)) {
-    return false;
-  }
+  /**
+   * Now we try to obtain the actual argument values.
+   */
+  double n;
+  double from;
+  double to;
+  if (!number_value_for_parameter(arguments, 0, n) ||
+      !number_value_for_parameter(arguments, 1, from) ||
+      !number_value_for_parameter(arguments, 2, to)) {
+    return false;
+  }
+
+  if (!(n >= 0.0 && n == std::floor(n) && n <= (double)(1ull << 53))) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. The number of values has to be a non-negative whole number.");
+    return false;
+  }
+
+  if (to < from) {
+    this->system.print_error_message(
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
+        "'. Argument 'from' must not be larger than 'to'.");
+    return false;
+  }
 
   /**
-   * Compute the result.
+   * The numbers are drawn in the same order as by n calls to
+   * random(from:, to:).
    */
-  result = ::sin(x);
+  std::shared_ptr<Array> array = std::make_shared<Array>();
+  try {
+    array->r.resize((size_t)n);
+  } catch (const std::bad_alloc &) {
+    return report_not_enough_memory(
+        function_call, std::to_string((long long)n) + " values");
+  } catch (const std::length_error &) {
+    return report_not_enough_memory(
+        function_call, std::to_string((long long)n) + " values");
+  }
+
+  for (double &value : array->r) {
+    value = this->random_engine.uniform(from, to);
+  }
+
+  result = std::shared_ptr<const Array>(array);
   return true;
 }
 
-bool Interpreter::function_sinh(const ParseResult &function_call,
-                                std::any &result) {
+bool Interpreter::function_random_graph(const ParseResult &function_call,
+                                        Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument values.  If omitted, the
+   * points are distributed uniformly, the temperature is 0 and the
+   * vertices are drawn using small marks.
+   */
+  double n;
+  double R;
+  if (!number_value_for_parameter(arguments, 0, n) ||
+      !number_value_for_parameter(arguments, 1, R)) {
+    return false;
+  }
+
+  double alpha = 1.0;
+  double T = 0.0;
+  double radius = 0.1;
+  if ((arguments.size > 2 &&
+       !number_value_for_parameter(arguments, 2, alpha)) ||
+      (arguments.size > 3 && !number_value_for_parameter(arguments, 3, T)) ||
+      (arguments.size > 4 &&
+       !number_value_for_parameter(arguments, 4, radius))) {
+    return false;
+  }
+
+  if (!(n >= 0.0 && n <= 2147483647.0 && n == std::floor(n))) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. The number of vertices 'n' has to be a non-negative whole "
+        "number.");
+    return false;
+  }
+
+  if (!(R >= 0.0) || !(alpha > 0.0) || !(T >= 0.0) || !(radius >= 0.0)) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. 'R', 'T' and 'radius' must not be negative and 'alpha' has to "
+        "be positive.");
+    return false;
+  }
+
+  /**
+   * Graphs that don't fit into memory are reported like invalid
+   * arguments, instead of ending the program.
+   */
+  RandomGraph graph((int)n, R, alpha, T);
+  try {
+    graph.generate(this->random_engine);
+
+    /**
+     * Add the vertices and the edges to the canvas.
+     */
+    for (const Pol &point : graph.points) {
+      this->canvas.add_mark(Circle(point, radius));
+    }
+
+    for (const std::pair<int, int> &edge : graph.edges) {
+      this->canvas.add_line(graph.points[edge.first],
+                            graph.points[edge.second]);
+    }
+  } catch (const std::bad_alloc &) {
+    return report_not_enough_memory(
+        function_call,
+        "a graph with " + std::to_string((long long)n) + " vertices");
+  } catch (const std::length_error &) {
+    return report_not_enough_memory(
+        function_call,
+        "a graph with " + std::to_string((long long)n) + " vertices");
+  }
+
+  result = (double)graph.edges.size();
+  return true;
+}
+
+bool Interpreter::function_random_radius(const ParseResult &function_call,
+                                         Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument values.  If alpha is
+   * omitted, the points are distributed uniformly in the disk.
+   */
+  double R;
+  if (!number_value_for_parameter(arguments, 0, R)) {
+    return false;
+  }
+
+  double alpha = 1.0;
+  if (arguments.size > 1 &&
+      !number_value_for_parameter(arguments, 1, alpha)) {
+    return false;
+  }
+
+  if (!(R >= 0.0) || !(alpha > 0.0)) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. 'R' must not be negative and 'alpha' has to be positive.");
+    return false;
+  }
+
+  result = this->random_engine.radius(R, alpha);
+  return true;
+}
+
+bool Interpreter::function_rotate(const ParseResult &function_call,
+                                  Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument value.
+   */
+  Elements points;
+  if (!pol_elements_for_parameter(arguments, 0, points)) {
+    return false;
+  }
+
+  /**
+   * Try interpreting the angle argument.
+   */
+  Elements angles;
+  if (!number_elements_for_parameter(arguments, 1, angles)) {
+    return false;
+  }
+
+  size_t number_of_points;
+  bool is_array;
+  if (!number_of_elements(function_call, {&points, &angles}, number_of_points,
+                          is_array)) {
+    return false;
+  }
+
+  /**
+   * Actually rotating.  The result is the rotated point, or the array
+   * of rotated points.
+   */
+  if (!is_array) {
+    points.single.rotate_by(angles.single.r);
+    result = points.single;
+    return true;
+  }
+
+  std::shared_ptr<Array> rotated_points = std::make_shared<Array>();
+  rotated_points->element_type = ValueType::Pol;
+  rotated_points->r.resize(number_of_points);
+  rotated_points->phi.resize(number_of_points);
+  for (size_t index = 0; index < number_of_points; ++index) {
+    Pol point = points.pol(index);
+    point.rotate_by(angles.number(index));
+    rotated_points->r[index] = point.r;
+    rotated_points->phi[index] = point.phi;
+  }
+
+  result = std::shared_ptr<const Array>(rotated_points);
+  return true;
+}
+
+bool Interpreter::function_translate(const ParseResult &function_call,
+                                     Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument value.
+   */
+  Elements points;
+  if (!pol_elements_for_parameter(arguments, 0, points)) {
+    return false;
+  }
+
+  /**
+   * Try interpreting the angle argument.
+   */
+  Elements distances;
+  if (!number_elements_for_parameter(arguments, 1, distances)) {
+    return false;
+  }
+
+  size_t number_of_points;
+  bool is_array;
+  if (!number_of_elements(function_call, {&points, &distances},
+                          number_of_points, is_array)) {
+    return false;
+  }
+
+  /**
+   * The result is the translated point, or the array of translated
+   * points.
+   */
+  if (!is_array) {
+    points.single.translate_horizontally_by(distances.single.r);
+    result = points.single;
+    return true;
+  }
+
+  std::shared_ptr<Array> translated_points = std::make_shared<Array>();
+  translated_points->element_type = ValueType::Pol;
+  translated_points->r.resize(number_of_points);
+  translated_points->phi.resize(number_of_points);
+  for (size_t index = 0; index < number_of_points; ++index) {
+    Pol point = points.pol(index);
+    point.translate_horizontally_by(distances.number(index));
+    translated_points->r[index] = point.r;
+    translated_points->phi[index] = point.phi;
+  }
+
+  result = std::shared_ptr<const Array>(translated_points);
+  return true;
+}
+
+bool Interpreter::function_load(const ParseResult &function_call,
+                                Arguments &arguments, Value &result) {
+
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument value.
+   */
+  std::string file_name;
+  if (!string_value_for_parameter(arguments, 0, file_name)) {
+    return false;
+  }
+
+  /**
+   * Add the objects of the stored canvas to the current canvas.
+   */
+  if (!this->canvas.load_from_file(file_name)) {
+    this->system.print_error_message(
+        std::string("Could not interpret '") +
+        std::string(function_call.value) + "'. The file '" + file_name +
+        "' could not be read or is not a canvas file ('.hcanvas').");
+    return false;
+  }
+
+  return true;
+}
+
+bool Interpreter::function_save(const ParseResult &function_call,
+                                Arguments &arguments, Value &result) {
+
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument value.
+   */
+  std::string file_name;
+  if (!string_value_for_parameter(arguments, 0, file_name)) {
+    return false;
+  }
+
+  if (!this->saved_file_suffix.empty()) {
+    const size_t position_of_extension = file_name.find_last_of('.');
+    const size_t position_of_directory = file_name.find_last_of('/');
+    if (position_of_extension != std::string::npos &&
+        (position_of_directory == std::string::npos ||
+         position_of_extension > position_of_directory)) {
+      file_name.insert(position_of_extension, this->saved_file_suffix);
+    } else {
+      file_name += this->saved_file_suffix;
+    }
+  }
+
+  /**
+   * Tell the canvas to save its contents to the passed file.
+   */
+  Profiler::Scope scope(this->profiler, Profiler::Kind::Export,
+                        file_name.substr(file_name.find_last_of('.') + 1));
+  this->canvas.save_to_file(file_name);
+  return true;
+}
+
+bool Interpreter::function_seed(const ParseResult &function_call,
+                                Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument value.
+   */
+  double value;
+
+  if (!number_value_for_parameter(arguments, 0, value)) {
+    return false;
+  }
+
+  if (!(value >= 0.0 && value < 18446744073709551616.0 &&
+        value == std::floor(value))) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. The seed has to be a non-negative whole number.");
+    return false;
+  }
+
+  /**
+   * All following random numbers are determined by the seed.
+   */
+  this->random_engine.seed((uint64_t)value);
+  return true;
+}
+
+bool Interpreter::function_set_image_size(const ParseResult &function_call,
+                                          Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -1111,32 +1481,225 @@ bool Interpreter::function_sinh(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument values.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  double width;
+  double height;
+
+  if (!number_value_for_parameter(arguments, 0, width) ||
+      !number_value_for_parameter(arguments, 1, height)) {
     return false;
   }
 
+  /**
+   * Passing 0 for both restores the default size.
+   */
+  for (double size : {width, height}) {
+    if (!(size >= 0.0 && size <= Canvas::maximum_image_size &&
+          size == std::floor(size)) ||
+        (size == 0.0) != (width == 0.0 && height == 0.0)) {
+      this->system.print_error_message(
+          std::string("Invalid argument in function '") +
+          std::string(function_call.value) +
+          "'. The width and height have to be whole numbers between 1 and " +
+          std::to_string(Canvas::maximum_image_size) + ", or both 0.");
+      return false;
+    }
+  }
+
+  /**
+   * Set the size of the PNG images that the canvas saves.
+   */
+  this->canvas.image_width = (int)width;
+  this->canvas.image_height = (int)height;
+  return true;
+}
+
+bool Interpreter::function_set_precision(const ParseResult &function_call,
+                                         Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
   /**
    * Now we try to obtain the actual argument value.
    */
   double x;
 
-  if (!number_value_for_parameter("x", interpreted_arguments, x)) {
+  if (!number_value_for_parameter(arguments, 0, x)) {
     return false;
   }
 
   /**
-   * Compute the result.
+   * The precision is the number of decimal places.
    */
-  result = ::sinh(x);
+  if (!(x >= 0.0 && x <= OutputSink::maximum_precision && x == std::floor(x))) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. The precision has to be a whole number between 0 and " +
+        std::to_string(OutputSink::maximum_precision) + ".");
+    return false;
+  }
+
+  /**
+   * Set the precision that the canvas uses when saving.
+   */
+  this->canvas.precision = (int)x;
+  result = x;
   return true;
 }
 
-bool Interpreter::function_sqrt(const ParseResult &function_call,
-                                std::any &result) {
+bool Interpreter::function_set_resolution(const ParseResult &function_call,
+                                          Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument value.
+   */
+  double x;
+
+  if (!number_value_for_parameter(arguments, 0, x)) {
+    return false;
+  }
+
+  /**
+   * The step size has to be positive.
+   */
+  if (!(x > 0.0)) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. Cannot set non-positive resolution.");
+    return false;
+  }
+
+  /**
+   * Set the resolution of the canvas.
+   */
+  this->canvas.resolution = x;
+  result = x;
+  return true;
+}
+
+bool Interpreter::function_set_simplification(
+    const ParseResult &function_call, Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument value.
+   */
+  double x;
+
+  if (!number_value_for_parameter(arguments, 0, x)) {
+    return false;
+  }
+
+  /**
+   * A distance of 0 turns the simplification off.
+   */
+  if (!(x >= 0.0 && std::isfinite(x))) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. Cannot set negative simplification.");
+    return false;
+  }
+
+  /**
+   * Set the simplification of the canvas.
+   */
+  this->canvas.simplification = x;
+  result = x;
+  return true;
+}
+
+bool Interpreter::function_set_tolerance(const ParseResult &function_call,
+                                         Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument value.
+   */
+  double x;
+
+  if (!number_value_for_parameter(arguments, 0, x)) {
+    return false;
+  }
+
+  /**
+   * A tolerance of 0 switches back to the resolution.
+   */
+  if (!(x >= 0.0 && std::isfinite(x))) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. Cannot set negative tolerance.");
+    return false;
+  }
+
+  /**
+   * Set the tolerance of the canvas.
+   */
+  this->canvas.tolerance = x;
+  result = x;
+  return true;
+}
+
+bool Interpreter::function_set_viewport(const ParseResult &function_call,
+                                        Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
+  /**
+   * Now we try to obtain the actual argument values.
+   */
+  Pol center;
+  double radius;
+
+  if (!pol_value_for_parameter(arguments, 0, center) ||
+      !number_value_for_parameter(arguments, 1, radius)) {
+    return false;
+  }
+
+  /**
+   * A radius of 0 removes the viewport.
+   */
+  if (!(radius >= 0.0 && std::isfinite(radius))) {
+    this->system.print_error_message(
+        std::string("Invalid argument in function '") +
+        std::string(function_call.value) +
+        "'. Cannot set negative viewport radius.");
+    return false;
+  }
+
+  /**
+   * Set the part of the canvas that is saved.
+   */
+  this->canvas.viewport_center = center;
+  this->canvas.viewport_radius = radius;
+  return true;
+}
+
+bool Interpreter::function_sin(const ParseResult &function_call,
+                               Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -1144,32 +1707,47 @@ bool Interpreter::function_sqrt(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument value.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  double x;
+
+  if (!number_value_for_parameter(arguments, 0, x)) {
     return false;
   }
 
+  /**
+   * Compute the result.
+   */
+  result = ::sin(x);
+  return true;
+}
+
+bool Interpreter::function_sinh(const ParseResult &function_call,
+                                Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
   /**
    * Now we try to obtain the actual argument value.
    */
   double x;
 
-  if (!number_value_for_parameter("x", interpreted_arguments, x)) {
+  if (!number_value_for_parameter(arguments, 0, x)) {
     return false;
   }
 
   /**
    * Compute the result.
    */
-  result = ::sqrt(x);
+  result = ::sinh(x);
   return true;
 }
 
-bool Interpreter::function_theta(const ParseResult &function_call,
-                                 std::any &result) {
+bool Interpreter::function_sqrt(const ParseResult &function_call,
+                                Arguments &arguments, Value &result) {
   DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
   /**
    * Reset the result so the check for has_value fails.
@@ -1177,14 +1755,29 @@ bool Interpreter::function_theta(const ParseResult &function_call,
   result.reset();
 
   /**
-   * Interpret the arguments.
+   * Now we try to obtain the actual argument value.
    */
-  std::unordered_map<std::string, std::any> interpreted_arguments;
-  if (!interpret_arguments_from_function_call(function_call,
-                                              interpreted_arguments)) {
+  double x;
+
+  if (!number_value_for_parameter(arguments, 0, x)) {
     return false;
   }
 
+  /**
+   * Compute the result.
+   */
+  result = ::sqrt(x);
+  return true;
+}
+
+bool Interpreter::function_theta(const ParseResult &function_call,
+                                 Arguments &arguments, Value &result) {
+  DLOG(INFO) << "Interpreting " << function_call.value << "." << std::endl;
+  /**
+   * Reset the result so the check for has_value fails.
+   */
+  result.reset();
+
   /**
    * Now we try to obtain the actual argument values.
    */
@@ -1195,9 +1788,9 @@ bool Interpreter::function_theta(const ParseResult &function_call,
   /**
    * Try interpreting the parameters.
    */
-  if (!number_value_for_parameter("r1", interpreted_arguments, r_1) ||
-      !number_value_for_parameter("r2", interpreted_arguments, r_2) ||
-      !number_value_for_parameter("R", interpreted_arguments, R)) {
+  if (!number_value_for_parameter(arguments, 0, r_1) ||
+      !number_value_for_parameter(arguments, 1, r_2) ||
+      !number_value_for_parameter(arguments, 2, R)) {
     return false;
   }
 
@@ -1206,7 +1799,8 @@ bool Interpreter::function_theta(const ParseResult &function_call,
    */
   if (r_1 > R || r_2 > R) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_call.value +
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
         "'. Argument 'r1' and 'r2' must not be larger than 'R'. (r1 = " +
         std::to_string(r_1) + ", r2 = " + std::to_string(r_2) +
         "', R = " + std::to_string(R) + ")");
@@ -1215,7 +1809,8 @@ bool Interpreter::function_theta(const ParseResult &function_call,
 
   if (r_1 + r_2 < R) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_call.value +
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
         "'. The sum of the arguments 'r1' and 'r2' must be at least 'R'.");
     return false;
   }
@@ -1231,7 +1826,8 @@ bool Interpreter::function_theta(const ParseResult &function_call,
    */
   if (theta < 0.0) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + function_call.value +
+        std::string("Could not interpret '") +
+        std::string(function_call.value) +
         "'. The value could not be computed due to numerical issues.");
     return false;
   }
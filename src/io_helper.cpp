@@ -8,9 +8,58 @@
 #include <fstream>
 #include <io_helper.hpp>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <glog/logging.h>
 
 namespace hydra {
+MappedFile::MappedFile(const std::string &file_name) {
+  int file = open(file_name.c_str(), O_RDONLY);
+  if (file < 0) {
+    return;
+  }
+
+  struct stat file_status;
+  if (fstat(file, &file_status) == 0) {
+    this->size = file_status.st_size;
+
+    /**
+     * Empty files cannot be mapped, but they can be read anyways.
+     */
+    if (this->size == 0) {
+      this->is_mapped = true;
+    } else {
+      void *memory =
+          mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, file, 0);
+
+      if (memory != MAP_FAILED) {
+        /**
+         * The file is read from front to back.
+         */
+        madvise(memory, this->size, MADV_SEQUENTIAL);
+        this->data = static_cast<const char *>(memory);
+        this->is_mapped = true;
+      } else {
+        this->size = 0;
+      }
+    }
+  }
+
+  /**
+   * The mapping remains valid after the file is closed.
+   */
+  close(file);
+}
+
+MappedFile::~MappedFile() {
+  if (this->data != nullptr) {
+    munmap(const_cast<char *>(this->data), this->size);
+  }
+}
+
 void IOHelper::iterate_lines_in_file(
     const std::string &file_name,
     std::function<bool(const std::string &, const int)> line_read_callback) {
@@ -85,6 +134,26 @@ void IOHelper::read_code_from_file(const std::string &file_name,
       });
 }
 
+bool IOHelper::next_line_in_text(std::string_view text, size_t &position,
+                                 std::string_view &line) {
+  if (position >= text.size()) {
+    return false;
+  }
+
+  /**
+   * Like std::getline, a final line break does not start another
+   * line.
+   */
+  size_t end_of_line = text.find('\n', position);
+  if (end_of_line == std::string_view::npos) {
+    end_of_line = text.size();
+  }
+
+  line = text.substr(position, end_of_line - position);
+  position = end_of_line + 1;
+  return true;
+}
+
 void IOHelper::convert_new_lines(std::string &str) {
   /**
    * Replace \n with actual new line in the string. We somehow
@@ -0,0 +1,385 @@
+//
+//  kernels.cpp
+//  hydra
+//
+
+#include <kernels.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HYDRA_KERNELS_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define HYDRA_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace hydra {
+
+namespace {
+
+typedef void (*PolarToEuclidean)(const double *, const double *, size_t,
+                                 double, double, double, double *, double *);
+typedef double (*Maximum)(const double *, size_t, double);
+
+struct Implementation {
+  const char *instruction_set;
+  PolarToEuclidean polar_to_euclidean;
+  Maximum maximum;
+};
+
+void polar_to_euclidean_scalar(const double *r, const double *phi,
+                               size_t size, double scale, double offset_x,
+                               double offset_y, double *x, double *y) {
+  for (size_t index = 0; index < size; ++index) {
+    /**
+     * The same order of operations as in Euc(point, scale).
+     */
+    const double scaled_radius = scale * r[index];
+    x[index] = scaled_radius * cos(phi[index]) + offset_x;
+    y[index] = scaled_radius * sin(phi[index]) + offset_y;
+  }
+}
+
+double maximum_scalar(const double *values, size_t size, double initial) {
+  double maximum = initial;
+  for (size_t index = 0; index < size; ++index) {
+    if (values[index] > maximum) {
+      maximum = values[index];
+    }
+  }
+  return maximum;
+}
+
+/**
+ * The vectorized sine and cosine reduce the angle to [-pi/4, pi/4]
+ * and evaluate the minimax polynomials of fdlibm (__kernel_sin and
+ * __kernel_cos), which are accurate to less than one ulp.  The
+ * reduction subtracts multiples of pi/2 in three parts, each of which
+ * has at most 33 significant bits.  For angles up to the following
+ * limit, the products with the multiples are exact.  Larger angles
+ * (and NaNs) are handled by the scalar implementation.
+ */
+const double reduction_limit = 1.0e5;
+
+const double two_over_pi = 6.36619772367581382433e-01;
+const double pi_over_two_1 = 1.57079632673412561417e+00;
+const double pi_over_two_2 = 6.07710050630396597660e-11;
+const double pi_over_two_3 = 2.02226624871116645580e-21;
+
+const double S1 = -1.66666666666666324348e-01;
+const double S2 = 8.33333333332248946124e-03;
+const double S3 = -1.98412698298579493134e-04;
+const double S4 = 2.75573137070700676789e-06;
+const double S5 = -2.50507602534068634195e-08;
+const double S6 = 1.58969099521155010221e-10;
+
+const double C1 = 4.16666666666666019037e-02;
+const double C2 = -1.38888888888741095749e-03;
+const double C3 = 2.48015872894767294178e-05;
+const double C4 = -2.75573143513906633035e-07;
+const double C5 = 2.08757232129817482790e-09;
+const double C6 = -1.13596475577881948265e-11;
+
+const double sin_coefficients[] = {S2, S3, S4, S5, S6};
+const double cos_coefficients[] = {C1, C2, C3, C4, C5, C6};
+
+#ifdef HYDRA_KERNELS_AVX2
+
+/**
+ * Evaluates coefficients[0] + z * (coefficients[1] + z * (...)).
+ */
+__attribute__((target("avx2"))) inline __m256d polynomial_avx2(
+    __m256d z, const double *coefficients, int size) {
+  __m256d result = _mm256_set1_pd(coefficients[size - 1]);
+  for (int index = size - 2; index >= 0; --index) {
+    result = _mm256_add_pd(_mm256_set1_pd(coefficients[index]),
+                           _mm256_mul_pd(z, result));
+  }
+  return result;
+}
+
+__attribute__((target("avx2"))) void polar_to_euclidean_avx2(
+    const double *r, const double *phi, size_t size, double scale,
+    double offset_x, double offset_y, double *x, double *y) {
+  const __m256d sign_mask = _mm256_set1_pd(-0.0);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d half = _mm256_set1_pd(0.5);
+
+  size_t index = 0;
+  for (; index + 4 <= size; index += 4) {
+    const __m256d angle = _mm256_loadu_pd(phi + index);
+
+    /**
+     * Fall back to the scalar implementation if one of the angles is
+     * too large to be reduced exactly.
+     */
+    const __m256d is_small =
+        _mm256_cmp_pd(_mm256_andnot_pd(sign_mask, angle),
+                      _mm256_set1_pd(reduction_limit), _CMP_LE_OQ);
+    if (_mm256_movemask_pd(is_small) != 0xF) {
+      polar_to_euclidean_scalar(r + index, phi + index, 4, scale, offset_x,
+                                offset_y, x + index, y + index);
+      continue;
+    }
+
+    /**
+     * angle = quadrant * pi/2 + reduced, with |reduced| <= pi/4.
+     */
+    const __m256d quadrant = _mm256_round_pd(
+        _mm256_mul_pd(angle, _mm256_set1_pd(two_over_pi)),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+    __m256d reduced = _mm256_sub_pd(
+        angle, _mm256_mul_pd(quadrant, _mm256_set1_pd(pi_over_two_1)));
+    reduced = _mm256_sub_pd(
+        reduced, _mm256_mul_pd(quadrant, _mm256_set1_pd(pi_over_two_2)));
+    reduced = _mm256_sub_pd(
+        reduced, _mm256_mul_pd(quadrant, _mm256_set1_pd(pi_over_two_3)));
+
+    const __m256d z = _mm256_mul_pd(reduced, reduced);
+
+    /**
+     * fdlibm's __kernel_sin.
+     */
+    const __m256d sin_r = polynomial_avx2(z, sin_coefficients, 5);
+    const __m256d sin_reduced = _mm256_add_pd(
+        reduced,
+        _mm256_mul_pd(_mm256_mul_pd(z, reduced),
+                      _mm256_add_pd(_mm256_set1_pd(S1),
+                                    _mm256_mul_pd(z, sin_r))));
+
+    /**
+     * fdlibm's __kernel_cos.
+     */
+    const __m256d cos_r =
+        _mm256_mul_pd(z, polynomial_avx2(z, cos_coefficients, 6));
+    const __m256d half_z = _mm256_mul_pd(half, z);
+    const __m256d w = _mm256_sub_pd(one, half_z);
+    const __m256d cos_reduced = _mm256_add_pd(
+        w, _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(one, w), half_z),
+                         _mm256_mul_pd(z, cos_r)));
+
+    /**
+     * Depending on the quadrant, sine and cosine are swapped and
+     * negated.
+     */
+    const __m256i quadrant_bits =
+        _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(quadrant));
+    const __m256i bit_1 = _mm256_set1_epi64x(1);
+    const __m256i bit_2 = _mm256_set1_epi64x(2);
+
+    const __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+        _mm256_and_si256(quadrant_bits, bit_1), bit_1));
+    const __m256d sin_sign = _mm256_castsi256_pd(
+        _mm256_slli_epi64(_mm256_and_si256(quadrant_bits, bit_2), 62));
+    const __m256d cos_sign = _mm256_castsi256_pd(_mm256_slli_epi64(
+        _mm256_and_si256(_mm256_add_epi64(quadrant_bits, bit_1), bit_2), 62));
+
+    const __m256d sine = _mm256_xor_pd(
+        _mm256_blendv_pd(sin_reduced, cos_reduced, swap), sin_sign);
+    const __m256d cosine = _mm256_xor_pd(
+        _mm256_blendv_pd(cos_reduced, sin_reduced, swap), cos_sign);
+
+    const __m256d scaled_radius =
+        _mm256_mul_pd(_mm256_set1_pd(scale), _mm256_loadu_pd(r + index));
+
+    _mm256_storeu_pd(x + index,
+                     _mm256_add_pd(_mm256_mul_pd(scaled_radius, cosine),
+                                   _mm256_set1_pd(offset_x)));
+    _mm256_storeu_pd(y + index,
+                     _mm256_add_pd(_mm256_mul_pd(scaled_radius, sine),
+                                   _mm256_set1_pd(offset_y)));
+  }
+
+  polar_to_euclidean_scalar(r + index, phi + index, size - index, scale,
+                            offset_x, offset_y, x + index, y + index);
+}
+
+__attribute__((target("avx2"))) double maximum_avx2(const double *values,
+                                                    size_t size,
+                                                    double initial) {
+  __m256d maximum = _mm256_set1_pd(initial);
+
+  size_t index = 0;
+  for (; index + 4 <= size; index += 4) {
+    /**
+     * _mm256_max_pd returns the second operand if one of them is NaN.
+     */
+    maximum = _mm256_max_pd(_mm256_loadu_pd(values + index), maximum);
+  }
+
+  double lanes[4];
+  _mm256_storeu_pd(lanes, maximum);
+
+  return maximum_scalar(values + index, size - index,
+                        maximum_scalar(lanes, 4, initial));
+}
+
+#endif /* HYDRA_KERNELS_AVX2 */
+
+#ifdef HYDRA_KERNELS_NEON
+
+/**
+ * Evaluates coefficients[0] + z * (coefficients[1] + z * (...)).
+ */
+inline float64x2_t polynomial_neon(float64x2_t z, const double *coefficients,
+                                   int size) {
+  float64x2_t result = vdupq_n_f64(coefficients[size - 1]);
+  for (int index = size - 2; index >= 0; --index) {
+    result = vaddq_f64(vdupq_n_f64(coefficients[index]), vmulq_f64(z, result));
+  }
+  return result;
+}
+
+void polar_to_euclidean_neon(const double *r, const double *phi, size_t size,
+                             double scale, double offset_x, double offset_y,
+                             double *x, double *y) {
+  const float64x2_t one = vdupq_n_f64(1.0);
+  const uint64x2_t bit_1 = vdupq_n_u64(1);
+  const uint64x2_t bit_2 = vdupq_n_u64(2);
+
+  size_t index = 0;
+  for (; index + 2 <= size; index += 2) {
+    const float64x2_t angle = vld1q_f64(phi + index);
+
+    /**
+     * Fall back to the scalar implementation if one of the angles is
+     * too large to be reduced exactly.
+     */
+    const uint64x2_t is_small =
+        vcleq_f64(vabsq_f64(angle), vdupq_n_f64(reduction_limit));
+    if ((vgetq_lane_u64(is_small, 0) & vgetq_lane_u64(is_small, 1)) == 0) {
+      polar_to_euclidean_scalar(r + index, phi + index, 2, scale, offset_x,
+                                offset_y, x + index, y + index);
+      continue;
+    }
+
+    /**
+     * angle = quadrant * pi/2 + reduced, with |reduced| <= pi/4.
+     */
+    const float64x2_t quadrant =
+        vrndnq_f64(vmulq_f64(angle, vdupq_n_f64(two_over_pi)));
+
+    float64x2_t reduced =
+        vsubq_f64(angle, vmulq_f64(quadrant, vdupq_n_f64(pi_over_two_1)));
+    reduced =
+        vsubq_f64(reduced, vmulq_f64(quadrant, vdupq_n_f64(pi_over_two_2)));
+    reduced =
+        vsubq_f64(reduced, vmulq_f64(quadrant, vdupq_n_f64(pi_over_two_3)));
+
+    const float64x2_t z = vmulq_f64(reduced, reduced);
+
+    /**
+     * fdlibm's __kernel_sin.
+     */
+    const float64x2_t sin_r = polynomial_neon(z, sin_coefficients, 5);
+    const float64x2_t sin_reduced = vaddq_f64(
+        reduced, vmulq_f64(vmulq_f64(z, reduced),
+                           vaddq_f64(vdupq_n_f64(S1), vmulq_f64(z, sin_r))));
+
+    /**
+     * fdlibm's __kernel_cos.
+     */
+    const float64x2_t cos_r =
+        vmulq_f64(z, polynomial_neon(z, cos_coefficients, 6));
+    const float64x2_t half_z = vmulq_f64(vdupq_n_f64(0.5), z);
+    const float64x2_t w = vsubq_f64(one, half_z);
+    const float64x2_t cos_reduced =
+        vaddq_f64(w, vaddq_f64(vsubq_f64(vsubq_f64(one, w), half_z),
+                               vmulq_f64(z, cos_r)));
+
+    /**
+     * Depending on the quadrant, sine and cosine are swapped and
+     * negated.
+     */
+    const uint64x2_t quadrant_bits =
+        vreinterpretq_u64_s64(vcvtq_s64_f64(quadrant));
+
+    const uint64x2_t swap = vtstq_u64(quadrant_bits, bit_1);
+    const uint64x2_t sin_sign = vshlq_n_u64(vandq_u64(quadrant_bits, bit_2), 62);
+    const uint64x2_t cos_sign =
+        vshlq_n_u64(vandq_u64(vaddq_u64(quadrant_bits, bit_1), bit_2), 62);
+
+    const float64x2_t sine = vreinterpretq_f64_u64(veorq_u64(
+        vreinterpretq_u64_f64(vbslq_f64(swap, cos_reduced, sin_reduced)),
+        sin_sign));
+    const float64x2_t cosine = vreinterpretq_f64_u64(veorq_u64(
+        vreinterpretq_u64_f64(vbslq_f64(swap, sin_reduced, cos_reduced)),
+        cos_sign));
+
+    const float64x2_t scaled_radius =
+        vmulq_f64(vdupq_n_f64(scale), vld1q_f64(r + index));
+
+    vst1q_f64(x + index, vaddq_f64(vmulq_f64(scaled_radius, cosine),
+                                   vdupq_n_f64(offset_x)));
+    vst1q_f64(y + index, vaddq_f64(vmulq_f64(scaled_radius, sine),
+                                   vdupq_n_f64(offset_y)));
+  }
+
+  polar_to_euclidean_scalar(r + index, phi + index, size - index, scale,
+                            offset_x, offset_y, x + index, y + index);
+}
+
+double maximum_neon(const double *values, size_t size, double initial) {
+  float64x2_t maximum = vdupq_n_f64(initial);
+
+  size_t index = 0;
+  for (; index + 2 <= size; index += 2) {
+    /**
+     * vmaxnmq_f64 ignores NaNs.
+     */
+    maximum = vmaxnmq_f64(maximum, vld1q_f64(values + index));
+  }
+
+  double lanes[2];
+  vst1q_f64(lanes, maximum);
+
+  return maximum_scalar(values + index, size - index,
+                        maximum_scalar(lanes, 2, initial));
+}
+
+#endif /* HYDRA_KERNELS_NEON */
+
+Implementation choose_implementation() {
+#ifdef HYDRA_KERNELS_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    return {"avx2", polar_to_euclidean_avx2, maximum_avx2};
+  }
+#endif
+
+#ifdef HYDRA_KERNELS_NEON
+  /**
+   * NEON is always available on 64-bit ARM.
+   */
+  return {"neon", polar_to_euclidean_neon, maximum_neon};
+#endif
+
+  return {"scalar", polar_to_euclidean_scalar, maximum_scalar};
+}
+
+const Implementation &implementation() {
+  static const Implementation implementation = choose_implementation();
+  return implementation;
+}
+
+}  // namespace
+
+void Kernels::polar_to_euclidean(const double *r, const double *phi,
+                                 size_t size, double scale, double offset_x,
+                                 double offset_y, double *x, double *y) {
+  implementation().polar_to_euclidean(r, phi, size, scale, offset_x, offset_y,
+                                      x, y);
+}
+
+double Kernels::maximum(const double *values, size_t size, double initial) {
+  return implementation().maximum(values, size, initial);
+}
+
+const char *Kernels::instruction_set() {
+  return implementation().instruction_set;
+}
+
+}  // namespace hydra
@@ -6,7 +6,10 @@
 //
 
 #include <lexer.hpp>
+#include <resolver.hpp>
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 
@@ -58,7 +61,7 @@ void Lexer::components_in_string(const std::string &str,
   }
 }
 
-void Lexer::clean_string(std::string &str) {
+std::string_view Lexer::cleaned_string(std::string_view str) {
   /**
    * Find leading white spaces.
    */
@@ -68,155 +71,132 @@ void Lexer::clean_string(std::string &str) {
   /**
    * If the first non-white space character was not found, the string is empty.
    */
-  if (position_of_first_non_white_space == std::string::npos) {
-    str = "";
+  if (position_of_first_non_white_space == std::string_view::npos) {
+    return str.substr(str.size());
   }
 
-  /**
-   * Remove leading spaces.
-   */
-  str.erase(0, position_of_first_non_white_space);
-
-  /**
-   * Find trailing white spaces.
-   */
-  const std::size_t position_of_last_non_white_space =
-      str.find_last_not_of(" \t");
-
   /**
    * Remove leading and trailing white spaces.
    */
-  if (position_of_last_non_white_space != std::string::npos) {
-    str.erase(position_of_last_non_white_space + 1, std::string::npos);
-  }
+  str = str.substr(position_of_first_non_white_space,
+                   str.find_last_not_of(" \t") + 1 -
+                       position_of_first_non_white_space);
 
   /**
-   * Remove comments.
+   * Remove comments. If a comment was found, ignore everything behind
+   * the comment indicator.
    */
-  std::size_t position_of_comment = str.find("//");
-
-  /**
-   * If a comment was found, erase everything behind the comment indicator.
-   */
-  if (position_of_comment != std::string::npos) {
-    /**
-     * Erase from comment till end of line.
-     */
-    str.erase(position_of_comment, std::string::npos);
-  }
+  return str.substr(0, str.find("//"));
 }
 
-bool Lexer::is_string_empty(std::string &str) {
+bool Lexer::is_string_empty(std::string_view str) {
   return str.empty() || str.find_first_not_of(" \t", 0) == std::string::npos;
 }
 
-int Lexer::position_of_matching_bracket_for_position(const std::string &str,
-                                                     const char opening_bracket,
-                                                     int position) {
-  const std::unordered_map<char, char> bracket_pairs = {{'(', ')'}, {'[', ']'}, {'{', '}'}, {'"', '"'}};
-
-  const char closing_bracket = bracket_pairs.at(opening_bracket);
-
-  /**
-   * Before parsing the function arguments, find the closing
-   * bracket.
-   */
-  int position_of_closing_bracket = -1;
-
-  /**
-   * The first bracket is already open, since is the one we just
-   * found.
-   */
-  int number_of_open_brackets = 1;
+void Lexer::find_matching_brackets(std::string_view str,
+                                   std::vector<int> &matching_brackets) {
+  matching_brackets.assign(str.size(), -1);
 
   /**
-   * Iterate the characters in the string to find the matching closing
-   * bracket. Obviously, we don't need to check the position itself,
-   * so we start at the next position instead.
+   * The positions of the brackets that are currently open.
+   * Parentheses and square brackets are matched independently of
+   * each other.
    */
-  for (int string_index = position + 1; string_index < (int)str.length();
-       ++string_index) {
-
-    /**
-     * Dealing open brackets.
-     */
-    if (str[string_index] == opening_bracket) {
-      ++number_of_open_brackets;
+  std::vector<int> open_parentheses;
+  std::vector<int> open_square_brackets;
 
-      /**
-       * Dealing with closing brackets.
-       */
-    } else if (str[string_index] == closing_bracket) {
-      --number_of_open_brackets;
-
-      /**
-       * If we just closed the last bracket.
-       */
-      if (number_of_open_brackets == 0) {
-        position_of_closing_bracket = string_index;
+  for (int index = 0; index < (int)str.size(); ++index) {
+    switch (str[index]) {
+      case '(':
+        open_parentheses.push_back(index);
+        break;
+      case '[':
+        open_square_brackets.push_back(index);
+        break;
+      case ')':
+        if (!open_parentheses.empty()) {
+          matching_brackets[open_parentheses.back()] = index;
+          open_parentheses.pop_back();
+        }
+        break;
+      case ']':
+        if (!open_square_brackets.empty()) {
+          matching_brackets[open_square_brackets.back()] = index;
+          open_square_brackets.pop_back();
+        }
+        break;
+      default:
         break;
-      }
     }
   }
-
-  return position_of_closing_bracket;
 }
 
-int Lexer::position_of_matching_quote_for_position(const std::string &str,
-                                                     int position) {
+bool Lexer::tokenize_string(std::string_view str, TokenRange &tokens) {
 
   /**
-   * Iterate the characters in the string to find the matching closing
-   * bracket. Obviously, we don't need to check the position itself,
-   * so we start at the next position instead.
+   * The tokens refer to the original string, such that their
+   * positions can be used in error messages.
    */
-  for (int string_index = position + 1; string_index < (int)str.length();
-       ++string_index) {
-
-    /**
-     * Dealing open brackets.
-     */
-    if (str[string_index] == '"') {
-      return string_index;
-    }
-  }
+  const std::string_view cleaned = Lexer::cleaned_string(str);
+  const int begin = (int)(cleaned.data() - str.data());
 
-  return (int)std::string::npos;
-}
+  DLOG(INFO) << "Tokenizing string: '" << cleaned << "'." << std::endl;
 
-bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens) {
+  std::vector<int> matching_brackets;
+  Lexer::find_matching_brackets(str, matching_brackets);
 
-  std::string cleaned_string = str;
-  Lexer::clean_string(cleaned_string);
+  /**
+   * The tokens of the previous string are no longer needed.
+   */
+  this->token_arena.clear();
+  this->pending_tokens.clear();
 
-  DLOG(INFO) << "Tokenizing string: '" << cleaned_string << "'." << std::endl;
+  return tokenize_range(str, matching_brackets, begin,
+                        begin + (int)cleaned.size(), tokens);
+}
 
-  std::string current_token;
-  int current_index = 0;
+bool Lexer::tokenize_range(std::string_view str,
+                           const std::vector<int> &matching_brackets,
+                           int begin, int end, TokenRange &tokens) {
+  /**
+   * The tokens in this part of the string are collected at the end of
+   * the pending tokens.
+   */
+  const size_t first = this->pending_tokens.size();
+  int current_index = begin;
 
-  do {
+  while (current_index < end) {
 
     /**
      * Skip all white spaces.
      */
-    current_index = cleaned_string.find_first_not_of(" \t", current_index);
+    while (current_index < end &&
+           (str[current_index] == ' ' || str[current_index] == '\t')) {
+      ++current_index;
+    }
+
+    /**
+     * If the rest of the string consists of white spaces only, we
+     * are done.
+     */
+    if (current_index == end) {
+      break;
+    }
 
     /**
      * If we found a bracket, we tokenize the contents of the bracket
      * as children of the last token.
      */
-    if (cleaned_string[current_index] == '(' ||
-        cleaned_string[current_index] == '[') {
+    if (str[current_index] == '(' || str[current_index] == '[') {
       /**
        * Find the matching bracket.
        */
-      int matching_bracket = Lexer::position_of_matching_bracket_for_position(
-          cleaned_string, cleaned_string[current_index], current_index);
+      const int matching_bracket = matching_brackets[current_index];
 
       /**
        * If we didn't find a matching bracket, we have an error.
        */
-      if (matching_bracket == (int)std::string::npos) {
+      if (matching_bracket < 0 || matching_bracket >= end) {
 
         /**
          * Print the error message.
@@ -224,11 +204,8 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
         this->system.print_error_message(
             std::string("Missing parentheses: Could not find matching "
                         "parentheses for '") +
-            cleaned_string[current_index] +
+            str[current_index] +
             "' at character index: " + std::to_string(current_index) + ".");
-
-        Token token(System::error_string, type_of_string(System::error_string));
-        tokens.push_back(token);
         return false;
       }
 
@@ -238,8 +215,9 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
        * parenthesis, we assume that we're actually dealing with a
        * function call of a user defined function.
        */
-      if (!tokens.empty() && tokens[0].type == Unknown) {
-        tokens[0].type = Function;
+      if (this->pending_tokens.size() > first &&
+          this->pending_tokens[first].type == Unknown) {
+        this->pending_tokens[first].type = Function;
       }
 
       /**
@@ -248,34 +226,20 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
        * resulting tokens as children of the function token. Otherwise
        * we treat it as an expression or range.
        */
-      if (tokens.back().type != Function &&
-          tokens.back().type != Initialization) {
+      if (this->pending_tokens.size() == first ||
+          (this->pending_tokens.back().type != Function &&
+           this->pending_tokens.back().type != Initialization)) {
         /**
          * We don't have a function call. If we find '(' we are
-         * probably dealing with an expression.
+         * probably dealing with an expression, if we find '[' we are
+         * probably dealing with a range.  The tokens within the
+         * brackets then become children of this token.
          */
-        if (cleaned_string[current_index] == '(') {
-
-          /**
-           * We add the expression token to the end of the token
-           * vector as the tokens within the parentheses will then
-           * become children of this token.
-           */
-          Token expression_token("(", Expression);
-          tokens.push_back(expression_token);
-
-          /**
-           * We don't have a function call. If we find '[' we are
-           * probably dealing with a range.
-           */
-        } else if (cleaned_string[current_index] == '[') {
-          /**
-           * We add the range token to the end of the token vector as
-           * the tokens within the brackets will then become children
-           * of this token.
-           */
-          Token range_token("[", Range);
-          tokens.push_back(range_token);
+        if (str[current_index] == '(') {
+          this->pending_tokens.push_back(
+              Token("(", Expression, current_index));
+        } else {
+          this->pending_tokens.push_back(Token("[", Range, current_index));
         }
       }
 
@@ -283,10 +247,12 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
        * Tokenize the contents of the parentheses / brackets and add
        * them as children of the last token.
        */
-      Lexer::tokenize_string(
-          cleaned_string.substr(current_index + 1,
-                                matching_bracket - (current_index + 1)),
-          tokens.back().children);
+      TokenRange children;
+      if (!tokenize_range(str, matching_brackets, current_index + 1,
+                          matching_bracket, children)) {
+        return false;
+      }
+      this->pending_tokens.back().children = children;
 
       /**
        * We already tokenized the contents of in the bracket, so we
@@ -294,103 +260,78 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
        */
       current_index = matching_bracket + 1;
 
-    } else if (cleaned_string[current_index] == '"') {
+    } else if (str[current_index] == '"') {
       /**
        * If we're dealing with a string, we identify the whole string
        * and save it as token.
        */
-      int matching_quote = Lexer::position_of_matching_quote_for_position(
-          cleaned_string, current_index);
+      const std::size_t position_of_quote =
+          str.substr(0, end).find('"', current_index + 1);
 
-      std::string string_content = cleaned_string.substr(
-          current_index + 1, matching_quote - (current_index + 1));
+      if (position_of_quote == std::string_view::npos) {
+        this->system.print_error_message(
+            std::string("Invalid syntax. Could not find matching '\"' for the "
+                        "one at character index ") +
+            std::to_string(current_index) + ".");
+        return false;
+      }
 
-      /**
-       * Creating the token.
-       */
-      Token string_token(string_content, String);
+      const int matching_quote = (int)position_of_quote;
 
       /**
-       * Now we check whether there are escapes within the string.
-       *
-       * For this we keep track of where the last escape ended. So
-       * that we can add the content in between as normal string
-       * content.
-       *
-       * Since we start to gather the string right after the position
-       * of the last escape (+1) but we initially start want to start
-       * our string at 0, we have -1 here.
+       * Creating the token.
        */
-      int position_of_last_escape_end = -1;
-      int position_of_escape = string_content.find_first_of("\\");
+      Token string_token(
+          str.substr(current_index + 1, matching_quote - (current_index + 1)),
+          String, current_index + 1);
 
       /**
-       * As long as we find an escape, we identify the part within the
-       * escape and parse these contents.
+       * Now we check whether there are escapes '\(' within the
+       * string.  The content between the escapes is added as normal
+       * string content.
        */
-      while (position_of_escape != (int)std::string::npos) {
-
-        /**
-         * If we're already to far at the end, we can stop looking for
-         * escape sequences.
-         */
-        if (position_of_escape >= (int)string_content.length() - 1) {
-          break;
-        }
+      int position_of_last_escape_end = current_index;
+      const size_t first_part = this->pending_tokens.size();
 
-        /**
-         * If the character after the \ is not a ( we have not really
-         * found the escape sequence.
-         */
-        if (string_content[position_of_escape + 1] != '(') {
-
-          /**
-           * We did not really found an escape marker, so we continue
-           * searching for the next possible position.
-           */
-          position_of_escape =
-              string_content.find_first_of("\\", position_of_escape + 1);
+      for (int index = current_index + 1; index < matching_quote - 1;
+           ++index) {
+        if (str[index] != '\\' || str[index + 1] != '(') {
           continue;
         }
 
         /**
-         * We found the \( escape marker but the current
-         * position_of_escape is on \. So we add 1.
+         * We found the \( escape marker but the current index is on
+         * \. So we add 1.
          */
-        ++position_of_escape;
+        const int position_of_escape = index + 1;
 
         DLOG(INFO) << "Found escape at position: " << position_of_escape
                    << std::endl;
-        /**
-         * If we found an escape character, we add the part of the
-         * string before the escape as a child of the string token.
-         */
-        std::string previous_string_part = string_content.substr(
-            position_of_last_escape_end + 1,
-            position_of_escape - 1 - (position_of_last_escape_end + 1));
 
         /**
-         * Add the previous part of the token if its not empty.
+         * If we found an escape character, we add the part of the
+         * string before the escape as a child of the string token, if
+         * it is not empty.
          */
-        if (!previous_string_part.empty()) {
-          Token previous_part_token(previous_string_part, String);
-          string_token.children.push_back(previous_part_token);
+        if (index > position_of_last_escape_end + 1) {
+          this->pending_tokens.push_back(
+              Token(str.substr(position_of_last_escape_end + 1,
+                               index - (position_of_last_escape_end + 1)),
+                    String, position_of_last_escape_end + 1));
         }
 
         /**
-         * Find the parenthesis closing this escape marker.
+         * Find the parenthesis closing this escape marker, which has to
+         * be part of the string.
          */
-        int position_of_matching_bracket =
-            position_of_matching_bracket_for_position(string_content, '(',
-                                                      position_of_escape);
+        const int position_of_matching_bracket =
+            matching_brackets[position_of_escape];
 
         DLOG(INFO) << "Position of escape closing bracket: "
                    << position_of_matching_bracket << std::endl;
 
-        /**
-         * Check whether the matching bracket was found.
-         */
-        if (position_of_matching_bracket == (int)std::string::npos) {
+        if (position_of_matching_bracket < 0 ||
+            position_of_matching_bracket >= matching_quote) {
           this->system.print_error_message(
               std::string("Invalid syntax. Could not find matching bracket for "
                           "'\\(' at character index ") +
@@ -398,78 +339,54 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
           return false;
         }
 
-        /**
-         * Get the string representing the content within the escape.
-         */
-        std::string escaped_content = string_content.substr(
-            position_of_escape + 1,
-            position_of_matching_bracket - (position_of_escape + 1));
-
-        DLOG(INFO) << "Found escaped content: '" << escaped_content << "'"
-                   << std::endl;
-
         /**
          * We now create a new string escape token that becomes a
          * child from the string token.
          *
          * Then we tokenize the string within this escape part into
-         * the children of that escaped_content token.
+         * the children of that token.
          */
-        Token escape_token(escaped_content, StringEscape);
-        tokenize_string(escaped_content, escape_token.children);
+        Token escape_token(
+            str.substr(position_of_escape + 1,
+                       position_of_matching_bracket - (position_of_escape + 1)),
+            StringEscape, position_of_escape + 1);
 
-        /**
-         * Add the escape_token as child of the string_token.
-         */
-        string_token.children.push_back(escape_token);
+        DLOG(INFO) << "Found escaped content: '" << escape_token.value << "'"
+                   << std::endl;
 
-        /**
-         * If we're at the end of the string we can just stop looking
-         * for escape markers now.
-         */
-        if (position_of_matching_bracket >= (int)string_content.length() - 1) {
-          break;
+        if (!tokenize_range(str, matching_brackets, position_of_escape + 1,
+                            position_of_matching_bracket,
+                            escape_token.children)) {
+          return false;
         }
 
-        /**
-         * Keep track of where the last escape ended.
-         */
-        position_of_last_escape_end = position_of_matching_bracket;
+        this->pending_tokens.push_back(escape_token);
 
         /**
-         * Now we update the position_of_escape with the position of
-         * the next escape marker.
+         * Keep track of where the last escape ended and continue
+         * looking for escape markers after it.
          */
-        position_of_escape = string_content.find_first_of(
-            "\\", position_of_matching_bracket + 1);
+        position_of_last_escape_end = position_of_matching_bracket;
+        index = position_of_matching_bracket;
+      }
 
-        /**
-         * If we don't have another escape part, we simply add the
-         * remainder of the string as last string part.
-         */
-        if (position_of_escape == (int)std::string::npos) {
-          /**
-           * If we could not find a new escape marker, we simply add the
-           * remainder of the string as child of the current
-           * string_token.
-           */
-          std::string last_string_part =
-            string_content.substr(position_of_matching_bracket + 1);
-
-          /**
-           * Add the last string part if its not empty.
-           */
-          if (!last_string_part.empty()) {
-            Token last_part_token(last_string_part, String);
-            string_token.children.push_back(last_part_token);
-          }
-        }
+      /**
+       * If the string contained escapes, we add the remainder of the
+       * string as last string part, if it is not empty.
+       */
+      if (this->pending_tokens.size() > first_part &&
+          matching_quote > position_of_last_escape_end + 1) {
+        this->pending_tokens.push_back(
+            Token(str.substr(position_of_last_escape_end + 1,
+                             matching_quote - (position_of_last_escape_end + 1)),
+                  String, position_of_last_escape_end + 1));
       }
 
       /**
        * Add the string token.
        */
-      tokens.push_back(string_token);
+      string_token.children = move_pending_tokens(first_part);
+      this->pending_tokens.push_back(string_token);
 
       /**
        * We already tokenized the whole string, so we now continue
@@ -479,49 +396,40 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
     }
 
     /**
-     * If the rest of the string consists of white spaces only, stop
-     * tokenizing.
+     * If we already reached the end of the string, stop tokenizing.
      */
-    if (current_index == (int)std::string::npos) {
+    if (current_index >= end) {
       break;
     }
 
     /**
-     * Get the position of the next separator
+     * Get the position of the next separator. If we can't find the
+     * next separator, we are at the end of the string.  So we take
+     * the remainder of the strings as token.  If the current_index
+     * and the position_of_next_separator are the same, we found a
+     * token only consisting of a separator.
      */
-    int position_of_next_separator =
-        cleaned_string.find_first_of(" (+-*/),:=[]", current_index);
-
-    /**
-     * If we can't find the next separator, we are at the end of the
-     * string.  So we take the remainder of the strings as token.
-     * Else we use the string up to the found separator as token.
-     */
-    if (position_of_next_separator == (int)std::string::npos) {
-      current_token = cleaned_string.substr(current_index, std::string::npos);
+    int position_of_next_separator = current_index;
+    while (position_of_next_separator < end &&
+           std::string_view(" (+-*/),:=[]").find(
+               str[position_of_next_separator]) == std::string_view::npos) {
+      ++position_of_next_separator;
+    }
 
-      /**
-       * If the current_index and the position_of_next_separator are
-       * the same, we found a token only consisting of a separator.
-       */
-    } else if (position_of_next_separator == current_index) {
-      /**
-       * Take the 1 character only.
-       */
-      current_token = cleaned_string.substr(current_index, 1);
+    if (position_of_next_separator == current_index) {
       /**
        * Make sure we continue with next character afterwards.
        */
-      position_of_next_separator += 1;
-    } else {
-      current_token = cleaned_string.substr(
-          current_index, position_of_next_separator - current_index);
+      ++position_of_next_separator;
     }
 
+    const std::string_view current_token =
+        str.substr(current_index, position_of_next_separator - current_index);
+
     /**
      * Create the token.
      */
-    Token token(current_token, type_of_string(current_token));
+    Token token(current_token, type_of_string(current_token), current_index);
 
     /**
      * If the type of the token is unknown, but the previous token was
@@ -529,7 +437,8 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
      * function name (that is being defined and therefore currently
      * unknown).
      */
-    if (!tokens.empty() && tokens.back().type == FunctionDefinition &&
+    if (this->pending_tokens.size() > first &&
+        this->pending_tokens.back().type == FunctionDefinition &&
         token.type == Unknown) {
       token.type = Function;
     }
@@ -544,15 +453,16 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
      * don't support concatenate property access.
      */
     if (token.type != Number) {
-      int position_of_dot = current_token.find_first_of(".");
+      const std::size_t position_of_dot = current_token.find('.');
 
-      if (position_of_dot != (int)std::string::npos) {
+      if (position_of_dot != std::string_view::npos) {
 
         if (position_of_dot == 0 ||
-            position_of_dot == (int)current_token.size() - 1) {
+            position_of_dot == current_token.size() - 1) {
           this->system.print_error_message(
-              std::string("Could not parse '") + current_token +
-              "'. '.' are only allowed to define numbers or when accessing "
+              std::string("Could not parse '") + std::string(current_token) +
+              "' at character index " + std::to_string(current_index) +
+              ". '.' are only allowed to define numbers or when accessing "
               "properties.");
           return false;
         }
@@ -560,28 +470,30 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
         /**
          * Determine the variable name and the property name.
          */
-        std::string variable_name = current_token.substr(0, position_of_dot);
-        std::string property_name =
-            current_token.substr(position_of_dot + 1, std::string::npos);
+        const std::string_view variable_name =
+            current_token.substr(0, position_of_dot);
+        const std::string_view property_name =
+            current_token.substr(position_of_dot + 1);
 
-        DLOG(INFO) << "Property access. Variable: '"
-                   << variable_name + "', Property: '" << property_name << "'."
-                   << std::endl;
+        DLOG(INFO) << "Property access. Variable: '" << variable_name
+                   << "', Property: '" << property_name << "'." << std::endl;
 
         /**
          * Check whether the property name contains a '.', which would
          * be an error.
          */
-        if (property_name.find_first_of(".") != std::string::npos) {
+        if (property_name.find('.') != std::string_view::npos) {
           this->system.print_error_message(
-              std::string("Could not parse '") + current_token +
-              "'. Concatenated property access is not yet supported.");
+              std::string("Could not parse '") + std::string(current_token) +
+              "' at character index " + std::to_string(current_index) +
+              ". Concatenated property access is not yet supported.");
           return false;
         }
 
-        token = Token(variable_name, Variable);
-        Token property_access_token(property_name, Property);
-        token.children.push_back(property_access_token);
+        const Token property_token(property_name, Property,
+                                   current_index + position_of_dot + 1);
+        token = Token(variable_name, Variable, current_index);
+        token.children = this->token_arena.copy(&property_token, 1);
       }
     }
 
@@ -595,16 +507,34 @@ bool Lexer::tokenize_string(const std::string &str, std::vector<Token> &tokens)
      * children.
      */
     if (!Lexer::is_string_empty(token.value) || !token.children.empty()) {
-      tokens.push_back(token);
+      this->pending_tokens.push_back(token);
     }
+  }
 
-  } while (current_index != (int)std::string::npos &&
-           current_index <= (int)cleaned_string.length());
-
+  tokens = move_pending_tokens(first);
   return true;
 }
 
-Type Lexer::type_of_string(const std::string &str) {
+TokenRange Lexer::move_pending_tokens(size_t first) {
+  const TokenRange tokens = this->token_arena.copy(
+      this->pending_tokens.data() + first, this->pending_tokens.size() - first);
+  this->pending_tokens.resize(first);
+  return tokens;
+}
+
+Span<ParseResult> Lexer::move_pending_results(size_t first) {
+  const Span<ParseResult> results = this->arena.copy(
+      this->pending_results.data() +
+      first, this->pending_results.size() - first);
+  this->pending_results.resize(first);
+  return results;
+}
+
+void Lexer::Children::move_to(ParseResult &result) {
+  result.children = this->lexer.move_pending_results(this->first);
+}
+
+Type Lexer::type_of_string(std::string_view str) {
 
   DLOG(INFO) << "Identifying token: '" << str << "'." << std::endl;
 
@@ -615,11 +545,16 @@ Type Lexer::type_of_string(const std::string &str) {
     return Error;
   }
 
+  /**
+   * Tokens are short, so the copy usually does not allocate.
+   */
+  const std::string token(str);
+
   /**
    * Check whether the token is keyword that we know of.
    */
   std::unordered_map<std::string, Type>::const_iterator token_type_result =
-      this->system.types_for_keywords.find(str);
+      this->system.types_for_keywords.find(token);
 
   if (token_type_result != this->system.types_for_keywords.end()) {
 
@@ -640,22 +575,25 @@ Type Lexer::type_of_string(const std::string &str) {
     } else {
 
       /**
-       * Try casting as number.
+       * Try casting as number.  Like std::stod, we accept the token
+       * if it starts with a number.  Unlike std::stod, strtod does
+       * not throw for other tokens, which is slow and serializes the
+       * threads that parse and execute code (see --stream).
        */
-      try {
-        std::stod(str);
+      char *end_of_number = nullptr;
+      std::strtod(token.c_str(), &end_of_number);
+      if (end_of_number != token.c_str()) {
         DLOG(INFO) << "Token identified as '" << System::name_for_type.at(Number)
                    << "'." << std::endl;
         return Number;
-      } catch (std::invalid_argument &ia) {}
+      }
     }
   }
 
   return Unknown;
 }
 
-Type Lexer::type_of_tokenized_string(
-    const std::vector<Token> &tokenized_string) {
+Type Lexer::type_of_tokenized_string(TokenRange tokenized_string) {
   /**
    * Check again if the string is empty. If it is, it was probably a
    * comment.
@@ -704,6 +642,50 @@ Type Lexer::type_of_tokenized_string(
 
 bool Lexer::parse_code(const std::vector<std::string> &code,
                        std::vector<ParseResult> &parsed_code) {
+  /**
+   * The lines are parsed one after the other and the top level
+   * statements are collected in parsed_code.
+   */
+  int next_line = 0;
+  bool success = parse_lines(
+      [&code, &next_line]() -> const std::string * {
+        if (next_line == (int)code.size()) {
+          return nullptr;
+        }
+
+        return &code[next_line++];
+      },
+      [&parsed_code](const ParseResult &statement) -> bool {
+        parsed_code.push_back(statement);
+        return true;
+      });
+
+  if (!success) {
+    return false;
+  }
+
+  /**
+   * Now that the whole code is known, we resolve the variables to
+   * their slots.
+   */
+  Resolver resolver(this->system);
+  if (!resolver.resolve_code(parsed_code)) {
+    return false;
+  }
+
+  /**
+   * If we reach this point, everything went well. Reset the state
+   * values.
+   */
+  this->system.state.line_number = -1;
+  this->system.state.current_line = "";
+  return true;
+}
+
+bool Lexer::parse_lines(
+    const std::function<const std::string *()> &next_line,
+    const std::function<bool(const ParseResult &)> &statement_parsed,
+    int first_line) {
   /**
    * We iterate all lines of code and try to parse them.
    *
@@ -713,12 +695,13 @@ bool Lexer::parse_code(const std::vector<std::string> &code,
    * can have nested loops, we need to keep track of where the current
    * code lines belong.
    *
-   * The code_scopes stores vectors of parse results. When a line is
-   * being parsed, the result is added to the last vector in the
-   * code_scopes vector. If we're in a loop, this last vector is the
-   * child-vector of the corresponding loop-parse-result.
+   * The parsed lines are collected in the pending results and the
+   * code_scopes stores for each open scope the position of its
+   * first line there. If we're in a loop, the loop-parse-result is
+   * the pending result right before the first line of the scope.
    */
-  std::vector<std::vector<ParseResult> *> code_scopes = {&parsed_code};
+  Children statements(*this);
+  std::vector<size_t> code_scopes = {this->pending_results.size()};
 
   /**
    * In order to being able to print meaningful error messages, we
@@ -730,14 +713,16 @@ bool Lexer::parse_code(const std::vector<std::string> &code,
   /**
    * Iterate all lines.
    */
-  for (int line_number = 0; line_number < (int)code.size(); ++line_number) {
+  int line_number = first_line;
+  for (const std::string *line = next_line(); line != nullptr;
+       line = next_line(), ++line_number) {
 
     /**
      * Let the system know about which line we're currently dealing
      * with.
      */
     this->system.state.line_number = line_number;
-    this->system.state.current_line = code[line_number];
+    this->system.state.current_line = *line;
 
     /**
      * Parse the line.
@@ -753,7 +738,7 @@ bool Lexer::parse_code(const std::vector<std::string> &code,
     /**
      * Parsing the current line.
      */
-    if (!parse_string(code[line_number], line_parse_result)) {
+    if (!parse_string(*line, line_parse_result)) {
       return false;
     }
 
@@ -763,13 +748,22 @@ bool Lexer::parse_code(const std::vector<std::string> &code,
 
     /**
      * If the line is a loop-definition, we add the loop definition to
-     * the back of the current code_scope AND open a new code scope by
-     * adding the children of the loop-definition to the code_scopes.
+     * the current code_scope AND open a new code scope for the
+     * children of the loop-definition.
      */
     if (line_parse_result.type == Loop ||
         line_parse_result.type == FunctionDefinition) {
-      code_scopes.back()->push_back(line_parse_result);
-      code_scopes.push_back(&(code_scopes.back()->back().children));
+      statements.push_back(line_parse_result);
+      code_scopes.push_back(this->pending_results.size());
+
+      /**
+       * The lines in the scope follow the children that the
+       * loop-parse-result already has, e.g., the loop variable and
+       * the range.
+       */
+      for (const ParseResult &child : line_parse_result.children) {
+        statements.push_back(child);
+      }
 
       /**
        * Keep track of the line number associated with this loop.
@@ -782,6 +776,16 @@ bool Lexer::parse_code(const std::vector<std::string> &code,
        * function by removing the children vector of the
        * loop-parse-result from the code_scopes vector.
        */
+      if (code_scopes.size() == 1) {
+        this->system.print_error_message(
+            std::string("Could not parse code. Found '}' without an open "
+                        "loop or function."));
+        return false;
+      }
+
+      const Span<ParseResult> children =
+          move_pending_results(code_scopes.back());
+      this->pending_results.back().children = children;
       code_scopes.pop_back();
       line_number_for_scope.pop_back();
       /**
@@ -793,7 +797,21 @@ bool Lexer::parse_code(const std::vector<std::string> &code,
        * The line is not a loop or parenthesis so we simply add it in
        * the current code_scope.
        */
-      code_scopes.back()->push_back(line_parse_result);
+      statements.push_back(line_parse_result);
+    }
+
+    /**
+     * If no scope is open anymore, the last statement is complete and
+     * can be passed on.
+     */
+    if (code_scopes.size() == 1 &&
+        this->pending_results.size() > code_scopes.back()) {
+      const ParseResult statement = this->pending_results.back();
+      this->pending_results.pop_back();
+
+      if (!statement_parsed(statement)) {
+        return false;
+      }
     }
   }
 
@@ -809,12 +827,6 @@ bool Lexer::parse_code(const std::vector<std::string> &code,
     return false;
   }
 
-  /**
-   * If we reach this point, everything went well. Reset the state
-   * values.
-   */
-  this->system.state.line_number = -1;
-  this->system.state.current_line = "";
   return true;
 }
 
@@ -825,7 +837,7 @@ bool Lexer::parse_string(const std::string &str, ParseResult &result) {
   /**
    * Tokenize the string.
    */
-  std::vector<Token> tokens;
+  TokenRange tokens;
   if (tokenize_string(str, tokens)) {
 #ifdef DEBUG
     Lexer::print_tokenized_string(tokens);
@@ -843,8 +855,7 @@ bool Lexer::parse_string(const std::string &str, ParseResult &result) {
   }
 }
 
-bool Lexer::parse_tokens(const std::vector<Token> &tokens,
-                         ParseResult &result) {
+bool Lexer::parse_tokens(TokenRange tokens, ParseResult &result) {
   /**
    * Determine the type of the tokenized string.
    */
@@ -860,7 +871,7 @@ bool Lexer::parse_tokens(const std::vector<Token> &tokens,
    * that type.
    */
   std::unordered_map<Type,
-                     std::function<bool(Lexer *, const std::vector<Token> &,
+                     std::function<bool(Lexer *, TokenRange,
                                         ParseResult &)>>::const_iterator
       position_of_parser = this->known_parsers.find(type);
 
@@ -881,7 +892,7 @@ bool Lexer::parse_tokens(const std::vector<Token> &tokens,
                  << "'. Maybe it is a variable name..." << std::endl;
 
       result.type = Unknown;
-      result.value = tokens[0].value;
+      result.value = this->arena.copy(tokens[0].value);
 
       /**
        * If the single token has exactly one child that is a property
@@ -895,10 +906,10 @@ bool Lexer::parse_tokens(const std::vector<Token> &tokens,
         /**
          * Create a token for the property name.
          */
-        ParseResult property_access_parse_result(Property,
-                                                 tokens[0].children[0].value);
+        ParseResult property_access_parse_result(
+            Property, this->arena.copy(tokens[0].children[0].value));
 
-        result.children.push_back(property_access_parse_result);
+        result.children = this->arena.copy(&property_access_parse_result, 1);
       }
 
       return true;
@@ -911,8 +922,7 @@ bool Lexer::parse_tokens(const std::vector<Token> &tokens,
   }
 }
 
-bool Lexer::parse_assignment(const std::vector<Token> &tokens,
-                             ParseResult &result) {
+bool Lexer::parse_assignment(TokenRange tokens, ParseResult &result) {
   /**
    * The type is assignment
    */
@@ -924,8 +934,6 @@ bool Lexer::parse_assignment(const std::vector<Token> &tokens,
    * the expression.
    */
   int index_of_equality_sign = -1;
-  std::vector<Token> lhs; // Tokens of the left hand side.
-  std::vector<Token> rhs; // Tokens of the right hand side.
 
   for (int index = 0; index < (int)tokens.size(); ++index) {
 
@@ -946,19 +954,19 @@ bool Lexer::parse_assignment(const std::vector<Token> &tokens,
                         "per statement."));
         return false;
       }
-    } else {
-      /**
-       * As long as we have not found the equality sign, we are on the
-       * left hand side, otherwise we are on the right hand side.
-       */
-      if (index_of_equality_sign < 0) {
-        lhs.push_back(tokens[index]);
-      } else {
-        rhs.push_back(tokens[index]);
-      }
     }
   }
 
+  /**
+   * The tokens before the equality sign form the left hand side, the
+   * tokens after it the right hand side.
+   */
+  TokenRange lhs = tokens.subrange(0, std::max(index_of_equality_sign, 0));
+  TokenRange rhs =
+      tokens.subrange(index_of_equality_sign + 1, tokens.size());
+
+  Children children(*this);
+
   /**
    * Parse left hand side.
    */
@@ -980,15 +988,16 @@ bool Lexer::parse_assignment(const std::vector<Token> &tokens,
       /**
        * Add the parsed result.
        */
-      ParseResult assignment_variable(Variable, lhs[0].value);
+      ParseResult assignment_variable(Variable,
+                                      this->arena.copy(lhs[0].value));
       assignment_variable.line_number = result.line_number;
-      result.children.push_back(assignment_variable);
+      children.push_back(assignment_variable);
     } else {
       result.type = Error;
       this->system.print_error_message(
           std::string(
               "Invalid assignment. Expected variable name but found '") +
-          lhs[0].value +
+          std::string(lhs[0].value) +
           " instead. Use 'a = 10.0' or 'var a = 10.0' to assign a variable.");
       return false;
     }
@@ -1016,7 +1025,7 @@ bool Lexer::parse_assignment(const std::vector<Token> &tokens,
       this->system.print_error_message(
           std::string(
               "Invalid assignment. Expected variable name but found '") +
-          lhs[0].value +
+          std::string(lhs[0].value) +
           " instead. Use 'a = 10.0' or 'var a = 10.0' to assign a variable.");
       return false;
     }
@@ -1024,13 +1033,14 @@ bool Lexer::parse_assignment(const std::vector<Token> &tokens,
     /**
      * Everything went as expected.
      */
-    ParseResult assignment_keyword(Assignment, lhs[0].value);
+    ParseResult assignment_keyword(Assignment,
+                                   this->arena.copy(lhs[0].value));
     assignment_keyword.line_number = result.line_number;
-    ParseResult assignment_variable(Variable, lhs[1].value);
+    ParseResult assignment_variable(Variable, this->arena.copy(lhs[1].value));
     assignment_variable.line_number = result.line_number;
 
-    result.children.push_back(assignment_keyword);
-    result.children.push_back(assignment_variable);
+    children.push_back(assignment_keyword);
+    children.push_back(assignment_variable);
 
   } else {
     result.type = Error;
@@ -1047,7 +1057,8 @@ bool Lexer::parse_assignment(const std::vector<Token> &tokens,
   ParseResult rhs_result;
   rhs_result.line_number = result.line_number;
   bool success = parse_tokens(rhs, rhs_result);
-  result.children.push_back(rhs_result);
+  children.push_back(rhs_result);
+  children.move_to(result);
 
   if (!success) {
     result.type = Error;
@@ -1057,8 +1068,7 @@ bool Lexer::parse_assignment(const std::vector<Token> &tokens,
   return success;
 }
 
-bool Lexer::parse_expression(const std::vector<Token> &tokens,
-                             ParseResult &result) {
+bool Lexer::parse_expression(TokenRange tokens, ParseResult &result) {
   /**
    * If the expression is empty, return false.
    */
@@ -1076,7 +1086,7 @@ bool Lexer::parse_expression(const std::vector<Token> &tokens,
   if (tokens.size() == 1) {
     if (tokens[0].type == Number) {
       result.type = Number;
-      result.value = tokens[0].value;
+      result.value = this->arena.copy(tokens[0].value);
       return true;
     } else if (tokens[0].type == Expression && !tokens[0].children.empty()) {
       /**
@@ -1103,6 +1113,7 @@ bool Lexer::parse_expression(const std::vector<Token> &tokens,
      * positions.
      */
     result.type = Expression;
+    Children children(*this);
 
     for (int index = 0; index < (int)tokens.size(); ++index) {
 
@@ -1123,9 +1134,10 @@ bool Lexer::parse_expression(const std::vector<Token> &tokens,
          * Evaluate the term.
          */
         ParseResult term_result;
-        bool success = parse_tokens({tokens[index]}, term_result);
+        bool success =
+            parse_tokens(tokens.subrange(index, index + 1), term_result);
 
-        result.children.push_back(term_result);
+        children.push_back(term_result);
 
         if (!success) {
           result.type = Error;
@@ -1139,17 +1151,21 @@ bool Lexer::parse_expression(const std::vector<Token> &tokens,
           result.type = Error;
           this->system.print_error_message(
               std::string("Invalid syntax: Expected operator but found '") +
-              tokens[index].value + "' instead.");
+              std::string(tokens[index].value) + "' at character index " +
+              std::to_string(tokens[index].position) + " instead.");
           return false;
         }
         /**
          * We found an operator.
          */
-        ParseResult operator_result(Operator, tokens[index].value);
-        result.children.push_back(operator_result);
+        ParseResult operator_result(Operator,
+                                    this->arena.copy(tokens[index].value));
+        children.push_back(operator_result);
       }
     }
 
+    children.move_to(result);
+
     /**
      * If we reach this point without returning, everything went well.
      */
@@ -1163,8 +1179,7 @@ bool Lexer::parse_expression(const std::vector<Token> &tokens,
 }
 
 
-bool Lexer::parse_function(const std::vector<Token> &tokens,
-                           ParseResult &result) {
+bool Lexer::parse_function(TokenRange tokens, ParseResult &result) {
 
   /**
    * A function call consists of the function name only, with the arguments as children.
@@ -1183,20 +1198,20 @@ bool Lexer::parse_function(const std::vector<Token> &tokens,
     result.type = Error;
     this->system.print_error_message(
         std::string("Invalid syntax. Expected function name but found '") +
-        tokens[0].value + "', which is of type '" +
+        std::string(tokens[0].value) + "', which is of type '" +
         System::name_for_type.at(tokens[0].type));
     return false;
   }
 
   result.type = Function;
-  result.value = tokens[0].value;
+  result.value = this->arena.copy(tokens[0].value);
 
   /**
    * Get the arguments for the function.
    */
   std::unordered_map<std::string, Func>::const_iterator
       position_of_function_arguments =
-          this->system.known_functions.find(tokens[0].value);
+          this->system.known_functions.find(std::string(tokens[0].value));
 
   /**
    * Check whether we know this function.
@@ -1210,7 +1225,7 @@ bool Lexer::parse_function(const std::vector<Token> &tokens,
     bool success = parse_argument_list(
         tokens[0].children, position_of_function_arguments->second.arguments,
         argument_parse_result);
-    result.children.push_back(argument_parse_result);
+    result.children = this->arena.copy(&argument_parse_result, 1);
 
     /**
      * If we did not succeed parsing the argument list, print
@@ -1220,12 +1235,13 @@ bool Lexer::parse_function(const std::vector<Token> &tokens,
       result.type = Error;
       this->system.print_error_message(
           std::string("Invalid arguments in function call '") +
-          tokens[0].value + "'.");
-      std::cerr << "> Usage of '" << tokens[0].value << "': " << tokens[0].value
-                << "(";
+          std::string(tokens[0].value) + "'.");
+      *this->system.error_output << "> Usage of '" << tokens[0].value
+                                 << "': " << tokens[0].value << "(";
       System::print_argument_list(
-          position_of_function_arguments->second.arguments);
-      std::cerr << ")" << std::endl;
+          position_of_function_arguments->second.arguments,
+          *this->system.error_output);
+      *this->system.error_output << ")" << std::endl;
     }
 
     return success;
@@ -1234,8 +1250,9 @@ bool Lexer::parse_function(const std::vector<Token> &tokens,
      * We don't know the function.
      */
     result.type = Error;
-    this->system.print_error_message(std::string("Unknown function: '") +
-                                     tokens[0].value + "'.");
+    this->system.print_error_message(
+        std::string("Unknown function: '") + std::string(tokens[0].value) +
+        "' at character index " + std::to_string(tokens[0].position) + ".");
     return false;
   }
 
@@ -1245,8 +1262,7 @@ bool Lexer::parse_function(const std::vector<Token> &tokens,
   return false;
 }
 
-bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
-                                      ParseResult &result) {
+bool Lexer::parse_function_definition(TokenRange tokens, ParseResult &result) {
   /**
    * A function definition consists of the func token indicating that
    * this is a function definition, followed by the name of the
@@ -1268,7 +1284,7 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
     result.type = Error;
     this->system.print_error_message(
         std::string("Invalid syntax. Expected keyword 'func' but found '") +
-        tokens[0].value + "'instead , which is of type '" +
+        std::string(tokens[0].value) + "'instead , which is of type '" +
         System::name_for_type.at(tokens[0].type));
     return false;
   }
@@ -1279,7 +1295,7 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
    */
 
   result.type = FunctionDefinition;
-  result.value = tokens[1].value;
+  result.value = this->arena.copy(tokens[1].value);
 
   /**
    * Parse the functions parameter list
@@ -1303,9 +1319,10 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
   /**
    * The parameters are simply comma separated words.
    */
+  Children parameters(*this);
   for (int i = 0; i < (int)tokens[1].children.size(); ++i) {
 
-    Token token = tokens[1].children[i];
+    const Token &token = tokens[1].children[i];
 
     if (i % 2 == 0) {
       /**
@@ -1315,7 +1332,7 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
       if (token.type != Unknown) {
         this->system.print_error_message(
             std::string("Invalid syntax. Expected parameter name but found '") +
-            token.value + "' instead, which is of type '" +
+            std::string(token.value) + "' instead, which is of type '" +
             System::name_for_type.at(token.type));
         return false;
       }
@@ -1327,8 +1344,8 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
       ParseResult parameter_parse_result;
       parameter_parse_result.line_number = result.line_number;
       parameter_parse_result.type = Parameter;
-      parameter_parse_result.value = token.value;
-      parameter_list_parse_result.children.push_back(parameter_parse_result);
+      parameter_parse_result.value = this->arena.copy(token.value);
+      parameters.push_back(parameter_parse_result);
     } else {
 
       /**
@@ -1337,13 +1354,14 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
       if (token.value != ",") {
         this->system.print_error_message(
             std::string("Invalid syntax. Expected ',' but found '") +
-            token.value + "' instead.");
+            std::string(token.value) + "' instead.");
         return false;
       }
     }
   }
 
-  result.children.push_back(parameter_list_parse_result);
+  parameters.move_to(parameter_list_parse_result);
+  result.children = this->arena.copy(&parameter_list_parse_result, 1);
 
   /**
    * In order to correctly recognize the function later, we now have
@@ -1357,7 +1375,7 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
    *
    * The value of the function definition is the name of the function.
    */
-  Func new_function(result.value);
+  Func new_function{std::string(result.value)};
 
   /**
    * The function definition should have at least on child which contains
@@ -1366,7 +1384,7 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
   if (result.children.empty()) {
     this->system.print_error_message(
         std::string("Could not parse function definition '") +
-        result.value +
+        std::string(result.value) +
         ": The function definition did not contain the parameter list.");
     return false;
   }
@@ -1376,7 +1394,7 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
    */
   if (result.children[0].type != ParameterList) {
     this->system.print_error_message(
-        std::string("Could not interpret '") + result.value +
+        std::string("Could not interpret '") + std::string(result.value) +
         "'. Expected parameter list but found '" +
         System::name_for_type.at(result.children[0].type) + "' instead.");
     return false;
@@ -1387,7 +1405,7 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
    */
   for (const ParseResult &parameter :
          result.children[0].children) {
-    new_function.arguments.push_back(parameter.value);
+    new_function.arguments.emplace_back(parameter.value);
   }
 
   /**
@@ -1412,8 +1430,7 @@ bool Lexer::parse_function_definition(const std::vector<Token> &tokens,
   return true;
 }
 
-bool Lexer::parse_initialization(const std::vector<Token> &tokens,
-                                 ParseResult &result) {
+bool Lexer::parse_initialization(TokenRange tokens, ParseResult &result) {
 
   /**
    * Check whether the first token signals an initialization.
@@ -1421,7 +1438,8 @@ bool Lexer::parse_initialization(const std::vector<Token> &tokens,
   if (tokens[0].type != Initialization) {
     result.type = Error;
     this->system.print_error_message(
-        std::string("Invalid initialization: '") + tokens[0].value +
+        std::string("Invalid initialization: '") +
+        std::string(tokens[0].value) +
         "' cannot be used to initialize a variable.");
     return false;
   }
@@ -1430,13 +1448,13 @@ bool Lexer::parse_initialization(const std::vector<Token> &tokens,
    * The type is initialization.
    */
   result.type = Initialization;
-  result.value = tokens[0].value;
+  result.value = this->arena.copy(tokens[0].value);
 
   /**
    * Get the list of expected arguments.
    */
   std::unordered_map<std::string, Func>::const_iterator position_of_arguments =
-      this->system.known_functions.find(tokens[0].value);
+      this->system.known_functions.find(std::string(tokens[0].value));
 
   if (position_of_arguments != this->system.known_functions.end()) {
     /**
@@ -1453,11 +1471,12 @@ bool Lexer::parse_initialization(const std::vector<Token> &tokens,
 
       this->system.print_error_message(
           std::string("Missing arguments during initialization of '") +
-          tokens[0].value + "'.");
-      std::cerr << "> Usage of '" << tokens[0].value << "': " << tokens[0].value
-                << "(";
-      System::print_argument_list(position_of_arguments->second.arguments);
-      std::cerr << ")" << std::endl;
+          std::string(tokens[0].value) + "'.");
+      *this->system.error_output << "> Usage of '" << tokens[0].value
+                                 << "': " << tokens[0].value << "(";
+      System::print_argument_list(position_of_arguments->second.arguments,
+                                  *this->system.error_output);
+      *this->system.error_output << ")" << std::endl;
       return false;
     }
 
@@ -1467,7 +1486,7 @@ bool Lexer::parse_initialization(const std::vector<Token> &tokens,
         tokens[0].children, position_of_arguments->second.arguments,
         argument_parse_result);
 
-    result.children.push_back(argument_parse_result);
+    result.children = this->arena.copy(&argument_parse_result, 1);
 
     /**
      * If something went wrong, print usage of this
@@ -1477,11 +1496,12 @@ bool Lexer::parse_initialization(const std::vector<Token> &tokens,
       this->system.print_error_message(
           std::string(
               "An error occurred while parsing the argument list of '") +
-          tokens[0].value + "'.");
-      std::cerr << "> Usage of '" << tokens[0].value << "': " << tokens[0].value
-                << "(";
-      System::print_argument_list(position_of_arguments->second.arguments);
-      std::cerr << ")" << std::endl;
+          std::string(tokens[0].value) + "'.");
+      *this->system.error_output << "> Usage of '" << tokens[0].value
+                                 << "': " << tokens[0].value << "(";
+      System::print_argument_list(position_of_arguments->second.arguments,
+                                  *this->system.error_output);
+      *this->system.error_output << ")" << std::endl;
     }
 
     return success;
@@ -1493,8 +1513,22 @@ bool Lexer::parse_initialization(const std::vector<Token> &tokens,
   return false;
 }
 
-bool Lexer::parse_loop(const std::vector<Token> &tokens,
-                           ParseResult &result) {
+bool Lexer::parse_loop(TokenRange tokens, ParseResult &result) {
+  /**
+   * A parallel loop starts with the keyword 'parallel', followed by
+   * an ordinary loop.  The value of the parse result tells them
+   * apart.
+   */
+  if (tokens.size() > 1 && tokens[0].value == "parallel" &&
+      tokens[1].value == "for") {
+    if (!parse_loop(tokens.subrange(1, tokens.size()), result)) {
+      return false;
+    }
+
+    result.value = this->arena.copy(tokens[0].value);
+    return true;
+  }
+
   /**
    * A for loop consists of
    *
@@ -1520,12 +1554,12 @@ bool Lexer::parse_loop(const std::vector<Token> &tokens,
     result.type = Error;
     this->system.print_error_message(
         std::string("Could not parse for-loop: Expected 'for' but found '") +
-        tokens[0].value + "'.");
+        std::string(tokens[0].value) + "'.");
     return false;
   }
 
   result.type = Loop;
-  result.value = tokens[0].value;
+  result.value = this->arena.copy(tokens[0].value);
 
   /**
    * Now we get the loop variable. Since the lexer doesn't know what
@@ -1544,9 +1578,11 @@ bool Lexer::parse_loop(const std::vector<Token> &tokens,
    * The loop variable is the first child of the
    * for-loop-parse-result.
    */
-  ParseResult variable_parse_result = ParseResult(Variable, tokens[1].value);
+  Children children(*this);
+  ParseResult variable_parse_result =
+      ParseResult(Variable, this->arena.copy(tokens[1].value));
   variable_parse_result.line_number = result.line_number; // Pass the line_number.
-  result.children.push_back(variable_parse_result);
+  children.push_back(variable_parse_result);
 
   /**
    * We now expect the keyword in.
@@ -1573,7 +1609,8 @@ bool Lexer::parse_loop(const std::vector<Token> &tokens,
 
   ParseResult range_parse_result;
   range_parse_result.line_number = result.line_number; // Pass the line_number.
-  bool range_parse_success = parse_range({tokens[3]}, range_parse_result);
+  bool range_parse_success =
+      parse_range(tokens.subrange(3, 4), range_parse_result);
 
   if (!range_parse_success) {
     result.type = Error;
@@ -1583,7 +1620,7 @@ bool Lexer::parse_loop(const std::vector<Token> &tokens,
   /**
    * The range is the second child of the for loop.
    */
-  result.children.push_back(range_parse_result);
+  children.push_back(range_parse_result);
 
   /**
    * Finally we check whether the last token is the opening
@@ -1593,15 +1630,15 @@ bool Lexer::parse_loop(const std::vector<Token> &tokens,
     result.type = Error;
     this->system.print_error_message(
         std::string("Could not parse for-loop: Expected '{' but found '") +
-        tokens[4].value + "' instead.");
+        std::string(tokens[4].value) + "' instead.");
     return false;
   }
 
+  children.move_to(result);
   return true;
 }
 
-bool Lexer::parse_number(const std::vector<Token> &tokens,
-                         ParseResult &result) {
+bool Lexer::parse_number(TokenRange tokens, ParseResult &result) {
 
   /**
    * Check if the this is a single number.
@@ -1609,7 +1646,8 @@ bool Lexer::parse_number(const std::vector<Token> &tokens,
   if (tokens.size() != 1) {
     result.type = Error;
     this->system.print_error_message(
-        std::string("Invalid number of arguments near '") + tokens[0].value +
+        std::string("Invalid number of arguments near '") +
+        std::string(tokens[0].value) +
         "'. Token could not be read as '" + System::name_for_type.at(Number) +
         "'.");
     return false;
@@ -1618,17 +1656,17 @@ bool Lexer::parse_number(const std::vector<Token> &tokens,
   if (tokens[0].type != Number) {
     result.type = Error;
     this->system.print_error_message(
-        std::string("Invalid argument: '") + tokens[0].value +
+        std::string("Invalid argument: '") + std::string(tokens[0].value) +
         "' could not be read as '" + System::name_for_type.at(Number) + "'.");
     return false;
   }
 
   result.type = Number;
-  result.value = tokens[0].value;
+  result.value = this->arena.copy(tokens[0].value);
   return true;
 }
 
-bool Lexer::parse_brace(const std::vector<Token> &tokens, ParseResult &result) {
+bool Lexer::parse_brace(TokenRange tokens, ParseResult &result) {
   /**
    * A line that contains a brace has to have exactly one token
    * and that token is the brace.
@@ -1657,7 +1695,8 @@ bool Lexer::parse_brace(const std::vector<Token> &tokens, ParseResult &result) {
           "for-loops in the same line as the loop-definition."));
     } else {
       this->system.print_error_message(
-          std::string("Expected '}', but found '") + tokens[0].value +
+          std::string("Expected '}', but found '") +
+          std::string(tokens[0].value) +
           "' instead.");
     }
 
@@ -1665,7 +1704,7 @@ bool Lexer::parse_brace(const std::vector<Token> &tokens, ParseResult &result) {
   }
 
   result.type = Braces;
-  result.value = tokens[0].value;
+  result.value = this->arena.copy(tokens[0].value);
   return true;
 }
 
@@ -1673,7 +1712,7 @@ bool Lexer::parse_brace(const std::vector<Token> &tokens, ParseResult &result) {
  * Parses a string that represents a range.  If the parsed string
  * is not a number, the result will have type Error.
  */
-bool Lexer::parse_range(const std::vector<Token> &tokens, ParseResult &result) {
+bool Lexer::parse_range(TokenRange tokens, ParseResult &result) {
 
   /**
    * A range is a single token that has the arguments of the range as
@@ -1715,20 +1754,22 @@ bool Lexer::parse_range(const std::vector<Token> &tokens, ParseResult &result) {
   }
 
   result.type = Range;
-  result.value = tokens[0].value;
+  result.value = this->arena.copy(tokens[0].value);
 
   /**
    * Now we parse the three range tokens.
    */
-  std::vector<Token> tokens_in_current_range_argument;
-  for (int index = 0; index <= (int)tokens[0].children.size(); ++index) {
+  const TokenRange arguments = tokens[0].children;
+  int first_token_of_current_range_argument = 0;
+  Children children(*this);
+  for (int index = 0; index <= (int)arguments.size(); ++index) {
 
     /**
      * If we find a comma or are at the very end of the arguments
      * vector, all previous tokens from the current argument of the
      * range. So we parse this argument.
      */
-    if (index == (int)tokens[0].children.size() || tokens[0].children[index].value == ",") {
+    if (index == (int)arguments.size() || arguments[index].value == ",") {
       ParseResult current_argument;
       current_argument.line_number = result.line_number;
 
@@ -1736,29 +1777,26 @@ bool Lexer::parse_range(const std::vector<Token> &tokens, ParseResult &result) {
        * Check whether we could successfully parse the current
        * argument.
        */
-      if (!parse_tokens(tokens_in_current_range_argument, current_argument)) {
+      if (!parse_tokens(
+              arguments.subrange(first_token_of_current_range_argument, index),
+              current_argument)) {
         return false;
       }
 
       /**
        * Add the argument to the range.
        */
-      result.children.push_back(current_argument);
+      children.push_back(current_argument);
 
       /**
-       * Reset the tokens array so we can use it for the next
-       * argument.
-       */
-      tokens_in_current_range_argument.clear();
-    } else {
-      /**
-       * If we didn't find a comma, we add the token to the current
-       * argument.
+       * The next argument starts after the comma.
        */
-      tokens_in_current_range_argument.push_back(tokens[0].children[index]);
+      first_token_of_current_range_argument = index + 1;
     }
   }
 
+  children.move_to(result);
+
   /**
    * We now check whether we found exactly 3 arguments. If not
    * something went wrong.
@@ -1774,8 +1812,7 @@ bool Lexer::parse_range(const std::vector<Token> &tokens, ParseResult &result) {
   return true;
 }
 
-bool Lexer::parse_string_token(const std::vector<Token> &tokens,
-                               ParseResult &result) {
+bool Lexer::parse_string_token(TokenRange tokens, ParseResult &result) {
 
   /**
    * A string token has to consist of exactly one token. Which
@@ -1804,7 +1841,7 @@ bool Lexer::parse_string_token(const std::vector<Token> &tokens,
    * check whether there are escapes in there.
    */
   result.type = String;
-  result.value = tokens[0].value;
+  result.value = this->arena.copy(tokens[0].value);
 
   /**
    * If there are no children, we don't have escapes and simply pass
@@ -1820,6 +1857,7 @@ bool Lexer::parse_string_token(const std::vector<Token> &tokens,
    * tokens.
    */
   int escape_index = 0; // Used for better error messages.
+  Children children(*this);
 
   for (const Token &child : tokens[0].children) {
 
@@ -1830,7 +1868,8 @@ bool Lexer::parse_string_token(const std::vector<Token> &tokens,
       /**
        * Try to parse the string.
        */
-      if (!parse_string_token({child}, string_token_parse_result)) {
+      if (!parse_string_token(TokenRange(&child, 1),
+                              string_token_parse_result)) {
         result.type = Error;
         return false;
       }
@@ -1838,7 +1877,7 @@ bool Lexer::parse_string_token(const std::vector<Token> &tokens,
       /**
        * Add the token.
        */
-      result.children.push_back(string_token_parse_result);
+      children.push_back(string_token_parse_result);
 
       /**
        * If the token is not a String, it might be a StringEscape.
@@ -1882,10 +1921,12 @@ bool Lexer::parse_string_token(const std::vector<Token> &tokens,
       /**
        * Add the ParseResult as child of the overall result.
        */
-      result.children.push_back(string_escape_parse_result);
+      children.push_back(string_escape_parse_result);
     }
   }
 
+  children.move_to(result);
+
   /**
    * If we reach this point without failing, everything went as
    * expected.
@@ -1894,7 +1935,7 @@ bool Lexer::parse_string_token(const std::vector<Token> &tokens,
 }
 
 bool Lexer::parse_argument_list(
-    const std::vector<Token> &tokens,
+    TokenRange tokens,
     const std::vector<std::string> &expected_arguments, ParseResult &result) {
 
   result.type = ArgumentList;
@@ -1939,6 +1980,7 @@ bool Lexer::parse_argument_list(
    * argument is followed by ':'. Then gather the argument values.
    */
   int token_index = 0;
+  Children children(*this);
   while (token_index < (int)tokens.size()) {
     /**
      * First check whether we have not already found more arguments
@@ -1956,13 +1998,13 @@ bool Lexer::parse_argument_list(
     /**
      * Check whether the argument matches the expected argument.
      */
-    std::string argument_name = tokens[token_index].value;
+    const std::string_view argument_name = tokens[token_index].value;
     if (argument_name != expected_arguments[number_of_found_arguments]) {
       result.type = Error;
       this->system.print_error_message(
           std::string("Invalid argument in function call. Expected '") +
           expected_arguments[number_of_found_arguments] + "' but found '" +
-          tokens[token_index].value + "' instead.");
+          std::string(argument_name) + "' instead.");
       return false;
     }
 
@@ -1987,7 +2029,7 @@ bool Lexer::parse_argument_list(
       this->system.print_error_message(
           std::string("Invalid syntax in function call. Expected ':' "
                       "but found '") +
-          tokens[token_index].value + "' instead.");
+          std::string(tokens[token_index].value) + "' instead.");
       return false;
     }
 
@@ -2010,15 +2052,15 @@ bool Lexer::parse_argument_list(
      * in this argument list. Therefore, we only need to
      * look for the next ',' or the end of the token list.
      */
-    std::vector<Token> argument_value_tokens;
+    const int first_argument_value_token = token_index;
 
     /**
      * While we have not found a ',' or the end of the
      * token list, collect tokens for the current argument
      * value.
      */
-    while (tokens[token_index].value != "," &&
-           token_index < (int)tokens.size()) {
+    while (token_index < (int)tokens.size() &&
+           tokens[token_index].value != ",") {
       /**
        * When we find a ':' before finding a ',' or the end
        * of the token list, the syntax is invalid.
@@ -2031,10 +2073,6 @@ bool Lexer::parse_argument_list(
         return false;
       }
 
-      /**
-       * Add the token to the current list, and continue.
-       */
-      argument_value_tokens.push_back(tokens[token_index]);
       ++token_index;
     }
 
@@ -2042,7 +2080,7 @@ bool Lexer::parse_argument_list(
      * We have now collected all values for this argument.  Parse
      * them!
      */
-    ParseResult argument_result(Argument, argument_name);
+    ParseResult argument_result(Argument, this->arena.copy(argument_name));
     argument_result.line_number = result.line_number;
 
     /**
@@ -2050,7 +2088,9 @@ bool Lexer::parse_argument_list(
      */
     ParseResult argument_evaluation;
     argument_evaluation.line_number = result.line_number;
-    bool success = parse_tokens(argument_value_tokens, argument_evaluation);
+    bool success = parse_tokens(
+        tokens.subrange(first_argument_value_token, token_index),
+        argument_evaluation);
 
     /**
      * If something went wrong, return false;
@@ -2063,8 +2103,8 @@ bool Lexer::parse_argument_list(
     /**
      * Add the parsed results.
      */
-    argument_result.children.push_back(argument_evaluation);
-    result.children.push_back(argument_result);
+    argument_result.children = this->arena.copy(&argument_evaluation, 1);
+    children.push_back(argument_result);
 
     /**
      * We have just identified an argument.
@@ -2080,6 +2120,8 @@ bool Lexer::parse_argument_list(
     ++token_index;
   }
 
+  children.move_to(result);
+
   /**
    * When we arrived here, we parsed the whole argument list
    * successfully.
@@ -2096,7 +2138,7 @@ void Lexer::print_parse_result(const ParseResult &result,
   }
 }
 
-void Lexer::print_tokenized_string(const std::vector<Token> &tokenized_string,
+void Lexer::print_tokenized_string(TokenRange tokenized_string,
                                    const std::string &indentation) {
   for (const Token &token : tokenized_string) {
     std::cout << indentation << "'" << token.value << "' ("
@@ -2104,4 +2146,9 @@ void Lexer::print_tokenized_string(const std::vector<Token> &tokenized_string,
     Lexer::print_tokenized_string(token.children, indentation + "\t");
   }
 }
+
+void Lexer::reset() {
+  this->arena.clear();
+  this->token_arena.clear();
+}
 }  // namespace hydra
@@ -6,20 +6,35 @@
 #define NDEBUG
 #endif
 
-#include <any>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <stdlib.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 /**
  * Hydra
  */
+#include <bounded_queue.hpp>
+#include <compiler.hpp>
+#include <hydra.hpp>
 #include <lexer.hpp>
 #include <interpreter.hpp>
 #include <io_helper.hpp>
+#include <profiler.hpp>
+#include <program_cache.hpp>
+#include <resolver.hpp>
+#include <session.hpp>
 #include <system.hpp>
 #include <state.hpp>
+#include <thread_pool.hpp>
+#include <vm.hpp>
 
 /**
  * gflags / glog
@@ -31,13 +46,76 @@
  * Flags
  */
 // DEFINE_string(flag, "", "A test flag that takes a string.");
+DEFINE_string(engine, "tree",
+              "The engine that executes the code. 'tree' interprets the "
+              "parse tree directly, 'vm' compiles the code to bytecode "
+              "first.");
+DEFINE_int64(seed, -1,
+             "The seed of the random numbers. If negative, the numbers "
+             "differ between runs.");
+DEFINE_int32(export_threads, 1,
+             "The number of threads that are used to write the canvas to a "
+             "file. 0 uses one thread per core.");
+DEFINE_int32(parallel_threads, 0,
+             "The number of threads that execute parallel loops. 0 uses one "
+             "thread per core.");
+DEFINE_bool(cache, false,
+            "Store the parsed code next to the file (as .hydrac) and use "
+            "it instead of parsing the file again, as long as the file "
+            "does not change.");
+DEFINE_bool(stream, false,
+            "Parse the file on a background thread and execute each top "
+            "level statement as soon as it was parsed.");
+DEFINE_bool(profile, false,
+            "Measure the time spent on each line, builtin function, user "
+            "defined function and export, and print the hotspots when the "
+            "code was executed.");
+DEFINE_string(profile_stacks, "",
+              "If set together with 'profile', the measured time is also "
+              "written to this file as folded stacks for flame graphs.");
+DEFINE_bool(watch, false,
+            "Execute the file again whenever it changes. Only the top level "
+            "statements from the first changed line on are parsed and "
+            "executed again, starting from the state that the statements "
+            "before them left.");
+DEFINE_int32(watch_interval, 200,
+             "The number of milliseconds between two checks of the watched "
+             "file for changes.");
+DEFINE_string(sweep, "",
+              "A CSV file whose first line names parameters and whose other "
+              "lines hold values for them. The file is parsed once and "
+              "executed once per line, with the parameters defined as "
+              "global variables. The canvas of each run is saved to a file "
+              "of its own (see 'sweep_output').");
+DEFINE_string(sweep_output, "",
+              "The file that the canvas of each run of a sweep is saved to, "
+              "where '#' is replaced by the number of the run. By default, "
+              "the name of the file is used, e.g. 'mycode_#.svg'.");
+DEFINE_int32(jobs, 0,
+             "The number of runs of a sweep that are executed at the same "
+             "time. 0 uses one per core. The threads for parallel loops are "
+             "divided among the runs.");
 
 /**
  * Forward declarations.
  */
 void interpret_code_from_file(const std::string &file_name);
+void interpret_code_from_stream(const std::string &file_name);
+void watch_code_in_file(const std::string &file_name);
+void sweep_code_in_file(const std::string &file_name);
+bool read_sweep_parameters(const std::string &file_name,
+                           std::vector<std::string> &names,
+                           std::vector<std::vector<hydra::Value>> &runs);
+bool parse_code_using_cache(const std::string &file_name,
+                            hydra::System &system, hydra::Lexer &lexer,
+                            hydra::ProgramCache &cache,
+                            std::vector<hydra::ParseResult> &parsed_code);
 void launch_REPL();
 void convert_new_lines(std::string &str);
+bool execute_code(hydra::Interpreter &interpreter, hydra::VM &vm,
+                  const std::vector<hydra::ParseResult> &parsed_code,
+                  hydra::Value &result);
+void report_profile(const hydra::Profiler &profiler);
 
 /**
  * Main procedure
@@ -61,6 +139,43 @@ int main(int argc, char *argv[]) {
    */
   FLAGS_logtostderr = 1;
 
+  /**
+   * Check whether we know the requested engine.
+   */
+  if (FLAGS_engine != "tree" && FLAGS_engine != "vm") {
+    std::cerr << "Unknown engine '" << FLAGS_engine
+              << "'. Use 'tree' or 'vm' instead." << std::endl;
+    return 1;
+  }
+
+  if (FLAGS_export_threads < 0) {
+    std::cerr << "Invalid number of export threads '" << FLAGS_export_threads
+              << "'." << std::endl;
+    return 1;
+  }
+
+  if (FLAGS_export_threads == 0) {
+    FLAGS_export_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  if (FLAGS_parallel_threads < 0) {
+    std::cerr << "Invalid number of parallel threads '"
+              << FLAGS_parallel_threads << "'." << std::endl;
+    return 1;
+  }
+
+  if (FLAGS_parallel_threads == 0) {
+    FLAGS_parallel_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  if (FLAGS_jobs < 0) {
+    std::cerr << "Invalid number of jobs '" << FLAGS_jobs << "'." << std::endl;
+    return 1;
+  }
+
+  if (FLAGS_jobs == 0) {
+    FLAGS_jobs = std::max(1u, std::thread::hardware_concurrency());
+  }
 
   /**
    * Check whether a file name was passed as argument.
@@ -71,7 +186,18 @@ int main(int argc, char *argv[]) {
     /**
      * We got a file, so we try to interpret its code.
      */
-    interpret_code_from_file(file_name);
+    if (!FLAGS_sweep.empty()) {
+      sweep_code_in_file(file_name);
+    } else if (FLAGS_watch) {
+      watch_code_in_file(file_name);
+    } else if (FLAGS_stream) {
+      interpret_code_from_stream(file_name);
+    } else {
+      interpret_code_from_file(file_name);
+    }
+  } else if (!FLAGS_sweep.empty()) {
+    std::cerr << "A sweep needs the file whose code is executed." << std::endl;
+    return 1;
   } else {
 
     /**
@@ -95,35 +221,63 @@ void interpret_code_from_file(const std::string &file_name) {
   hydra::System system;
   hydra::Lexer lexer(system);
   hydra::Interpreter interpreter(system);
+  hydra::VM vm(interpreter);
+  interpreter.canvas.export_threads = FLAGS_export_threads;
+  interpreter.parallel_threads = FLAGS_parallel_threads;
+  if (FLAGS_seed >= 0) {
+    interpreter.random_engine.seed(FLAGS_seed);
+  }
+
+  std::unique_ptr<hydra::Profiler> profiler;
+  if (FLAGS_profile) {
+    profiler = std::make_unique<hydra::Profiler>();
+    interpreter.profiler = profiler.get();
+  }
 
   /**
-   * Read the code from the passed file.
+   * The cache holds the parsed code, if it is used.
    */
-  std::vector<std::string> code;
+  std::vector<hydra::ParseResult> parsed_code;
+  hydra::ProgramCache cache;
+  if (FLAGS_cache) {
+    if (!parse_code_using_cache(file_name, system, lexer, cache,
+                                parsed_code)) {
+      std::cerr << "Code could not be interpreted successfully." << std::endl;
+      return;
+    }
+  } else {
+    /**
+     * Read the code from the passed file.
+     */
+    std::vector<std::string> code;
 
-  DLOG(INFO) << "Reading code from file: '" << file_name << "'..." << std::endl;
-  hydra::IOHelper::read_code_from_file(file_name, code);
+    DLOG(INFO) << "Reading code from file: '" << file_name << "'..."
+               << std::endl;
+    hydra::IOHelper::read_code_from_file(file_name, code);
 
-  #ifdef DEBUG
-  std::cout << "Interpreting code: " << std::endl << std::endl;
-  for (int line = 0; line < (int)code.size(); ++line) {
-    std::string code_line = code[line];
+    #ifdef DEBUG
+    std::cout << "Interpreting code: " << std::endl << std::endl;
+    for (int line = 0; line < (int)code.size(); ++line) {
+      std::string code_line = code[line];
+
+      /**
+       * Replace '\n' with actual 'new lines'.
+       */
+      convert_new_lines(code_line);
+
+      std::cout << line + 1 << "| " << code_line << std::endl;
+    }
+    std::cout << std::endl;
+    #endif
 
     /**
-     * Replace '\n' with actual 'new lines'.
+     * First parse the whole code.
      */
-    convert_new_lines(code_line);
-
-    std::cout << line + 1 << "| " << code_line << std::endl;
+    if (!lexer.parse_code(code, parsed_code)) {
+      std::cerr << "Code could not be interpreted successfully." << std::endl;
+      return;
+    }
   }
-  std::cout << std::endl;
-  #endif
-
-  /**
-   * First parse the whole code.
-   */
-  std::vector<hydra::ParseResult> parsed_code;
-  lexer.parse_code(code, parsed_code);
 
   /**
    * Print the parsed code.
@@ -138,17 +292,527 @@ void interpret_code_from_file(const std::string &file_name) {
   /**
    * Interpret the code.
    */
-  std::any interpretation_result;
-  if (!interpreter.interpret_code(parsed_code, interpretation_result)) {
+  hydra::Value interpretation_result;
+  if (!execute_code(interpreter, vm, parsed_code, interpretation_result)) {
     std::cerr << "Code could not be interpreted successfully." << std::endl;
   }
 
+  if (profiler) {
+    report_profile(*profiler);
+  }
+
   #ifdef DEBUG
-  interpreter.print_scopes();
+  interpreter.print_globals();
   #endif
 
 }
 
+/**
+ * Parses the code in a hydra file, unless the cache next to the file
+ * holds the parsed code already.  In that case, the code is only
+ * resolved.  Otherwise the cache is updated.
+ */
+bool parse_code_using_cache(const std::string &file_name,
+                            hydra::System &system, hydra::Lexer &lexer,
+                            hydra::ProgramCache &cache,
+                            std::vector<hydra::ParseResult> &parsed_code) {
+  hydra::MappedFile file(file_name);
+  if (!file.is_open()) {
+    std::cerr << "Could not open file '" << file_name << "'." << std::endl;
+    return false;
+  }
+
+  const std::string_view text = file.contents();
+  const uint64_t code_hash = hydra::ProgramCache::hash_of_code(text);
+  const std::string cache_file_name =
+      hydra::ProgramCache::file_name_for_code(file_name);
+
+  if (cache.load(cache_file_name, code_hash, parsed_code)) {
+    DLOG(INFO) << "Using the parsed code from '" << cache_file_name << "'."
+               << std::endl;
+
+    hydra::Resolver resolver(system);
+    return resolver.resolve_code(parsed_code);
+  }
+
+  /**
+   * The lines are converted just like by IOHelper::read_code_from_file.
+   */
+  std::vector<std::string> code;
+  size_t position = 0;
+  std::string_view line;
+  while (hydra::IOHelper::next_line_in_text(text, position, line)) {
+    code.emplace_back(line);
+    hydra::IOHelper::convert_new_lines(code.back());
+  }
+
+  if (!lexer.parse_code(code, parsed_code)) {
+    return false;
+  }
+
+  if (!hydra::ProgramCache::save(cache_file_name, code_hash, parsed_code)) {
+    DLOG(INFO) << "Could not write the cache '" << cache_file_name << "'."
+               << std::endl;
+  }
+
+  return true;
+}
+
+/**
+ * Reads and interprets code from a hydra file, while it is being
+ * parsed.  The file is mapped into memory and parsed on a background
+ * thread, which passes the top level statements to the main thread
+ * as soon as they are complete.  Statements that precede a parse
+ * error are executed.
+ */
+void interpret_code_from_stream(const std::string &file_name) {
+
+  hydra::MappedFile file(file_name);
+  if (!file.is_open()) {
+    std::cerr << "Could not open file '" << file_name << "'." << std::endl;
+    return;
+  }
+
+  hydra::System system;
+  hydra::Interpreter interpreter(system);
+  hydra::VM vm(interpreter);
+  interpreter.canvas.export_threads = FLAGS_export_threads;
+  interpreter.parallel_threads = FLAGS_parallel_threads;
+  if (FLAGS_seed >= 0) {
+    interpreter.random_engine.seed(FLAGS_seed);
+  }
+
+  std::unique_ptr<hydra::Profiler> profiler;
+  if (FLAGS_profile) {
+    profiler = std::make_unique<hydra::Profiler>();
+    interpreter.profiler = profiler.get();
+  }
+
+  /**
+   * The lexer works with a system of its own, such that parsing does
+   * not interfere with the execution.  Its arena holds the statements
+   * until the execution is done.
+   */
+  hydra::System parser_system;
+  hydra::Lexer lexer(parser_system);
+
+  /**
+   * The statements are passed on in batches, such that the threads
+   * rarely have to wait for each other.  The parser may only get a
+   * few batches ahead of the execution.
+   */
+  const size_t statements_per_batch = 64;
+  hydra::BoundedQueue<std::vector<hydra::ParseResult>> batches(16);
+  std::atomic<bool> parsing_succeeded(false);
+
+  std::thread parser([&file, &lexer, &batches, &parsing_succeeded,
+                      statements_per_batch]() {
+    const std::string_view text = file.contents();
+    size_t position = 0;
+    std::string code_line;
+    std::vector<hydra::ParseResult> batch;
+
+    bool success = lexer.parse_lines(
+        [&text, &position, &code_line]() -> const std::string * {
+          std::string_view line;
+          if (!hydra::IOHelper::next_line_in_text(text, position, line)) {
+            return nullptr;
+          }
+
+          code_line.assign(line);
+          hydra::IOHelper::convert_new_lines(code_line);
+          return &code_line;
+        },
+        [&batches, &batch,
+         statements_per_batch](const hydra::ParseResult &statement) -> bool {
+          batch.push_back(statement);
+          if (batch.size() < statements_per_batch) {
+            return true;
+          }
+
+          bool is_open = batches.push(batch);
+          batch.clear();
+          return is_open;
+        });
+
+    /**
+     * The statements that precede a parse error are executed as well.
+     */
+    if (!batch.empty()) {
+      batches.push(batch);
+    }
+
+    parsing_succeeded = success;
+    batches.close();
+  });
+
+  /**
+   * The statements are resolved and executed in the order in which
+   * they are parsed.
+   */
+  hydra::Resolver resolver(system);
+  std::vector<hydra::ParseResult> parsed_code;
+  hydra::Value interpretation_result;
+  bool execution_succeeded = true;
+
+  while (batches.pop(parsed_code)) {
+    #ifdef DEBUG
+    for (const hydra::ParseResult &parsed_line : parsed_code) {
+      std::cout << parsed_line.line_number << "| ";
+      hydra::Lexer::print_parse_result(parsed_line);
+    }
+    #endif
+
+    if (!resolver.resolve_code(parsed_code) ||
+        !execute_code(interpreter, vm, parsed_code, interpretation_result)) {
+      execution_succeeded = false;
+
+      /**
+       * Stops the parser.
+       */
+      batches.close();
+      break;
+    }
+  }
+
+  parser.join();
+
+  if (!execution_succeeded || !parsing_succeeded) {
+    std::cerr << "Code could not be interpreted successfully." << std::endl;
+  }
+
+  if (profiler) {
+    report_profile(*profiler);
+  }
+
+  #ifdef DEBUG
+  interpreter.print_globals();
+  #endif
+}
+
+/**
+ * Executes the code in a hydra file and executes it again whenever
+ * the file changes, until the program is stopped.  The session
+ * continues from the first changed statement, such that the
+ * statements before it are neither parsed nor executed again.
+ */
+void watch_code_in_file(const std::string &file_name) {
+
+  hydra::System system;
+  hydra::Lexer lexer(system);
+  hydra::Interpreter interpreter(system);
+  hydra::VM vm(interpreter);
+  interpreter.canvas.export_threads = FLAGS_export_threads;
+  interpreter.parallel_threads = FLAGS_parallel_threads;
+  if (FLAGS_seed >= 0) {
+    interpreter.random_engine.seed(FLAGS_seed);
+  }
+
+  hydra::Session session(lexer, interpreter,
+                         FLAGS_engine == "vm" ? &vm : nullptr);
+
+  std::cerr << "Watching '" << file_name << "' for changes." << std::endl;
+
+  std::vector<std::string> code;
+  std::vector<std::string> executed_code;
+  bool is_first_run = true;
+
+  while (true) {
+    /**
+     * Editors may replace the file when saving it, so a file that
+     * cannot be opened is checked again later.  The lines are
+     * converted just like by IOHelper::read_code_from_file.
+     */
+    hydra::MappedFile file(file_name);
+    if (file.is_open()) {
+      const std::string_view text = file.contents();
+      code.clear();
+      size_t position = 0;
+      std::string_view line;
+      while (hydra::IOHelper::next_line_in_text(text, position, line)) {
+        code.emplace_back(line);
+        hydra::IOHelper::convert_new_lines(code.back());
+      }
+
+      if (is_first_run || code != executed_code) {
+        is_first_run = false;
+
+        hydra::Value result;
+        if (session.run(code, result)) {
+          std::cerr << "Executed " << session.number_of_executed_statements()
+                    << " of " << session.number_of_statements()
+                    << " statements." << std::endl;
+        } else {
+          std::cerr << "Code could not be interpreted successfully."
+                    << std::endl;
+        }
+
+        executed_code.swap(code);
+      }
+    } else if (is_first_run) {
+      std::cerr << "Could not open file '" << file_name << "'." << std::endl;
+      return;
+    }
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(std::max(1, FLAGS_watch_interval)));
+  }
+}
+
+/**
+ * Executes the code in a hydra file once for each set of parameters
+ * in the sweep file and saves each canvas to a file of its own.  The
+ * code is parsed once and the runs are distributed among the jobs,
+ * each of which takes the next run as soon as it is done with its
+ * previous one.  Afterwards, the time of each run is reported.
+ */
+void sweep_code_in_file(const std::string &file_name) {
+
+  std::vector<std::string> names;
+  std::vector<std::vector<hydra::Value>> runs;
+  if (!read_sweep_parameters(FLAGS_sweep, names, runs)) {
+    return;
+  }
+
+  std::string errors;
+  std::shared_ptr<const hydra::Program> program =
+      hydra::Program::load(file_name, FLAGS_cache, errors);
+  if (program == nullptr) {
+    std::cerr << errors << "Code could not be interpreted successfully."
+              << std::endl;
+    return;
+  }
+
+  /**
+   * The runs are numbered from 1, with as many digits as the last
+   * one, such that the files are sorted like the runs.
+   */
+  std::string output = FLAGS_sweep_output;
+  if (output.empty()) {
+    output = file_name;
+
+    const size_t position_of_extension = output.find_last_of('.');
+    const size_t position_of_directory = output.find_last_of('/');
+    if (position_of_extension != std::string::npos &&
+        (position_of_directory == std::string::npos ||
+         position_of_extension > position_of_directory)) {
+      output.erase(position_of_extension);
+    }
+    output += "_#.svg";
+  }
+
+  const int number_of_digits = std::to_string(runs.size()).size();
+
+  hydra::Options options;
+  options.engine = FLAGS_engine == "vm" ? hydra::Options::Engine::VM
+                                        : hydra::Options::Engine::Tree;
+  options.export_threads = FLAGS_export_threads;
+  options.parallel_threads = std::max(1, FLAGS_parallel_threads / FLAGS_jobs);
+  options.seed = FLAGS_seed;
+  hydra::InstancePool instances(options);
+
+  struct Run {
+    std::string file_name;
+    bool succeeded = false;
+    std::string errors;
+    double seconds = 0.0;
+  };
+  std::vector<Run> results(runs.size());
+
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  hydra::ThreadPool jobs(std::max(1, std::min<int>(FLAGS_jobs, runs.size())));
+  jobs.parallel_for(runs.size(), [&](int run) {
+    const std::chrono::steady_clock::time_point run_start =
+        std::chrono::steady_clock::now();
+
+    std::string number = std::to_string(run + 1);
+    number.insert(0, number_of_digits - number.size(), '0');
+
+    Run &result = results[run];
+    result.file_name = output;
+    for (size_t position = result.file_name.find('#');
+         position != std::string::npos;
+         position = result.file_name.find('#', position + number.size())) {
+      result.file_name.replace(position, 1, number);
+    }
+
+    /**
+     * The files that the code saves itself get the number of the run,
+     * since the runs would overwrite each other's files otherwise.
+     */
+    hydra::InstancePool::Lease instance = instances.acquire();
+    instance->set_saved_file_suffix("_" + number);
+    for (int index = 0; index < (int)names.size(); ++index) {
+      instance->define_variable(names[index], runs[run][index]);
+    }
+
+    result.succeeded = instance->run(*program);
+    if (result.succeeded) {
+      instance->canvas().save_to_file(result.file_name);
+    }
+    result.errors = instance->errors();
+
+    result.seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - run_start)
+                         .count();
+  });
+
+  const double total_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  /**
+   * The errors come first, such that the summary is not interrupted.
+   */
+  int number_of_failed_runs = 0;
+  for (int run = 0; run < (int)results.size(); ++run) {
+    if (!results[run].succeeded) {
+      ++number_of_failed_runs;
+      std::cerr << "Run " << run + 1 << " failed:\n" << results[run].errors;
+    }
+  }
+
+  const std::ios_base::fmtflags flags = std::cerr.flags();
+  const std::streamsize precision = std::cerr.precision();
+
+  std::cerr << "Sweep of " << results.size()
+            << (results.size() == 1 ? " run" : " runs") << " using "
+            << jobs.size() << (jobs.size() == 1 ? " job" : " jobs")
+            << " (total " << std::fixed << std::setprecision(3)
+            << total_seconds << "s";
+  if (number_of_failed_runs > 0) {
+    std::cerr << ", " << number_of_failed_runs << " failed";
+  }
+  std::cerr << "):\n"
+            << std::right << std::setw(8) << "run" << std::setw(12)
+            << "seconds"
+            << "  file\n";
+
+  for (int run = 0; run < (int)results.size(); ++run) {
+    std::cerr << std::setw(8) << run + 1 << std::setw(12)
+              << results[run].seconds << "  "
+              << (results[run].succeeded ? results[run].file_name : "failed")
+              << "\n";
+  }
+
+  std::cerr.flags(flags);
+  std::cerr.precision(precision);
+  std::cerr << std::flush;
+}
+
+/**
+ * Reads the parameters of a sweep from a CSV file.  The first line
+ * holds the names of the parameters, each of the other lines the
+ * values of one run.  Values are separated by commas and may be
+ * quoted.  Unquoted values that are numbers become numbers, all
+ * other values strings.  Empty lines are skipped.
+ */
+bool read_sweep_parameters(const std::string &file_name,
+                           std::vector<std::string> &names,
+                           std::vector<std::vector<hydra::Value>> &runs) {
+  hydra::MappedFile file(file_name);
+  if (!file.is_open()) {
+    std::cerr << "Could not open file '" << file_name << "'." << std::endl;
+    return false;
+  }
+
+  const std::string_view text = file.contents();
+  size_t position = 0;
+  std::string_view line;
+  int line_number = 0;
+
+  std::vector<std::string> fields;
+  std::vector<bool> is_quoted;
+
+  while (hydra::IOHelper::next_line_in_text(text, position, line)) {
+    ++line_number;
+
+    /**
+     * Split the line into its fields, without the quotes and the white
+     * spaces around the values.
+     */
+    fields.assign(1, std::string());
+    is_quoted.assign(1, false);
+    bool is_in_quotes = false;
+    for (size_t index = 0; index < line.size(); ++index) {
+      const char character = line[index];
+      if (is_in_quotes) {
+        if (character != '"') {
+          fields.back() += character;
+        } else if (index + 1 < line.size() && line[index + 1] == '"') {
+          fields.back() += '"';
+          ++index;
+        } else {
+          is_in_quotes = false;
+        }
+      } else if (character == '"') {
+        is_in_quotes = true;
+        is_quoted.back() = true;
+      } else if (character == ',') {
+        fields.emplace_back();
+        is_quoted.push_back(false);
+      } else if (!std::isspace((unsigned char)character) ||
+                 (!fields.back().empty() && !is_quoted.back())) {
+        fields.back() += character;
+      }
+    }
+
+    for (int index = 0; index < (int)fields.size(); ++index) {
+      std::string &field = fields[index];
+      while (!is_quoted[index] && !field.empty() &&
+             std::isspace((unsigned char)field.back())) {
+        field.pop_back();
+      }
+    }
+
+    if (fields.size() == 1 && fields[0].empty() && !is_quoted[0]) {
+      continue;
+    }
+
+    if (names.empty()) {
+      for (const std::string &name : fields) {
+        if (name.empty()) {
+          std::cerr << "Line " << line_number << " of '" << file_name
+                    << "' contains a parameter without a name." << std::endl;
+          return false;
+        }
+      }
+
+      names = fields;
+      continue;
+    }
+
+    if (fields.size() != names.size()) {
+      std::cerr << "Line " << line_number << " of '" << file_name << "' has "
+                << fields.size() << " values, but there are " << names.size()
+                << " parameters." << std::endl;
+      return false;
+    }
+
+    runs.emplace_back();
+    for (int index = 0; index < (int)fields.size(); ++index) {
+      char *end_of_number = nullptr;
+      const double number = std::strtod(fields[index].c_str(), &end_of_number);
+      if (!is_quoted[index] && !fields[index].empty() &&
+          *end_of_number == '\0') {
+        runs.back().emplace_back(number);
+      } else {
+        runs.back().emplace_back(fields[index]);
+      }
+    }
+  }
+
+  if (names.empty()) {
+    std::cerr << "The file '" << file_name << "' does not name any parameters."
+              << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 /**
  * Launches the REPL!
  */
@@ -163,14 +827,22 @@ void launch_REPL() {
   hydra::System system;
   hydra::Lexer lexer(system);
   hydra::Interpreter interpreter(system);
+  hydra::VM vm(interpreter);
+  interpreter.canvas.export_threads = FLAGS_export_threads;
+  interpreter.parallel_threads = FLAGS_parallel_threads;
+  if (FLAGS_seed >= 0) {
+    interpreter.random_engine.seed(FLAGS_seed);
+  }
 
   /**
    * We usually interpret the code straight after execution. If,
    * however, we have a for loop, we only interpret the code once the
-   * last for-loop closes.
+   * last for-loop closes.  The session keeps all code that was
+   * entered, such that only the new statements are executed.
    */
   std::vector<std::string> code;
-  std::vector<hydra::ParseResult> parsed_code;
+  hydra::Session session(lexer, interpreter,
+                         FLAGS_engine == "vm" ? &vm : nullptr);
 
   /**
    * Get input from the user as long as the user didn't quit.
@@ -238,12 +910,12 @@ void launch_REPL() {
       std::cerr << "(Code was not interpreted.)" << std::endl;
 
       /**
-       * An error occurred we start over, with out having any code
-       * stored.
+       * An error occurred we start over, keeping only the code that
+       * was executed already.
        */
       number_of_open_for_loops = 0;
-      code.clear();
-      parsed_code.clear();
+      code.resize(session.number_of_lines());
+      continue;
     }
 
     /**
@@ -265,29 +937,17 @@ void launch_REPL() {
      */
     if (number_of_open_for_loops <= 0) {
 
-      if (!lexer.parse_code(code, parsed_code)) {
-        std::cerr << "(Code was not interpreted.)" << std::endl;
-
-        /**
-         * An error occurred we start over, with out having any code
-         * stored.
-         */
-        number_of_open_for_loops = 0;
-        code.clear();
-        parsed_code.clear();
-      }
-
-      std::any result;
-      if (!interpreter.interpret_code(parsed_code, result)) {
+      hydra::Value result;
+      if (!session.run(code, result)) {
         std::cerr << "(Code was not interpreted.)" << std::endl;
 
         /**
-         * An error occurred we start over, with out having any code
-         * stored.
+         * An error occurred we start over, keeping only the code that
+         * was executed already.
          */
         number_of_open_for_loops = 0;
-        code.clear();
-        parsed_code.clear();
+        code.resize(session.number_of_lines());
+        continue;
       }
 
       /**
@@ -298,19 +958,53 @@ void launch_REPL() {
       if (interpreter.string_representation_of_interpretation_result(result, result_string)) {
         std::cout << "> " << result_string << std::endl;
       }
-
-      /**
-       * Since we don't want to parse this same code again, we clear
-       * the currently read code.
-       */
-      code.clear();
-      parsed_code.clear();
     }
   }
 
   std::cout << "Exiting Hydra REPL." << std::endl;
 }
 
+/**
+ * Executes parsed code using the engine selected by the 'engine'
+ * flag.
+ */
+bool execute_code(hydra::Interpreter &interpreter, hydra::VM &vm,
+                  const std::vector<hydra::ParseResult> &parsed_code,
+                  hydra::Value &result) {
+  if (FLAGS_engine != "vm") {
+    return interpreter.interpret_code(parsed_code, result);
+  }
+
+  /**
+   * The VM executes the code after it was compiled.
+   */
+  hydra::Compiler compiler(interpreter);
+  hydra::Chunk chunk;
+  if (!compiler.compile_code(parsed_code, chunk)) {
+    return false;
+  }
+
+  #ifdef DEBUG
+  hydra::Compiler::print_chunk(chunk);
+  #endif
+
+  return vm.run(chunk, result);
+}
+
+/**
+ * Prints the hotspots of the profile and writes its stacks, if
+ * requested by the 'profile_stacks' flag.
+ */
+void report_profile(const hydra::Profiler &profiler) {
+  profiler.print_hotspots(std::cerr, 30);
+
+  if (!FLAGS_profile_stacks.empty() &&
+      !profiler.write_folded_stacks(FLAGS_profile_stacks)) {
+    std::cerr << "Could not write the profile to '" << FLAGS_profile_stacks
+              << "'." << std::endl;
+  }
+}
+
 /**
  * Takes a string and turns 'new lines' into '\n'.
  */
@@ -0,0 +1,357 @@
+//
+//  optimizer.cpp
+//  hydra
+//
+
+#include <optimizer.hpp>
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+
+namespace hydra {
+
+Optimizer::Optimizer(System &system) : system(system) {}
+
+void Optimizer::optimize_code(std::vector<ParseResult> &code,
+                              int number_of_top_level_slots) {
+  for (ParseResult &statement : code) {
+    fold_constants(statement);
+  }
+
+  this->number_of_slots = number_of_top_level_slots;
+  for (ParseResult &statement : code) {
+    hoist_calls(statement);
+  }
+
+  this->system.state.reserve_top_level_slots(this->number_of_slots);
+}
+
+void Optimizer::fold_constants(ParseResult &input) {
+  /**
+   * Forget what a previous optimization determined.
+   */
+  input.is_constant = false;
+  input.number = 0.0;
+  input.number_of_hoisted_calls = 0;
+  if (input.type == Function || input.type == Loop) {
+    input.frame = UnresolvedFrame;
+    input.slot = -1;
+  }
+
+  for (ParseResult &child : input.children) {
+    fold_constants(child);
+  }
+
+  /**
+   * Numbers are converted like by the interpreter.  Numbers that are
+   * out of range are left to the interpreter, which reports them.
+   */
+  if (input.type == Number) {
+    if (input.value == "M_PI") {
+      input.is_constant = true;
+      input.number = M_PI;
+      return;
+    }
+
+    const std::string text(input.value);
+    char *end_of_number = nullptr;
+    errno = 0;
+    const double value = std::strtod(text.c_str(), &end_of_number);
+    if (end_of_number != text.c_str() && errno != ERANGE) {
+      input.is_constant = true;
+      input.number = value;
+    }
+    return;
+  }
+
+  if (input.type != Expression || input.children.size() % 2 != 1) {
+    return;
+  }
+
+  if (input.children.size() == 1) {
+    input.is_constant = input.children[0].is_constant;
+    input.number = input.children[0].number;
+    return;
+  }
+
+  /**
+   * The expression is evaluated exactly like by the interpreter (see
+   * Interpreter::interpret_expression), such that folding it does not
+   * change its value.
+   */
+  double final_result = 0.0;
+  double term = 0.0;
+  char term_operation = '+';
+  char current_operation = ' ';
+
+  for (int index = 0; index < (int)input.children.size(); ++index) {
+    const ParseResult &part = input.children[index];
+
+    if (index % 2 == 1) {
+      if (part.type != Operator || part.value.size() != 1) {
+        return;
+      }
+
+      current_operation = part.value[0];
+      if (current_operation == '+' || current_operation == '-') {
+        final_result += term_operation == '+' ? term : -term;
+        term_operation = current_operation;
+      } else if (current_operation != '*' && current_operation != '/') {
+        return;
+      }
+      continue;
+    }
+
+    if (part.type == Operator || !part.is_constant) {
+      return;
+    }
+
+    if (current_operation == '*') {
+      term *= part.number;
+    } else if (current_operation == '/') {
+      term /= part.number;
+    } else {
+      term = part.number;
+    }
+  }
+
+  final_result += term_operation == '+' ? term : -term;
+
+  input.is_constant = true;
+  input.number = final_result;
+}
+
+void Optimizer::hoist_calls(ParseResult &input) {
+  if (input.type == FunctionDefinition) {
+    hoist_calls_in_function_definition(input);
+    return;
+  }
+
+  if (input.type == Loop) {
+    hoist_calls_in_loop(input);
+    return;
+  }
+
+  for (ParseResult &child : input.children) {
+    hoist_calls(child);
+  }
+}
+
+void Optimizer::hoist_calls_in_function_definition(
+    ParseResult &function_definition) {
+  if (function_definition.children.empty() ||
+      function_definition.children[0].type != ParameterList) {
+    return;
+  }
+
+  std::unordered_map<std::string, Func>::iterator position_of_function =
+      this->system.known_functions.find(
+          std::string(function_definition.value));
+  if (position_of_function == this->system.known_functions.end()) {
+    return;
+  }
+
+  /**
+   * The body of the function has a frame of its own, whose first
+   * slots hold the parameters.
+   */
+  Func &function = position_of_function->second;
+  const int enclosing_number_of_slots = this->number_of_slots;
+
+  this->number_of_slots = function.number_of_slots;
+  if (this->number_of_slots < (int)function.arguments.size()) {
+    this->number_of_slots = function.arguments.size();
+  }
+
+  for (int index = 1; index < (int)function_definition.children.size();
+       ++index) {
+    hoist_calls(function_definition.children[index]);
+  }
+
+  function.number_of_slots = this->number_of_slots;
+  this->number_of_slots = enclosing_number_of_slots;
+}
+
+void Optimizer::hoist_calls_in_loop(ParseResult &loop) {
+  if (loop.children.size() < 3) {
+    return;
+  }
+
+  LoopEffects effects;
+  collect_effects(loop, effects);
+
+  /**
+   * The values of the calls are stored after all slots that are used
+   * while the loop is running.
+   */
+  loop.slot = this->number_of_slots;
+  for (int index = 2; index < (int)loop.children.size(); ++index) {
+    hoist_invariant_calls(loop.children[index], effects);
+  }
+
+  loop.number_of_hoisted_calls = this->number_of_slots - loop.slot;
+  if (loop.number_of_hoisted_calls == 0) {
+    loop.slot = -1;
+  }
+
+  /**
+   * The calls that depend on the outer loop may still not depend on
+   * the loops within it.
+   */
+  for (int index = 2; index < (int)loop.children.size(); ++index) {
+    hoist_calls(loop.children[index]);
+  }
+}
+
+void Optimizer::hoist_invariant_calls(ParseResult &input,
+                                      const LoopEffects &effects) {
+  /**
+   * The body of a function is not executed by the loop.
+   */
+  if (input.type == FunctionDefinition) {
+    return;
+  }
+
+  if (input.type == Function) {
+    /**
+     * The call was already hoisted out of an enclosing loop.
+     */
+    if (input.frame != UnresolvedFrame) {
+      return;
+    }
+
+    if (is_loop_invariant(input, effects)) {
+      input.frame = LocalFrame;
+      input.slot = this->number_of_slots++;
+      return;
+    }
+  }
+
+  for (ParseResult &child : input.children) {
+    hoist_invariant_calls(child, effects);
+  }
+}
+
+void Optimizer::collect_effects(const ParseResult &input,
+                                LoopEffects &effects) const {
+  /**
+   * Collects the slot of a variable that is defined or assigned to.
+   */
+  const auto collect_variable = [&effects](const ParseResult &variable) {
+    if (variable.frame == LocalFrame) {
+      effects.local_slots.insert(variable.slot);
+    } else if (variable.frame == GlobalFrame) {
+      effects.global_slots.insert(variable.slot);
+    } else {
+      effects.changes_globals = true;
+    }
+  };
+
+  switch (input.type) {
+    case Assignment:
+      if (input.children.size() == 3 &&
+          input.children[0].type == Assignment) {
+        collect_variable(input.children[1]);
+      } else if (input.children.size() == 2) {
+        collect_variable(input.children[0]);
+      }
+      break;
+    case Loop:
+      if (!input.children.empty()) {
+        collect_variable(input.children[0]);
+      }
+      break;
+    case Argument:
+      /**
+       * The hidden variable of the argument is set by the function.
+       */
+      if (input.frame == LocalFrame) {
+        effects.local_slots.insert(input.slot);
+      }
+      break;
+    case Function:
+      /**
+       * User defined functions may assign to global variables, unless
+       * they are pure.
+       */
+      if (!is_pure_function(input) &&
+          !this->system.is_builtin_function(std::string(input.value))) {
+        effects.changes_globals = true;
+      }
+      break;
+    case FunctionDefinition:
+      return;
+    default:
+      break;
+  }
+
+  for (const ParseResult &child : input.children) {
+    collect_effects(child, effects);
+  }
+}
+
+bool Optimizer::is_loop_invariant(const ParseResult &input,
+                                  const LoopEffects &effects) const {
+  if (input.is_constant) {
+    return true;
+  }
+
+  switch (input.type) {
+    case Unknown:
+      /**
+       * An Unknown without children is a variable.
+       */
+      if (!input.children.empty()) {
+        return false;
+      }
+      // fall through
+    case Variable:
+      if (input.frame == LocalFrame) {
+        return effects.local_slots.count(input.slot) == 0;
+      }
+      if (input.frame == GlobalFrame) {
+        return !effects.changes_globals &&
+               effects.global_slots.count(input.slot) == 0;
+      }
+      return false;
+    case Function:
+      if (!is_pure_function(input)) {
+        return false;
+      }
+      break;
+    case Argument:
+      if (input.frame != UnresolvedFrame) {
+        return false;
+      }
+      break;
+    case ArgumentList:
+    case Expression:
+    case Initialization:
+    case Operator:
+    case Property:
+    case String:
+    case StringEscape:
+      break;
+    default:
+      return false;
+  }
+
+  for (const ParseResult &child : input.children) {
+    if (!is_loop_invariant(child, effects)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Optimizer::is_pure_function(const ParseResult &function_call) const {
+  std::unordered_map<std::string, Func>::const_iterator position_of_function =
+      this->system.known_functions.find(std::string(function_call.value));
+
+  return position_of_function != this->system.known_functions.end() &&
+         position_of_function->second.is_pure;
+}
+
+}  // namespace hydra
@@ -0,0 +1,75 @@
+//
+//  output_sink.cpp
+//  hydra
+//
+
+#include <output_sink.hpp>
+
+#include <charconv>
+#include <cstring>
+
+namespace hydra {
+
+OutputSink::OutputSink(std::ostream *stream, int precision)
+    : precision(precision), stream(stream) {
+  if (this->stream != nullptr) {
+    this->buffer.reserve(OutputSink::buffer_capacity);
+  }
+}
+
+OutputSink::~OutputSink() { flush(); }
+
+OutputSink &OutputSink::operator<<(const char *str) {
+  this->buffer.append(str, std::strlen(str));
+  flush_if_full();
+  return *this;
+}
+
+OutputSink &OutputSink::operator<<(const std::string &str) {
+  this->buffer += str;
+  flush_if_full();
+  return *this;
+}
+
+OutputSink &OutputSink::operator<<(char character) {
+  this->buffer += character;
+  flush_if_full();
+  return *this;
+}
+
+OutputSink &OutputSink::operator<<(double number) {
+  /**
+   * Large enough for the integral digits of the largest double,
+   * together with the sign, the decimal point and the maximum
+   * precision.
+   */
+  char digits[384];
+
+  /**
+   * In contrast to std::to_string, std::to_chars does not depend on
+   * the locale and doesn't allocate.  The fixed format with 6
+   * decimal places yields the same digits as std::to_string.
+   */
+  std::to_chars_result conversion =
+      std::to_chars(digits, digits + sizeof(digits), number,
+                    std::chars_format::fixed, this->precision);
+
+  this->buffer.append(digits, conversion.ptr - digits);
+  flush_if_full();
+  return *this;
+}
+
+void OutputSink::flush() {
+  if (this->stream != nullptr && !this->buffer.empty()) {
+    this->stream->write(this->buffer.data(), this->buffer.size());
+    this->buffer.clear();
+  }
+}
+
+void OutputSink::flush_if_full() {
+  if (this->buffer.size() >= OutputSink::buffer_capacity) {
+    flush();
+  }
+}
+
+}  // namespace hydra
@@ -0,0 +1,282 @@
+//
+//  png_writer.cpp
+//  hydra
+//
+
+#include <png_writer.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace hydra {
+
+namespace {
+
+const char png_signature[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a',
+                               '\n'};
+
+/**
+ * The largest amount of data that is stored in a single IDAT chunk.
+ */
+const size_t maximum_chunk_size = 1 << 20;
+
+/**
+ * The lengths of the deflate length symbols 257 to 285 and the
+ * number of extra bits that follow them.
+ */
+const int length_bases[29] = {3,  4,  5,  6,  7,  8,  9,  10,  11, 13,
+                              15, 17, 19, 23, 27, 31, 35, 43,  51, 59,
+                              67, 83, 99, 115, 131, 163, 195, 227, 258};
+const int length_extra_bits[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                   1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                   4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+/**
+ * The longest run that a single length symbol can represent.
+ */
+const int maximum_run_length = 258;
+
+uint32_t crc32(const char *data, size_t size, uint32_t crc = 0) {
+  static const std::vector<uint32_t> table = [] {
+    std::vector<uint32_t> table(256);
+    for (uint32_t index = 0; index < 256; ++index) {
+      uint32_t value = index;
+      for (int bit = 0; bit < 8; ++bit) {
+        value = (value & 1) ? 0xedb88320u ^ (value >> 1) : value >> 1;
+      }
+      table[index] = value;
+    }
+    return table;
+  }();
+
+  crc = ~crc;
+  for (size_t index = 0; index < size; ++index) {
+    crc = table[(crc ^ (uint8_t)data[index]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+uint32_t adler32(const uint8_t *data, size_t size) {
+  static const uint32_t modulus = 65521;
+
+  /**
+   * The sums are reduced every 5552 bytes, which is the largest
+   * number of bytes that cannot overflow them.
+   */
+  uint32_t a = 1;
+  uint32_t b = 0;
+  while (size > 0) {
+    const size_t block_size = std::min<size_t>(size, 5552);
+    for (size_t index = 0; index < block_size; ++index) {
+      a += data[index];
+      b += a;
+    }
+    a %= modulus;
+    b %= modulus;
+    data += block_size;
+    size -= block_size;
+  }
+
+  return (b << 16) | a;
+}
+
+void append_big_endian(std::string &output, uint32_t value) {
+  output.push_back((char)(value >> 24));
+  output.push_back((char)(value >> 16));
+  output.push_back((char)(value >> 8));
+  output.push_back((char)value);
+}
+
+void write_chunk(std::ostream &stream, const char type[4], const char *data,
+                 size_t size) {
+  std::string header;
+  append_big_endian(header, size);
+  header.append(type, 4);
+
+  uint32_t crc = crc32(type, 4);
+  crc = crc32(data, size, crc);
+
+  std::string footer;
+  append_big_endian(footer, crc);
+
+  stream.write(header.data(), header.size());
+  stream.write(data, size);
+  stream.write(footer.data(), footer.size());
+}
+
+/**
+ * Packs the bits of a deflate stream into bytes, starting with the
+ * least significant bit.
+ */
+class BitWriter {
+ public:
+  BitWriter(std::string &output) : output(output) {}
+
+  /**
+   * Writes the lowest number_of_bits bits of the value, least
+   * significant bit first.
+   */
+  void write(uint32_t value, int number_of_bits) {
+    this->buffer |= (uint64_t)value << this->number_of_bits;
+    this->number_of_bits += number_of_bits;
+    while (this->number_of_bits >= 8) {
+      this->output.push_back((char)(this->buffer & 0xff));
+      this->buffer >>= 8;
+      this->number_of_bits -= 8;
+    }
+  }
+
+  /**
+   * Writes a Huffman code, which is stored most significant bit
+   * first.
+   */
+  void write_code(uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int bit = 0; bit < length; ++bit) {
+      reversed = (reversed << 1) | ((code >> bit) & 1);
+    }
+    write(reversed, length);
+  }
+
+  /**
+   * Writes the remaining bits, padded with zeros to a full byte.
+   */
+  void flush() {
+    if (this->number_of_bits > 0) {
+      this->output.push_back((char)(this->buffer & 0xff));
+    }
+    this->buffer = 0;
+    this->number_of_bits = 0;
+  }
+
+ private:
+  std::string &output;
+  uint64_t buffer = 0;
+  int number_of_bits = 0;
+};
+
+/**
+ * Writes the passed literal/length symbol using the fixed Huffman
+ * code of deflate.
+ */
+void write_fixed_symbol(BitWriter &writer, int symbol) {
+  if (symbol < 144) {
+    writer.write_code(0x30 + symbol, 8);
+  } else if (symbol < 256) {
+    writer.write_code(0x190 + symbol - 144, 9);
+  } else if (symbol < 280) {
+    writer.write_code(symbol - 256, 7);
+  } else {
+    writer.write_code(0xc0 + symbol - 280, 8);
+  }
+}
+
+/**
+ * Writes a reference to the preceding byte that is repeated
+ * length times (3 <= length <= 258).
+ */
+void write_run(BitWriter &writer, int length) {
+  int index = 28;
+  while (length_bases[index] > length) {
+    --index;
+  }
+
+  write_fixed_symbol(writer, 257 + index);
+  writer.write(length - length_bases[index], length_extra_bits[index]);
+
+  /**
+   * The distance 1 has the 5 bit code 0 and no extra bits.
+   */
+  writer.write_code(0, 5);
+}
+
+/**
+ * Compresses the data into a zlib stream that consists of a single
+ * deflate block with fixed Huffman codes.
+ */
+void compress(const std::vector<uint8_t> &data, std::string &output) {
+  /**
+   * Deflate with a 32K window and the fastest compression level.
+   */
+  output.push_back((char)0x78);
+  output.push_back((char)0x01);
+
+  BitWriter writer(output);
+
+  /**
+   * The header of the final block, which uses the fixed codes.
+   */
+  writer.write(1, 1);
+  writer.write(1, 2);
+
+  size_t index = 0;
+  while (index < data.size()) {
+    int length = 0;
+    if (index > 0) {
+      const size_t end =
+          std::min(data.size(), index + (size_t)maximum_run_length);
+      while (index + length < end && data[index + length] == data[index - 1]) {
+        ++length;
+      }
+    }
+
+    if (length >= 3) {
+      write_run(writer, length);
+      index += length;
+    } else {
+      write_fixed_symbol(writer, data[index]);
+      ++index;
+    }
+  }
+
+  write_fixed_symbol(writer, 256);
+  writer.flush();
+
+  append_big_endian(output, adler32(data.data(), data.size()));
+}
+
+}  // namespace
+
+void PNGWriter::write_grayscale(std::ostream &stream, int width, int height,
+                                const uint8_t *pixels) {
+  stream.write(png_signature, sizeof(png_signature));
+
+  /**
+   * 8 bit grayscale, without interlacing.
+   */
+  std::string header;
+  append_big_endian(header, width);
+  append_big_endian(header, height);
+  header.push_back((char)8);
+  header.push_back((char)0);
+  header.push_back((char)0);
+  header.push_back((char)0);
+  header.push_back((char)0);
+  write_chunk(stream, "IHDR", header.data(), header.size());
+
+  /**
+   * Each row starts with its filter type, which is always 0 (none).
+   */
+  std::vector<uint8_t> rows;
+  rows.reserve((size_t)height * (width + 1));
+  for (int row = 0; row < height; ++row) {
+    rows.push_back(0);
+    rows.insert(rows.end(), pixels + (size_t)row * width,
+                pixels + (size_t)(row + 1) * width);
+  }
+
+  std::string data;
+  compress(rows, data);
+  rows = std::vector<uint8_t>();
+
+  for (size_t position = 0; position < data.size();
+       position += maximum_chunk_size) {
+    write_chunk(stream, "IDAT", data.data() + position,
+                std::min(maximum_chunk_size, data.size() - position));
+  }
+
+  write_chunk(stream, "IEND", nullptr, 0);
+}
+
+}  // namespace hydra
@@ -11,8 +11,6 @@ namespace hydra {
 
 Pol::Pol(double r, double phi) : r(r), phi(phi) { normalize_phi(); }
 
-Pol::Pol(const Pol &p) : r(p.r), phi(p.phi) { normalize_phi(); }
-
 void Pol::normalize_phi() {
   while (this->phi < 0.0) {
     this->phi += 2.0 * M_PI;
@@ -91,7 +89,7 @@ void Pol::translate_horizontally_by(const double distance) {
     } catch (std::domain_error &de) {
     }
 
-    if (isnan(angular_coordinate)) {
+    if (std::isnan(angular_coordinate)) {
       angular_coordinate = 0.0;
     }
 
@@ -164,4 +162,28 @@ double Pol::theta(double r_1, double r_2, double R) {
 
   return -1.0;
 }
+
+void CachedPol::distances(const CachedPol &from, const double *r,
+                          const double *phi, size_t size, double *distances) {
+  for (size_t index = 0; index < size; ++index) {
+    Pol point;
+    point.r = r[index];
+    point.phi = phi[index];
+    distances[index] = from.distance_to(point);
+  }
+}
+
+void CachedPol::pairs_within(const std::vector<CachedPol> &points,
+                             double distance,
+                             std::vector<std::pair<int, int>> &pairs) {
+  const double cosh_distance = cosh(distance);
+  for (int first = 0; first < (int)points.size(); ++first) {
+    const CachedPol &point = points[first];
+    for (int second = first + 1; second < (int)points.size(); ++second) {
+      if (point.is_within(points[second], cosh_distance)) {
+        pairs.push_back(std::make_pair(first, second));
+      }
+    }
+  }
+}
 }  // namespace hydra
@@ -0,0 +1,214 @@
+//
+//  profiler.cpp
+//  hydra
+//
+
+#include <profiler.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace hydra {
+
+Profiler::Profiler() : start(Clock::now()) {
+  /**
+   * The root of all stacks.
+   */
+  this->stacks.push_back({-1, -1});
+}
+
+void Profiler::enter_line(int line_number) {
+  if (line_number < 0) {
+    line_number = 0;
+  }
+
+  if (line_number >= (int)this->entries_for_lines.size()) {
+    this->entries_for_lines.resize(line_number + 1, -1);
+  }
+
+  int &entry = this->entries_for_lines[line_number];
+  if (entry < 0) {
+    entry = this->entries.size();
+    this->entries.push_back(Entry());
+    this->entries.back().kind = Kind::Line;
+    this->entries.back().name = std::to_string(line_number);
+  }
+
+  enter_entry(entry);
+}
+
+void Profiler::enter(Kind kind, std::string_view name) {
+  std::map<std::string, int, std::less<>> &entries_for_names =
+      this->entries_for_names[(int)kind];
+
+  std::map<std::string, int, std::less<>>::const_iterator position_of_entry =
+      entries_for_names.find(name);
+
+  int entry;
+  if (position_of_entry != entries_for_names.end()) {
+    entry = position_of_entry->second;
+  } else {
+    entry = this->entries.size();
+    this->entries.push_back(Entry());
+    this->entries.back().kind = kind;
+    this->entries.back().name = std::string(name);
+    entries_for_names.emplace(std::string(name), entry);
+  }
+
+  enter_entry(entry);
+}
+
+void Profiler::enter_entry(int entry) {
+  const int parent = this->frames.empty() ? 0 : this->frames.back().stack;
+
+  std::map<std::pair<int, int>, int>::const_iterator position_of_stack =
+      this->stacks_for_children.find({parent, entry});
+
+  int stack;
+  if (position_of_stack != this->stacks_for_children.end()) {
+    stack = position_of_stack->second;
+  } else {
+    stack = this->stacks.size();
+    this->stacks.push_back({parent, entry});
+    this->stacks_for_children[{parent, entry}] = stack;
+  }
+
+  ++this->entries[entry].calls;
+  ++this->entries[entry].active;
+
+  Frame frame;
+  frame.entry = entry;
+  frame.stack = stack;
+  frame.start = Clock::now();
+  this->frames.push_back(frame);
+}
+
+void Profiler::leave() {
+  if (this->frames.empty()) {
+    return;
+  }
+
+  const Frame frame = this->frames.back();
+  this->frames.pop_back();
+
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - frame.start).count();
+  const double exclusive_seconds = seconds - frame.child_seconds;
+
+  Entry &entry = this->entries[frame.entry];
+  if (--entry.active == 0) {
+    entry.inclusive_seconds += seconds;
+  }
+  entry.exclusive_seconds += exclusive_seconds;
+  this->stacks[frame.stack].exclusive_seconds += exclusive_seconds;
+
+  if (!this->frames.empty()) {
+    this->frames.back().child_seconds += seconds;
+  }
+}
+
+void Profiler::print_hotspots(std::ostream &stream, int number_of_rows) const {
+  const double total_seconds =
+      std::chrono::duration<double>(Clock::now() - this->start).count();
+
+  std::vector<const Entry *> sorted_entries;
+  for (const Entry &entry : this->entries) {
+    sorted_entries.push_back(&entry);
+  }
+  std::sort(sorted_entries.begin(), sorted_entries.end(),
+            [](const Entry *first, const Entry *second) {
+              return first->exclusive_seconds > second->exclusive_seconds;
+            });
+
+  const std::ios_base::fmtflags flags = stream.flags();
+  const std::streamsize precision = stream.precision();
+
+  stream << "Profile (total " << std::fixed << std::setprecision(3)
+         << total_seconds << "s):\n"
+         << std::left << std::setw(32) << "  entry" << std::right
+         << std::setw(12) << "calls" << std::setw(14) << "inclusive ms"
+         << std::setw(14) << "exclusive ms" << std::setw(10) << "%"
+         << "\n";
+
+  for (int row = 0;
+       row < number_of_rows && row < (int)sorted_entries.size(); ++row) {
+    const Entry &entry = *sorted_entries[row];
+    std::string name = name_of_kind(entry.kind) + " " + entry.name;
+    if (name.size() > 29) {
+      name = name.substr(0, 26) + "...";
+    }
+
+    stream << "  " << std::left << std::setw(30) << name << std::right
+           << std::setw(12) << entry.calls << std::setw(14)
+           << std::setprecision(3) << 1e3 * entry.inclusive_seconds
+           << std::setw(14) << 1e3 * entry.exclusive_seconds << std::setw(10)
+           << std::setprecision(1)
+           << (total_seconds > 0.0
+                   ? 100.0 * entry.exclusive_seconds / total_seconds
+                   : 0.0)
+           << "\n";
+  }
+
+  stream.flags(flags);
+  stream.precision(precision);
+  stream << std::flush;
+}
+
+bool Profiler::write_folded_stacks(const std::string &file_name) const {
+  std::ofstream file(file_name);
+  if (!file.good()) {
+    return false;
+  }
+
+  /**
+   * Spaces and semicolons separate the parts of a line, so they are
+   * replaced in the names.
+   */
+  std::vector<std::string> names;
+  for (const Entry &entry : this->entries) {
+    std::string name = name_of_kind(entry.kind) + ":" + entry.name;
+    std::replace(name.begin(), name.end(), ' ', '_');
+    std::replace(name.begin(), name.end(), ';', '_');
+    names.push_back(name);
+  }
+
+  std::vector<int> path;
+  for (int stack = 1; stack < (int)this->stacks.size(); ++stack) {
+    const long long microseconds =
+        std::llround(this->stacks[stack].exclusive_seconds * 1e6);
+    if (microseconds <= 0) {
+      continue;
+    }
+
+    path.clear();
+    for (int node = stack; node > 0; node = this->stacks[node].parent) {
+      path.push_back(this->stacks[node].entry);
+    }
+
+    for (int index = path.size() - 1; index >= 0; --index) {
+      file << names[path[index]] << (index > 0 ? ";" : " ");
+    }
+    file << microseconds << "\n";
+  }
+
+  return file.good();
+}
+
+std::string Profiler::name_of_kind(Kind kind) {
+  switch (kind) {
+    case Kind::Line:
+      return "line";
+    case Kind::Builtin:
+      return "builtin";
+    case Kind::Function:
+      return "function";
+    case Kind::Export:
+      return "export";
+  }
+
+  return "";
+}
+
+}  // namespace hydra
@@ -0,0 +1,273 @@
+//
+//  program_cache.cpp
+//  hydra
+//
+
+#include <program_cache.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+#include <glog/logging.h>
+
+namespace hydra {
+
+namespace {
+
+const char magic[8] = {'h', 'y', 'd', 'r', 'a', 'c', '\n', '\0'};
+
+/**
+ * Identifies the build of hydra that wrote a cache, such that a
+ * rebuilt parser never uses the parse results of an old one.  The
+ * Makefile derives HYDRA_BUILD_ID from all sources of hydra (and
+ * recompiles this file whenever one of them changes).  Builds without
+ * it fall back to the time this file was compiled.
+ */
+#ifdef HYDRA_BUILD_ID
+const std::string build =
+    std::to_string(ProgramCache::format_version) + " " + HYDRA_BUILD_ID;
+#else
+const std::string build = std::to_string(ProgramCache::format_version) +
+                          " " + __DATE__ + " " + __TIME__;
+#endif
+
+struct Header {
+  uint32_t format_version;
+  uint32_t build_size;
+  uint64_t code_hash;
+  uint64_t number_of_results;
+  uint64_t number_of_statements;
+  uint64_t strings_size;
+};
+
+/**
+ * A parse result in the file.  Its value is a range in the strings
+ * that follow the results.
+ */
+struct Record {
+  int32_t type;
+  int32_t line_number;
+  uint32_t value_offset;
+  uint32_t value_size;
+  uint32_t first_child;
+  uint32_t number_of_children;
+};
+
+/**
+ * Reads a value of type T from the data at position and advances
+ * the position.  Returns false if the data is too short.
+ */
+template <typename T>
+bool read(std::string_view data, size_t &position, T &value) {
+  if (data.size() - position < sizeof(T)) {
+    return false;
+  }
+
+  std::memcpy(&value, data.data() + position, sizeof(T));
+  position += sizeof(T);
+  return true;
+}
+
+}  // namespace
+
+std::string ProgramCache::file_name_for_code(const std::string &file_name) {
+  const std::string extension = ".hydra";
+  if (file_name.size() >= extension.size() &&
+      file_name.compare(file_name.size() - extension.size(),
+                        extension.size(), extension) == 0) {
+    return file_name + "c";
+  }
+
+  return file_name + ".hydrac";
+}
+
+uint64_t ProgramCache::hash_of_code(std::string_view code) {
+  /**
+   * 64 bit FNV-1a.
+   */
+  uint64_t hash = 14695981039346656037ull;
+  for (char character : code) {
+    hash ^= (unsigned char)character;
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+bool ProgramCache::save(const std::string &file_name, uint64_t code_hash,
+                        const std::vector<ParseResult> &code) {
+  /**
+   * The results are stored breadth first, such that the children of
+   * each result are consecutive.  The top level statements come
+   * first.
+   */
+  std::vector<const ParseResult *> results;
+  results.reserve(code.size());
+  for (const ParseResult &statement : code) {
+    results.push_back(&statement);
+  }
+
+  std::vector<Record> records;
+  std::string strings;
+  std::unordered_map<std::string_view, uint32_t> offsets_for_values;
+
+  for (size_t index = 0; index < results.size(); ++index) {
+    const ParseResult &result = *results[index];
+
+    /**
+     * Values such as the names of functions and arguments are
+     * repeated a lot, so each is stored only once.
+     */
+    std::unordered_map<std::string_view, uint32_t>::const_iterator
+        position_of_value = offsets_for_values.find(result.value);
+    uint32_t value_offset;
+    if (position_of_value != offsets_for_values.end()) {
+      value_offset = position_of_value->second;
+    } else {
+      if (strings.size() + result.value.size() >
+          std::numeric_limits<uint32_t>::max()) {
+        return false;
+      }
+
+      value_offset = strings.size();
+      strings.append(result.value);
+      offsets_for_values[result.value] = value_offset;
+    }
+
+    if (results.size() + result.children.size() >
+        std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+
+    Record record;
+    record.type = result.type;
+    record.line_number = result.line_number;
+    record.value_offset = value_offset;
+    record.value_size = result.value.size();
+    record.first_child = results.size();
+    record.number_of_children = result.children.size();
+    records.push_back(record);
+
+    for (const ParseResult &child : result.children) {
+      results.push_back(&child);
+    }
+  }
+
+  Header header;
+  header.format_version = ProgramCache::format_version;
+  header.build_size = build.size();
+  header.code_hash = code_hash;
+  header.number_of_results = records.size();
+  header.number_of_statements = code.size();
+  header.strings_size = strings.size();
+
+  /**
+   * The file is written under a temporary name first, such that a
+   * run that reads the cache at the same time never sees half of it.
+   */
+  const std::string temporary_file_name = file_name + ".tmp";
+  {
+    std::ofstream file(temporary_file_name,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.good()) {
+      return false;
+    }
+
+    file.write(magic, sizeof(magic));
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(build.data(), build.size());
+    file.write(reinterpret_cast<const char *>(records.data()),
+               records.size() * sizeof(Record));
+    file.write(strings.data(), strings.size());
+
+    if (!file.good()) {
+      file.close();
+      std::remove(temporary_file_name.c_str());
+      return false;
+    }
+  }
+
+  return std::rename(temporary_file_name.c_str(), file_name.c_str()) == 0;
+}
+
+bool ProgramCache::load(const std::string &file_name, uint64_t code_hash,
+                        std::vector<ParseResult> &code) {
+  this->results.clear();
+  this->file.reset(new MappedFile(file_name));
+  if (!this->file->is_open()) {
+    return false;
+  }
+
+  const std::string_view data = this->file->contents();
+  size_t position = 0;
+
+  char file_magic[sizeof(magic)];
+  Header header;
+  if (!read(data, position, file_magic) ||
+      std::memcmp(file_magic, magic, sizeof(magic)) != 0 ||
+      !read(data, position, header) ||
+      header.format_version != ProgramCache::format_version ||
+      header.code_hash != code_hash || header.build_size != build.size() ||
+      data.substr(position, build.size()) != build) {
+    DLOG(INFO) << "The cache '" << file_name << "' is stale." << std::endl;
+    return false;
+  }
+  position += build.size();
+
+  /**
+   * The remaining size is checked before anything is allocated, such
+   * that a corrupt header cannot request arbitrary amounts of memory.
+   */
+  const size_t remaining_size = data.size() - position;
+  if (header.number_of_results > remaining_size / sizeof(Record) ||
+      header.number_of_results * sizeof(Record) + header.strings_size !=
+          remaining_size ||
+      header.number_of_statements > header.number_of_results) {
+    return false;
+  }
+
+  const std::string_view strings =
+      data.substr(position + header.number_of_results * sizeof(Record));
+
+  this->results.resize(header.number_of_results);
+  for (size_t index = 0; index < this->results.size(); ++index) {
+    ParseResult &result = this->results[index];
+    Record record;
+    read(data, position, record);
+
+    /**
+     * The children were stored after their parent, so children that
+     * precede it (which could make a parse result its own descendant)
+     * or lie outside of the results mean that the file is corrupt.
+     */
+    if (record.type < Argument || record.type > Variable ||
+        (uint64_t)record.value_offset + record.value_size >
+            strings.size() ||
+        (uint64_t)record.first_child + record.number_of_children >
+            header.number_of_results ||
+        (record.number_of_children > 0 && record.first_child <= index)) {
+      DLOG(INFO) << "The cache '" << file_name << "' is corrupt."
+                 << std::endl;
+      this->results.clear();
+      return false;
+    }
+
+    result.type = (Type)record.type;
+    result.line_number = record.line_number;
+    result.value = strings.substr(record.value_offset, record.value_size);
+    if (record.number_of_children > 0) {
+      result.children = Span<ParseResult>(
+          this->results.data() + record.first_child,
+          record.number_of_children);
+    }
+  }
+
+  code.insert(code.end(), this->results.begin(),
+              this->results.begin() + header.number_of_statements);
+  return true;
+}
+
+}  // namespace hydra
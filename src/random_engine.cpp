@@ -0,0 +1,50 @@
+//
+//  random_engine.cpp
+//  hydra
+//
+
+#include <random_engine.hpp>
+
+#include <cmath>
+
+namespace hydra {
+
+RandomEngine::RandomEngine() {
+  std::random_device random_device;
+  seed((uint64_t(random_device()) << 32) | random_device());
+}
+
+void RandomEngine::seed(uint64_t seed) { this->engine.seed(seed); }
+
+void RandomEngine::seed(uint64_t seed, uint64_t stream) {
+  std::seed_seq sequence = {uint32_t(seed), uint32_t(seed >> 32),
+                            uint32_t(stream), uint32_t(stream >> 32)};
+  this->engine.seed(sequence);
+}
+
+void RandomEngine::fill_uniform(double from, double to, double *values,
+                                size_t count) {
+  for (size_t index = 0; index < count; ++index) {
+    values[index] = uniform(from, to);
+  }
+}
+
+void RandomEngine::fill_angles(double *values, size_t count) {
+  fill_uniform(0.0, 2.0 * M_PI, values, count);
+}
+
+void RandomEngine::fill_radii(double R, double alpha, double *values,
+                              size_t count) {
+  /**
+   * Draw the uniform samples first, such that the transformation is a
+   * separate loop, which the compiler can vectorize.
+   */
+  fill_uniform(0.0, 1.0, values, count);
+
+  const double scale = cosh(alpha * R) - 1.0;
+  for (size_t index = 0; index < count; ++index) {
+    values[index] = acosh(1.0 + scale * values[index]) / alpha;
+  }
+}
+
+}  // namespace hydra
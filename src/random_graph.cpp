@@ -0,0 +1,295 @@
+//
+//  random_graph.cpp
+//  hydra
+//
+
+#include <random_graph.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace hydra {
+
+void RandomGraph::generate(RandomEngine &engine) {
+  this->points.clear();
+  this->edges.clear();
+
+  if (this->n <= 0) {
+    return;
+  }
+
+  sample_points(engine);
+  build_bands();
+
+  for (int u = 0; u < this->n; ++u) {
+    /**
+     * Pairs with vertices in inner bands have already been decided by
+     * these vertices.
+     */
+    for (int band = this->band_of_vertex[u]; band < (int)this->bands.size();
+         ++band) {
+      if (this->T > 0.0) {
+        add_probabilistic_edges(u, this->bands[band], engine);
+      } else {
+        add_threshold_edges(u, this->bands[band]);
+      }
+    }
+  }
+}
+
+void RandomGraph::sample_points(RandomEngine &engine) {
+  std::vector<double> r(this->n);
+  std::vector<double> phi(this->n);
+  engine.fill_angles(phi.data(), this->n);
+  engine.fill_radii(this->R, this->alpha, r.data(), this->n);
+
+  this->points.resize(this->n);
+  this->cached_points.resize(this->n);
+  for (int vertex = 0; vertex < this->n; ++vertex) {
+    this->points[vertex] = Pol(r[vertex], phi[vertex]);
+    this->cached_points[vertex] = CachedPol(this->points[vertex]);
+  }
+}
+
+void RandomGraph::build_bands() {
+  /**
+   * Most vertices are close to the boundary of the disk, so the bands
+   * become narrower towards the boundary.  Their widths form a
+   * geometric series, whose sum is R.
+   */
+  const int number_of_bands =
+      std::max(1, (int)std::ceil(std::log((double)this->n)));
+  const double ratio = 0.9;
+  const double total = (1.0 - std::pow(ratio, number_of_bands)) / (1.0 - ratio);
+
+  this->bands.assign(number_of_bands, Band());
+  double inner_radius = 0.0;
+  for (int band = 0; band < number_of_bands; ++band) {
+    this->bands[band].inner_radius = inner_radius;
+    inner_radius += this->R * std::pow(ratio, band) / total;
+    this->bands[band].outer_radius = inner_radius;
+  }
+  this->bands.back().outer_radius = this->R;
+
+  /**
+   * Distribute the vertices among the bands.
+   */
+  this->band_of_vertex.resize(this->n);
+  for (int vertex = 0; vertex < this->n; ++vertex) {
+    const double r = this->points[vertex].r;
+    int band = number_of_bands - 1;
+    while (band > 0 && r < this->bands[band].inner_radius) {
+      --band;
+    }
+    this->band_of_vertex[vertex] = band;
+    this->bands[band].vertices.push_back(vertex);
+  }
+
+  /**
+   * Sort the vertices in each band by angle.
+   */
+  this->position_in_band.resize(this->n);
+  for (Band &band : this->bands) {
+    std::sort(band.vertices.begin(), band.vertices.end(),
+              [this](int u, int v) {
+                return this->points[u].phi < this->points[v].phi;
+              });
+
+    band.angles.resize(band.vertices.size());
+    for (int position = 0; position < (int)band.vertices.size(); ++position) {
+      band.angles[position] = this->points[band.vertices[position]].phi;
+      this->position_in_band[band.vertices[position]] = position;
+    }
+  }
+}
+
+void RandomGraph::add_threshold_edges(int u, const Band &band) {
+  const double r = this->points[u].r;
+  const double phi = this->points[u].phi;
+
+  /**
+   * If theta cannot be computed, the vertices in the band may be on
+   * either side of the disk.
+   */
+  double theta = M_PI;
+  if (r + band.inner_radius > this->R) {
+    theta = Pol::theta(r, band.inner_radius, this->R);
+    if (!(theta >= 0.0 && theta <= M_PI)) {
+      theta = M_PI;
+    }
+  }
+
+  std::vector<Range> ranges;
+  append_ranges(band, phi - theta, phi + theta, ranges);
+
+  const double cosh_R = cosh(this->R);
+  for (const Range &range : ranges) {
+    for (int position = range.first; position < range.second; ++position) {
+      const int v = band.vertices[position];
+      if (comes_before(u, v) &&
+          this->cached_points[u].is_within(this->cached_points[v], cosh_R)) {
+        this->edges.push_back(std::make_pair(u, v));
+      }
+    }
+  }
+}
+
+void RandomGraph::add_probabilistic_edges(int u, const Band &band,
+                                          RandomEngine &engine) {
+  const double r = this->points[u].r;
+  const double phi = this->points[u].phi;
+
+  /**
+   * The first segment contains the vertices that would be adjacent for
+   * T = 0.  The following segments cover the angular distances from
+   * the end of the previous segment to twice that distance.
+   */
+  double width = M_PI;
+  if (r + band.inner_radius > this->R) {
+    width = Pol::theta(r, band.inner_radius, this->R);
+    if (!(width > 0.0 && width <= M_PI)) {
+      width = M_PI;
+    }
+  }
+
+  std::vector<Range> ranges;
+  double from = 0.0;
+  while (from < M_PI) {
+    const double to = std::min(M_PI, from + width);
+
+    /**
+     * Elsewhere in the segment the probability can only be smaller.
+     */
+    const double bound =
+        connection_probability(minimum_distance(u, band, from));
+
+    ranges.clear();
+    if (from == 0.0) {
+      append_ranges(band, phi - to, phi + to, ranges);
+    } else {
+      append_ranges(band, phi + from, phi + to, ranges);
+      append_ranges(band, phi - to, phi - from, ranges);
+    }
+
+    if (bound > 0.0) {
+      /**
+       * Every candidate in the segment is considered with probability
+       * bound, which means that the gaps between the considered
+       * candidates are geometrically distributed.  A considered
+       * candidate is adjacent with probability p(d) / bound.
+       */
+      const double log_of_miss = std::log1p(-bound);
+      int range = 0;
+      int position = ranges.empty() ? 0 : ranges[0].first - 1;
+      while (range < (int)ranges.size()) {
+        int skip = 0;
+        if (bound < 1.0) {
+          const double gap = std::floor(std::log(1.0 - engine.uniform()) /
+                                        log_of_miss);
+          skip = gap < (double)band.vertices.size() ? (int)gap
+                                                    : band.vertices.size();
+        }
+        position += 1 + skip;
+
+        while (range < (int)ranges.size() &&
+               position >= ranges[range].second) {
+          const int overshoot = position - ranges[range].second;
+          ++range;
+          if (range < (int)ranges.size()) {
+            position = ranges[range].first + overshoot;
+          }
+        }
+        if (range == (int)ranges.size()) {
+          break;
+        }
+
+        const int v = band.vertices[position];
+        if (!comes_before(u, v)) {
+          continue;
+        }
+
+        const double distance = acosh(std::max(1.0, cosh_distance(u, v)));
+        if (engine.uniform() * bound < connection_probability(distance)) {
+          this->edges.push_back(std::make_pair(u, v));
+        }
+      }
+    }
+
+    from = to;
+    width = to;
+  }
+}
+
+void RandomGraph::append_ranges(const Band &band, double from, double to,
+                                std::vector<Range> &ranges) {
+  if (from < 0.0) {
+    from += 2.0 * M_PI;
+    to += 2.0 * M_PI;
+  } else if (from >= 2.0 * M_PI) {
+    from -= 2.0 * M_PI;
+    to -= 2.0 * M_PI;
+  }
+
+  const std::vector<double> &angles = band.angles;
+  const int begin =
+      std::lower_bound(angles.begin(), angles.end(), from) - angles.begin();
+
+  if (to <= 2.0 * M_PI) {
+    const int end =
+        std::lower_bound(angles.begin(), angles.end(), to) - angles.begin();
+    if (begin < end) {
+      ranges.push_back(Range(begin, end));
+    }
+    return;
+  }
+
+  /**
+   * The interval contains the angle 0.
+   */
+  const int end = std::lower_bound(angles.begin(), angles.end(),
+                                   to - 2.0 * M_PI) -
+                  angles.begin();
+  if (begin < (int)angles.size()) {
+    ranges.push_back(Range(begin, angles.size()));
+  }
+  if (0 < end) {
+    ranges.push_back(Range(0, end));
+  }
+}
+
+bool RandomGraph::comes_before(int u, int v) const {
+  if (this->band_of_vertex[u] != this->band_of_vertex[v]) {
+    return this->band_of_vertex[u] < this->band_of_vertex[v];
+  }
+  return this->position_in_band[u] < this->position_in_band[v];
+}
+
+double RandomGraph::cosh_distance(int u, int v) const {
+  return this->cached_points[u].cosh_distance_to(this->cached_points[v]);
+}
+
+double RandomGraph::minimum_distance(int u, const Band &band,
+                                     double angle) const {
+  /**
+   * For a fixed angular distance, the distance to u decreases until
+   * the radius for which tanh(r) = tanh(r_u) / cos(angle) and increases
+   * afterwards.
+   */
+  const double r_u = this->points[u].r;
+  const double cos_angle = cos(angle);
+  double r = band.inner_radius;
+  if (cos_angle > 0.0 && tanh(r_u) < cos_angle) {
+    r = std::min(std::max(atanh(tanh(r_u) / cos_angle), band.inner_radius),
+                 band.outer_radius);
+  }
+
+  const CachedPol &point = this->cached_points[u];
+  return acosh(std::max(
+      1.0, point.cosh_r * cosh(r) - point.sinh_r * sinh(r) * cos_angle));
+}
+
+double RandomGraph::connection_probability(double distance) const {
+  return 1.0 / (1.0 + std::exp((distance - this->R) / (2.0 * this->T)));
+}
+
+}  // namespace hydra
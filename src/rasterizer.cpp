@@ -0,0 +1,181 @@
+//
+//  rasterizer.cpp
+//  hydra
+//
+
+#include <rasterizer.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace hydra {
+
+namespace {
+
+/**
+ * The distance between the point (x, y) and the segment of the
+ * stroke.
+ */
+double distance_to_stroke(const Stroke &stroke, double x, double y) {
+  const double dx = stroke.x1 - stroke.x0;
+  const double dy = stroke.y1 - stroke.y0;
+  const double squared_length = dx * dx + dy * dy;
+
+  double t = 0.0;
+  if (squared_length > 0.0) {
+    t = ((x - stroke.x0) * dx + (y - stroke.y0) * dy) / squared_length;
+    t = std::max(0.0, std::min(1.0, t));
+  }
+
+  const double distance_x = x - (stroke.x0 + t * dx);
+  const double distance_y = y - (stroke.y0 + t * dy);
+  return std::sqrt(distance_x * distance_x + distance_y * distance_y);
+}
+
+/**
+ * The bounding box of the stroke, in pixels, with one pixel of margin
+ * for the anti-aliasing.
+ */
+void bounding_box(const Stroke &stroke, double &min_x, double &min_y,
+                  double &max_x, double &max_y) {
+  const double margin = stroke.outer_radius + 1.0;
+  min_x = std::min(stroke.x0, stroke.x1) - margin;
+  min_y = std::min(stroke.y0, stroke.y1) - margin;
+  max_x = std::max(stroke.x0, stroke.x1) + margin;
+  max_y = std::max(stroke.y0, stroke.y1) + margin;
+}
+
+}  // namespace
+
+Rasterizer::Rasterizer(int width, int height, ThreadPool &thread_pool)
+    : width(width), height(height), thread_pool(thread_pool) {
+  this->pixels.assign((size_t)width * height, 255);
+  this->columns_of_tiles = (width + tile_size - 1) / tile_size;
+  this->rows_of_tiles = (height + tile_size - 1) / tile_size;
+}
+
+void Rasterizer::draw(const std::vector<std::vector<Stroke>> &batches) {
+  const int number_of_tiles = this->columns_of_tiles * this->rows_of_tiles;
+
+  if (this->bins.size() < batches.size()) {
+    this->bins.resize(batches.size());
+  }
+
+  this->thread_pool.parallel_for(batches.size(), [&](int batch) {
+    std::vector<std::vector<uint32_t>> &bins = this->bins[batch];
+    bins.resize(number_of_tiles);
+    for (std::vector<uint32_t> &bin : bins) {
+      bin.clear();
+    }
+
+    this->bin(batches[batch], bins);
+  });
+
+  this->thread_pool.parallel_for(
+      number_of_tiles, [&](int tile) { this->draw_tile(tile, batches); });
+}
+
+void Rasterizer::bin(const std::vector<Stroke> &strokes,
+                     std::vector<std::vector<uint32_t>> &bins) const {
+  /**
+   * The distance between the center of a tile and its corners.
+   */
+  const double tile_radius = tile_size * M_SQRT1_2;
+
+  for (uint32_t index = 0; index < strokes.size(); ++index) {
+    const Stroke &stroke = strokes[index];
+
+    double min_x, min_y, max_x, max_y;
+    bounding_box(stroke, min_x, min_y, max_x, max_y);
+
+    /**
+     * Strokes with invalid coordinates and strokes that are outside
+     * of the image are skipped.
+     */
+    if (!(std::isfinite(min_x) && std::isfinite(min_y) &&
+          std::isfinite(max_x) && std::isfinite(max_y)) ||
+        max_x < 0.0 || max_y < 0.0 || min_x >= this->width ||
+        min_y >= this->height) {
+      continue;
+    }
+
+    const int first_column = std::max(0.0, min_x) / tile_size;
+    const int first_row = std::max(0.0, min_y) / tile_size;
+    const int last_column = std::min(max_x, this->width - 1.0) / tile_size;
+    const int last_row = std::min(max_y, this->height - 1.0) / tile_size;
+
+    /**
+     * A long diagonal stroke passes only few of the tiles of its
+     * bounding box, so the tiles are tested individually.
+     */
+    const bool test_tiles =
+        first_column != last_column && first_row != last_row;
+
+    for (int row = first_row; row <= last_row; ++row) {
+      for (int column = first_column; column <= last_column; ++column) {
+        if (test_tiles &&
+            distance_to_stroke(stroke, (column + 0.5) * tile_size,
+                               (row + 0.5) * tile_size) >
+                tile_radius + stroke.outer_radius + 1.0) {
+          continue;
+        }
+
+        bins[row * this->columns_of_tiles + column].push_back(index);
+      }
+    }
+  }
+}
+
+void Rasterizer::draw_tile(int tile,
+                           const std::vector<std::vector<Stroke>> &batches) {
+  const int tile_x = (tile % this->columns_of_tiles) * tile_size;
+  const int tile_y = (tile / this->columns_of_tiles) * tile_size;
+  const int tile_end_x = std::min(tile_x + tile_size, this->width);
+  const int tile_end_y = std::min(tile_y + tile_size, this->height);
+
+  for (size_t batch = 0; batch < batches.size(); ++batch) {
+    for (uint32_t index : this->bins[batch][tile]) {
+      const Stroke &stroke = batches[batch][index];
+
+      double min_x, min_y, max_x, max_y;
+      bounding_box(stroke, min_x, min_y, max_x, max_y);
+
+      const int start_x = std::max((double)tile_x, std::floor(min_x));
+      const int start_y = std::max((double)tile_y, std::floor(min_y));
+      const int end_x = std::min((double)tile_end_x, std::ceil(max_x));
+      const int end_y = std::min((double)tile_end_y, std::ceil(max_y));
+
+      for (int y = start_y; y < end_y; ++y) {
+        uint8_t *row = this->pixels.data() + (size_t)y * this->width;
+        for (int x = start_x; x < end_x; ++x) {
+          /**
+           * Black pixels cannot get any darker.
+           */
+          if (row[x] == 0) {
+            continue;
+          }
+
+          /**
+           * The coverage of a pixel is approximated by the part of
+           * the pixel-wide interval around its distance that lies
+           * between the radii of the stroke.  This is exact for long
+           * straight strokes and also handles strokes that are
+           * thinner than a pixel.
+           */
+          const double distance = distance_to_stroke(stroke, x + 0.5, y + 0.5);
+          const double coverage =
+              std::min(distance + 0.5, stroke.outer_radius) -
+              std::max(distance - 0.5, stroke.inner_radius);
+
+          if (coverage > 0.0) {
+            const uint8_t shade =
+                255 - (uint8_t)std::lround(std::min(coverage, 1.0) * 255.0);
+            row[x] = std::min(row[x], shade);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace hydra
@@ -0,0 +1,497 @@
+//
+//  resolver.cpp
+//  hydra
+//
+
+#include <resolver.hpp>
+
+#include <optimizer.hpp>
+
+namespace hydra {
+
+Resolver::Resolver(System &system) : system(system) {}
+
+bool Resolver::resolve_code(std::vector<ParseResult> &code) {
+  /**
+   * At the top level, the first scope represents the global
+   * variables.
+   */
+  this->scopes = {std::unordered_map<std::string, int>()};
+  this->is_in_function = false;
+  this->next_free_slot = 0;
+  this->number_of_slots = 0;
+  this->defined_globals.clear();
+  this->defined_functions.clear();
+  this->parallel_loop_scope = -1;
+  this->changes_shared_state = false;
+  this->is_pure = true;
+  this->function_name.clear();
+
+  for (ParseResult &statement : code) {
+    if (!resolve_parse_result(statement)) {
+      return false;
+    }
+  }
+
+  /**
+   * Variables that are defined in top level loops live in the top
+   * level frame, as do the values of calls that the optimizer hoists
+   * out of top level loops.
+   */
+  Optimizer optimizer(this->system);
+  optimizer.optimize_code(code, this->number_of_slots);
+  return true;
+}
+
+bool Resolver::resolve_parse_result(ParseResult &input) {
+  switch (input.type) {
+    case Assignment:
+      return resolve_assignment(input);
+    case Function:
+      return resolve_function(input);
+    case FunctionDefinition:
+      return resolve_function_definition(input);
+    case Loop:
+      return resolve_loop(input);
+    case Unknown:
+      /**
+       * An Unknown without children is assumed to be a variable.
+       */
+      if (input.children.empty()) {
+        resolve_variable(input);
+        return true;
+      }
+      break;
+    case Variable:
+      resolve_variable(input);
+      return true;
+    default:
+      break;
+  }
+
+  for (ParseResult &child : input.children) {
+    if (!resolve_parse_result(child)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Resolver::resolve_assignment(ParseResult &assignment) {
+  /**
+   * Version 1 (with 'var'): The right hand side is resolved before
+   * the variable is defined, such that it can still refer to a
+   * variable with the same name in an outer scope.
+   */
+  if (assignment.children.size() == 3 &&
+      assignment.children[0].type == Assignment) {
+    return resolve_parse_result(assignment.children[2]) &&
+           define_variable(assignment.children[1]);
+  }
+
+  /**
+   * Version 2 (without 'var'):
+   */
+  if (assignment.children.size() == 2) {
+    if (!resolve_parse_result(assignment.children[1])) {
+      return false;
+    }
+
+    ParseResult &variable = assignment.children[0];
+    resolve_variable(variable);
+
+    if (this->is_in_function && variable.frame != LocalFrame) {
+      this->changes_shared_state = true;
+      this->is_pure = false;
+    }
+
+    if (this->parallel_loop_scope >= 0 &&
+        !is_defined_in_parallel_loop(std::string(variable.value))) {
+      this->system.state.line_number = assignment.line_number;
+      this->system.state.current_line = "";
+      this->system.print_error_message(
+          std::string("Cannot assign to '") + std::string(variable.value) +
+          "' in a parallel loop. Only variables that are defined in the "
+          "loop can be assigned to.");
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Invalid assignments are reported by the interpreter.
+   */
+  return true;
+}
+
+bool Resolver::resolve_function(ParseResult &function_call) {
+  /**
+   * Check whether the function has an argument that uses the hidden
+   * variable.
+   */
+  int argument_with_hidden_variable = -1;
+
+  std::unordered_map<std::string, Func>::const_iterator position_of_function =
+      this->system.known_functions.find(std::string(function_call.value));
+  if (position_of_function != this->system.known_functions.end()) {
+    argument_with_hidden_variable =
+        position_of_function->second.argument_with_hidden_variable;
+
+    /**
+     * Functions that are called before they are resolved are not
+     * known to be pure yet.  Recursive calls don't change whether the
+     * function is pure.
+     */
+    if (!position_of_function->second.is_pure &&
+        position_of_function->first != this->function_name) {
+      this->is_pure = false;
+    }
+
+    if (position_of_function->second.changes_shared_state) {
+      if (this->is_in_function) {
+        this->changes_shared_state = true;
+      }
+
+      if (this->parallel_loop_scope >= 0) {
+        this->system.state.line_number = function_call.line_number;
+        this->system.state.current_line = "";
+        this->system.print_error_message(
+            std::string("Cannot call '") + std::string(function_call.value) +
+            "' in a parallel loop, since it changes state that is shared "
+            "by the iterations.");
+        return false;
+      }
+    }
+  } else {
+    this->is_pure = false;
+  }
+
+  for (ParseResult &argument_list : function_call.children) {
+    for (int index = 0; index < (int)argument_list.children.size(); ++index) {
+      ParseResult &argument = argument_list.children[index];
+
+      /**
+       * The hidden variable is only visible within its argument. Its
+       * slot is stored in the argument itself, such that the function
+       * knows where to store the value.  Since the arguments are in
+       * the order of the parameters, the position of the argument is
+       * its index in the argument list.
+       */
+      bool has_hidden_variable = index == argument_with_hidden_variable &&
+                                 argument.type == Argument;
+
+      if (has_hidden_variable) {
+        open_scope();
+
+        argument.frame = LocalFrame;
+        argument.slot = this->next_free_slot++;
+        if (this->next_free_slot > this->number_of_slots) {
+          this->number_of_slots = this->next_free_slot;
+        }
+
+        this->scopes.back()[System::hidden_variable_string] = argument.slot;
+      }
+
+      if (!resolve_parse_result(argument)) {
+        return false;
+      }
+
+      if (has_hidden_variable) {
+        close_scope();
+      }
+    }
+  }
+
+  return true;
+}
+
+bool Resolver::resolve_function_definition(ParseResult &function_definition) {
+  if (this->parallel_loop_scope >= 0) {
+    this->system.state.line_number = function_definition.line_number;
+    this->system.state.current_line = "";
+    this->system.print_error_message(
+        std::string("Cannot define '") +
+        std::string(function_definition.value) +
+        "' in a parallel loop. Define the function before the loop instead.");
+    return false;
+  }
+
+  /**
+   * Functions that define functions change the system.
+   */
+  this->is_pure = false;
+
+  if (function_definition.children.empty() ||
+      function_definition.children[0].type != ParameterList) {
+    return true;
+  }
+
+  /**
+   * The lexer adds the functions it parses to the known functions of
+   * its system.  If the code was parsed using another system (e.g.,
+   * on another thread), the function is added here.
+   */
+  const std::string name(function_definition.value);
+  if (this->system.known_functions.find(name) ==
+      this->system.known_functions.end()) {
+    Func new_function(name);
+    for (const ParseResult &parameter :
+         function_definition.children[0].children) {
+      new_function.arguments.emplace_back(parameter.value);
+    }
+
+    this->system.known_functions.insert(
+        std::pair<std::string, Func>(name, new_function));
+    this->system.types_for_keywords.insert(
+        std::pair<std::string, Type>(name, Function));
+  }
+
+  /**
+   * The function body is resolved in a frame of its own.
+   */
+  std::vector<std::unordered_map<std::string, int>> enclosing_scopes =
+      this->scopes;
+  bool enclosing_is_in_function = this->is_in_function;
+  int enclosing_next_free_slot = this->next_free_slot;
+  int enclosing_number_of_slots = this->number_of_slots;
+  bool enclosing_changes_shared_state = this->changes_shared_state;
+  bool enclosing_is_pure = this->is_pure;
+  std::string enclosing_function_name = this->function_name;
+
+  this->scopes = {std::unordered_map<std::string, int>()};
+  this->is_in_function = true;
+  this->next_free_slot = 0;
+  this->number_of_slots = 0;
+  this->changes_shared_state = false;
+  this->is_pure = true;
+  this->function_name = name;
+
+  /**
+   * The parameters occupy the first slots of the frame, in the order
+   * in which they are declared.
+   */
+  bool success = true;
+  for (ParseResult &parameter : function_definition.children[0].children) {
+    if (!define_variable(parameter)) {
+      success = false;
+      break;
+    }
+  }
+
+  for (int index = 1; success && index < (int)function_definition.children.size();
+       ++index) {
+    success = resolve_parse_result(function_definition.children[index]);
+  }
+
+  /**
+   * Functions cannot be redefined. So we only store the frame size
+   * for the first definition.
+   */
+  if (success &&
+      this->defined_functions.find(std::string(function_definition.value)) ==
+          this->defined_functions.end() &&
+      this->system.statements_for_functions.find(std::string(
+          function_definition.value)) ==
+          this->system.statements_for_functions.end()) {
+    std::unordered_map<std::string, Func>::iterator position_of_function =
+        this->system.known_functions.find(std::string(
+            function_definition.value));
+    if (position_of_function != this->system.known_functions.end()) {
+      position_of_function->second.number_of_slots = this->number_of_slots;
+      position_of_function->second.changes_shared_state =
+          this->changes_shared_state;
+      position_of_function->second.is_pure = this->is_pure;
+    }
+  }
+  this->defined_functions.insert(std::string(function_definition.value));
+
+  this->scopes = enclosing_scopes;
+  this->is_in_function = enclosing_is_in_function;
+  this->next_free_slot = enclosing_next_free_slot;
+  this->number_of_slots = enclosing_number_of_slots;
+  this->changes_shared_state = enclosing_changes_shared_state;
+  this->is_pure = enclosing_is_pure;
+  this->function_name = enclosing_function_name;
+
+  return success;
+}
+
+bool Resolver::resolve_loop(ParseResult &loop) {
+  if (loop.children.size() < 2) {
+    return true;
+  }
+
+  /**
+   * The range is evaluated before the loop variable exists.
+   */
+  if (!resolve_parse_result(loop.children[1])) {
+    return false;
+  }
+
+  /**
+   * The loop variable and all variables in the loop live in the
+   * scope of the loop.
+   */
+  open_scope();
+
+  int enclosing_parallel_loop_scope = this->parallel_loop_scope;
+  if (loop.value == "parallel") {
+    this->parallel_loop_scope = this->scopes.size() - 1;
+  }
+
+  bool success = define_variable(loop.children[0]);
+
+  for (int index = 2; success && index < (int)loop.children.size(); ++index) {
+    success = resolve_parse_result(loop.children[index]);
+  }
+
+  this->parallel_loop_scope = enclosing_parallel_loop_scope;
+
+  close_scope();
+  return success;
+}
+
+bool Resolver::is_defined_in_parallel_loop(const std::string &name) const {
+  for (int index = this->scopes.size() - 1; index >= this->parallel_loop_scope;
+       --index) {
+    if (this->scopes[index].find(name) != this->scopes[index].end()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Resolver::resolve_variable(ParseResult &variable) {
+  /**
+   * First we look for the variable in the scopes of the current
+   * frame. At the top level, the first scope holds the global
+   * variables, which are handled below.
+   */
+  int first_local_scope = this->is_in_function ? 0 : 1;
+
+  for (int index = this->scopes.size() - 1; index >= first_local_scope;
+       --index) {
+    std::unordered_map<std::string, int>::const_iterator position_of_slot =
+        this->scopes[index].find(std::string(variable.value));
+
+    if (position_of_slot != this->scopes[index].end()) {
+      variable.frame = LocalFrame;
+      variable.slot = position_of_slot->second;
+      return;
+    }
+  }
+
+  /**
+   * The value of a function that reads a global variable does not
+   * only depend on its arguments.
+   */
+  this->is_pure = false;
+
+  /**
+   * Now check whether we know a global variable with that name.
+   */
+  std::unordered_map<std::string, int>::const_iterator position_of_global =
+      this->system.state.slots_for_globals.find(std::string(variable.value));
+
+  if (position_of_global != this->system.state.slots_for_globals.end()) {
+    variable.frame = GlobalFrame;
+    variable.slot = position_of_global->second;
+    return;
+  }
+
+  /**
+   * The variable may still be defined as global variable, before the
+   * code is executed. (E.g. a function referring to a global
+   * variable that is defined after the function.) In that case, the
+   * variable is looked up by name.
+   */
+  variable.frame = UnresolvedFrame;
+  variable.slot = -1;
+}
+
+bool Resolver::define_variable(ParseResult &variable) {
+  const std::string name(variable.value);
+
+  /**
+   * Global variables.
+   */
+  if (!this->is_in_function && this->scopes.size() == 1) {
+    /**
+     * A global variable that was defined in previously executed code
+     * (e.g., in the REPL) can only be defined again, if its previous
+     * definition failed.
+     */
+    std::unordered_map<std::string, int>::const_iterator position_of_global =
+        this->system.state.slots_for_globals.find(name);
+
+    bool is_defined =
+        this->defined_globals.find(name) != this->defined_globals.end() ||
+        (position_of_global != this->system.state.slots_for_globals.end() &&
+         this->system.state.globals[position_of_global->second].has_value());
+
+    if (is_defined) {
+      this->system.state.line_number = variable.line_number;
+      this->system.state.current_line = "";
+      if (this->system.state.names_of_parameters.find(name) !=
+          this->system.state.names_of_parameters.end()) {
+        this->system.print_error_message(
+            std::string("The parameter '") + name +
+            "' is also defined by the code. Remove its definition, the "
+            "value of the parameter is passed to the code.");
+      } else {
+        this->system.print_error_message(std::string("Redefinition of : '") +
+                                         name + "'.");
+      }
+      return false;
+    }
+
+    this->defined_globals.insert(name);
+    variable.frame = GlobalFrame;
+    variable.slot = this->system.state.slot_for_global(name);
+    return true;
+  }
+
+  /**
+   * Local variables.
+   */
+  if (this->scopes.back().find(name) != this->scopes.back().end()) {
+    this->system.state.line_number = variable.line_number;
+    this->system.state.current_line = "";
+    this->system.print_error_message(std::string("Redefinition of : '") +
+                                     name + "'.");
+    return false;
+  }
+
+  variable.frame = LocalFrame;
+  variable.slot = this->next_free_slot++;
+  if (this->next_free_slot > this->number_of_slots) {
+    this->number_of_slots = this->next_free_slot;
+  }
+
+  this->scopes.back()[name] = variable.slot;
+  return true;
+}
+
+void Resolver::open_scope() {
+  this->scopes.push_back(std::unordered_map<std::string, int>());
+}
+
+void Resolver::close_scope() {
+  /**
+   * The slots of the variables in the closed scope can be reused.
+   */
+  int first_slot_of_scope = this->next_free_slot;
+  for (const std::pair<const std::string, int> &variable : this->scopes.back()) {
+    if (variable.second < first_slot_of_scope) {
+      first_slot_of_scope = variable.second;
+    }
+  }
+
+  this->next_free_slot = first_slot_of_scope;
+  this->scopes.pop_back();
+}
+
+}  // namespace hydra
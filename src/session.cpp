@@ -0,0 +1,189 @@
+//
+//  session.cpp
+//  hydra
+//
+
+#include <session.hpp>
+
+#include <compiler.hpp>
+#include <resolver.hpp>
+
+namespace hydra {
+
+Session::Session(Lexer &lexer, Interpreter &interpreter, VM *vm)
+    : lexer(lexer), interpreter(interpreter), vm(vm) {}
+
+bool Session::run(const std::vector<std::string> &code, Value &result) {
+  result.reset();
+  this->number_of_executed_statements_in_last_run = 0;
+
+  /**
+   * The statements whose lines precede the first changed line are
+   * kept.
+   */
+  int first_changed_line = 0;
+  while (first_changed_line < (int)this->lines.size() &&
+         first_changed_line < (int)code.size() &&
+         this->lines[first_changed_line] == code[first_changed_line]) {
+    ++first_changed_line;
+  }
+
+  int first_changed_statement = 0;
+  while (first_changed_statement < (int)this->statements.size() &&
+         this->statements[first_changed_statement].end_of_lines <=
+             first_changed_line) {
+    ++first_changed_statement;
+  }
+
+  if (!undo_statements(first_changed_statement)) {
+    undo_statements(0);
+  }
+
+  /**
+   * Without any statements left, the parse results of the lexer are
+   * not needed anymore.
+   */
+  if (this->statements.empty()) {
+    this->lexer.reset();
+  }
+
+  /**
+   * The code is parsed from the end of the kept statements, where no
+   * loop or function definition is open.
+   */
+  System &system = this->interpreter.system;
+  const int first_line = this->lines.size();
+  int next_line = first_line;
+
+  std::vector<ParseResult> parsed_code;
+  std::vector<int> ends_of_lines;
+  bool success = this->lexer.parse_lines(
+      [&code, &next_line]() -> const std::string * {
+        if (next_line >= (int)code.size()) {
+          return nullptr;
+        }
+
+        return &code[next_line++];
+      },
+      [&system, &parsed_code,
+       &ends_of_lines](const ParseResult &statement) -> bool {
+        parsed_code.push_back(statement);
+        ends_of_lines.push_back(system.state.line_number + 1);
+        return true;
+      },
+      first_line);
+
+  if (success) {
+    Resolver resolver(system);
+    success = resolver.resolve_code(parsed_code);
+  }
+
+  if (!success) {
+    forget_undone_functions();
+    return false;
+  }
+
+  system.state.line_number = -1;
+  system.state.current_line = "";
+
+  for (int index = 0; index < (int)parsed_code.size(); ++index) {
+    Statement statement;
+    statement.parse_result = parsed_code[index];
+    statement.end_of_lines = ends_of_lines[index];
+    statement.snapshot.state = system.state;
+    statement.snapshot.canvas = this->interpreter.canvas.checkpoint();
+    statement.snapshot.random_engine = this->interpreter.random_engine;
+    this->statements.push_back(std::move(statement));
+
+    this->code_to_execute.assign(1, parsed_code[index]);
+    if (!execute(this->code_to_execute, result)) {
+      if (!undo_statements(this->statements.size() - 1)) {
+        undo_statements(0);
+      }
+      return false;
+    }
+
+    this->lines.insert(this->lines.end(), code.begin() + this->lines.size(),
+                       code.begin() + ends_of_lines[index]);
+    ++this->number_of_executed_statements_in_last_run;
+  }
+
+  return true;
+}
+
+int Session::number_of_statements() const { return this->statements.size(); }
+
+int Session::number_of_executed_statements() const {
+  return this->number_of_executed_statements_in_last_run;
+}
+
+int Session::number_of_lines() const { return this->lines.size(); }
+
+bool Session::undo_statements(int first_statement) {
+  if (first_statement < (int)this->statements.size()) {
+    const Snapshot &snapshot = this->statements[first_statement].snapshot;
+    if (!this->interpreter.canvas.restore(snapshot.canvas)) {
+      return false;
+    }
+
+    this->interpreter.system.state = snapshot.state;
+    this->interpreter.random_engine = snapshot.random_engine;
+    this->statements.erase(this->statements.begin() + first_statement,
+                           this->statements.end());
+  }
+
+  this->lines.resize(
+      this->statements.empty() ? 0 : this->statements.back().end_of_lines);
+  forget_undone_functions();
+  return true;
+}
+
+void Session::forget_undone_functions() {
+  std::unordered_set<std::string> defined_functions;
+  for (const Statement &statement : this->statements) {
+    collect_defined_functions(statement.parse_result, defined_functions);
+  }
+
+  System &system = this->interpreter.system;
+  const size_t number_of_functions = system.known_functions.size();
+  system.forget_user_defined_functions(defined_functions);
+
+  /**
+   * The remembered results of the functions that were removed must
+   * not be used by functions that are defined again.
+   */
+  if (system.known_functions.size() != number_of_functions) {
+    this->interpreter.memoized_results.clear();
+  }
+
+  if (this->vm != nullptr) {
+    this->vm->forget_unknown_functions();
+  }
+}
+
+void Session::collect_defined_functions(
+    const ParseResult &input, std::unordered_set<std::string> &functions) {
+  if (input.type == FunctionDefinition) {
+    functions.emplace(input.value);
+  }
+
+  for (const ParseResult &child : input.children) {
+    collect_defined_functions(child, functions);
+  }
+}
+
+bool Session::execute(const std::vector<ParseResult> &code, Value &result) {
+  if (this->vm == nullptr) {
+    return this->interpreter.interpret_code(code, result);
+  }
+
+  Compiler compiler(this->interpreter);
+  Chunk chunk;
+  if (!compiler.compile_code(code, chunk)) {
+    return false;
+  }
+
+  return this->vm->run(chunk, result);
+}
+
+}  // namespace hydra
@@ -10,128 +10,147 @@
 
 namespace hydra {
 
-State::State() {
-  this->scopes.push_back(std::unordered_map<std::string, std::any>());
-}
+State::State() {}
 
-void State::open_new_scope() {
-  this->scopes.push_back(std::unordered_map<std::string, std::any>());
-}
+int State::slot_for_global(const std::string &variable) {
+  std::unordered_map<std::string, int>::const_iterator position_of_slot =
+      this->slots_for_globals.find(variable);
 
-bool State::close_scope() {
+  if (position_of_slot != this->slots_for_globals.end()) {
+    return position_of_slot->second;
+  }
 
   /**
-   * We must not delete the last scope.
+   * The variable does not have a slot yet, so we add one.
    */
-  if (this->scopes.size() <= 1) {
-    return false;
-  }
+  int slot = this->globals.size();
+  this->globals.push_back(Value());
+  this->slots_for_globals[variable] = slot;
 
-  this->scopes.pop_back();
-  return true;
+  return slot;
 }
 
-int State::define_variable_with_value(const std::string &variable,
-                                      const std::any &value) {
-  /**
-   * First check whether the variable is not yet defined.
-   */
-  std::any already_defined_value;
-  if (value_for_variable_in_current_scope(variable, already_defined_value)) {
-    /**
-     * Variable is already defined.
-     */
-    return -1;
-  }
+void State::define_variable_with_value(const std::string &variable,
+                                       const Value &value) {
+  this->globals[slot_for_global(variable)] = value;
+  this->names_of_parameters.insert(variable);
+}
 
+void State::reserve_top_level_slots(int number_of_slots) {
   /**
-   * Check whether the value does actually have a value.
+   * The top level frame is the first frame on the stack. It can only
+   * grow while no function is being executed.
    */
-  if (!value.has_value()) {
-    return -1;
+  if (this->frame_base == 0 && (int)this->stack.size() < number_of_slots) {
+    this->stack.resize(number_of_slots);
+    this->names_of_slots.resize(number_of_slots);
   }
+}
 
-  /**
-   * Actually defining the variable.
-   */
-  this->scopes.back()[variable] = value;
-  return this->scopes.size() - 1;
+int State::open_frame(int number_of_slots) {
+  return enter_frame(reserve_frame(number_of_slots));
 }
 
-bool State::set_value_for_variable(const std::string &variable,
-                                   const std::any &value, int scope) {
+int State::reserve_frame(int number_of_slots) {
+  int frame = this->stack.size();
+  this->stack.resize(frame + number_of_slots);
 
   /**
-   * We now check whether the variable is already defined.
+   * Frames that were reserved but not entered are removed by
+   * shrinking the stack only, so their names are dropped here.
    */
-  std::any current_value;
-  int scope_of_variable = value_for_variable(variable, current_value);
+  this->names_of_slots.resize(frame);
+  this->names_of_slots.resize(frame + number_of_slots);
 
-  /**
-   * If we try to assign a variable in another scope than it is
-   * defined in, an error occurred. Note that value_for_variable
-   * determines the LAST scope that the variable was defined in and
-   * that the value could also be defined in the passed
-   * scope. However, we only can assign the variable in the last scope
-   * that it is defined in.
-   */
-  if (scope_of_variable != scope) {
-    return false;
-  }
+  return frame;
+}
 
+int State::enter_frame(int frame) {
+  int previous_frame_base = this->frame_base;
+  this->caller_frame_bases.push_back(previous_frame_base);
+  this->frame_base = frame;
+
+  return previous_frame_base;
+}
+
+void State::close_frame(int previous_frame_base) {
   /**
-   * If the new value doesn't actually have a value, we cannot assign
-   * it.
+   * Removing the frame forgets all variables defined in there.
    */
-  if (!value.has_value()) {
-    return false;
+  this->stack.resize(this->frame_base);
+  this->names_of_slots.resize(this->frame_base);
+  this->caller_frame_bases.pop_back();
+  this->frame_base = previous_frame_base;
+}
+
+Value *State::storage_for_variable(Frame frame, int slot,
+                                   std::string_view variable) {
+  switch (frame) {
+    case GlobalFrame:
+      return &this->globals[slot];
+    case LocalFrame:
+      return &this->stack[this->frame_base + slot];
+    default:
+      break;
   }
 
   /**
-   * Actually assigning the value.
+   * The variable was not resolved, so we look for a variable with
+   * that name in the frames of the callers, starting with the
+   * innermost one.  Each caller frame ends where the next one starts.
    */
-  this->scopes[scope][variable] = value;
-  return true;
-}
+  int end_of_frame = this->frame_base;
+  for (std::vector<int>::const_reverse_iterator caller_frame_base =
+           this->caller_frame_bases.rbegin();
+       caller_frame_base != this->caller_frame_bases.rend();
+       ++caller_frame_base) {
+    for (int index = end_of_frame - 1; index >= *caller_frame_base; --index) {
+      if (this->names_of_slots[index] == variable &&
+          this->stack[index].has_value()) {
+        return &this->stack[index];
+      }
+    }
+
+    end_of_frame = *caller_frame_base;
+  }
 
-int State::value_for_variable(const std::string &variable, std::any &value) {
   /**
-   * Reset the value to ensure that the has_value check fails when we
-   * don't find a value.
+   * Otherwise, we look for a global variable with that name.
    */
-  value.reset();
-
-  for (int i = this->scopes.size() - 1; i >= 0; --i) {
-    std::unordered_map<std::string, std::any>::const_iterator
-        position_of_variable = this->scopes[i].find(variable);
+  std::unordered_map<std::string, int>::const_iterator position_of_slot =
+      this->slots_for_globals.find(std::string(variable));
 
-    if (position_of_variable != this->scopes[i].end()) {
-      value = position_of_variable->second;
-      return i;
-    }
+  if (position_of_slot != this->slots_for_globals.end()) {
+    return &this->globals[position_of_slot->second];
   }
 
-  return -1;
+  return nullptr;
 }
 
-bool State::value_for_variable_in_current_scope(
-    const std::string &variable, std::any &value) {
-
-  /**
-   * Reset the value to ensure that the has_value check fails when we
-   * don't find a value.
-   */
-  value.reset();
-
-  std::unordered_map<std::string, std::any>::const_iterator
-      position_of_variable = this->scopes.back().find(variable);
+Value *State::storage_for_definition(Frame frame, int slot,
+                                     std::string_view variable) {
+  if (frame == LocalFrame) {
+    int index = this->frame_base + slot;
+    if (this->names_of_slots[index] != variable) {
+      this->names_of_slots[index] = variable;
+    }
 
-  if (position_of_variable != this->scopes.back().end()) {
-    value = position_of_variable->second;
-    return true;
+    return &this->stack[index];
   }
 
-  return false;
+  return storage_for_variable(frame, slot, variable);
+}
+
+void State::reset() {
+  this->line_number = -1;
+  this->current_line.clear();
+  this->globals.clear();
+  this->slots_for_globals.clear();
+  this->names_of_parameters.clear();
+  this->stack.clear();
+  this->frame_base = 0;
+  this->names_of_slots.clear();
+  this->caller_frame_bases.clear();
 }
 
 }  // namespace hydra
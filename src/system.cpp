@@ -12,7 +12,7 @@
 namespace hydra {
 
 const std::string System::error_string = "__ERROR__";
-const std::string System::type_string = "__TYPE__";
+const std::string System::hidden_variable_string = "_p";
 
 const std::unordered_map<Type, std::string, std::hash<int>>
     System::name_for_type = {
@@ -41,29 +41,51 @@ const std::unordered_map<Type, std::string, std::hash<int>>
 System::System() {
 
   this->types_for_keywords = {{"arc", Function},
+                              {"array_element", Function},
+                              {"array_size", Function},
                               {"circle", Function},
                               {"clear", Function},
                               {"cos", Function},
                               {"cosh", Function},
                               {"curve_angle", Function},
                               {"curve_distance", Function},
+                              {"distance", Function},
                               {"Euc", Initialization},
                               {"func", FunctionDefinition},
                               {"exp", Function},
                               {"for", Loop},
                               {"in", Range},
                               {"line", Function},
+                              {"lines", Function},
+                              {"lines_within", Function},
+                              {"load", Function},
                               {"log", Function},
                               {"mark", Function},
+                              {"marks", Function},
+                              {"number_array", Function},
+                              {"parallel", Loop},
                               {"Pol", Initialization},
+                              {"pol_array", Function},
+                              {"polyline", Function},
                               {"print", Function},
                               {"random", Function},
+                              {"random_angle", Function},
+                              {"random_array", Function},
+                              {"random_graph", Function},
+                              {"random_radius", Function},
                               {"rotate", Function},
                               {"save", Function},
+                              {"seed", Function},
+                              {"set_image_size", Function},
+                              {"set_precision", Function},
                               {"set_resolution", Function},
+                              {"set_simplification", Function},
+                              {"set_tolerance", Function},
+                              {"set_viewport", Function},
                               {"sin", Function},
                               {"sinh", Function},
                               {"show", Function},
+                              {"sqrt", Function},
                               {"theta", Function},
                               {"translate", Function},
                               {"var", Assignment},
@@ -79,6 +101,8 @@ System::System() {
    * The initially known functions.
    */
   this->known_functions = {{"arc", Func("arc", {"center", "radius", "from", "to"})},
+                           {"array_element", Func("array_element", {"of", "at"})},
+                           {"array_size", Func("array_size", {"of"})},
                            {"circle", Func("circle", {"center", "radius"})},
                            {"clear", Func("clear", {})},
                            {"cos", Func("cos", {"x"})},
@@ -89,39 +113,128 @@ System::System() {
                            {"Euc", Func("Euc", {"x", "y"})},
                            {"exp", Func("exp", {"x"})},
                            {"line", Func("line", {"from", "to"})},
+                           {"lines", Func("lines", {"from", "to"})},
+                           {"lines_within", Func("lines_within", {"points", "distance"})},
+                           {"load", Func("load", {"file"})},
                            {"log", Func("log", {"x"})},
                            {"mark", Func("mark", {"center", "radius"})},
+                           {"marks", Func("marks", {"at", "radius"})},
+                           {"number_array", Func("number_array", {"from", "step", "to"})},
                            {"Pol", Func("Pol", {"r", "phi"})},
+                           {"pol_array", Func("pol_array", {"r", "phi"})},
+                           {"polyline", Func("polyline", {"points"})},
                            {"print", Func("print", {"message"})},
                            {"random", Func("random", {"from", "to"})},
+                           {"random_angle", Func("random_angle", {})},
+                           {"random_array", Func("random_array", {"n", "from", "to"})},
+                           {"random_graph", Func("random_graph", {"n", "R", "alpha", "T", "radius"})},
+                           {"random_radius", Func("random_radius", {"R", "alpha"})},
                            {"rotate", Func("rotate", {"point", "by"})},
                            {"save", Func("save", {"file"})},
+                           {"seed", Func("seed", {"value"})},
+                           {"set_image_size", Func("set_image_size", {"width", "height"})},
+                           {"set_precision", Func("set_precision", {"x"})},
                            {"set_resolution", Func("set_resolution", {"x"})},
+                           {"set_simplification", Func("set_simplification", {"x"})},
+                           {"set_tolerance", Func("set_tolerance", {"x"})},
+                           {"set_viewport", Func("set_viewport", {"center", "radius"})},
                            {"sin", Func("sin", {"x"})},
                            {"sinh", Func("sinh", {"x"})},
                            {"show", Func("show", {})},
+                           {"sqrt", Func("sqrt", {"x"})},
                            {"theta", Func("theta", {"r1", "r2", "R"})},
                            {"translate", Func("translate", {"point", "by"})}};
+
+  /**
+   * The functions that evaluate an argument using the hidden
+   * variable ('angle' and 'distance', respectively).
+   */
+  this->known_functions.at("curve_angle").argument_with_hidden_variable = 2;
+  this->known_functions.at("curve_distance").argument_with_hidden_variable = 2;
+
+  /**
+   * The functions that change the canvas as a whole or the settings
+   * of the interpreter, which is why they cannot be called in
+   * parallel loops.
+   */
+  for (const char *name :
+       {"clear", "load", "save", "seed", "set_image_size", "set_precision",
+        "set_resolution", "set_simplification", "set_tolerance",
+        "set_viewport"}) {
+    this->known_functions.at(name).changes_shared_state = true;
+  }
+
+  /**
+   * The functions that only compute a value from their arguments.
+   */
+  for (const char *name :
+       {"array_element", "array_size", "cos", "cosh", "distance", "exp", "log",
+        "number_array", "pol_array", "rotate", "sin", "sinh", "sqrt", "theta",
+        "translate"}) {
+    this->known_functions.at(name).is_pure = true;
+  }
+
+  for (const std::pair<const std::string, Func> &function :
+       this->known_functions) {
+    this->builtin_function_names.insert(function.first);
+  }
+}
+
+void System::reset() {
+  this->state.reset();
+  this->statements_for_functions.clear();
+  forget_user_defined_functions({});
+}
+
+void System::forget_user_defined_functions(
+    const std::unordered_set<std::string> &kept_functions) {
+  /**
+   * User defined functions are known as keywords as well.
+   */
+  std::unordered_map<std::string, Func>::iterator position_of_function =
+      this->known_functions.begin();
+  while (position_of_function != this->known_functions.end()) {
+    if (this->builtin_function_names.count(position_of_function->first) > 0 ||
+        kept_functions.count(position_of_function->first) > 0) {
+      ++position_of_function;
+      continue;
+    }
+
+    this->types_for_keywords.erase(position_of_function->first);
+    this->statements_for_functions.erase(position_of_function->first);
+    position_of_function = this->known_functions.erase(position_of_function);
+  }
+}
+
+bool System::is_builtin_function(const std::string &name) const {
+  return this->builtin_function_names.count(name) > 0;
 }
 
 void System::print_error_message(const std::string &message) {
+  /**
+   * The message is written at once, such that messages of
+   * different threads don't interleave.
+   */
+  std::string output;
   if (this->state.line_number >= 0) {
     if (!this->state.current_line.empty()) {
-      std::cerr << "Error in line " << this->state.line_number << ": '"
-                << this->state.current_line << "'." << std::endl
-                << "> " << message << std::endl;
+      output = "Error in line " + std::to_string(this->state.line_number) +
+               ": '" + this->state.current_line + "'.\n> " + message + "\n";
     } else {
-      std::cerr << "Error in line " << this->state.line_number << ": "
-                << message << std::endl;
+      output = "Error in line " + std::to_string(this->state.line_number) +
+               ": " + message + "\n";
     }
   } else {
-    std::cerr << "> " << message << std::endl;
+    output = "> " + message + "\n";
   }
+
+  *this->error_output << output << std::flush;
 }
 
-void System::print_argument_list(const std::vector<std::string> &arguments) {
+void System::print_argument_list(const std::vector<std::string> &arguments,
+                                 std::ostream &stream) {
   for (int i = 0; i < (int)arguments.size(); ++i) {
-    std::cerr << arguments[i] << ":";
+    stream << arguments[i] << ":";
   }
 }
 } // namespace hydra
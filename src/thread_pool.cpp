@@ -0,0 +1,101 @@
+//
+//  thread_pool.cpp
+//  hydra
+//
+
+#include <thread_pool.hpp>
+
+namespace hydra {
+
+ThreadPool::ThreadPool(int number_of_threads) {
+  for (int thread = 1; thread < number_of_threads; ++thread) {
+    this->workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->is_stopping = true;
+  }
+  this->job_available.notify_all();
+
+  for (std::thread &worker : this->workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::parallel_for(int count,
+                              const std::function<void(int)> &task) {
+  if (this->workers.empty()) {
+    for (int index = 0; index < count; ++index) {
+      task(index);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->task = &task;
+    this->count = count;
+    this->next_index = 0;
+    ++this->generation;
+    this->busy_workers = this->workers.size();
+  }
+  this->job_available.notify_all();
+
+  /**
+   * The calling thread helps with the job.
+   */
+  process_job(task, count);
+
+  /**
+   * The task must outlive all calls, so we wait for the workers to
+   * leave the job.
+   */
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->job_done.wait(lock, [this] { return this->busy_workers == 0; });
+  this->task = nullptr;
+}
+
+void ThreadPool::process_job(const std::function<void(int)> &task,
+                             int count) {
+  for (int index = this->next_index++; index < count;
+       index = this->next_index++) {
+    task(index);
+  }
+}
+
+void ThreadPool::work() {
+  int processed_generation = 0;
+
+  while (true) {
+    const std::function<void(int)> *task;
+    int count;
+
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->job_available.wait(lock, [this, processed_generation] {
+        return this->is_stopping || this->generation != processed_generation;
+      });
+
+      if (this->is_stopping) {
+        return;
+      }
+
+      processed_generation = this->generation;
+      task = this->task;
+      count = this->count;
+    }
+
+    process_job(*task, count);
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      --this->busy_workers;
+    }
+    this->job_done.notify_one();
+  }
+}
+
+}  // namespace hydra
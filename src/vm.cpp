@@ -0,0 +1,470 @@
+//
+//  vm.cpp
+//  hydra
+//
+
+#include <vm.hpp>
+
+#include <iostream>
+
+namespace hydra {
+
+namespace {
+
+/**
+ * Reports the lines of the executed instructions to the profiler.  A
+ * line is entered when the first of its instructions is executed and
+ * left when an instruction of another line is executed or the chunk
+ * is left.
+ */
+class LineTracker {
+ public:
+  explicit LineTracker(Profiler *profiler) : profiler(profiler) {}
+
+  ~LineTracker() {
+    if (this->line_number >= 0) {
+      this->profiler->leave();
+    }
+  }
+
+  LineTracker(const LineTracker &) = delete;
+  LineTracker &operator=(const LineTracker &) = delete;
+
+  void step(int line_number) {
+    if (line_number == this->line_number) {
+      return;
+    }
+
+    if (this->line_number >= 0) {
+      this->profiler->leave();
+    }
+    this->profiler->enter_line(line_number);
+    this->line_number = line_number;
+  }
+
+ private:
+  Profiler *const profiler;
+  int line_number = -1;
+};
+
+}  // namespace
+
+VM::VM(Interpreter &interpreter) : interpreter(interpreter) {}
+
+bool VM::run(const Chunk &chunk, Value &result) {
+  result.reset();
+  return execute(chunk, 0, result);
+}
+
+void VM::reset() {
+  this->registers.clear();
+  this->functions.clear();
+}
+
+void VM::forget_unknown_functions() {
+  const std::unordered_map<std::string, Span<const ParseResult>>
+      &statements_for_functions =
+          this->interpreter.system.statements_for_functions;
+
+  std::unordered_map<std::string, std::shared_ptr<const Chunk>>::iterator
+      position_of_function = this->functions.begin();
+  while (position_of_function != this->functions.end()) {
+    if (statements_for_functions.count(position_of_function->first) > 0) {
+      ++position_of_function;
+    } else {
+      position_of_function = this->functions.erase(position_of_function);
+    }
+  }
+}
+
+bool VM::fail(const Chunk &chunk, int instruction, const std::string &message) {
+  this->interpreter.system.state.line_number = chunk.line_numbers[instruction];
+  this->interpreter.system.print_error_message(message);
+  return false;
+}
+
+bool VM::execute(const Chunk &chunk, int base, Value &result) {
+  result.reset();
+
+  if ((int)this->registers.size() < base + chunk.number_of_registers) {
+    this->registers.resize(base + chunk.number_of_registers);
+  }
+
+  State &state = this->interpreter.system.state;
+
+  /**
+   * The registers of this chunk. Since calls may grow the register
+   * vector, this has to be updated after each call.
+   */
+  Value *r = this->registers.data() + base;
+
+  Profiler *const profiler = this->interpreter.profiler;
+  LineTracker line_tracker(profiler);
+
+  int program_counter = 0;
+
+  while (program_counter < (int)chunk.instructions.size()) {
+    const int current_instruction = program_counter++;
+    const Instruction &instruction = chunk.instructions[current_instruction];
+
+    if (profiler != nullptr) {
+      line_tracker.step(chunk.line_numbers[current_instruction]);
+    }
+
+    switch (instruction.op_code) {
+      case OpCode::LoadConstant:
+        r[instruction.a] = chunk.constants[instruction.b];
+        break;
+
+      case OpCode::LoadVariable: {
+        const VariableReference &variable = chunk.variables[instruction.b];
+        const Value *value = state.storage_for_variable(
+            variable.frame, variable.slot, variable.name);
+
+        if (value == nullptr || !value->has_value()) {
+          return fail(chunk, current_instruction,
+                      std::string("Use of undeclared variable '") +
+                          variable.name +
+                          "'. Declare the variable first using 'var " +
+                          variable.name + " = ...'");
+        }
+
+        r[instruction.a] = *value;
+        break;
+      }
+
+      case OpCode::LoadProperty: {
+        const VariableReference &variable = chunk.variables[instruction.b];
+        const std::string &property = chunk.names[instruction.c];
+
+        const Value *value = state.storage_for_variable(
+            variable.frame, variable.slot, variable.name);
+
+        if (value == nullptr || !value->has_value()) {
+          return fail(chunk, current_instruction,
+                      std::string("Use of undeclared variable '") +
+                          variable.name +
+                          "'. Declare the variable first using 'var " +
+                          variable.name + " = ...'");
+        }
+
+        if (value->pol() == nullptr && value->object() == nullptr &&
+            value->array() == nullptr) {
+          return fail(chunk, current_instruction,
+                      std::string("Could not access property '") + property +
+                          "' of variable '" + variable.name +
+                          "'. Did not find property map.");
+        }
+
+        state.line_number = chunk.line_numbers[current_instruction];
+        if (!this->interpreter.value_for_property(property, *value,
+                                                  r[instruction.a])) {
+          return false;
+        }
+        break;
+      }
+
+      case OpCode::DefineVariable: {
+        const VariableReference &variable = chunk.variables[instruction.b];
+
+        if (!r[instruction.a].has_value()) {
+          return fail(chunk, current_instruction,
+                      std::string("Could not define '") + variable.name +
+                          "'. Right hand side of assignment did not have "
+                          "a value.");
+        }
+
+        /**
+         * Redefinitions were already ruled out by the resolver.
+         */
+        Value *value = state.storage_for_definition(
+            variable.frame, variable.slot, variable.name);
+
+        if (value == nullptr) {
+          return fail(chunk, current_instruction,
+                      std::string("Could not define '") + variable.name +
+                          "'.");
+        }
+
+        *value = r[instruction.a];
+        break;
+      }
+
+      case OpCode::AssignVariable: {
+        const VariableReference &variable = chunk.variables[instruction.b];
+        Value *value = state.storage_for_variable(
+            variable.frame, variable.slot, variable.name);
+
+        if (value == nullptr || !value->has_value()) {
+          return fail(chunk, current_instruction,
+                      std::string("Trying to assign to undefined variable. "
+                                  "Define the variable first using 'var ") +
+                          variable.name + " = ...' instead.");
+        }
+
+        if (!r[instruction.a].has_value()) {
+          return fail(chunk, current_instruction,
+                      std::string("Could not define '") + variable.name +
+                          "'. Right hand side of assignment did not have a "
+                          "value.");
+        }
+
+        *value = r[instruction.a];
+        break;
+      }
+
+      case OpCode::Add:
+      case OpCode::Subtract:
+      case OpCode::Multiply:
+      case OpCode::Divide: {
+        static const char *operator_strings[] = {"+", "-", "*", "/"};
+        const char *operator_string =
+            operator_strings[(int)instruction.op_code - (int)OpCode::Add];
+
+        const double *lhs = r[instruction.b].number();
+        if (lhs == nullptr) {
+          return fail(chunk, current_instruction,
+                      std::string("Interpretation failed: Left hand side of "
+                                  "operation near '") +
+                          operator_string +
+                          "' could not be interpreted as number.");
+        }
+
+        const double *rhs = r[instruction.c].number();
+        if (rhs == nullptr) {
+          return fail(chunk, current_instruction,
+                      std::string("Interpretation failed: Right hand side of "
+                                  "operation near '") +
+                          operator_string +
+                          "' could not be interpreted as number.");
+        }
+
+        double value;
+        switch (instruction.op_code) {
+          case OpCode::Add:
+            value = *lhs + *rhs;
+            break;
+          case OpCode::Subtract:
+            value = *lhs - *rhs;
+            break;
+          case OpCode::Multiply:
+            value = *lhs * *rhs;
+            break;
+          default:
+            value = *lhs / *rhs;
+            break;
+        }
+
+        r[instruction.a] = value;
+        break;
+      }
+
+      case OpCode::BuildString: {
+        std::string final_string;
+
+        for (int part = 0; part < instruction.c; ++part) {
+          std::string string_representation;
+          if (!this->interpreter.string_representation_of_interpretation_result(
+                  r[instruction.b + part], string_representation)) {
+            return fail(chunk, current_instruction,
+                        std::string("Interpretation failed. Part ") +
+                            std::to_string(part + 1) +
+                            " of the string could not be interpreted as "
+                            "string.");
+          }
+          final_string += string_representation;
+        }
+
+        r[instruction.a] = final_string;
+        break;
+      }
+
+      case OpCode::Initialize: {
+        const CallSite &call_site = chunk.call_sites[instruction.b];
+
+        /**
+         * The arguments were evaluated into the registers in the
+         * order of the parameters.
+         */
+        Arguments arguments;
+        arguments.function = call_site.function;
+        arguments.values = r + instruction.c;
+        arguments.size = call_site.parameters.size();
+
+        state.line_number = chunk.line_numbers[current_instruction];
+        if (!this->interpreter.value_for_initialization(
+                call_site.call, arguments, r[instruction.a])) {
+          return false;
+        }
+        break;
+      }
+
+      case OpCode::CallBuiltin: {
+        const CallSite &call_site = chunk.call_sites[instruction.b];
+        const Builtin &builtin = *call_site.builtin;
+
+        /**
+         * The builtin function works directly on the registers that
+         * hold the arguments.  The register of the argument that uses
+         * the hidden variable was not written, so we clear it.
+         */
+        Arguments arguments;
+        arguments.function = builtin.function;
+        arguments.values = r + instruction.c;
+        arguments.size = call_site.parameters.size();
+
+        const int lazy_argument = builtin.function->argument_with_hidden_variable;
+        if (lazy_argument >= 0 && lazy_argument < arguments.size) {
+          arguments.values[lazy_argument].reset();
+        }
+
+        state.line_number = chunk.line_numbers[current_instruction];
+        Profiler::Scope scope(profiler, Profiler::Kind::Builtin,
+                              call_site.call.value);
+        if (!builtin.implementation(&this->interpreter, call_site.call,
+                                    arguments, r[instruction.a])) {
+          return false;
+        }
+        break;
+      }
+
+      case OpCode::CallFunction: {
+        const CallSite &call_site = chunk.call_sites[instruction.b];
+
+        Value value;
+        if (!call_function(call_site, base + instruction.c,
+                           base + chunk.number_of_registers, value)) {
+          return false;
+        }
+
+        r = this->registers.data() + base;
+        r[instruction.a] = value;
+        break;
+      }
+
+      case OpCode::DefineFunction: {
+        const std::shared_ptr<const Chunk> &function =
+            chunk.functions[instruction.a];
+
+        /**
+         * The statements are stored as well, such that builtin
+         * functions can call the function when interpreting their
+         * arguments.
+         */
+        this->functions.insert(
+            std::pair<std::string, std::shared_ptr<const Chunk>>(
+                function->name, function));
+        this->interpreter.system.statements_for_functions.insert(
+            std::pair<std::string, Span<const ParseResult>>(
+                function->name, chunk.function_statements[instruction.a]));
+        break;
+      }
+
+      case OpCode::LoopPrepare: {
+        static const char *bound_names[] = {"lower bound", "step size",
+                                            "upper bound"};
+        for (int index = 0; index < 3; ++index) {
+          if (r[instruction.a + index].number() == nullptr) {
+            return fail(chunk, current_instruction,
+                        std::string("Interpretation failed. Could not "
+                                    "interpret ") +
+                            bound_names[index] + " of range.");
+          }
+        }
+
+        r[instruction.a + 3] = r[instruction.a];
+
+        if (*r[instruction.a + 3].number() > *r[instruction.a + 2].number()) {
+          program_counter = instruction.c;
+          break;
+        }
+
+        const VariableReference &variable = chunk.variables[instruction.b];
+        *state.storage_for_definition(variable.frame, variable.slot,
+                                      variable.name) = r[instruction.a + 3];
+        break;
+      }
+
+      case OpCode::LoopStep: {
+        /**
+         * Assignments to the loop variable within the loop don't
+         * affect the iteration.
+         */
+        double &loop_variable = *r[instruction.a + 3].number();
+        loop_variable += *r[instruction.a + 1].number();
+
+        if (loop_variable <= *r[instruction.a + 2].number()) {
+          const VariableReference &variable = chunk.variables[instruction.b];
+          *state.storage_for_definition(variable.frame, variable.slot,
+                                        variable.name) = r[instruction.a + 3];
+          program_counter = instruction.c;
+        }
+        break;
+      }
+
+      case OpCode::ParallelLoop: {
+        Value loop_result;
+        if (!this->interpreter.interpret_loop(
+                chunk.call_sites[instruction.b].call, loop_result)) {
+          return false;
+        }
+        break;
+      }
+
+      case OpCode::Return:
+        if (instruction.a >= 0) {
+          result = r[instruction.a];
+        }
+        return true;
+    }
+  }
+
+  return true;
+}
+
+bool VM::call_function(const CallSite &call_site, int first_argument,
+                       int base, Value &result) {
+  std::unordered_map<std::string, std::shared_ptr<const Chunk>>::const_iterator
+      position_of_function = this->functions.find(std::string(
+          call_site.call.value));
+
+  if (position_of_function == this->functions.end()) {
+    this->interpreter.system.state.line_number = call_site.call.line_number;
+    this->interpreter.system.print_error_message(
+        std::string("Could not interpret '") +
+        std::string(call_site.call.value) +
+        "'. No function definition found.");
+    return false;
+  }
+
+  /**
+   * Keep a reference to the function, in case the function table
+   * changes during the execution.
+   */
+  std::shared_ptr<const Chunk> function = position_of_function->second;
+
+  /**
+   * All variables defined in the function (including the
+   * parameters) will be forgotten after the function.  The
+   * parameters occupy the first slots of the frame.
+   */
+  State &state = this->interpreter.system.state;
+  int previous_frame_base = state.open_frame(function->number_of_slots);
+
+  for (int index = 0; index < (int)call_site.parameters.size() &&
+                      index < function->number_of_slots;
+       ++index) {
+    *state.storage_for_definition(LocalFrame, index,
+                                  call_site.parameters[index]) =
+        this->registers[first_argument + index];
+  }
+
+  Profiler::Scope scope(this->interpreter.profiler, Profiler::Kind::Function,
+                        call_site.call.value);
+  bool success = execute(*function, base, result);
+
+  state.close_frame(previous_frame_base);
+  return success;
+}
+
+}  // namespace hydra